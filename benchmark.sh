@@ -0,0 +1,237 @@
+#!/bin/bash
+
+# Benchmarks for the Series-Parallel Recognizer
+# Run after build_and_test.sh; uses ./graph_generator and ./sp_recognizer from the current
+# directory. Every workload is one batch stream, timed with the recognizer's own batch report
+# (best of RUNS runs, single-threaded unless THREADS is set).
+
+set -e
+
+GRAPH_GEN="./graph_generator"
+SP_RECOG="./sp_recognizer"
+BENCH_DIR="bench_graphs"
+RUNS=${RUNS:-3}
+THREADS=${THREADS:-1}
+
+if [ ! -x "$GRAPH_GEN" ] || [ ! -x "$SP_RECOG" ]; then
+    echo "Error: build graph_generator and sp_recognizer first (./build_and_test.sh)"
+    exit 1
+fi
+
+mkdir -p "$BENCH_DIR"
+
+# Triangulated polygon on n vertices, with the chords zigzagging across it: outerplanar, so
+# series-parallel, with a decomposition tree of about 2n nodes. With a fourth argument the
+# chord (0, n / 2) is added, which crosses the zigzag and makes the graph non-SP.
+strip_graph() {
+    awk -v n="$1" -v cross="$2" 'BEGIN {
+        m = 0
+        for (i = 0; i < n; i++) e[m++] = i " " (i + 1) % n
+        l = 0; r = n - 1
+        while (r - l > 2) {
+            e[m++] = (l + 1) " " r; l++
+            if (r - l > 2) { e[m++] = l " " (r - 1); r-- }
+        }
+        if (cross) e[m++] = 0 " " int(n / 2)
+        print n, m
+        for (i = 0; i < m; i++) print e[i]
+    }'
+}
+
+# make_stream NAME COUNT COMMAND...: concatenates COUNT outputs of COMMAND (given the graph
+# index as its last argument) into $BENCH_DIR/NAME
+make_stream() {
+    local name=$1 count=$2
+    shift 2
+    local file="$BENCH_DIR/$name"
+    [ -f "$file" ] && return
+    for ((i = 0; i < count; i++)); do "$@" "$i"; done > "$file"
+}
+
+# Chain of $1 cycles of length $2, each sharing a vertex with the next half way round: SP, with
+# $1 bicomps that can be recognized independently.
+cycle_chain() {
+    awk -v b="$1" -v l="$2" 'BEGIN {
+        print b * (l - 1) + 1, b * l
+        at = 0; next_v = 1
+        for (k = 0; k < b; k++) {
+            first = next_v; prev = at
+            for (i = 1; i < l; i++) { print prev, next_v; prev = next_v++ }
+            print prev, at
+            at = first + int(l / 2) - 1
+        }
+    }'
+}
+
+strip_sp() { strip_graph "$1" ""; }
+strip_nonsp() { strip_graph "$1" 1; }
+cycles() { "$GRAPH_GEN" --binary 1 "$1" 0 3 0 "$((12000 + $2))"; }
+complete() { "$GRAPH_GEN" --binary 0 3 "$1" 5 0 "$((13000 + $2))"; }
+cycle_tree() { "$GRAPH_GEN" --binary "$1" 40 0 3 0 "$((14000 + $2))"; }
+
+echo "Generating workloads in $BENCH_DIR ..."
+make_stream sp_strips.txt 32 strip_sp 100000
+make_stream sp_cycles.bin 32 cycles 100000
+make_stream nonsp_strips.txt 32 strip_nonsp 100000
+make_stream nonsp_complete.bin 32 complete 2000
+make_stream nonsp_cycle_tree.bin 32 cycle_tree 2000
+[ -f "$BENCH_DIR/cycle_chain.txt" ] || cycle_chain 4000 500 > "$BENCH_DIR/cycle_chain.txt"
+[ -f "$BENCH_DIR/cycle_tree_big.bin" ] || "$GRAPH_GEN" --binary 200000 20 0 3 0 14999 > "$BENCH_DIR/cycle_tree_big.bin"
+[ -f "$BENCH_DIR/strip_big.txt" ] || strip_sp 2000000 > "$BENCH_DIR/strip_big.txt"
+[ -f "$BENCH_DIR/cycle_big.bin" ] || "$GRAPH_GEN" --binary 1 2000000 0 3 0 14998 > "$BENCH_DIR/cycle_big.bin"
+[ -f "$BENCH_DIR/complete_big.bin" ] || "$GRAPH_GEN" --binary 0 3 20000 5 0 14997 > "$BENCH_DIR/complete_big.bin"
+
+# best batch time in seconds of $SP_RECOG --batch over a stream, with extra options
+best_time() {
+    local file=$1
+    shift
+    local best=""
+    for ((r = 0; r < RUNS; r++)); do
+        local t
+        t=$("$SP_RECOG" --batch --threads "$THREADS" "$@" "$file" 2>&1 >/dev/null | sed -n 's/.* in \([0-9.e+-]*\) s .*/\1/p')
+        if [ -z "$best" ] || awk -v a="$t" -v b="$best" 'BEGIN { exit !(a < b) }'; then best=$t; fi
+    done
+    echo "$best"
+}
+
+# ---- Certificate policies ----
+# The full build against the decision-only one, on SP-positive and SP-negative streams.
+echo ""
+echo "Certificate policies (--cert-policy), seconds per stream:"
+printf "%-22s %10s %10s %10s %9s\n" "workload" "full" "terminals" "boolean" "speedup"
+for file in sp_strips.txt sp_cycles.bin nonsp_strips.txt nonsp_complete.bin nonsp_cycle_tree.bin; do
+    full=$(best_time "$BENCH_DIR/$file" --cert-policy full)
+    terminals=$(best_time "$BENCH_DIR/$file" --cert-policy terminals)
+    boolean=$(best_time "$BENCH_DIR/$file" --cert-policy boolean)
+    speedup=$(awk -v a="$full" -v b="$boolean" 'BEGIN { printf "%.2fx", (b > 0 ? a / b : 0) }')
+    printf "%-22s %10.4f %10.4f %10.4f %9s\n" "$file" "$full" "$terminals" "$boolean" "$speedup"
+done
+
+# best wall time in seconds of one single-graph run of $SP_RECOG, with extra options
+best_single_time() {
+    local file=$1
+    shift
+    local best=""
+    for ((r = 0; r < RUNS; r++)); do
+        local start end t
+        start=$(date +%s.%N)
+        "$SP_RECOG" "$@" "$file" > /dev/null
+        end=$(date +%s.%N)
+        t=$(awk -v a="$start" -v b="$end" 'BEGIN { printf "%.4f", b - a }')
+        if [ -z "$best" ] || awk -v a="$t" -v b="$best" 'BEGIN { exit !(a < b) }'; then best=$t; fi
+    done
+    echo "$best"
+}
+
+# ---- Bicomps on a pool ----
+# One graph of many bicomps, recognized with its bicomps spread over 1 to BLOCK_THREADS threads
+# (--threads in single-graph mode); the time includes reading the graph.
+BLOCK_THREADS=${BLOCK_THREADS:-$(nproc)}
+echo ""
+echo "Bicomps on a pool (cycle_chain.txt, single graph), seconds:"
+printf "%-10s %10s %9s\n" "threads" "time" "speedup"
+base=$(best_single_time "$BENCH_DIR/cycle_chain.txt" --threads 1)
+for ((t = 1; t <= BLOCK_THREADS; t *= 2)); do
+    time=$(best_single_time "$BENCH_DIR/cycle_chain.txt" --threads "$t")
+    speedup=$(awk -v a="$base" -v b="$time" 'BEGIN { printf "%.2fx", (b > 0 ? a / b : 0) }')
+    printf "%-10s %10.4f %9s\n" "$t" "$time" "$speedup"
+done
+
+# ---- Parallel bicomp engine ----
+# One wide graph of 4M vertices in 200k cycles (cycle_tree_big.bin), its bicomps found by the DFS
+# engine and by the parallel engine (--bicomps parallel) on 1 to BLOCK_THREADS threads; speedups
+# are against the DFS engine.
+echo ""
+echo "Parallel bicomp engine (cycle_tree_big.bin, single graph), seconds:"
+printf "%-10s %10s %9s\n" "engine" "time" "speedup"
+base=$(best_single_time "$BENCH_DIR/cycle_tree_big.bin" --bicomps dfs)
+printf "%-10s %10.4f %9s\n" "dfs" "$base" "1.00x"
+for ((t = 1; t <= BLOCK_THREADS; t *= 2)); do
+    time=$(best_single_time "$BENCH_DIR/cycle_tree_big.bin" --bicomps parallel --threads "$t")
+    speedup=$(awk -v a="$base" -v b="$time" 'BEGIN { printf "%.2fx", (b > 0 ? a / b : 0) }')
+    printf "%-10s %10.4f %9s\n" "par/$t" "$time" "$speedup"
+done
+
+# ---- Parallel ear engine ----
+# Two single-block graphs, a 2M-vertex triangulated strip (SP, one ear per chord) and
+# cycle_tree_big.bin (non-SP), recognized by the DFS and by the ear engine (--engine ears) on 1
+# to BLOCK_THREADS threads; speedups are against the DFS.
+for file in strip_big.txt cycle_tree_big.bin; do
+    echo ""
+    echo "Parallel ear engine ($file, single graph), seconds:"
+    printf "%-10s %10s %9s\n" "engine" "time" "speedup"
+    base=$(best_single_time "$BENCH_DIR/$file" --engine dfs)
+    printf "%-10s %10.4f %9s\n" "dfs" "$base" "1.00x"
+    for ((t = 1; t <= BLOCK_THREADS; t *= 2)); do
+        time=$(best_single_time "$BENCH_DIR/$file" --engine ears --threads "$t")
+        speedup=$(awk -v a="$base" -v b="$time" 'BEGIN { printf "%.2fx", (b > 0 ? a / b : 0) }')
+        printf "%-10s %10.4f %9s\n" "ears/$t" "$time" "$speedup"
+    done
+done
+
+# ---- Degree-2 path compression ----
+# The chained cycles (SP) and cycle_tree_big.bin (non-SP), long degree-2 paths between few
+# branch vertices, recognized as they are and through their kernel (--compress-paths); the
+# time includes reading the graph, building the kernel and lifting the certificates.
+echo ""
+echo "Degree-2 path compression (single graph), seconds:"
+printf "%-20s %10s %10s %9s\n" "graph" "plain" "kernel" "speedup"
+for file in cycle_chain.txt cycle_tree_big.bin; do
+    plain=$(best_single_time "$BENCH_DIR/$file")
+    kernel=$(best_single_time "$BENCH_DIR/$file" --compress-paths)
+    speedup=$(awk -v a="$plain" -v b="$kernel" 'BEGIN { printf "%.2fx", (b > 0 ? a / b : 0) }')
+    printf "%-20s %10.4f %10.4f %9s\n" "$file" "$plain" "$kernel" "$speedup"
+done
+
+# ---- Pre-filter ----
+# The SP-negative streams with and without --prefilter, under every policy: the complete
+# graphs fail the edge bound, the cycle trees and strips pass it and pay for the peeling.
+echo ""
+echo "Pre-filter (--prefilter), seconds per stream:"
+printf "%-22s %-10s %10s %10s %9s\n" "workload" "policy" "plain" "filtered" "speedup"
+for file in nonsp_strips.txt nonsp_complete.bin nonsp_cycle_tree.bin; do
+    for policy in full terminals boolean; do
+        plain=$(best_time "$BENCH_DIR/$file" --cert-policy "$policy")
+        filtered=$(best_time "$BENCH_DIR/$file" --cert-policy "$policy" --prefilter)
+        speedup=$(awk -v a="$plain" -v b="$filtered" 'BEGIN { printf "%.2fx", (b > 0 ? a / b : 0) }')
+        printf "%-22s %-10s %10.4f %10.4f %9s\n" "$file" "$policy" "$plain" "$filtered" "$speedup"
+    done
+done
+
+# ---- Recognition engines ----
+# Single graphs from the generator families and the SP chains, recognized by the DFS engine and
+# by series-parallel reductions (--engine reduction, reducing on one thread): a 2M-vertex cycle,
+# the 2M-vertex strip and the chained cycles reduce to one edge; the complete graphs get stuck at
+# once and the cycle tree after reducing its cycles, and both are left to the DFS (the boolean
+# policy rejects what is stuck with every degree at least 3 without it).
+echo ""
+echo "Recognition engines (single graph, --threads 1), seconds:"
+printf "%-22s %-10s %10s %10s %9s\n" "workload" "policy" "dfs" "reduction" "speedup"
+for file in cycle_big.bin strip_big.txt cycle_chain.txt complete_big.bin cycle_tree_big.bin; do
+    for policy in full boolean; do
+        dfs=$(best_single_time "$BENCH_DIR/$file" --cert-policy "$policy" --threads 1)
+        reduction=$(best_single_time "$BENCH_DIR/$file" --cert-policy "$policy" --engine reduction --threads 1)
+        speedup=$(awk -v a="$dfs" -v b="$reduction" 'BEGIN { printf "%.2fx", (b > 0 ? a / b : 0) }')
+        printf "%-22s %-10s %10.4f %10.4f %9s\n" "$file" "$policy" "$dfs" "$reduction" "$speedup"
+    done
+done
+
+# ---- Vertex relabeling ----
+# The generator shuffles vertex labels, so the per-vertex arrays of the recognizer are read at
+# random; --relabel renumbers the graph first and maps the result back. Single graphs, on one
+# thread, without relabeling and with each order, the time including the relabeling; the strip
+# is numbered in order already and shows what relabeling costs when there is nothing to gain.
+echo ""
+echo "Vertex relabeling (single graph, --threads 1), seconds and speedup per order:"
+printf "%-22s %-10s %10s %16s %16s %16s\n" "workload" "policy" "plain" "bfs" "rcm" "dfs"
+for file in cycle_big.bin cycle_tree_big.bin strip_big.txt; do
+    for policy in full boolean; do
+        plain=$(best_single_time "$BENCH_DIR/$file" --cert-policy "$policy" --threads 1)
+        line=$(printf "%-22s %-10s %10.4f" "$file" "$policy" "$plain")
+        for order in bfs rcm dfs; do
+            time=$(best_single_time "$BENCH_DIR/$file" --cert-policy "$policy" --threads 1 --relabel "$order")
+            line+=$(awk -v a="$plain" -v b="$time" 'BEGIN { printf " %8.4f (%.2fx)", b, (b > 0 ? a / b : 0) }')
+        done
+        echo "$line"
+    done
+done
@@ -4,7 +4,7 @@ echo "Building and Testing Graph Generator and Series-Parallel Recognizer"
 echo "=================================================================="
 
 # Cleasn up any existing files
-rm -f graph_generator sp_recognizer tester test_graph.txt sp_result.txt
+rm -f graph_generator sp_recognizer sp_recognizer_alloc sp_verify tester test_graph.txt sp_result.txt
 
 # Compiles graph generator
 echo "Compiling graph generator..."
@@ -17,13 +17,31 @@ fi
 
 # Compiles series-parallel recognizer
 echo "Compiling series-parallel recognizer..."
-if clang++ -std=c++20 -Wall -Wextra sp_recognizer.cpp -o sp_recognizer; then
+if clang++ -std=c++20 -O2 -Wall -Wextra -pthread sp_recognition.cpp -o sp_recognizer; then
     echo "✓ Series-parallel recognizer compiled successfully"
 else
     echo "✗ Failed to compile series-parallel recognizer"
     exit 1
 fi
 
+# Compiles the allocation-counting build used by the allocation test
+echo "Compiling allocation-counting recognizer..."
+if clang++ -std=c++20 -O2 -Wall -Wextra -pthread -D__COUNT_ALLOCATIONS__ sp_recognition.cpp -o sp_recognizer_alloc; then
+    echo "✓ Allocation-counting recognizer compiled successfully"
+else
+    echo "✗ Failed to compile allocation-counting recognizer"
+    exit 1
+fi
+
+# Compiles the standalone certificate verifier
+echo "Compiling certificate verifier..."
+if clang++ -std=c++20 -O2 -Wall -Wextra -pthread sp_verify.cpp -o sp_verify; then
+    echo "✓ Certificate verifier compiled successfully"
+else
+    echo "✗ Failed to compile certificate verifier"
+    exit 1
+fi
+
 # Compiles tester
 echo "Compiling tester..."
 if clang++ -std=c++20 -Wall -Wextra tester.cpp -o tester; then
@@ -0,0 +1,216 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+
+#include "graph_format.h"
+
+// ==================== CERTIFICATE FILE FORMAT ====================
+// Written by sp_recognition --emit-cert. A file is a sequence of self-delimiting records, a
+// group of them per recognized graph in input order, so files concatenate like graph streams do.
+// Every field is little-endian and every array is 4-byte aligned, so a mapped file can be used in
+// place. A group is the record of the SP verdict, then one for each of the GSP and outerplanar
+// verdicts the recognizer certified, in that order; version 1 files hold the first only.
+//
+//   offset  size  field
+//        0     4  magic "GSPC"
+//        4     2  version (cert_file_version)
+//        6     2  kind (cert_kind)
+//        8     4  flags, below
+//       12     4  n of the graph
+//       16     8  payload words w
+//       24   4 w  payload, uint32 words
+//    24+4w     8  checksum of the payload words (graph_file_checksum)
+//
+// Flags: cert_file_sp, the graph is in the class of the record; the class (cert_class) in the
+// bits at cert_file_class_shift; and cert_file_shared, for a certificate that is the one of the
+// group's record whose class is in the bits at cert_file_shared_shift, with an empty payload.
+//
+// Payload by kind; a path is its length followed by its vertices, terminal to terminal:
+//   none     empty (the graph could not be read)
+//   SP       size, then the postfix-ordered tree as parallel arrays source[size],
+//            sink[size], left[size], right[size] (UINT32_MAX for no child), then the
+//            (size + 3) / 4 bytes of 2-bit composition codes of sp_decomposition::comp_bits,
+//            zero-padded to a whole word
+//   K4       a b c d, paths ab ac ad bc bd cd
+//   K23      a b, paths one two three
+//   T4       c1 c2 a b, paths c1a c1b c2a c2b ab
+//   CUT3     v
+//   BICOMP3  c1 c2 c3
+//   GSP      as SP, for a tree that may also use dangling compositions (a generalized SP
+//            decomposition of a graph that is not SP), or a forest of one tree per component
+//            with an edge for a graph that is not connected
+//   OP       the number of blocks, the outer cycle of each as a path, then the rotation as a
+//            path of 2m vertices, the neighbours of vertex 0 in cyclic order, then those of
+//            vertex 1, ... (length 0 for none)
+//   DISC     u v, two vertices in different components
+//
+// The JSON encoding writes one object per graph and line instead, e.g.
+//   {"graph":0,"n":4,"sp":false,"kind":"K4","terminals":{"a":0,...},"paths":{"ab":[0,1],...},
+//    "gsp":false,"gsp_cert":{"kind":"K4","same_as":"sp"},"op":false,"op_cert":{...}}
+// with an SP tree as "tree":[[source,sink,"e"|"S"|"P"|"Q"|"D"],...] in postfix order, so each
+// internal node combines the two subtrees before it.
+
+constexpr char cert_file_magic[4] = {'G', 'S', 'P', 'C'};
+constexpr uint16_t cert_file_version = 2;
+constexpr uint32_t cert_file_sp = 1;
+constexpr uint32_t cert_file_shared = 2;
+constexpr int cert_file_class_shift = 8;
+constexpr int cert_file_shared_shift = 10;
+constexpr uint32_t cert_file_header_bytes = 24;
+constexpr uint32_t cert_file_trailer_bytes = 8;
+
+enum cert_kind : uint16_t {cert_none, cert_sp, cert_k4, cert_k23, cert_t4, cert_cut3, cert_bicomp3, cert_gsp, cert_op, cert_disc, cert_kinds};
+
+// indexed by cert_kind; the same tags as certificate::kind()
+constexpr char const * cert_kind_names[cert_kinds] = {"NONE", "SP", "K4", "K23", "T4", "CUT3", "BICOMP3", "GSP", "OP", "DISC"};
+
+inline cert_kind cert_kind_from_name(char const * name) {
+    for (int k = 0; k < cert_kinds; k++) {
+        if (std::strcmp(name, cert_kind_names[k]) == 0) return (cert_kind)(k);
+    }
+    return cert_none;
+}
+
+// the verdicts of a graph, in the order of its records
+enum cert_class : uint32_t {cert_class_sp, cert_class_gsp, cert_class_op, cert_classes};
+
+constexpr char const * cert_class_names[cert_classes] = {"sp", "gsp", "op"};
+
+enum class cert_encoding {binary, json};
+
+struct cert_file_header {
+    uint16_t version = cert_file_version;
+    uint16_t kind = cert_none;
+    uint32_t flags = 0;
+    uint32_t n = 0;
+    uint64_t payload_words = 0;
+};
+
+inline bool is_cert_file(char const * data, size_t size) {
+    return size >= sizeof(cert_file_magic) && std::memcmp(data, cert_file_magic, sizeof(cert_file_magic)) == 0;
+}
+
+inline void encode_cert_file_header(cert_file_header const& h, unsigned char * out) {
+    std::memcpy(out, cert_file_magic, sizeof(cert_file_magic));
+    store_little_endian<uint16_t>(out + 4, h.version);
+    store_little_endian<uint16_t>(out + 6, h.kind);
+    store_little_endian<uint32_t>(out + 8, h.flags);
+    store_little_endian<uint32_t>(out + 12, h.n);
+    store_little_endian<uint64_t>(out + 16, h.payload_words);
+}
+
+// graph_file_checksum computed one word at a time, for payloads that are streamed out
+class checksum_stream {
+public:
+    void push(uint32_t w) {
+        pending[count++ % 4] = w;
+        if (count % 4 == 0) {
+            for (int k = 0; k < 4; k++) lane[k] = (lane[k] ^ pending[k]) * prime;
+        }
+    }
+
+    uint64_t finish() const {
+        uint64_t l0 = lane[0];
+        for (uint64_t k = 0; k < count % 4; k++) l0 = (l0 ^ pending[k]) * prime;
+
+        uint64_t h = count;
+        h = (h ^ l0) * prime;
+        for (int k = 1; k < 4; k++) h = (h ^ lane[k]) * prime;
+        return h;
+    }
+
+private:
+    static constexpr uint64_t prime = 0x100000001b3ULL;
+    uint64_t lane[4] = {0xcbf29ce484222325ULL, 0x84222325cbf29ce4ULL, 0x9ce484222325cbf2ULL, 0x2325cbf29ce48422ULL};
+    uint32_t pending[4] = {};
+    uint64_t count = 0;
+};
+
+// ==================== BUFFERED WRITER ====================
+// Collects output in one large buffer and writes it to fd whenever it passes limit. Without an
+// fd the writer only accumulates, which lets batch workers encode into memory and hand the
+// bytes to the thread that owns the file.
+class buffered_writer {
+public:
+    explicit buffered_writer(int fd_ = -1, size_t limit_ = (size_t)(4) << 20) : fd{fd_}, limit{limit_} {}
+
+    buffered_writer(buffered_writer const& other) = delete;
+    buffered_writer& operator=(buffered_writer const& other) = delete;
+    buffered_writer(buffered_writer&& other) noexcept : fd{other.fd}, limit{other.limit}, buf{std::move(other.buf)}, failed{other.failed} {
+        other.fd = -1;
+    }
+
+    ~buffered_writer() {flush();}
+
+    void put(char c) {
+        buf += c;
+        flush_if_full();
+    }
+
+    void put(std::string_view s) {
+        buf += s;
+        flush_if_full();
+    }
+
+    void put_uint(uint64_t x) {
+        char digits[24];
+        buf.append(digits, (size_t)(std::to_chars(digits, digits + sizeof(digits), x).ptr - digits));
+        flush_if_full();
+    }
+
+    void put_int(long long x) {
+        char digits[24];
+        buf.append(digits, (size_t)(std::to_chars(digits, digits + sizeof(digits), x).ptr - digits));
+        flush_if_full();
+    }
+
+    void put_u32(uint32_t x) {
+        unsigned char bytes[4];
+        store_little_endian<uint32_t>(bytes, x);
+        buf.append((char const *)(bytes), 4);
+        flush_if_full();
+    }
+
+    void put_u64(uint64_t x) {
+        unsigned char bytes[8];
+        store_little_endian<uint64_t>(bytes, x);
+        buf.append((char const *)(bytes), 8);
+        flush_if_full();
+    }
+
+    void flush_if_full() {
+        if (fd >= 0 && buf.size() >= limit) flush();
+    }
+
+    // writes out everything buffered; returns false once any write has failed
+    bool flush() {
+        if (fd >= 0) {
+            size_t done = 0;
+            while (!failed && done < buf.size()) {
+                ssize_t k = ::write(fd, buf.data() + done, buf.size() - done);
+                if (k < 0 && errno == EINTR) continue;
+                if (k <= 0) failed = true;
+                else done += (size_t)(k);
+            }
+            buf.clear();
+        }
+        return !failed;
+    }
+
+    bool ok() const {return !failed;}
+
+    // the bytes not yet written; for a writer without an fd, everything put so far
+    std::string& buffer() {return buf;}
+
+private:
+    int fd;
+    size_t limit;
+    std::string buf;
+    bool failed = false;
+};
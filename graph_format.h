@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <bit>
+#include <string>
+#include <vector>
+
+// ==================== BINARY GRAPH FORMAT ====================
+// Shared by graph_generator (writer) and sp_recognition (reader). Every field is little-endian
+// and every array is 4-byte aligned, so a mapped file can be used in place.
+//
+//   offset  size  field
+//        0     4  magic "GSPB"
+//        4     2  version (graph_file_version)
+//        6     2  flags (graph_file_csr: payload is CSR, otherwise an edge array)
+//        8     4  header size in bytes (payload offset)
+//       12     4  reserved, 0
+//       16     8  n
+//       24     8  m
+//       32     8  checksum of the payload words (graph_file_checksum)
+//       40        payload, uint32 words:
+//                   edge array: u0 v0 u1 v1 ... (2m words, the same order as the text format)
+//                   CSR: n + 1 row offsets, then 2m neighbors; row v lists v's neighbors in
+//                        the order the text loader would produce for the same edge list
+
+constexpr char graph_file_magic[4] = {'G', 'S', 'P', 'B'};
+constexpr uint16_t graph_file_version = 1;
+constexpr uint16_t graph_file_csr = 1;
+constexpr uint32_t graph_file_header_bytes = 40;
+
+struct graph_file_header {
+    uint16_t version = graph_file_version;
+    uint16_t flags = 0;
+    uint32_t header_bytes = graph_file_header_bytes;
+    uint64_t n = 0;
+    uint64_t m = 0;
+    uint64_t checksum = 0;
+
+    uint64_t payload_words() const {
+        return (flags & graph_file_csr) ? n + 1 + 2 * m : 2 * m;
+    }
+};
+
+inline uint32_t to_little_endian(uint32_t x) {
+    if constexpr (std::endian::native == std::endian::little) return x;
+    return __builtin_bswap32(x);
+}
+
+inline uint64_t to_little_endian(uint64_t x) {
+    if constexpr (std::endian::native == std::endian::little) return x;
+    return __builtin_bswap64(x);
+}
+
+template <typename T>
+T load_little_endian(unsigned char const * p) {
+    T x;
+    std::memcpy(&x, p, sizeof(T));
+    if constexpr (sizeof(T) == 2 && std::endian::native != std::endian::little) return (T)(__builtin_bswap16(x));
+    if constexpr (sizeof(T) > 2) return to_little_endian(x);
+    return x;
+}
+
+template <typename T>
+void store_little_endian(unsigned char * p, T x) {
+    if constexpr (sizeof(T) == 2 && std::endian::native != std::endian::little) x = (T)(__builtin_bswap16(x));
+    if constexpr (sizeof(T) > 2) x = to_little_endian(x);
+    std::memcpy(p, &x, sizeof(T));
+}
+
+// FNV-1a over the payload words (host order) in four interleaved lanes
+inline uint64_t graph_file_checksum(uint32_t const * words, size_t count) {
+    const uint64_t prime = 0x100000001b3ULL;
+    uint64_t lane[4] = {0xcbf29ce484222325ULL, 0x84222325cbf29ce4ULL, 0x9ce484222325cbf2ULL, 0x2325cbf29ce48422ULL};
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        for (int k = 0; k < 4; k++) lane[k] = (lane[k] ^ words[i + k]) * prime;
+    }
+    for (; i < count; i++) lane[0] = (lane[0] ^ words[i]) * prime;
+
+    uint64_t h = count;
+    for (uint64_t l : lane) h = (h ^ l) * prime;
+    return h;
+}
+
+inline bool is_graph_file(char const * data, size_t size) {
+    return size >= sizeof(graph_file_magic) && std::memcmp(data, graph_file_magic, sizeof(graph_file_magic)) == 0;
+}
+
+inline void encode_graph_file_header(graph_file_header const& h, unsigned char * out) {
+    std::memcpy(out, graph_file_magic, sizeof(graph_file_magic));
+    store_little_endian<uint16_t>(out + 4, h.version);
+    store_little_endian<uint16_t>(out + 6, h.flags);
+    store_little_endian<uint32_t>(out + 8, h.header_bytes);
+    store_little_endian<uint32_t>(out + 12, 0);
+    store_little_endian<uint64_t>(out + 16, h.n);
+    store_little_endian<uint64_t>(out + 24, h.m);
+    store_little_endian<uint64_t>(out + 32, h.checksum);
+}
+
+inline bool decode_graph_file_header(char const * data, size_t size, graph_file_header& h, std::string& error) {
+    if (size < graph_file_header_bytes || !is_graph_file(data, size)) {
+        error = "truncated binary graph header";
+        return false;
+    }
+
+    unsigned char const * p = (unsigned char const *)(data);
+    h.version = load_little_endian<uint16_t>(p + 4);
+    h.flags = load_little_endian<uint16_t>(p + 6);
+    h.header_bytes = load_little_endian<uint32_t>(p + 8);
+    h.n = load_little_endian<uint64_t>(p + 16);
+    h.m = load_little_endian<uint64_t>(p + 24);
+    h.checksum = load_little_endian<uint64_t>(p + 32);
+
+    if (h.version != graph_file_version) {
+        error = "unsupported binary graph version " + std::to_string(h.version);
+        return false;
+    }
+    if (h.header_bytes < graph_file_header_bytes || h.header_bytes % 4 != 0) {
+        error = "malformed binary graph header";
+        return false;
+    }
+    if (h.n > 0x7fffffffULL || h.m > 0x3fffffffULL) {
+        error = "binary graph too large";
+        return false;
+    }
+    if (size < h.header_bytes || (size - h.header_bytes) / 4 < h.payload_words()) {
+        error = "truncated binary graph payload";
+        return false;
+    }
+    return true;
+}
+
+// Writes a graph given as an edge list (u0, v0, u1, v1, ...) in the binary format, either as
+// the edge array itself or as CSR rows built with the same counting order the loaders use.
+inline bool write_graph_file(std::FILE * out, uint32_t n, std::vector<uint32_t> const& endpoints, bool csr) {
+    graph_file_header h;
+    h.flags = csr ? graph_file_csr : 0;
+    h.n = n;
+    h.m = endpoints.size() / 2;
+
+    std::vector<uint32_t> payload;
+    if (csr) {
+        payload.assign((size_t)(h.payload_words()), 0);
+        uint32_t * offsets = payload.data();
+        uint32_t * targets = payload.data() + n + 1;
+        for (uint32_t v : endpoints) offsets[v + 1]++;
+        for (uint32_t v = 0; v < n; v++) offsets[v + 1] += offsets[v];
+
+        std::vector<uint32_t> cursor(offsets, offsets + n);
+        for (size_t i = 0; i + 1 < endpoints.size(); i += 2) {
+            targets[cursor[endpoints[i]]++] = endpoints[i + 1];
+            targets[cursor[endpoints[i + 1]]++] = endpoints[i];
+        }
+    } else {
+        payload = endpoints;
+    }
+
+    h.checksum = graph_file_checksum(payload.data(), payload.size());
+    if constexpr (std::endian::native != std::endian::little) {
+        for (uint32_t& w : payload) w = to_little_endian(w);
+    }
+
+    unsigned char header[graph_file_header_bytes];
+    encode_graph_file_header(h, header);
+    return std::fwrite(header, 1, sizeof(header), out) == sizeof(header)
+        && std::fwrite(payload.data(), sizeof(uint32_t), payload.size(), out) == payload.size();
+}
@@ -1,32 +1,73 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
+#include <string.h>
+#include <charconv>
 #include <iostream>
 #include <vector>
 #include <set>
 
+#include "graph_format.h"
+
 void print_usage(const char* program_name) {
-    printf("Usage: %s nC lC nK lK three_edges [seed]\n", program_name);
+    printf("Usage: %s [--binary | --csr] nC lC nK lK three_edges [seed]\n", program_name);
     printf("  nC: number of cycle subgraphs\n");
     printf("  lC: length of cycles (must be at least 3)\n");
     printf("  nK: number of complete subgraphs\n");
     printf("  lK: size of complete subgraphs (must be at least 3)\n");
     printf("  three_edges: connect with 3 edges instead of 2 (0=no, 1=yes)\n");
     printf("  seed: random seed (optional, uses current time if not provided)\n");
+    printf("  --binary: write the binary graph format (edge array) instead of text\n");
+    printf("  --csr: write the binary graph format with CSR rows\n");
+}
+
+// Formats the edge list into a large buffer flushed with fwrite.
+void write_text(long n, std::vector<std::pair<long, long>> const& edges) {
+    std::vector<char> buf(1 << 20);
+    size_t used = 0;
+    auto put = [&](long x, char sep) {
+        if (buf.size() - used < 32) {
+            fwrite(buf.data(), 1, used, stdout);
+            used = 0;
+        }
+        used = std::to_chars(buf.data() + used, buf.data() + buf.size(), x).ptr - buf.data();
+        buf[used++] = sep;
+    };
+
+    put(n, ' ');
+    put((long)edges.size(), '\n');
+    for (const auto& edge : edges) {
+        put(edge.first, ' ');
+        put(edge.second, '\n');
+    }
+    fwrite(buf.data(), 1, used, stdout);
 }
 
 int main(int argc, char* argv[]) {
-    if (argc < 6 || argc > 7) {
+    bool binary = false;
+    bool csr = false;
+    std::vector<char*> args;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--binary") == 0) {
+            binary = true;
+        } else if (strcmp(argv[i], "--csr") == 0) {
+            binary = csr = true;
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+
+    if (args.size() < 5 || args.size() > 6) {
         print_usage(argv[0]);
         return 1;
     }
 
-    long nC = atol(argv[1]);
-    long lC = atol(argv[2]);
-    long nK = atol(argv[3]);
-    long lK = atol(argv[4]);
-    long three_edges = atol(argv[5]);
-    long seed = (argc == 7) ? atol(argv[6]) : time(0);
+    long nC = atol(args[0]);
+    long lC = atol(args[1]);
+    long nK = atol(args[2]);
+    long lK = atol(args[3]);
+    long three_edges = atol(args[4]);
+    long seed = (args.size() == 6) ? atol(args[5]) : time(0);
 
     // Validating parameters
     if (lC < 3) {
@@ -151,9 +192,25 @@ int main(int argc, char* argv[]) {
         }
     }
 
-    std::cout << n << " " << unique_edges.size() << "\n";
-    for (const auto& edge : unique_edges) {
-        std::cout << edge.first << " " << edge.second << "\n";
+    if (binary) {
+        if (n > 0x7fffffffL) {
+            fprintf(stderr, "Error: binary format supports at most 2^31 - 1 vertices\n");
+            return 1;
+        }
+
+        std::vector<uint32_t> endpoints;
+        endpoints.reserve(2 * unique_edges.size());
+        for (const auto& edge : unique_edges) {
+            endpoints.push_back((uint32_t)edge.first);
+            endpoints.push_back((uint32_t)edge.second);
+        }
+
+        if (!write_graph_file(stdout, (uint32_t)n, endpoints, csr)) {
+            fprintf(stderr, "Error: failed to write binary graph\n");
+            return 1;
+        }
+    } else {
+        write_text(n, unique_edges);
     }
 
     return 0;
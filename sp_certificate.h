@@ -0,0 +1,1700 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <stack>
+#include <memory>
+#include <algorithm>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <span>
+
+#include "certificate_format.h"
+#include "sp_graph.h"
+
+// ==================== SP DECOMPOSITION TREE ====================
+enum class c_type {
+    edge, series, parallel, antiparallel, dangling
+};
+
+inline char c_type_char(c_type comp) {
+    switch (comp) {
+        case c_type::edge:
+            return 'e';
+        case c_type::series:
+            return 'S';
+        case c_type::parallel:
+            return 'P';
+        case c_type::antiparallel:
+            return 'Q';
+        case c_type::dangling:
+            return 'D';
+    }
+}
+
+constexpr uint32_t sp_no_node = UINT32_MAX;
+
+// Composition types of internal nodes packed two bits per node; a node without children is an
+// edge, so c_type::edge never needs to be stored.
+inline c_type unpack_comp(uint8_t const * bits, uint32_t i) {
+    return (c_type)(((bits[i >> 2] >> ((i & 3) * 2)) & 3) + 1);
+}
+
+inline void pack_comp(uint8_t * bits, uint32_t i, c_type comp) {
+    int shift = (int)(i & 3) * 2;
+    bits[i >> 2] = (uint8_t)((bits[i >> 2] & ~(3 << shift)) | ((((int)(comp) - 1) & 3) << shift));
+}
+
+// The decomposition tree of an SP certificate: parallel arrays in postfix order (left subtree,
+// right subtree, node), so the root is the last node and a single forward pass visits children
+// before parents. A GSP certificate of a graph that is not connected has a forest, one tree per
+// component with an edge, each in postfix order after the one before; a graph without edges has
+// none.
+// The arrays are plain fixed-width integers and may point into an arena, a file buffer or a
+// mapping. A certificate only reads them, as an sp_decomposition_view, which may map a
+// read-only file; an sp_decomposition is the writable form its builder fills first.
+template <bool Writable>
+struct basic_sp_decomposition {
+    template <typename T>
+    using array = std::span<std::conditional_t<Writable, T, T const>>;
+
+    uint32_t size = 0;
+    array<int> source;
+    array<int> sink;
+    array<uint32_t> left; // sp_no_node for edges
+    array<uint32_t> right;
+    array<uint8_t> comp_bits; // (size + 3) / 4 bytes
+
+    bool empty() const {return size == 0;}
+    uint32_t root() const {return size - 1;}
+    bool is_edge(uint32_t i) const {return left[i] == sp_no_node;}
+    c_type comp(uint32_t i) const {return is_edge(i) ? c_type::edge : unpack_comp(comp_bits.data(), i);}
+
+    operator basic_sp_decomposition<false>() const requires Writable {
+        return {size, source, sink, left, right, comp_bits};
+    }
+
+    // Rewrites every antiparallel node as a parallel one by reversing the subtree below its
+    // right child. A node is reversed when an odd number of its proper ancestors are
+    // antiparallel nodes it descends from on the right; parents come after children, so one
+    // backward pass hands each node its parity before the node itself is visited.
+    void deantiparallelize() requires Writable {
+        std::vector<char> flip(size, 0);
+        for (uint32_t i = size; i-- > 0;) {
+            if (is_edge(i)) {
+                if (flip[i]) std::swap(source[i], sink[i]);
+                continue;
+            }
+
+            bool anti = (comp(i) == c_type::antiparallel);
+            flip[left[i]] = flip[i];
+            flip[right[i]] = (char)(flip[i] ^ anti);
+            if (anti) pack_comp(comp_bits.data(), i, c_type::parallel);
+            if (flip[i]) {
+                std::swap(left[i], right[i]);
+                std::swap(source[i], sink[i]);
+            }
+        }
+    }
+};
+
+using sp_decomposition = basic_sp_decomposition<true>;
+using sp_decomposition_view = basic_sp_decomposition<false>;
+
+// Prints the subtree at node i of a pool or decomposition as {source comp sink}, with the
+// children on either side in verbose logging.
+template <typename Nodes>
+struct sp_subtree {
+    Nodes const& nodes;
+    uint32_t i;
+};
+
+template <typename Nodes>
+sp_subtree<Nodes> show(Nodes const& nodes, uint32_t i) {
+    return sp_subtree<Nodes>{nodes, i};
+}
+
+template <typename Nodes>
+std::ostream& operator<<(std::ostream& os, sp_subtree<Nodes> const& t) {
+    if (t.i == sp_no_node) return os << "(null tree)";
+    #ifdef __VERBOSE_LOGGING__
+    os << "{";
+    if (!t.nodes.is_edge(t.i)) os << show(t.nodes, t.nodes.left[t.i]);
+    os << t.nodes.source[t.i] << c_type_char(t.nodes.comp(t.i)) << t.nodes.sink[t.i];
+    if (!t.nodes.is_edge(t.i)) os << show(t.nodes, t.nodes.right[t.i]);
+    os << "}";
+    #else
+    os << "{" << t.nodes.source[t.i] << c_type_char(t.nodes.comp(t.i)) << t.nodes.sink[t.i] << "}";
+    #endif
+    return os;
+}
+
+// ==================== AUTHENTICATION CONTEXT ====================
+// Open-addressing set of the undirected edges of a graph, for O(1) expected adjacency tests
+// however long the adjacency lists are. A key packs the endpoints (smaller first) into 64 bits;
+// the table is a power of two at most half full, probed linearly.
+class edge_set {
+public:
+    void build(graph const& g) {
+        reset((size_t)(g.e));
+        for (int u = 0; u < g.n; u++) {
+            for (int v : g.adjLists[u]) {
+                if (u < v) insert(u, v);
+            }
+        }
+    }
+
+    // empties the set, sized for up to edges edges
+    void reset(size_t edges) {
+        int bits = 1;
+        while (((size_t)(1) << bits) < 2 * edges + 2) bits++;
+        shift = 64 - bits;
+        mask = ((size_t)(1) << bits) - 1;
+        slots.assign(mask + 1, empty_key);
+    }
+
+    void insert(int u, int v) {
+        uint64_t k = key(u, v);
+        size_t i = slot(k);
+        for (; slots[i] != empty_key && slots[i] != k; i = (i + 1) & mask);
+        slots[i] = k;
+    }
+
+    bool contains(int u, int v) const {
+        if (slots.empty()) return false;
+        uint64_t k = key(u, v);
+        for (size_t i = slot(k);; i = (i + 1) & mask) {
+            if (slots[i] == k) return true;
+            if (slots[i] == empty_key) return false;
+        }
+    }
+
+    size_t capacity() const {return slots.capacity();}
+
+private:
+    static constexpr uint64_t empty_key = UINT64_MAX; // not the key of any pair of ints
+    std::vector<uint64_t> slots;
+    size_t mask = 0;
+    int shift = 64;
+
+    static uint64_t key(int u, int v) {
+        if (u > v) std::swap(u, v);
+        return ((uint64_t)(uint32_t)(u) << 32) | (uint32_t)(v);
+    }
+
+    size_t slot(uint64_t k) const {return (size_t)((k * 0x9e3779b97f4a7c15ULL) >> shift);}
+};
+
+// Block-cut structure of a graph, from one iterative DFS over all its components. Every vertex
+// but a DFS root lies in the block of the tree edge to its parent (its parent block), and is
+// also in each block it heads, i.e. is the shallowest vertex of. Removing a vertex splits its
+// component into one piece per block it lies in, so cut vertices, the pieces left after a
+// removal and shared blocks all come out of three arrays in O(1).
+class block_cut_index {
+public:
+    void build(graph const& g) {
+        n = g.n;
+        components = 0;
+        component.assign((size_t)(n), -1);
+        parent_block.assign((size_t)(n), -1);
+        heads.assign((size_t)(n), 0);
+        block_head.clear();
+        dfs_no.assign((size_t)(n), 0);
+        low.assign((size_t)(n), 0);
+        parent.assign((size_t)(n), -1);
+
+        int counter = 0;
+        for (int r = 0; r < n; r++) {
+            if (dfs_no[r] != 0) continue;
+            components++;
+            component[r] = components - 1;
+            dfs_no[r] = low[r] = ++counter;
+            frames.emplace_back(r, 0);
+            vertices.push_back(r);
+
+            while (!frames.empty()) {
+                int w = frames.back().first;
+                size_t i = frames.back().second++;
+                if (i < g.adjLists[w].size()) {
+                    int u = g.adjLists[w][i];
+                    if (dfs_no[u] == 0) {
+                        parent[u] = w;
+                        component[u] = component[w];
+                        dfs_no[u] = low[u] = ++counter;
+                        frames.emplace_back(u, 0);
+                        vertices.push_back(u);
+                    } else if (u != parent[w] && dfs_no[u] < low[w]) {
+                        low[w] = dfs_no[u];
+                    }
+                    continue;
+                }
+
+                frames.pop_back();
+                int p = parent[w];
+                if (p == -1) {
+                    vertices.pop_back();
+                    continue;
+                }
+
+                if (low[w] < low[p]) low[p] = low[w];
+                if (low[w] >= dfs_no[p]) {
+                    // p heads a new block: w and the vertices discovered below it since
+                    int block = (int)(block_head.size());
+                    block_head.push_back(p);
+                    heads[p]++;
+                    int x;
+                    do {
+                        x = vertices.back();
+                        vertices.pop_back();
+                        parent_block[x] = block;
+                    } while (x != w);
+                }
+            }
+        }
+    }
+
+    bool contains(int v) const {return v >= 0 && v < n;}
+
+    // blocks v lies in; 0 for an isolated vertex
+    int blocks(int v) const {return heads[v] + (parent_block[v] != -1);}
+
+    bool is_cut_vertex(int v) const {return contains(v) && blocks(v) >= 2;}
+
+    // whether one block contains a, b and c; such a block is the parent block of all of them
+    // but at most one, its head
+    bool share_block(int a, int b, int c) const {
+        if (!contains(a) || !contains(b) || !contains(c)) return false;
+        for (int block : {parent_block[a], parent_block[b], parent_block[c]}) {
+            if (block != -1 && in_block(a, block) && in_block(b, block) && in_block(c, block)) return true;
+        }
+        return false;
+    }
+
+    int block_count() const {return (int)(block_head.size());}
+
+    // isolated vertices included
+    int component_count() const {return components;}
+
+    int component_of(int v) const {return component[v];}
+
+    // -1 for a DFS root
+    int parent_block_of(int v) const {return parent_block[v];}
+
+    // the block of the edge uv: the parent block of an endpoint the other one heads or shares
+    int edge_block(int u, int v) const {
+        if (parent_block[v] != -1 && in_block(u, parent_block[v])) return parent_block[v];
+        return parent_block[u];
+    }
+
+private:
+    int n = 0;
+    int components = 0;
+    std::vector<int> component; // in order of the smallest vertex
+    std::vector<int> parent_block; // -1 for DFS roots
+    std::vector<int> heads; // number of blocks each vertex heads
+    std::vector<int> block_head;
+
+    // DFS scratch
+    std::vector<int> dfs_no;
+    std::vector<int> low;
+    std::vector<int> parent;
+    std::vector<std::pair<int, size_t>> frames;
+    std::vector<int> vertices;
+
+    bool in_block(int v, int block) const {return parent_block[v] == block || block_head[block] == v;}
+};
+
+// Indexes over the graph being authenticated, shared by the certificate checks. Each index is
+// built on first use, and prepare() drops them for the next graph while keeping their buffers.
+struct auth_context {
+    void prepare() {
+        edges_ready = false;
+        blocks_ready = false;
+        scanned = 0;
+    }
+
+    block_cut_index const& block_cut(graph const& g) {
+        if (!blocks_ready) {
+            blocks.build(g);
+            blocks_ready = true;
+        }
+        return blocks;
+    }
+
+    // Scans the shorter adjacency list until the scans of this graph add up to a few times its
+    // size, then builds the edge set in O(n + m) and answers in O(1) from there on. Either way
+    // the adjacency tests of a graph cost O(n + m) in total, and certificates whose paths avoid
+    // high-degree vertices never pay for the set.
+    bool adjacent(graph const& g, int u, int v) {
+        if (edges_ready) return edges.contains(u, v);
+
+        if (g.degree(u) > g.degree(v)) std::swap(u, v);
+        scanned += g.degree(u);
+        if (scanned > scan_budget * ((long long)(g.n) + g.e)) {
+            edges.build(g);
+            edges_ready = true;
+            return edges.contains(u, v);
+        }
+
+        for (int w : g.adjLists[u]) {
+            if (w == v) return true;
+        }
+        return false;
+    }
+
+private:
+    static constexpr long long scan_budget = 4;
+    edge_set edges;
+    bool edges_ready = false;
+    long long scanned = 0;
+    block_cut_index blocks;
+    bool blocks_ready = false;
+};
+
+// ==================== AUXILIARY FUNCTIONS ====================
+// Checks that path runs from end1 to end2 (either way round) along edges of g. The caller marks
+// every terminal of its certificate in seen before the first path, and each path marks its
+// internal vertices, so no path passes through a terminal or shares a vertex with another.
+inline bool trace_path(int end1, int end2, std::span<int const> path, graph const& g, auth_context& ctx, std::vector<bool>& seen) {
+    #ifdef __VERBOSE_LOGGING__
+    for (int v : path) {
+        V_LOG(v << " ")
+    }
+    #endif
+    
+    N_LOG("\n")
+    if (path.size() < 2) {
+        L_LOG("====== AUTH FAILED: no edges in path ======\n")
+        return false;
+    }
+
+    if (path[0] == end2) {
+        int tmp = end2;
+        end2 = end1;
+        end1 = tmp;
+    }
+
+    if (path[0] != end1) {
+        L_LOG("====== AUTH FAILED: start of path does not match either endpoint ======\n")
+        return false;
+    }
+
+    if (path.back() != end2) {
+        L_LOG("====== AUTH FAILED: end of path does not match second endpoint ======\n")
+        return false;
+    }
+
+    for (int v : path) {
+        if (v < 0 || v >= g.n) {
+            L_LOG("====== AUTH FAILED: vertex " << v << " is not in graph ======\n")
+            return false;
+        }
+    }
+
+    for (size_t i = 1; i < path.size(); i++) {
+        if (!ctx.adjacent(g, path[i - 1], path[i])) {
+            L_LOG("====== AUTH FAILED: edge (" << path[i - 1] << ", " << path[i] << ") does not exist in graph ======\n")
+            return false;
+        }
+
+        if (i + 1 == path.size()) break;
+        if (seen[path[i]]) {
+            L_LOG("====== AUTH FAILED: duplicated vertex or terminal " << path[i] << " inside path ======\n")
+            return false;
+        }
+
+        seen[path[i]] = true;
+    }
+
+    N_LOG("path good\n")
+    return true;
+}
+
+inline bool is_cut_vertex(graph const& g, auth_context& ctx, int v) {
+    if (!ctx.block_cut(g).is_cut_vertex(v)) {
+        L_LOG("\n====== AUTH FAILED: " << v << " not a cut vertex ======\n\n")
+        return false;
+    }
+    N_LOG("yes\n")
+    return true;
+}
+
+// ==================== CERTIFICATE DEFINITIONS ====================
+// Receives the parts of a certificate in the order of the exported record (see
+// certificate_format.h): terminals, then paths, then the decomposition tree.
+struct certificate_encoder {
+    virtual void terminal(char const * name, int v) = 0;
+    virtual void path(char const * name, std::span<int const> vertices) = 0;
+    virtual void tree(sp_decomposition_view const& d) = 0;
+    virtual ~certificate_encoder() {}
+};
+
+struct certificate {
+    bool verified = false;
+    virtual bool authenticate(graph const& g, auth_context& ctx) = 0;
+    virtual char const * kind() const = 0; // short tag used in batch result records
+    virtual void encode(certificate_encoder& out) const = 0;
+    virtual ~certificate() {}
+};
+
+// The paths of the obstructions below are vertex sequences between their terminals; they may
+// point into an arena, like the arrays of an outer_embedding.
+struct negative_cert_K4 : certificate {
+    int a, b, c, d;
+    std::span<int> ab, ac, ad, bc, bd, cd;
+
+    char const * kind() const override {return "K4";}
+
+    void encode(certificate_encoder& out) const override {
+        out.terminal("a", a);
+        out.terminal("b", b);
+        out.terminal("c", c);
+        out.terminal("d", d);
+        out.path("ab", ab);
+        out.path("ac", ac);
+        out.path("ad", ad);
+        out.path("bc", bc);
+        out.path("bd", bd);
+        out.path("cd", cd);
+    }
+
+    bool authenticate(graph const& g, auth_context& ctx) override {
+        if (verified) return true;
+
+        L_LOG("====== AUTHENTICATE K4: terminating vertices a: " << a << ", b: " << b << ", c: " << c << ", d: " << d << " ======\n")
+        if (a == b || b == c || c == d || d == a || a == c || b == d) {
+            L_LOG("====== AUTH FAILED: terminating vertices non-distinct ======\n\n")
+            return false;
+        }
+        if (a < 0 || a >= g.n || b < 0 || b >= g.n || c < 0 || c >= g.n || d < 0 || d >= g.n) {
+            L_LOG("====== AUTH FAILED: terminating vertex not in graph ======\n\n")
+            return false;
+        }
+        std::vector<bool> seen((size_t)(g.n), false);
+        for (int v : {a, b, c, d}) seen[v] = true;
+
+        N_LOG("verify ab: ")
+        if (!trace_path(a, b, ab, g, ctx, seen)) return false;
+        N_LOG("verify ac: ")
+        if (!trace_path(a, c, ac, g, ctx, seen)) return false;
+        N_LOG("verify ad: ")
+        if (!trace_path(a, d, ad, g, ctx, seen)) return false;
+        N_LOG("verify bc: ")
+        if (!trace_path(b, c, bc, g, ctx, seen)) return false;
+        N_LOG("verify bd: ")
+        if (!trace_path(b, d, bd, g, ctx, seen)) return false;
+        N_LOG("verify cd: ")
+        if (!trace_path(c, d, cd, g, ctx, seen)) return false;
+
+        L_LOG("====== AUTH SUCCESS ======\n\n")
+        verified = true;
+        return true;
+    }
+};
+
+struct negative_cert_K23 : certificate {
+    int a, b;
+    std::span<int> one, two, three;
+
+    char const * kind() const override {return "K23";}
+
+    void encode(certificate_encoder& out) const override {
+        out.terminal("a", a);
+        out.terminal("b", b);
+        out.path("one", one);
+        out.path("two", two);
+        out.path("three", three);
+    }
+
+    bool authenticate(graph const& g, auth_context& ctx) override {
+        if (verified) return true;
+
+        L_LOG("====== AUTHENTICATE K23: terminating vertices a: " << a << ", b: " << b << " ======\n")
+
+        if (a == b) {
+            L_LOG("====== AUTH FAILED: terminating vertices non-distinct ======\n\n")
+            return false;
+        }
+
+        if (a < 0 || a >= g.n || b < 0 || b >= g.n) {
+            L_LOG("====== AUTH FAILED: terminating vertex not in graph ======\n\n")
+            return false;
+        }
+        std::vector<bool> seen((size_t)(g.n), false);
+        seen[a] = seen[b] = true;
+
+        N_LOG("verify path one: ")
+        if (!trace_path(a, b, one, g, ctx, seen)) return false;
+        if (one.size() < 3) {
+            L_LOG("\n====== AUTH FAILED: path one has no internal vertex ======\n\n")
+            return false;
+        }
+
+        N_LOG("verify path two: ")
+        if (!trace_path(a, b, two, g, ctx, seen)) return false;
+        if (two.size() < 3) {
+            L_LOG("\n====== AUTH FAILED: path two has no internal vertex ======\n\n")
+            return false;
+        }
+
+        N_LOG("verify path three: ")
+        if (!trace_path(a, b, three, g, ctx, seen)) return false;
+        if (three.size() < 3) {
+            L_LOG("\n====== AUTH FAILED: path three has no internal vertex ======\n\n")
+            return false;
+        }
+
+        L_LOG("====== AUTH SUCCESS ======\n\n")
+        verified = true;
+        return true;
+    }
+};
+
+struct negative_cert_T4 : certificate {
+    int c1, c2, a, b;
+    std::span<int> c1a, c1b, c2a, c2b, ab;
+
+    char const * kind() const override {return "T4";}
+
+    void encode(certificate_encoder& out) const override {
+        out.terminal("c1", c1);
+        out.terminal("c2", c2);
+        out.terminal("a", a);
+        out.terminal("b", b);
+        out.path("c1a", c1a);
+        out.path("c1b", c1b);
+        out.path("c2a", c2a);
+        out.path("c2b", c2b);
+        out.path("ab", ab);
+    }
+
+    bool authenticate(graph const& g, auth_context& ctx) override {
+        if (verified) return true;
+        L_LOG("====== AUTHENTICATE T4: terminating vertices a: " << a << ", b: " << b << ", c1: " << c1 << ", c2: " << c2 << " ======\n")
+
+        if (a == b || a == c1 || a == c2 || b == c1 || b == c2 || c1 == c2) {
+            L_LOG("====== AUTH FAILED: terminating vertices non-distinct ======\n\n")
+            return false;
+        }
+
+        N_LOG("verify c1 cut vertex: ")
+        if (!is_cut_vertex(g, ctx, c1)) return false;
+        N_LOG("verify c2 cut vertex: ")
+        if (!is_cut_vertex(g, ctx, c2)) return false;
+
+        if (a < 0 || a >= g.n || b < 0 || b >= g.n) {
+            L_LOG("====== AUTH FAILED: terminating vertex not in graph ======\n\n")
+            return false;
+        }
+        std::vector<bool> seen((size_t)(g.n), false);
+        for (int v : {c1, c2, a, b}) seen[v] = true;
+        N_LOG("verify path c1a: ")
+        if (!trace_path(c1, a, c1a, g, ctx, seen)) return false;
+        N_LOG("verify path c2a: ")
+        if (!trace_path(c2, a, c2a, g, ctx, seen)) return false;
+        N_LOG("verify path ab: ")
+        if (!trace_path(a, b, ab, g, ctx, seen)) return false;
+        N_LOG("verify path c1b: ")
+        if (!trace_path(c1, b, c1b, g, ctx, seen)) return false;
+        N_LOG("verify path c2b: ")
+        if (!trace_path(c2, b, c2b, g, ctx, seen)) return false;
+
+        L_LOG("====== AUTH SUCCESS ======\n\n")
+        verified = true;
+        return true;
+    }
+};
+
+struct negative_cert_tri_comp_cut : certificate {
+    int v;
+
+    char const * kind() const override {return "CUT3";}
+
+    void encode(certificate_encoder& out) const override {out.terminal("v", v);}
+
+    bool authenticate(graph const& g, auth_context& ctx) override {
+        if (verified) return true;
+        L_LOG("====== AUTHENTICATE THREE-COMPONENT CUT VERTEX: " << v << " ======\n")
+
+        // only the pieces of v's own component count: other components are no reason
+        block_cut_index const& bc = ctx.block_cut(g);
+        int comps = (bc.contains(v) ? bc.blocks(v) : 0);
+
+        if (comps < 3) {
+            L_LOG("====== AUTH FAILED: vertex " << v << " only splits its component into " << comps << " components ======\n\n")
+            return false;
+        }
+
+        N_LOG(comps << " comps after removal\n")
+        L_LOG("====== AUTH SUCCESS ======\n\n")
+
+        verified = true;
+        return true;
+    }
+};
+
+struct negative_cert_tri_cut_comp : certificate {
+    int c1, c2, c3;
+
+    char const * kind() const override {return "BICOMP3";}
+
+    void encode(certificate_encoder& out) const override {
+        out.terminal("c1", c1);
+        out.terminal("c2", c2);
+        out.terminal("c3", c3);
+    }
+
+    bool authenticate(graph const& g, auth_context& ctx) override {
+        if (verified) return true;
+        L_LOG("====== AUTHENTICATE BICOMP WITH THREE CUT VERTICES: cut vertices " << c1 << ", " << c2 << ", " << c3 << " ======\n")
+        if (c1 == c2 || c1 == c3 || c2 == c3) {
+            L_LOG("====== AUTH FAILED: cut vertices non-distinct ======\n\n")
+            return false;
+        }
+        N_LOG("verify c1 cut vertex: ")
+        if (!is_cut_vertex(g, ctx, c1)) return false;
+        N_LOG("verify c2 cut vertex: ")
+        if (!is_cut_vertex(g, ctx, c2)) return false;
+        N_LOG("verify c3 cut vertex: ")
+        if (!is_cut_vertex(g, ctx, c3)) return false;
+
+        if (ctx.block_cut(g).share_block(c1, c2, c3)) {
+            N_LOG("vertices belong to one biconnected component...\n")
+            L_LOG("====== AUTH SUCCESS ======\n\n")
+            verified = true;
+            return true;
+        }
+
+        L_LOG("====== AUTH FAILED: bicomp does not contain the three cut vertices ======\n\n")
+        return false;
+    }
+};
+
+// An SP graph is connected, so two vertices in different components refute it.
+struct negative_cert_disconnected : certificate {
+    int u, v;
+
+    char const * kind() const override {return "DISC";}
+
+    void encode(certificate_encoder& out) const override {
+        out.terminal("u", u);
+        out.terminal("v", v);
+    }
+
+    bool authenticate(graph const& g, auth_context& ctx) override {
+        if (verified) return true;
+        L_LOG("====== AUTHENTICATE DISCONNECTED: vertices " << u << ", " << v << " ======\n")
+        if (u < 0 || u >= g.n || v < 0 || v >= g.n) {
+            L_LOG("====== AUTH FAILED: vertex not in graph ======\n\n")
+            return false;
+        }
+
+        block_cut_index const& bc = ctx.block_cut(g);
+        if (bc.component_of(u) == bc.component_of(v)) {
+            L_LOG("====== AUTH FAILED: " << u << " and " << v << " are in one component ======\n\n")
+            return false;
+        }
+
+        L_LOG("====== AUTH SUCCESS ======\n\n")
+        verified = true;
+        return true;
+    }
+};
+
+struct positive_cert_sp : certificate {
+    sp_decomposition_view decomposition;
+    bool is_sp;
+
+    char const * kind() const override {return is_sp ? "SP" : "GSP";}
+
+    void encode(certificate_encoder& out) const override {out.tree(decomposition);}
+
+    bool authenticate(graph const& g, auth_context& ctx) override {
+        if (verified) return true;
+
+        std::vector<int> n_src((size_t)(g.n), 0);
+        std::vector<int> n_sink((size_t)(g.n), 0);
+        std::vector<bool> no_edge((size_t)(g.n), false);
+
+        std::vector<int> g2_endpoints;
+        g2_endpoints.reserve((size_t)(g.e) * 2);
+
+        L_LOG("====== AUTHENTICATE SP DECOMPOSITION TREE ======\n")
+        if (decomposition.empty() && g.e > 0) {
+            L_LOG("====== AUTH FAILED: decomposition tree does not exist ======\n\n")
+            return false;
+        }
+
+        // Check that the arrays form trees in postfix order, and hand every node the parity of
+        // the antiparallel compositions above it: inside the right child of an antiparallel
+        // node, sources and sinks are read swapped.
+        uint32_t size = decomposition.size;
+        std::vector<char> swapped(size, 0);
+        std::vector<char> has_parent(size, 0);
+        for (uint32_t i = size; i-- > 0;) {
+            uint32_t l = decomposition.left[i];
+            uint32_t r = decomposition.right[i];
+            if ((l == sp_no_node) != (r == sp_no_node)) {
+                L_LOG("====== AUTH FAILED: node " << show(decomposition, i) << " malformed (one child) ======\n\n")
+                return false;
+            }
+            if (l == sp_no_node) continue;
+
+            if (l >= i || r >= i || l == r || has_parent[l] || has_parent[r]) {
+                L_LOG("====== AUTH FAILED: node " << i << " malformed (children not earlier, unshared nodes) ======\n\n")
+                return false;
+            }
+            has_parent[l] = has_parent[r] = 1;
+            swapped[l] = swapped[i];
+            swapped[r] = (char)(swapped[i] ^ (decomposition.comp(i) == c_type::antiparallel));
+        }
+        // An SP graph is connected and has one tree, none for a single vertex. A GSP tree may be
+        // a forest: trees that together give G, each edge in one of them, are its components
+        // when there are as many as G has components with an edge.
+        block_cut_index const& bc = ctx.block_cut(g);
+        int trees = 0;
+        int isolated = 0;
+        for (uint32_t i = 0; i < size; i++) trees += !has_parent[i];
+        for (int v = 0; v < g.n; v++) isolated += (g.degree(v) == 0);
+        if (is_sp && bc.component_count() != 1) {
+            L_LOG("====== AUTH FAILED: an SP tree for a graph of " << bc.component_count() << " components ======\n\n")
+            return false;
+        }
+        if (trees != bc.component_count() - isolated) {
+            L_LOG("====== AUTH FAILED: " << trees << " decomposition trees for " << bc.component_count() - isolated << " components with an edge ======\n\n")
+            return false;
+        }
+
+        for (uint32_t i = 0; i < size; i++) {
+            V_LOG("traversal: " << show(decomposition, i) << "\n")
+            bool swap = swapped[i];
+            int source = (swap ? decomposition.sink[i] : decomposition.source[i]);
+            int sink = (swap ? decomposition.source[i] : decomposition.sink[i]);
+
+            if (decomposition.is_edge(i)) {
+                if (source < 0 || source >= g.n || sink < 0 || sink >= g.n) {
+                    L_LOG("====== AUTH FAILED: edge node " << show(decomposition, i) << " is not on G's vertices ======\n\n")
+                    return false;
+                }
+
+                if (no_edge[source] || no_edge[sink]) {
+                    L_LOG("====== AUTH FAILED: edge node " << show(decomposition, i) << " is incident on an vertex already merged into a series SP subgraph ======\n\n")
+                    return false;
+                }
+
+                g2_endpoints.push_back(source);
+                g2_endpoints.push_back(sink);
+                n_src[source]++;
+                n_sink[sink]++;
+                continue;
+            }
+
+            uint32_t l = decomposition.left[i];
+            uint32_t r = decomposition.right[i];
+            int lsource = (swap ? decomposition.sink[r] : decomposition.source[l]);
+            int lsink = (swap ? decomposition.source[r] : decomposition.sink[l]);
+            int rsource = (swap ? decomposition.sink[l] : decomposition.source[r]);
+            int rsink = (swap ? decomposition.source[l] : decomposition.sink[r]);
+
+            switch (decomposition.comp(i)) {
+                case c_type::edge:
+                    break;
+                case c_type::series:
+                    if (lsource != source || rsink != sink || lsink != rsource) {
+                        L_LOG("====== AUTH FAILED: node " << show(decomposition, i) << " malformed (series children source/sink mismatch) ======\n\n")
+                        return false;
+                    }
+
+                    if (n_src[lsink] != 1 || n_sink[lsink] != 1) {
+                        L_LOG("====== AUTH FAILED: series node " << show(decomposition, i) << " has incident edges on its middle vertex " << lsink << " which cannot be merged into it ======\n\n")
+                        return false;
+                    }
+
+                    V_LOG("BLOCKING: " << lsink << "\n")
+                    no_edge[lsink] = true;
+                    n_src[lsink]--;
+                    n_sink[lsink]--;
+                    break;
+                case c_type::parallel:
+                    if (lsource != source || rsource != source || lsink != sink || rsink != sink) {
+                        L_LOG("====== AUTH FAILED: node " << show(decomposition, i) << " malformed (parallel children source/sink mismatch) ======\n\n")
+                        return false;
+                    }
+
+                    n_src[source]--;
+                    n_sink[sink]--;
+                    break;
+                case c_type::antiparallel:
+                    if (swap) {
+                        if (lsource != sink || rsource != source || lsink != source || rsink != sink) {
+                            L_LOG("====== AUTH FAILED: node " << show(decomposition, i) << " malformed (antiparallel children source/sink mismatch) ======\n\n")
+                            return false;
+                        }
+                    } else {
+                        if (lsource != source || rsource != sink || lsink != sink || rsink != source) {
+                            L_LOG("====== AUTH FAILED: node " << show(decomposition, i) << " malformed (antiparallel children source/sink mismatch) ======\n\n")
+                            return false;
+                        }
+                    }
+
+                    n_src[source]--;
+                    n_sink[sink]--;
+                    break;
+                case c_type::dangling:
+                    if (is_sp) {
+                        L_LOG("====== AUTH FAILED: illegal dangling composition in SP decomposition tree ======\n\n")
+                        return false;
+                    }
+
+                    if (swap) {
+                        if (rsource != source || rsink != sink || lsink != sink) {
+                            L_LOG("====== AUTH FAILED: node " << show(decomposition, i) << " malformed (dangling children source/sink mismatch) ======\n\n")
+                            return false;
+                        }
+                    } else {
+                        if (lsource != source || lsink != sink || rsource != source) {
+                            L_LOG("====== AUTH FAILED: node " << show(decomposition, i) << " malformed (dangling children source/sink mismatch) ======\n\n")
+                            return false;
+                        }
+                    }
+
+                    if (swap) {
+                        n_src[lsource]--;
+                        n_sink[sink]--;
+                    } else {
+                        n_src[source]--;
+                        n_sink[rsink]--;
+                    }
+
+                    break;
+            }
+        }
+
+        N_LOG("decomposition tree well-formed...\n")
+        for (uint32_t i = 0; i < size; i++) {
+            if (has_parent[i]) continue;
+            n_src[decomposition.source[i]]--;
+            n_sink[decomposition.sink[i]]--;
+        }
+
+        bool failed = false;
+        for (int i = 0; i < g.n; i++) {
+            if (n_src[i] != 0) {
+                N_LOG("OH NO: disconnected SP subgraph sourced at vertex " << i << "\n")
+                failed = true;
+            }
+            
+            if (n_sink[i] != 0) {
+                N_LOG("OH NO: disconnected SP subgraph sinked at vertex " << i << "\n")
+                failed = true;
+            }
+        }
+
+        if (failed) {
+            L_LOG("====== AUTH FAILED: additional disconnected SP subgraphs are part of the decomposition tree ======\n\n")
+            return false;
+        }
+
+        N_LOG("decomposition tree connected...\n")
+
+        graph g2;
+        std::string error;
+        if (!build_graph(g.n, (int)(g2_endpoints.size() / 2), g2_endpoints, g2, error, 1)) {
+            L_LOG("====== AUTH FAILED: decomposition tree does not produce a graph on G's vertices (" << error << ") ======\n\n")
+            return false;
+        }
+
+        // G and g2 are equal when every vertex has the same neighbour multiset in both: count
+        // its neighbours in G up and those in g2 down. With equal degrees, no count dropping
+        // below zero means the multisets match, and it also leaves every count back at zero.
+        std::vector<int> count((size_t)(g.n), 0);
+        for (int i = 0; i < g.n; i++) {
+            bool same = (g.degree(i) == g2.degree(i));
+            if (same) {
+                for (int w : g.adjLists[i]) count[w]++;
+                for (int w : g2.adjLists[i]) {
+                    if (count[w]-- == 0) same = false;
+                }
+            }
+
+            if (!same) {
+                L_LOG("====== AUTH FAILED: vertex " << i << " of G does not have the same adjacency list as the one produced by the decomposition tree ======\n\n")
+
+                #ifdef __LOGGING__
+                N_LOG("ORIGINAL GRAPH: ")
+                g.output_adj_list(i, std::cout);
+                N_LOG("PRODUCED GRAPH: ")
+                g2.output_adj_list(i, std::cout);
+                #endif
+
+                L_LOG("======================================================================\n\n")
+                return false;
+            }
+        }
+
+        N_LOG("decomposition tree produces graph identical to G...\n")
+        L_LOG("====== AUTH SUCCESS ======\n\n")
+
+        verified = true;
+        return true;
+    }
+};
+
+// An outerplanar embedding: the outer cycle of every block, and the rotation system the cycles
+// induce. A bridge is a block whose cycle is just its two ends. The rotation lists the
+// neighbours of each vertex in cyclic order, at the offsets of its adjacency list in the graph.
+// The arrays may point into an arena.
+struct outer_embedding {
+    std::span<int> cycle_offsets; // where each cycle starts, then where the last one ends
+    std::span<int> cycles;
+    std::span<int> rotation;
+
+    int blocks() const {return cycle_offsets.empty() ? 0 : (int)(cycle_offsets.size()) - 1;}
+
+    std::span<int const> cycle(int block) const {
+        return {cycles.data() + cycle_offsets[block], (size_t)(cycle_offsets[block + 1] - cycle_offsets[block])};
+    }
+};
+
+struct positive_cert_op : certificate {
+    outer_embedding embedding;
+
+    char const * kind() const override {return "OP";}
+
+    void encode(certificate_encoder& out) const override {
+        out.terminal("blocks", embedding.blocks());
+        for (int b = 0; b < embedding.blocks(); b++) {
+            out.path(("block" + std::to_string(b)).c_str(), embedding.cycle(b));
+        }
+        out.path("rotation", embedding.rotation);
+    }
+
+    // A graph is outerplanar if every block has a Hamiltonian cycle whose chords do not cross.
+    // Each cycle must stay in one block, a different one for each cycle, and cover all of its
+    // vertices; the chords of the block, as intervals of cycle positions, must then nest, which
+    // a stack checks in one pass over them sorted by left end, longer ones first. Both sorts are
+    // counting sorts, so the whole check is O(n + m). The rotation only has to be a permutation
+    // of every adjacency list.
+    bool authenticate(graph const& g, auth_context& ctx) override {
+        if (verified) return true;
+
+        L_LOG("====== AUTHENTICATE OUTERPLANAR EMBEDDING ======\n")
+        block_cut_index const& bc = ctx.block_cut(g);
+        int blocks = bc.block_count();
+        if (embedding.blocks() != blocks) {
+            L_LOG("====== AUTH FAILED: " << embedding.blocks() << " outer cycles for " << blocks << " blocks ======\n\n")
+            return false;
+        }
+        for (int b = 0; b < blocks; b++) {
+            if (embedding.cycle_offsets[b] < 0 || embedding.cycle_offsets[b] > embedding.cycle_offsets[b + 1]) {
+                L_LOG("====== AUTH FAILED: malformed cycle offsets ======\n\n")
+                return false;
+            }
+        }
+        if (blocks > 0 && (size_t)(embedding.cycle_offsets[blocks]) != embedding.cycles.size()) {
+            L_LOG("====== AUTH FAILED: malformed cycle offsets ======\n\n")
+            return false;
+        }
+
+        // the order of every block, and its edges bucketed by block
+        std::vector<int> order((size_t)(blocks), 1);
+        for (int v = 0; v < g.n; v++) {
+            if (bc.parent_block_of(v) != -1) order[bc.parent_block_of(v)]++;
+        }
+        std::vector<int> edge_start((size_t)(blocks) + 1, 0);
+        for (int u = 0; u < g.n; u++) {
+            for (int v : g.adjLists[u]) {
+                if (u < v) edge_start[bc.edge_block(u, v) + 1]++;
+            }
+        }
+        for (int b = 0; b < blocks; b++) edge_start[b + 1] += edge_start[b];
+        std::vector<edge_t> edges((size_t)(edge_start[blocks]));
+        std::vector<int> next(edge_start.begin(), edge_start.end() - 1);
+        for (int u = 0; u < g.n; u++) {
+            for (int v : g.adjLists[u]) {
+                if (u < v) edges[next[bc.edge_block(u, v)]++] = edge_t{u, v};
+            }
+        }
+
+        std::vector<int> cycle_of((size_t)(blocks), -1);
+        std::vector<int> pos((size_t)(g.n), -1);
+        std::vector<int> count((size_t)(g.n) + 1);
+        std::vector<edge_t> chords;
+        std::vector<edge_t> sorted;
+        std::vector<edge_t> open;
+
+        // stable counting sort of from into to by key, which is below k
+        auto sort_by = [&](std::vector<edge_t> const& from, std::vector<edge_t>& to, int k, auto key) {
+            std::fill(count.begin(), count.begin() + k + 1, 0);
+            for (edge_t const& x : from) count[key(x) + 1]++;
+            for (int i = 0; i < k; i++) count[i + 1] += count[i];
+            to.resize(from.size());
+            for (edge_t const& x : from) to[count[key(x)]++] = x;
+        };
+
+        for (int c = 0; c < blocks; c++) {
+            std::span<int const> cycle = embedding.cycle(c);
+            int k = (int)(cycle.size());
+            for (int v : cycle) {
+                if (v < 0 || v >= g.n) {
+                    L_LOG("====== AUTH FAILED: vertex " << v << " is not in graph ======\n\n")
+                    return false;
+                }
+            }
+            if (k < 2) {
+                L_LOG("====== AUTH FAILED: outer cycle " << c << " has fewer than two vertices ======\n\n")
+                return false;
+            }
+
+            int block = -1;
+            for (int i = 0; i < k; i++) {
+                int u = cycle[i];
+                int v = cycle[(i + 1) % k];
+                if (pos[u] != -1) {
+                    L_LOG("====== AUTH FAILED: vertex " << u << " repeated on outer cycle " << c << " ======\n\n")
+                    return false;
+                }
+                pos[u] = i;
+                if (k == 2 && i == 1) break;
+
+                if (!ctx.adjacent(g, u, v)) {
+                    L_LOG("====== AUTH FAILED: edge (" << u << ", " << v << ") of outer cycle " << c << " does not exist in graph ======\n\n")
+                    return false;
+                }
+                int b = bc.edge_block(u, v);
+                if (block != -1 && b != block) {
+                    L_LOG("====== AUTH FAILED: outer cycle " << c << " leaves its block at (" << u << ", " << v << ") ======\n\n")
+                    return false;
+                }
+                block = b;
+            }
+
+            if (cycle_of[block] != -1) {
+                L_LOG("====== AUTH FAILED: outer cycles " << cycle_of[block] << " and " << c << " are in the same block ======\n\n")
+                return false;
+            }
+            cycle_of[block] = c;
+            if (order[block] != k) {
+                L_LOG("====== AUTH FAILED: outer cycle " << c << " misses " << order[block] - k << " vertices of its block ======\n\n")
+                return false;
+            }
+
+            chords.clear();
+            for (int i = edge_start[block]; i < edge_start[block + 1]; i++) {
+                auto [u, v] = edges[(size_t)(i)];
+                chords.emplace_back(std::min(pos[u], pos[v]), std::max(pos[u], pos[v]));
+            }
+            sort_by(chords, sorted, k, [k](edge_t const& x) {return k - 1 - x.second;});
+            sort_by(sorted, chords, k, [](edge_t const& x) {return x.first;});
+
+            open.clear();
+            for (auto [l, r] : chords) {
+                while (!open.empty() && open.back().second <= l) open.pop_back();
+                if (!open.empty() && r > open.back().second) {
+                    L_LOG("====== AUTH FAILED: chords (" << cycle[open.back().first] << ", " << cycle[open.back().second] << ") and ("
+                          << cycle[l] << ", " << cycle[r] << ") of outer cycle " << c << " cross ======\n\n")
+                    return false;
+                }
+                open.emplace_back(l, r);
+            }
+
+            for (int v : cycle) pos[v] = -1;
+        }
+
+        if (!embedding.rotation.empty()) {
+            if (embedding.rotation.size() != 2 * (size_t)(g.e)) {
+                L_LOG("====== AUTH FAILED: rotation has " << embedding.rotation.size() << " entries for " << g.e << " edges ======\n\n")
+                return false;
+            }
+            // pos marks the neighbours of v with v, and count holds how often each is still to
+            // be listed in its rotation, as parallel edges list it more than once
+            for (int v = 0; v < g.n; v++) {
+                for (int u : g.adjLists[v]) {
+                    if (pos[u] != v) count[u] = 0;
+                    pos[u] = v;
+                    count[u]++;
+                }
+                for (int i = g.adjLists.offsets[v]; i < g.adjLists.offsets[v + 1]; i++) {
+                    int u = embedding.rotation[(size_t)(i)];
+                    if (u < 0 || u >= g.n || pos[u] != v || count[u] == 0) {
+                        L_LOG("====== AUTH FAILED: rotation of " << v << " is not a permutation of its neighbours ======\n\n")
+                        return false;
+                    }
+                    count[u]--;
+                }
+            }
+        }
+
+        L_LOG("====== AUTH SUCCESS ======\n\n")
+        verified = true;
+        return true;
+    }
+};
+
+// The certificate kinds, as bit sets over cert_kind, that can show a graph to be in a class
+// (member) or not in it (non_member).
+struct graph_class {
+    char const * name;
+    unsigned member;
+    unsigned non_member;
+};
+
+constexpr unsigned cert_kind_bit(cert_kind k) {return 1u << k;}
+
+// An SP tree shows SP and GSP, a GSP tree only GSP, and outer cycles outerplanarity. K4
+// excludes all three, K23 only outerplanarity, and the cut certificates and T4 only a single SP
+// decomposition.
+constexpr graph_class sp_class{"SP", cert_kind_bit(cert_sp),
+    cert_kind_bit(cert_k4) | cert_kind_bit(cert_t4) | cert_kind_bit(cert_cut3) | cert_kind_bit(cert_bicomp3) | cert_kind_bit(cert_disc)};
+constexpr graph_class gsp_class{"GSP", cert_kind_bit(cert_sp) | cert_kind_bit(cert_gsp), cert_kind_bit(cert_k4)};
+constexpr graph_class op_class{"OP", cert_kind_bit(cert_op), cert_kind_bit(cert_k4) | cert_kind_bit(cert_k23)};
+
+// The verdicts of one recognition run: series-parallel (is_sp, with reason), generalized
+// series-parallel and outerplanar, each with its own certificate. Certificates are often shared
+// between the classes (a K4 refutes all three). A class whose certificate is null, as after
+// importing a version 1 certificate file, is not checked by authenticate().
+struct sp_result {
+    bool is_sp;
+    std::shared_ptr<certificate> reason;
+    bool is_gsp = false;
+    std::shared_ptr<certificate> gsp_reason;
+    bool is_op = false;
+    std::shared_ptr<certificate> op_reason;
+
+    bool authenticate(graph const& g) {
+        auth_context ctx;
+        return authenticate(g, ctx);
+    }
+
+    // ctx may be reused from one graph to the next
+    bool authenticate(graph const& g, auth_context& ctx) {
+        L_LOG("================== AUTHENTICATING SP RESULT ==================\n") 
+        V_LOG(g)
+        V_LOG("=============================================================\n")
+        L_LOG("\n")
+
+        if (!reason) {
+            L_LOG("ERROR: reason not given")
+            return false;
+        }
+        if (!authenticate_verdict(g, ctx, sp_class, is_sp, reason.get())) return false;
+        if (!authenticate_verdict(g, ctx, gsp_class, is_gsp, gsp_reason.get())) return false;
+        if (!authenticate_verdict(g, ctx, op_class, is_op, op_reason.get())) return false;
+
+        L_LOG("this graph is " << (is_sp ? "" : "NOT ") << "SP\n")
+        return true;
+    }
+
+private:
+    static bool authenticate_verdict(graph const& g, auth_context& ctx, graph_class const& cls, bool member, certificate * cert) {
+        if (!cert) return true;
+        unsigned kinds = (member ? cls.member : cls.non_member);
+        if (!(kinds & cert_kind_bit(cert_kind_from_name(cert->kind())))) {
+            L_LOG("====== AUTH FAILED: a " << cert->kind() << " certificate cannot show the graph " << (member ? "in " : "not in ") << cls.name << " ======\n\n")
+            return false;
+        }
+        ctx.prepare();
+        return cert->authenticate(g, ctx);
+    }
+};
+
+// ==================== CERTIFICATE EXPORT ====================
+// Streams certificates to a buffered_writer in the formats of certificate_format.h.
+
+// counts the payload words of a binary record, which precede the payload in its header
+struct cert_word_counter : certificate_encoder {
+    uint64_t words = 0;
+
+    void terminal(char const *, int) override {words++;}
+    void path(char const *, std::span<int const> vertices) override {words += 1 + vertices.size();}
+    void tree(sp_decomposition_view const& d) override {words += 1 + 4 * (uint64_t)(d.size) + ((uint64_t)(d.size) + 15) / 16;}
+};
+
+struct binary_cert_encoder : certificate_encoder {
+    buffered_writer& out;
+    checksum_stream checksum;
+
+    explicit binary_cert_encoder(buffered_writer& out_) : out{out_} {}
+
+    void word(uint32_t w) {
+        out.put_u32(w);
+        checksum.push(w);
+    }
+
+    void terminal(char const *, int v) override {word((uint32_t)(v));}
+
+    void path(char const *, std::span<int const> vertices) override {
+        word((uint32_t)(vertices.size()));
+        for (int v : vertices) word((uint32_t)(v));
+    }
+
+    void tree(sp_decomposition_view const& d) override {
+        word(d.size);
+        for (int v : d.source) word((uint32_t)(v));
+        for (int v : d.sink) word((uint32_t)(v));
+        for (uint32_t x : d.left) word(x);
+        for (uint32_t x : d.right) word(x);
+        // comp_bits bytes in file order, so each word is read back as its little-endian bytes
+        for (size_t i = 0; i < d.comp_bits.size(); i += 4) {
+            uint32_t w = 0;
+            for (size_t k = 0; k < 4 && i + k < d.comp_bits.size(); k++) w |= (uint32_t)(d.comp_bits[i + k]) << (8 * k);
+            word(w);
+        }
+    }
+};
+
+struct json_cert_encoder : certificate_encoder {
+    buffered_writer& out;
+    char const * section = nullptr; // the open "terminals" or "paths" object
+
+    explicit json_cert_encoder(buffered_writer& out_) : out{out_} {}
+
+    void open(char const * name) {
+        if (section && std::strcmp(section, name) == 0) {
+            out.put(',');
+            return;
+        }
+        close();
+        out.put(",\"");
+        out.put(name);
+        out.put("\":{");
+        section = name;
+    }
+
+    void close() {
+        if (section) out.put('}');
+        section = nullptr;
+    }
+
+    void key(char const * name) {
+        out.put('"');
+        out.put(name);
+        out.put("\":");
+    }
+
+    void terminal(char const * name, int v) override {
+        open("terminals");
+        key(name);
+        out.put_int(v);
+    }
+
+    void path(char const * name, std::span<int const> vertices) override {
+        open("paths");
+        key(name);
+        out.put('[');
+        for (size_t i = 0; i < vertices.size(); i++) {
+            if (i) out.put(',');
+            out.put_int(vertices[i]);
+        }
+        out.put(']');
+    }
+
+    void tree(sp_decomposition_view const& d) override {
+        close();
+        out.put(",\"tree\":[");
+        for (uint32_t i = 0; i < d.size; i++) {
+            if (i) out.put(',');
+            out.put('[');
+            out.put_int(d.source[i]);
+            out.put(',');
+            out.put_int(d.sink[i]);
+            out.put(",\"");
+            out.put(c_type_char(d.comp(i)));
+            out.put("\"]");
+        }
+        out.put(']');
+    }
+};
+
+// the class of the group whose certificate cert is, before class c; cert_classes if none
+inline cert_class shared_cert_class(sp_result const& result, cert_class c, certificate const * cert) {
+    certificate const * earlier[cert_classes] = {result.reason.get(), result.gsp_reason.get(), result.op_reason.get()};
+    for (uint32_t k = 0; k < c; k++) {
+        if (earlier[k] == cert) return (cert_class)(k);
+    }
+    return cert_classes;
+}
+
+// Writes the binary record of class c of a group; a shared certificate has no payload.
+inline void write_certificate_record(buffered_writer& out, int n, cert_class c, bool member, certificate const * cert, cert_class shared) {
+    cert_file_header h;
+    h.kind = (cert ? cert_kind_from_name(cert->kind()) : cert_none);
+    h.flags = (member ? cert_file_sp : 0) | ((uint32_t)(c) << cert_file_class_shift);
+    h.n = (uint32_t)(n);
+    if (shared != cert_classes) {
+        h.flags |= cert_file_shared | ((uint32_t)(shared) << cert_file_shared_shift);
+        cert = nullptr;
+    }
+    if (cert) {
+        cert_word_counter counter;
+        cert->encode(counter);
+        h.payload_words = counter.words;
+    }
+
+    unsigned char header[cert_file_header_bytes];
+    encode_cert_file_header(h, header);
+    out.put(std::string_view{(char const *)(header), sizeof(header)});
+
+    binary_cert_encoder binary{out};
+    if (cert) cert->encode(binary);
+    out.put_u64(binary.checksum.finish());
+}
+
+// Writes the certificate group of graph index, of order n; result is null for a graph that
+// could not be read.
+inline void write_certificate(buffered_writer& out, cert_encoding encoding, long long index, int n, sp_result const * result) {
+    certificate const * cert = (result ? result->reason.get() : nullptr);
+    cert_kind kind = (cert ? cert_kind_from_name(cert->kind()) : cert_none);
+    bool is_sp = (result && result->is_sp);
+    certificate const * gsp = (result ? result->gsp_reason.get() : nullptr);
+    certificate const * op = (result ? result->op_reason.get() : nullptr);
+
+    if (encoding == cert_encoding::json) {
+        out.put("{\"graph\":");
+        out.put_int(index);
+        out.put(",\"n\":");
+        out.put_int(n);
+        out.put(is_sp ? ",\"sp\":true" : ",\"sp\":false");
+        out.put(",\"kind\":\"");
+        out.put(cert_kind_names[kind]);
+        out.put('"');
+        if (cert) {
+            json_cert_encoder json{out};
+            cert->encode(json);
+            json.close();
+        }
+        for (cert_class c : {cert_class_gsp, cert_class_op}) {
+            certificate const * other = (c == cert_class_gsp ? gsp : op);
+            if (!other) continue;
+            out.put(",\"");
+            out.put(cert_class_names[c]);
+            out.put((c == cert_class_gsp ? result->is_gsp : result->is_op) ? "\":true,\"" : "\":false,\"");
+            out.put(cert_class_names[c]);
+            out.put("_cert\":{\"kind\":\"");
+            out.put(other->kind());
+            out.put('"');
+            cert_class shared = shared_cert_class(*result, c, other);
+            if (shared != cert_classes) {
+                out.put(",\"same_as\":\"");
+                out.put(cert_class_names[shared]);
+                out.put('"');
+            } else {
+                json_cert_encoder json{out};
+                other->encode(json);
+                json.close();
+            }
+            out.put('}');
+        }
+        out.put("}\n");
+        return;
+    }
+
+    write_certificate_record(out, n, cert_class_sp, is_sp, cert, cert_classes);
+    if (gsp) write_certificate_record(out, n, cert_class_gsp, result->is_gsp, gsp, shared_cert_class(*result, cert_class_gsp, gsp));
+    if (op) write_certificate_record(out, n, cert_class_op, result->is_op, op, shared_cert_class(*result, cert_class_op, op));
+}
+
+// ==================== CERTIFICATE IMPORT ====================
+// Rebuilds certificates from the binary records of certificate_format.h. On a little-endian
+// host an SP tree is used in place, its arrays pointing into the record, so the buffer must
+// outlive the certificate; otherwise the words are copied into storage the certificate owns.
+
+// reads the payload words of one record, failing once it would run past the payload
+struct cert_word_reader {
+    unsigned char const * p;
+    uint64_t left;
+    bool ok = true;
+
+    uint32_t next() {
+        if (left == 0) {
+            ok = false;
+            return 0;
+        }
+        uint32_t w = load_little_endian<uint32_t>(p);
+        p += 4;
+        left--;
+        return w;
+    }
+
+    int vertex() {return (int)(next());}
+
+    void path(std::vector<int>& out) {
+        uint32_t len = next();
+        if (len > left) {
+            ok = false;
+            return;
+        }
+        out.resize(len);
+        for (int& v : out) v = vertex();
+    }
+
+    // reads the paths of an obstruction one after another into vertices, and points them there
+    void paths(std::vector<int>& vertices, std::initializer_list<std::span<int> *> out) {
+        std::vector<size_t> ends;
+        for (size_t k = 0; k < out.size() && ok; k++) {
+            uint32_t len = next();
+            if (len > left) {
+                ok = false;
+                return;
+            }
+            for (uint32_t i = 0; i < len; i++) vertices.push_back(vertex());
+            ends.push_back(vertices.size());
+        }
+        if (!ok) return;
+
+        size_t start = 0;
+        size_t k = 0;
+        for (std::span<int> * path : out) {
+            *path = std::span<int>{vertices}.subspan(start, ends[k] - start);
+            start = ends[k++];
+        }
+    }
+};
+
+// an SP certificate together with the words its decomposition points into, when it cannot
+// point into the record itself
+struct imported_cert_sp {
+    std::vector<uint32_t> words;
+    positive_cert_sp cert;
+};
+
+// an obstruction together with the vertices its paths point into
+template <typename Cert>
+struct imported_cert_paths {
+    std::vector<int> vertices;
+    Cert cert;
+};
+
+// the outer cycles and rotation of an OP certificate, which its embedding points into
+struct imported_cert_op {
+    std::vector<int> cycle_offsets, cycles, rotation;
+    positive_cert_op cert;
+};
+
+// Decodes the record at pos, with its header into h, and advances pos past it. cert is null for
+// a "none" record or a shared one.
+inline bool read_certificate_record(char const * data, size_t size, size_t& pos, cert_file_header& h, std::shared_ptr<certificate>& cert, std::string& error) {
+    const size_t framing = cert_file_header_bytes + cert_file_trailer_bytes;
+    if (size - pos < framing || !is_cert_file(data + pos, size - pos)) {
+        error = "truncated certificate header";
+        return false;
+    }
+
+    unsigned char const * p = (unsigned char const *)(data + pos);
+    h.version = load_little_endian<uint16_t>(p + 4);
+    h.kind = load_little_endian<uint16_t>(p + 6);
+    h.flags = load_little_endian<uint32_t>(p + 8);
+    h.n = load_little_endian<uint32_t>(p + 12);
+    h.payload_words = load_little_endian<uint64_t>(p + 16);
+
+    if (h.version < 1 || h.version > cert_file_version) {
+        error = "unsupported certificate version " + std::to_string(h.version);
+        return false;
+    }
+    if (h.kind >= cert_kinds) {
+        error = "unknown certificate kind " + std::to_string(h.kind);
+        return false;
+    }
+    if ((size - pos - framing) / 4 < h.payload_words) {
+        error = "truncated certificate payload";
+        return false;
+    }
+
+    unsigned char const * payload = p + cert_file_header_bytes;
+    checksum_stream checksum;
+    for (uint64_t i = 0; i < h.payload_words; i++) checksum.push(load_little_endian<uint32_t>(payload + 4 * i));
+    if (checksum.finish() != load_little_endian<uint64_t>(payload + 4 * h.payload_words)) {
+        error = "certificate checksum mismatch";
+        return false;
+    }
+
+    cert = nullptr;
+    cert_word_reader in{payload, h.payload_words};
+    // a shared certificate is in an earlier record of the group
+    switch ((h.flags & cert_file_shared) ? cert_none : (cert_kind)(h.kind)) {
+        case cert_none:
+            break;
+        case cert_sp:
+        case cert_gsp: {
+            auto holder = std::make_shared<imported_cert_sp>();
+            sp_decomposition_view& d = holder->cert.decomposition;
+            d.size = in.next();
+            uint64_t bit_words = ((uint64_t)(d.size) + 15) / 16;
+            if (!in.ok || in.left < 4 * (uint64_t)(d.size) + bit_words) {
+                in.ok = false;
+                break;
+            }
+
+            // the arrays are read in place when the file's layout is the native one; the
+            // mapping is read-only, and so is the view
+            size_t tree_words = 4 * (size_t)(d.size);
+            uint32_t const * words;
+            if (std::endian::native == std::endian::little && (uintptr_t)(in.p) % alignof(uint32_t) == 0) {
+                words = (uint32_t const *)(in.p);
+            } else {
+                holder->words.resize(tree_words + bit_words);
+                uint32_t * copy = holder->words.data();
+                for (size_t i = 0; i < tree_words; i++) copy[i] = load_little_endian<uint32_t>(in.p + 4 * i);
+                // comp_bits are read as bytes, so they keep their file order
+                std::memcpy(copy + tree_words, in.p + 4 * tree_words, 4 * bit_words);
+                words = copy;
+            }
+            d.source = {(int const *)(words), d.size};
+            d.sink = {(int const *)(words) + d.size, d.size};
+            d.left = {words + 2 * (size_t)(d.size), d.size};
+            d.right = {words + 3 * (size_t)(d.size), d.size};
+            d.comp_bits = {(uint8_t const *)(words + tree_words), ((size_t)(d.size) + 3) / 4};
+            in.p += 4 * (tree_words + bit_words);
+            in.left -= tree_words + bit_words;
+
+            holder->cert.is_sp = (h.kind == cert_sp);
+            cert = std::shared_ptr<certificate>{holder, &holder->cert};
+            break;
+        }
+        case cert_k4: {
+            auto holder = std::make_shared<imported_cert_paths<negative_cert_K4>>();
+            negative_cert_K4& k4 = holder->cert;
+            k4.a = in.vertex();
+            k4.b = in.vertex();
+            k4.c = in.vertex();
+            k4.d = in.vertex();
+            in.paths(holder->vertices, {&k4.ab, &k4.ac, &k4.ad, &k4.bc, &k4.bd, &k4.cd});
+            cert = std::shared_ptr<certificate>{holder, &k4};
+            break;
+        }
+        case cert_k23: {
+            auto holder = std::make_shared<imported_cert_paths<negative_cert_K23>>();
+            negative_cert_K23& k23 = holder->cert;
+            k23.a = in.vertex();
+            k23.b = in.vertex();
+            in.paths(holder->vertices, {&k23.one, &k23.two, &k23.three});
+            cert = std::shared_ptr<certificate>{holder, &k23};
+            break;
+        }
+        case cert_t4: {
+            auto holder = std::make_shared<imported_cert_paths<negative_cert_T4>>();
+            negative_cert_T4& t4 = holder->cert;
+            t4.c1 = in.vertex();
+            t4.c2 = in.vertex();
+            t4.a = in.vertex();
+            t4.b = in.vertex();
+            in.paths(holder->vertices, {&t4.c1a, &t4.c1b, &t4.c2a, &t4.c2b, &t4.ab});
+            cert = std::shared_ptr<certificate>{holder, &t4};
+            break;
+        }
+        case cert_cut3: {
+            auto cut = std::make_shared<negative_cert_tri_comp_cut>();
+            cut->v = in.vertex();
+            cert = cut;
+            break;
+        }
+        case cert_bicomp3: {
+            auto bicomp = std::make_shared<negative_cert_tri_cut_comp>();
+            bicomp->c1 = in.vertex();
+            bicomp->c2 = in.vertex();
+            bicomp->c3 = in.vertex();
+            cert = bicomp;
+            break;
+        }
+        case cert_disc: {
+            auto disc = std::make_shared<negative_cert_disconnected>();
+            disc->u = in.vertex();
+            disc->v = in.vertex();
+            cert = disc;
+            break;
+        }
+        case cert_op: {
+            auto holder = std::make_shared<imported_cert_op>();
+            uint32_t blocks = in.next();
+            if (!in.ok || blocks > in.left) {
+                in.ok = false;
+                break;
+            }
+            std::vector<int> cycle;
+            holder->cycle_offsets.push_back(0);
+            for (uint32_t b = 0; b < blocks && in.ok; b++) {
+                in.path(cycle);
+                holder->cycles.insert(holder->cycles.end(), cycle.begin(), cycle.end());
+                holder->cycle_offsets.push_back((int)(holder->cycles.size()));
+            }
+            if (blocks == 0) holder->cycle_offsets.clear();
+            in.path(holder->rotation);
+
+            outer_embedding& e = holder->cert.embedding;
+            e.cycle_offsets = holder->cycle_offsets;
+            e.cycles = holder->cycles;
+            e.rotation = holder->rotation;
+            cert = std::shared_ptr<certificate>{holder, &holder->cert};
+            break;
+        }
+        default:
+            break;
+    }
+
+    if (!in.ok || in.left != 0) {
+        error = std::string{"malformed "} + cert_kind_names[h.kind] + " certificate payload";
+        return false;
+    }
+
+    pos += framing + 4 * (size_t)(h.payload_words);
+    return true;
+}
+
+// Decodes the group of records at pos, one graph's, and advances pos past it. result.reason is
+// null for a "none" record, and the GSP and outerplanar certificates are for a group without
+// their records; n receives the order of the graph the group belongs to.
+inline bool read_certificate(char const * data, size_t size, size_t& pos, sp_result& result, uint32_t& n, std::string& error) {
+    static constexpr graph_class const * classes[cert_classes] = {&sp_class, &gsp_class, &op_class};
+    bool * member[cert_classes] = {&result.is_sp, &result.is_gsp, &result.is_op};
+    std::shared_ptr<certificate> * reason[cert_classes] = {&result.reason, &result.gsp_reason, &result.op_reason};
+    result.gsp_reason = result.op_reason = nullptr;
+    result.is_gsp = result.is_op = false;
+
+    for (uint32_t c = 0; c < cert_classes; c++) {
+        // the next record is the group's if it is of a later class
+        if (c > 0) {
+            if (size - pos < cert_file_header_bytes || !is_cert_file(data + pos, size - pos)) break;
+            uint32_t flags = load_little_endian<uint32_t>((unsigned char const *)(data + pos) + 8);
+            uint32_t next = (flags >> cert_file_class_shift) & 3;
+            if (next == cert_class_sp) break;
+            if (next < c || next >= cert_classes) {
+                error = "misplaced certificate record";
+                return false;
+            }
+            c = next;
+        }
+
+        cert_file_header h;
+        std::shared_ptr<certificate> cert;
+        if (!read_certificate_record(data, size, pos, h, cert, error)) return false;
+        if (c == cert_class_sp) {
+            if ((h.flags >> cert_file_class_shift & 3) != cert_class_sp) {
+                error = "certificate group does not start with an SP record";
+                return false;
+            }
+            n = h.n;
+        } else if (h.n != n) {
+            error = std::string{classes[c]->name} + " certificate is for a graph of order " + std::to_string(h.n);
+            return false;
+        }
+
+        if (h.flags & cert_file_shared) {
+            uint32_t shared = (h.flags >> cert_file_shared_shift) & 3;
+            if (shared >= c || h.payload_words != 0 || !*reason[shared] || std::strcmp((*reason[shared])->kind(), cert_kind_names[h.kind]) != 0) {
+                error = std::string{"malformed shared "} + classes[c]->name + " certificate";
+                return false;
+            }
+            cert = *reason[shared];
+        }
+
+        *member[c] = (h.flags & cert_file_sp) != 0;
+        *reason[c] = cert;
+        unsigned kinds = (*member[c] ? classes[c]->member : classes[c]->non_member);
+        if (!(kinds & cert_kind_bit((cert_kind)(h.kind))) && (c != cert_class_sp || h.kind != cert_none || *member[c])) {
+            error = "certificate verdict does not match its kind";
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,876 @@
+#pragma once
+
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <string>
+#include <cstring>
+#include <climits>
+#include <cerrno>
+#include <cstdint>
+#include <thread>
+#include <span>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "graph_format.h"
+#include "work_stealing_pool.h"
+
+// ==================== LOGGING ====================
+#ifdef __VERBOSE_LOGGING__
+#define __LOGGING__
+#define V_LOG(a) std::cout << a;
+#else
+#define V_LOG(a)
+#endif
+
+#ifdef __LOGGING__
+#define __LIGHT_LOGGING__
+#define N_LOG(a) std::cout << a;
+#else
+#define N_LOG(a)
+#endif
+
+#ifdef __LIGHT_LOGGING__
+#define L_LOG(a) std::cout << a;
+#else
+#define L_LOG(a)
+#endif
+
+// ==================== GRAPH ====================
+using edge_t = std::pair<int, int>;
+
+inline int hardware_threads() {
+    unsigned t = std::thread::hardware_concurrency();
+    return t ? (int)(t) : 1;
+}
+
+// calls f(0), ..., f(workers - 1) concurrently, running f(0) on the calling thread
+template <typename F>
+void run_parallel(int workers, F const& f) {
+    std::vector<std::thread> threads;
+    for (int i = 1; i < workers; i++) threads.emplace_back(f, i);
+    f(0);
+    for (std::thread& t : threads) t.join();
+}
+
+// read-only CSR adjacency: row v is targets[offsets[v] .. offsets[v + 1])
+struct csr_view {
+    int const * offsets = nullptr;
+    int const * targets = nullptr;
+    int n = 0;
+
+    std::span<const int> operator[](int v) const {
+        return {targets + offsets[v], targets + offsets[v + 1]};
+    }
+
+    size_t size() const {return (size_t)(n);}
+};
+
+struct csr_storage {
+    std::vector<int> offsets;
+    std::vector<int> targets;
+};
+
+// what build_graph and read_binary_graph keep between the graphs of one reader
+struct csr_buffers {
+    std::shared_ptr<csr_storage> csr; // the arrays of the last graph built
+    std::vector<std::span<const int>> used;
+    std::vector<size_t> start;
+    std::vector<int> payload; // a binary payload copied to be aligned
+    std::vector<int> in_start, sources, fill, count; // csr_symmetric
+
+    // the arrays for the next graph: those of the last one, once no graph shares them
+    std::shared_ptr<csr_storage> const& storage() {
+        if (!csr || csr.use_count() > 1) csr.reset(new csr_storage{});
+        return csr;
+    }
+
+    size_t capacity() const {
+        size_t sum = used.capacity() + start.capacity() + payload.capacity() + in_start.capacity() + sources.capacity()
+                   + fill.capacity() + count.capacity();
+        if (csr) sum += csr->offsets.capacity() + csr->targets.capacity();
+        return sum;
+    }
+};
+
+struct graph {
+    int n = 0; // graph order
+    int e = 0; // graph size
+    csr_view adjLists; // graph adjacency lists
+    std::shared_ptr<void const> storage; // owns the arrays adjLists points into; shared between copies
+
+    int degree(int v) const {return adjLists.offsets[v + 1] - adjLists.offsets[v];}
+
+    bool adjacent(int e1, int e2) const {
+        for (int v : adjLists[e1]) {
+            if (v == e2) return true;
+        }
+        return false;
+    }
+
+    void output_adj_list(int v, std::ostream& os) const {
+        os << "vertex " << v << " adjacencies: ";
+        for (int v2 : adjLists[v]) {
+            os << v2 << " ";
+        }
+        os << "\n";
+    }
+};
+
+// Builds the CSR arrays from the first 2e integers of the concatenated endpoint buffers, read
+// as (u, v) pairs. The edges are split into one contiguous range per worker, and every pass reads
+// each endpoint once: each worker counts the degrees of its range into a histogram of its own,
+// the histograms are summed per vertex, an exclusive scan of the degrees gives the row starts,
+// and each worker scatters its range backwards into its share of every row. The shares follow
+// the ranges, so every row is in input order whatever the number of workers. The histograms take
+// n words per worker, so a graph gets no more workers than its endpoints are multiples of n.
+// With buffers, the arrays and the scratch are those of the previous graph built with them, once
+// no graph shares the arrays any more, so a reader of many graphs allocates only to grow them.
+inline bool build_graph(int n, int e, std::span<const std::span<const int>> endpoints, graph& g, std::string& error, int threads = hardware_threads(), csr_buffers * buffers = nullptr) {
+    size_t needed = (size_t)(e) * 2;
+    size_t found = 0;
+    for (std::span<const int> chunk : endpoints) found += chunk.size();
+    if (found < needed) {
+        error = "expected " + std::to_string(e) + " edges, found " + std::to_string(found / 2);
+        return false;
+    }
+
+    csr_buffers local;
+    csr_buffers& b = (buffers ? *buffers : local);
+    std::vector<std::span<const int>>& used = b.used;
+    std::vector<size_t>& start = b.start; // where each used span starts among the endpoints
+    used.clear();
+    start.assign(1, 0);
+    for (size_t left = needed; std::span<const int> chunk : endpoints) {
+        if (left == 0) break;
+        used.push_back(chunk.first(std::min(left, chunk.size())));
+        left -= used.back().size();
+        start.push_back(start.back() + used.back().size());
+    }
+
+    // calls f on each of the endpoints [lo, hi), backwards when reverse is set
+    auto visit = [&](size_t lo, size_t hi, bool reverse, auto&& f) {
+        for (size_t k = 0; k < used.size(); k++) {
+            size_t c = (reverse ? used.size() - 1 - k : k);
+            size_t a = std::max(lo, start[c]), b = std::min(hi, start[c + 1]);
+            if (reverse) {
+                for (size_t i = b; i-- > a;) f(used[c][i - start[c]]);
+            } else {
+                for (size_t i = a; i < b; i++) f(used[c][i - start[c]]);
+            }
+        }
+    };
+
+    std::shared_ptr<csr_storage> csr = b.storage();
+    csr->offsets.assign((size_t)(n) + 1, 0);
+    csr->targets.resize(needed);
+    int * offsets = csr->offsets.data();
+    int * targets = csr->targets.data();
+
+    const size_t min_endpoints_per_worker = (size_t)(1) << 20;
+    size_t max_workers = std::min((size_t)(std::max(threads, 1)), std::max(needed / std::max((size_t)(n), (size_t)(1)), (size_t)(1)));
+    int workers = (int)(std::clamp<size_t>(needed / min_endpoints_per_worker, 1, max_workers));
+    bool bad = false;
+
+    if (workers == 1) {
+        visit(0, needed, false, [&](int v) {
+            if ((unsigned)(v) >= (unsigned)(n)) bad = true;
+            else offsets[v]++;
+        });
+        if (bad) {
+            error = "edge endpoint out of range";
+            return false;
+        }
+
+        // row ends, which the backward fill moves down to the row starts
+        for (int v = 0, sum = 0; v < n; v++) {
+            sum += offsets[v];
+            offsets[v] = sum;
+        }
+        int second = -1;
+        visit(0, needed, true, [&](int v) {
+            if (second == -1) {
+                second = v;
+                return;
+            }
+            targets[--offsets[second]] = v;
+            targets[--offsets[v]] = second;
+            second = -1;
+        });
+    } else {
+        work_stealing_pool pool{workers};
+        std::vector<std::vector<int>> count((size_t)(workers), std::vector<int>((size_t)(n), 0));
+        std::vector<char> bad_range((size_t)(workers), 0);
+        auto endpoint = [&](int t) {return 2 * ((size_t)(e) * (size_t)(t) / (size_t)(workers));};
+
+        for_each_chunk(pool, workers, workers, [&](int t, int, int) {
+            int * mine = count[(size_t)(t)].data();
+            visit(endpoint(t), endpoint(t + 1), false, [&](int v) {
+                if ((unsigned)(v) >= (unsigned)(n)) bad_range[(size_t)(t)] = 1;
+                else mine[v]++;
+            });
+        });
+        for (char b : bad_range) bad = bad || b;
+        if (bad) {
+            error = "edge endpoint out of range";
+            return false;
+        }
+
+        // count[t][v] becomes the end of worker t's share of row v, counted from the row start
+        for_each_chunk(pool, workers, n, [&](int, int lo, int hi) {
+            for (int v = lo; v < hi; v++) {
+                int sum = 0;
+                for (std::vector<int>& c : count) {
+                    sum += c[(size_t)(v)];
+                    c[(size_t)(v)] = sum;
+                }
+                offsets[v] = sum;
+            }
+        });
+        std::vector<int> sums;
+        exclusive_scan(pool, offsets, n, sums);
+
+        for_each_chunk(pool, workers, workers, [&](int t, int, int) {
+            int * mine = count[(size_t)(t)].data();
+            int second = -1;
+            visit(endpoint(t), endpoint(t + 1), true, [&](int v) {
+                if (second == -1) {
+                    second = v;
+                    return;
+                }
+                targets[offsets[second] + --mine[second]] = v;
+                targets[offsets[v] + --mine[v]] = second;
+                second = -1;
+            });
+        });
+    }
+    offsets[n] = (int)(needed);
+
+    g = graph{};
+    g.n = n;
+    g.e = e;
+    g.adjLists = csr_view{offsets, targets, n};
+    g.storage = std::move(csr);
+    return true;
+}
+
+inline bool build_graph(int n, int e, std::span<const int> endpoints, graph& g, std::string& error, int threads = hardware_threads(), csr_buffers * buffers = nullptr) {
+    return build_graph(n, e, std::span<const std::span<const int>>{&endpoints, 1}, g, error, threads, buffers);
+}
+
+inline std::ostream& operator<<(std::ostream& os, graph const& g) {
+    os << "Graph with " << g.n << " vertices and " << g.e << " edges:\n";
+    for (int i = 0; i < g.n; i++) {
+        g.output_adj_list(i, os);
+    }
+    return os;
+}
+
+// ==================== CONNECTED COMPONENTS ====================
+// Labels every vertex of g with its connected component, the components numbered in order of
+// their smallest vertices, and returns how many there are. A union-find over the edges, split
+// across workers by vertex range like build_graph: every vertex is united with its larger
+// neighbours, and the larger of two roots is linked below the smaller with a compare-and-swap,
+// so that whatever the interleaving each class ends up rooted at its smallest vertex.
+inline int connected_components(graph const& g, std::vector<int>& component, int threads = hardware_threads()) {
+    int n = g.n;
+    component.resize((size_t)(n));
+    int * link = component.data();
+
+    const size_t min_endpoints_per_worker = (size_t)(1) << 20;
+    int workers = (int)(std::clamp<size_t>((size_t)(g.e) * 2 / min_endpoints_per_worker, 1, (size_t)(std::max(threads, 1))));
+    workers = std::min(workers, std::max(n, 1));
+    auto range = [&](int t) {return (int)((long long)(n) * t / workers);};
+
+    // path halving; whatever another worker stored meanwhile, upup is still an ancestor of x, so
+    // a plain store is enough
+    auto find = [&](int x) {
+        for (;;) {
+            int up = std::atomic_ref<int>{link[x]}.load(std::memory_order_relaxed);
+            if (up == x) return x;
+            int upup = std::atomic_ref<int>{link[up]}.load(std::memory_order_relaxed);
+            if (up != upup) std::atomic_ref<int>{link[x]}.store(upup, std::memory_order_relaxed);
+            x = upup;
+        }
+    };
+
+    run_parallel(workers, [&](int t) {
+        for (int v = range(t); v < range(t + 1); v++) link[v] = v;
+    });
+    run_parallel(workers, [&](int t) {
+        for (int v = range(t); v < range(t + 1); v++) {
+            for (int u : g.adjLists[v]) {
+                if (u <= v) continue;
+                for (int a = v, b = u;;) {
+                    a = find(a);
+                    b = find(b);
+                    if (a == b) break;
+                    if (a < b) std::swap(a, b);
+                    if (std::atomic_ref<int>{link[a]}.compare_exchange_strong(a, b, std::memory_order_relaxed)) break;
+                }
+            }
+        }
+    });
+    run_parallel(workers, [&](int t) {
+        for (int v = range(t); v < range(t + 1); v++) std::atomic_ref<int>{link[v]}.store(find(v), std::memory_order_relaxed);
+    });
+
+    // every root comes before the rest of its class, and is numbered first
+    int count = 0;
+    for (int v = 0; v < n; v++) component[v] = (component[v] == v ? count++ : component[component[v]]);
+    return count;
+}
+
+// The connected components of a graph as graphs of their own, sharing one CSR storage. Vertex i
+// of part c is the i-th smallest vertex of component c, and its row lists the same neighbours in
+// the same order as in the graph. Splitting another graph into the same components reuses their
+// arrays, once no graph outside them shares the storage.
+struct graph_components {
+    std::vector<graph> parts;
+    std::vector<int> vertices; // part after part, the vertex of the graph behind each vertex of a part
+    std::vector<int> first_vertex; // part c has vertices[first_vertex[c] .. first_vertex[c + 1])
+    std::shared_ptr<csr_storage> csr; // of the parts
+    std::vector<int> local, first_target, next, row; // split_components scratch
+
+    size_t capacity() const {
+        size_t sum = parts.capacity() + vertices.capacity() + first_vertex.capacity() + local.capacity()
+                   + first_target.capacity() + next.capacity() + row.capacity();
+        if (csr) sum += csr->offsets.capacity() + csr->targets.capacity();
+        return sum;
+    }
+
+    std::span<const int> vertices_of(int c) const {
+        return {vertices.data() + first_vertex[c], vertices.data() + first_vertex[c + 1]};
+    }
+};
+
+// Splits g along the count components connected_components labeled; the rows are filled in
+// parallel, split by vertex range.
+inline void split_components(graph const& g, std::vector<int> const& component, int count, graph_components& out, int threads = hardware_threads()) {
+    int n = g.n;
+    std::vector<int>& first = out.first_vertex;
+    std::vector<int>& vertices = out.vertices;
+    std::vector<int>& local = out.local;
+    std::vector<int>& first_target = out.first_target;
+    local.resize((size_t)(n));
+    first_target.assign((size_t)(count) + 1, 0);
+
+    first.assign((size_t)(count) + 1, 0);
+    for (int v = 0; v < n; v++) {
+        first[component[v] + 1]++;
+        first_target[component[v] + 1] += g.degree(v);
+    }
+    for (int c = 0; c < count; c++) {
+        first[c + 1] += first[c];
+        first_target[c + 1] += first_target[c];
+    }
+
+    // part c keeps its n_c + 1 row offsets from offsets[first[c] + c] on; the parts of the last
+    // split let go of the storage first
+    for (graph& part : out.parts) part = graph{};
+    if (!out.csr || out.csr.use_count() > 1) out.csr.reset(new csr_storage{});
+    std::shared_ptr<csr_storage> const& csr = out.csr;
+    csr->offsets.resize((size_t)(n) + count);
+    csr->targets.resize((size_t)(g.adjLists.offsets[n]));
+    int * offsets = csr->offsets.data();
+    int * targets = csr->targets.data();
+
+    vertices.resize((size_t)(n));
+    std::vector<int>& next = out.next;
+    std::vector<int>& row = out.row;
+    next.assign(first.begin(), first.end() - 1);
+    row.assign(first_target.begin(), first_target.end() - 1);
+    for (int v = 0; v < n; v++) {
+        int c = component[v];
+        int i = next[c]++;
+        vertices[i] = v;
+        local[v] = i - first[c];
+        offsets[i + c] = row[c] - first_target[c];
+        row[c] += g.degree(v);
+    }
+
+    out.parts.resize((size_t)(count));
+    for (int c = 0; c < count; c++) {
+        int order = first[c + 1] - first[c];
+        int ends = first_target[c + 1] - first_target[c];
+        offsets[first[c + 1] + c] = ends;
+        graph& part = out.parts[c];
+        part.n = order;
+        part.e = ends / 2;
+        part.adjLists = csr_view{offsets + first[c] + c, targets + first_target[c], order};
+        part.storage = csr;
+    }
+
+    const size_t min_endpoints_per_worker = (size_t)(1) << 20;
+    int workers = (int)(std::clamp<size_t>((size_t)(g.e) * 2 / min_endpoints_per_worker, 1, (size_t)(std::max(threads, 1))));
+    workers = std::min(workers, std::max(n, 1));
+    run_parallel(workers, [&](int t) {
+        for (int v = (int)((long long)(n) * t / workers); v < (int)((long long)(n) * (t + 1) / workers); v++) {
+            int c = component[v];
+            int * out_row = targets + first_target[c] + offsets[first[c] + c + local[v]];
+            for (int u : g.adjLists[v]) *out_row++ = local[u];
+        }
+    });
+}
+
+// ==================== VERTEX ORDERING ====================
+// Generated graphs shuffle their labels and real inputs often hash them, so the per-vertex
+// arrays of a recognizer are read at random. A connected graph can be relabeled first so that
+// neighbours get nearby labels:
+//   bfs: breadth-first from vertex 0, neighbours in row order;
+//   rcm: reverse Cuthill-McKee, breadth-first from a pseudo-peripheral vertex (George-Liu)
+//        taking the new neighbours of every vertex by increasing degree, then reversed;
+//   dfs: DFS preorder from vertex 0, neighbours in row order, the order in which a DFS of the
+//        relabeled graph from its vertex 0 meets the vertices.
+enum class vertex_order {bfs, rcm, dfs};
+constexpr char const * vertex_order_names[] = {"bfs", "rcm", "dfs"};
+
+// what order_vertices and permute_graph keep between graphs: their scratch, and the arrays of the
+// last graph permuted, reused once no graph shares them
+struct ordering_buffers {
+    std::vector<char> seen;
+    std::vector<std::pair<int const *, int const *>> stack;
+    csr_buffers csr;
+
+    size_t capacity() const {return seen.capacity() + stack.capacity() + csr.capacity();}
+};
+
+// Fills names with the vertices of the connected graph g in the given order: vertex names[i] is
+// labeled i. O(n + m), up to the degree sorts of rcm and its search for a starting vertex,
+// which runs a few more BFS.
+inline void order_vertices(graph const& g, vertex_order order, std::vector<int>& names, ordering_buffers * buffers = nullptr) {
+    int n = g.n;
+    names.clear();
+    names.reserve((size_t)(n));
+    if (n == 0) return;
+    ordering_buffers local;
+    ordering_buffers& b = (buffers ? *buffers : local);
+    std::vector<char>& seen = b.seen;
+    seen.assign((size_t)(n), 0);
+
+    if (order == vertex_order::dfs) {
+        // the rest of the row of every vertex on the path, so that going back up reads no offsets
+        std::vector<std::pair<int const *, int const *>>& stack = b.stack;
+        stack.clear();
+        auto visit = [&](int v) {
+            seen[v] = 1;
+            names.push_back(v);
+            std::span<const int> row = g.adjLists[v];
+            stack.emplace_back(row.data(), row.data() + row.size());
+        };
+        visit(0);
+        while (!stack.empty()) {
+            auto& [next, end] = stack.back();
+            while (next != end && seen[*next]) next++;
+            if (next == end) {
+                stack.pop_back();
+                continue;
+            }
+            visit(*next++);
+        }
+        return;
+    }
+
+    // breadth-first from root into names; returns the number of levels and where the last starts
+    auto bfs = [&](int root, bool by_degree) {
+        names.clear();
+        std::fill(seen.begin(), seen.end(), 0);
+        names.push_back(root);
+        seen[root] = 1;
+        int levels = 1;
+        size_t level = 0;
+        size_t level_end = 1;
+        for (size_t head = 0; head < names.size(); head++) {
+            if (head == level_end) {
+                levels++;
+                level = head;
+                level_end = names.size();
+            }
+            size_t first = names.size();
+            for (int u : g.adjLists[names[head]]) {
+                if (seen[u]) continue;
+                seen[u] = 1;
+                names.push_back(u);
+            }
+            if (by_degree) {
+                std::sort(names.begin() + (ptrdiff_t)(first), names.end(), [&](int a, int b) {
+                    return g.degree(a) != g.degree(b) ? g.degree(a) < g.degree(b) : a < b;
+                });
+            }
+        }
+        return std::pair{levels, level};
+    };
+    if (order == vertex_order::bfs) {
+        bfs(0, false);
+        return;
+    }
+
+    // from a vertex of least degree, move to a vertex of least degree on the last level for as
+    // long as that makes the BFS deeper, twice at most
+    int root = 0;
+    for (int v = 1; v < n; v++) {
+        if (g.degree(v) < g.degree(root)) root = v;
+    }
+    auto [levels, last] = bfs(root, false);
+    for (int round = 0; round < 2; round++) {
+        int far = names[last];
+        for (size_t i = last; i < names.size(); i++) {
+            if (g.degree(names[i]) < g.degree(far)) far = names[i];
+        }
+        auto [far_levels, far_last] = bfs(far, false);
+        if (far_levels <= levels) break;
+        root = far;
+        levels = far_levels;
+        last = far_last;
+    }
+    bfs(root, true);
+    std::reverse(names.begin(), names.end());
+}
+
+// g with vertex names[i] relabeled i, and id with the label of every vertex of g. Every row lists
+// the same neighbours, relabeled, in the same order, and the rows are filled in parallel, split
+// by vertex range. With buffers, the arrays are those of the last graph permuted with them, once
+// no graph shares them.
+inline void permute_graph(graph const& g, std::vector<int> const& names, std::vector<int>& id, graph& out, int threads = hardware_threads(),
+                          ordering_buffers * buffers = nullptr) {
+    int n = g.n;
+    id.resize((size_t)(n));
+    for (int i = 0; i < n; i++) id[names[i]] = i;
+
+    std::shared_ptr<csr_storage> csr = (buffers ? buffers->csr.storage() : std::make_shared<csr_storage>());
+    csr->offsets.resize((size_t)(n) + 1);
+    csr->targets.resize((size_t)(g.adjLists.offsets[n]));
+    int * offsets = csr->offsets.data();
+    int * targets = csr->targets.data();
+    offsets[0] = 0;
+    for (int i = 0; i < n; i++) offsets[i + 1] = offsets[i] + g.degree(names[i]);
+
+    const size_t min_endpoints_per_worker = (size_t)(1) << 20;
+    int workers = (int)(std::clamp<size_t>((size_t)(g.e) * 2 / min_endpoints_per_worker, 1, (size_t)(std::max(threads, 1))));
+    workers = std::min(workers, std::max(n, 1));
+    run_parallel(workers, [&](int t) {
+        for (int i = (int)((long long)(n) * t / workers); i < (int)((long long)(n) * (t + 1) / workers); i++) {
+            int * out_row = targets + offsets[i];
+            for (int u : g.adjLists[names[i]]) *out_row++ = id[u];
+        }
+    });
+
+    out.n = n;
+    out.e = g.e;
+    out.adjLists = csr_view{offsets, targets, n};
+    out.storage = csr;
+}
+
+// ==================== INPUT ====================
+// Input is either the binary format of graph_format.h (recognised by its magic) or text:
+// "n m" followed by m "u v" pairs. Regular files (including a redirected stdin)
+// are mapped into memory, pipes are slurped with large read() calls. The edge section is
+// split into whitespace-aligned chunks that are decoded on all cores, and the CSR
+// graph is built straight from the decoded endpoint buffers.
+struct input_buffer {
+    char const * data = nullptr;
+    size_t size = 0;
+    void * mapping = nullptr;
+    std::vector<char> owned;
+
+    input_buffer() = default;
+    input_buffer(input_buffer const& other) = delete;
+    input_buffer& operator=(input_buffer const& other) = delete;
+
+    ~input_buffer() {
+        if (mapping) munmap(mapping, size);
+    }
+
+    bool open_fd(int fd) {
+        struct stat st;
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 && lseek(fd, 0, SEEK_CUR) == 0) {
+            void * m = mmap(nullptr, (size_t)(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (m != MAP_FAILED) {
+                madvise(m, (size_t)(st.st_size), MADV_SEQUENTIAL);
+                mapping = m;
+                data = (char const *)(m);
+                size = (size_t)(st.st_size);
+                return true;
+            }
+        }
+
+        const size_t block = (size_t)(1) << 24;
+        for (;;) {
+            size_t used = owned.size();
+            owned.resize(used + block);
+            ssize_t got = read(fd, owned.data() + used, block);
+            if (got < 0 && errno == EINTR) {
+                owned.resize(used);
+                continue;
+            }
+            if (got < 0) return false;
+            owned.resize(used + (size_t)(got));
+            if (got == 0) break;
+        }
+
+        data = owned.data();
+        size = owned.size();
+        return true;
+    }
+
+    bool open_path(char const * path) {
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) return false;
+        bool ok = open_fd(fd);
+        close(fd);
+        return ok;
+    }
+};
+
+inline bool is_space(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+}
+
+enum class token { value, end, bad };
+
+// decodes the next non-negative integer at p, advancing p past it
+inline token next_uint(char const *& p, char const * end, int& x) {
+    while (p < end && is_space(*p)) p++;
+    if (p == end) return token::end;
+
+    long long acc = 0;
+    char const * start = p;
+    for (; p < end && (unsigned)(*p - '0') < 10u; p++) {
+        acc = acc * 10 + (*p - '0');
+        if (acc > INT_MAX) return token::bad;
+    }
+
+    if (p == start || (p < end && !is_space(*p))) return token::bad;
+    x = (int)(acc);
+    return token::value;
+}
+
+inline bool parse_uints(char const * p, char const * end, std::vector<int>& out) {
+    int x;
+    token t;
+    while ((t = next_uint(p, end, x)) == token::value) out.push_back(x);
+    return t == token::end;
+}
+
+// splits [p, end) at whitespace into at most max_chunks pieces and decodes them concurrently;
+// concatenating the returned buffers gives the integers in input order
+inline bool parse_uints_parallel(char const * p, char const * end, int max_chunks, std::vector<std::vector<int>>& out) {
+    const size_t min_chunk_bytes = (size_t)(1) << 20;
+    size_t bytes = (size_t)(end - p);
+    size_t n_chunks = std::max<size_t>(1, std::min<size_t>((size_t)(max_chunks), bytes / min_chunk_bytes));
+
+    std::vector<char const *> bounds(n_chunks + 1, end);
+    bounds[0] = p;
+    for (size_t i = 1; i < n_chunks; i++) {
+        char const * b = std::max(bounds[i - 1], p + bytes / n_chunks * i);
+        while (b < end && !is_space(*b)) b++;
+        bounds[i] = b;
+    }
+
+    out.assign(n_chunks, std::vector<int>{});
+    std::vector<char> ok(n_chunks, 0);
+    auto work = [&](int i) {
+        out[i].reserve((size_t)(bounds[i + 1] - bounds[i]) / 8);
+        ok[i] = parse_uints(bounds[i], bounds[i + 1], out[i]);
+    };
+
+    run_parallel((int)(n_chunks), work);
+
+    return std::all_of(ok.begin(), ok.end(), [](char c) {return c != 0;});
+}
+
+// Whether CSR rows describe an undirected graph: every u -> v has its own v -> u (a self-loop
+// is listed twice in its row, so it pairs with itself). The sources of the arcs into each vertex
+// are gathered by a counting pass and compared with its row as multisets, O(n + m).
+inline bool csr_symmetric(int const * offsets, int const * targets, int n, csr_buffers& b) {
+    std::vector<int>& in_start = b.in_start;
+    std::vector<int>& sources = b.sources;
+    std::vector<int>& fill = b.fill;
+    std::vector<int>& count = b.count;
+    in_start.assign((size_t)(n) + 1, 0);
+    for (int i = 0; i < offsets[n]; i++) in_start[(size_t)(targets[i]) + 1]++;
+    for (int v = 0; v < n; v++) {
+        if (in_start[(size_t)(v) + 1] != offsets[v + 1] - offsets[v]) return false;
+        in_start[(size_t)(v) + 1] += in_start[(size_t)(v)];
+    }
+    sources.resize((size_t)(offsets[n]));
+    fill.assign(in_start.begin(), in_start.end() - 1);
+    for (int u = 0; u < n; u++) {
+        for (int i = offsets[u]; i < offsets[u + 1]; i++) sources[(size_t)(fill[(size_t)(targets[i])]++)] = u;
+    }
+
+    count.assign((size_t)(n), 0);
+    for (int v = 0; v < n; v++) {
+        for (int i = offsets[v]; i < offsets[v + 1]; i++) count[(size_t)(targets[i])]++;
+        bool ok = true;
+        for (int i = in_start[(size_t)(v)]; i < in_start[(size_t)(v) + 1]; i++) ok = (count[(size_t)(sources[(size_t)(i)])]-- > 0) && ok;
+        if (!ok) return false;
+    }
+    return true;
+}
+
+// Binary graphs (graph_format.h) need no decoding: a CSR payload is used in place, with the
+// graph sharing ownership of the mapped buffer, once its rows are checked to be in range and
+// symmetric, and an edge array goes straight to build_graph. The payload is only copied on
+// big-endian hosts or when a mixed stream leaves it misaligned, into the buffers when given.
+inline bool read_binary_graph(std::shared_ptr<input_buffer const> const& in, size_t& pos, graph& g, std::string& error, int threads, csr_buffers * buffers = nullptr) {
+    graph_file_header h;
+    if (!decode_graph_file_header(in->data + pos, in->size - pos, h, error)) return false;
+
+    int n = (int)(h.n);
+    int e = (int)(h.m);
+    size_t words = (size_t)(h.payload_words());
+    char const * payload = in->data + pos + h.header_bytes;
+    pos += h.header_bytes + 4 * words;
+
+    csr_buffers local;
+    csr_buffers& b = (buffers ? *buffers : local);
+    bool copied = (std::endian::native != std::endian::little || (uintptr_t)(payload) % alignof(int) != 0);
+    int const * data = (int const *)(payload);
+    if (copied) {
+        b.payload.resize(words);
+        for (size_t i = 0; i < words; i++) b.payload[i] = (int)(load_little_endian<uint32_t>((unsigned char const *)(payload) + 4 * i));
+        data = b.payload.data();
+    }
+
+    if (graph_file_checksum((uint32_t const *)(data), words) != h.checksum) {
+        error = "binary graph checksum mismatch";
+        return false;
+    }
+
+    if (!(h.flags & graph_file_csr)) {
+        return build_graph(n, e, std::span<const int>{data, words}, g, error, threads, &b);
+    }
+
+    int const * offsets = data;
+    int const * targets = data + n + 1;
+    bool ok = offsets[0] == 0 && offsets[n] == 2 * e;
+    for (int v = 0; ok && v < n; v++) ok = offsets[v] <= offsets[v + 1];
+    for (int i = 0; ok && i < 2 * e; i++) ok = (unsigned)(targets[i]) < (unsigned)(n);
+    if (!ok) {
+        error = "malformed binary graph rows";
+        return false;
+    }
+    if (!csr_symmetric(offsets, targets, n, b)) {
+        error = "binary graph rows are not symmetric";
+        return false;
+    }
+
+    std::shared_ptr<void const> owner = in;
+    if (copied) {
+        std::shared_ptr<csr_storage> csr = b.storage();
+        csr->offsets.assign(offsets, offsets + n + 1);
+        csr->targets.assign(targets, targets + 2 * (size_t)(e));
+        offsets = csr->offsets.data();
+        targets = csr->targets.data();
+        owner = std::move(csr);
+    }
+
+    g = graph{};
+    g.n = n;
+    g.e = e;
+    g.adjLists = csr_view{offsets, targets, n};
+    g.storage = std::move(owner);
+    return true;
+}
+
+inline bool read_graph(std::shared_ptr<input_buffer const> const& in, graph& g, std::string& error, int threads = hardware_threads()) {
+    size_t pos = 0;
+    if (is_graph_file(in->data, in->size)) return read_binary_graph(in, pos, g, error, threads);
+
+    char const * p = in->data;
+    char const * end = in->data + in->size;
+    int n, e;
+    if (next_uint(p, end, n) != token::value || next_uint(p, end, e) != token::value || e > INT_MAX / 2) {
+        error = "malformed graph header";
+        return false;
+    }
+
+    std::vector<std::vector<int>> endpoints;
+    if (!parse_uints_parallel(p, end, threads, endpoints)) {
+        error = "malformed edge list";
+        return false;
+    }
+
+    std::vector<std::span<const int>> spans(endpoints.begin(), endpoints.end());
+    return build_graph(n, e, spans, g, error, threads);
+}
+
+// Reads a stream of concatenated graphs, text and binary mixed freely. Text graphs are decoded
+// sequentially into a reused buffer since batch inputs are typically many small graphs, and
+// edge lists are built into CSR arrays that are reused once the previous graph is dropped.
+struct graph_reader {
+    std::shared_ptr<input_buffer const> in;
+    size_t pos = 0;
+    std::vector<int> endpoints;
+    csr_buffers csr;
+
+    explicit graph_reader(std::shared_ptr<input_buffer const> in_) : in{std::move(in_)} {}
+
+    bool at_end() {
+        while (pos < in->size && is_space(in->data[pos])) pos++;
+        return pos == in->size;
+    }
+
+    bool next(graph& g, std::string& error, int threads = 1) {
+        if (is_graph_file(in->data + pos, in->size - pos)) return read_binary_graph(in, pos, g, error, threads, &csr);
+
+        char const * p = in->data + pos;
+        char const * end = in->data + in->size;
+        int n, e;
+        if (next_uint(p, end, n) != token::value || next_uint(p, end, e) != token::value || e > INT_MAX / 2) {
+            error = "malformed graph header";
+            return false;
+        }
+
+        endpoints.clear();
+        int x;
+        for (size_t i = 0; i < (size_t)(e) * 2; i++) {
+            token t = next_uint(p, end, x);
+            if (t != token::value) {
+                error = (t == token::end ? "expected " + std::to_string(e) + " edges, found " + std::to_string(i / 2) : "malformed edge list");
+                return false;
+            }
+            endpoints.push_back(x);
+        }
+
+        pos = (size_t)(p - in->data);
+        return build_graph(n, e, endpoints, g, error, threads, &csr);
+    }
+
+    // moves past the next graph without decoding its edges, so that the graph can be read
+    // later by another reader positioned here
+    bool skip(std::string& error) {
+        if (is_graph_file(in->data + pos, in->size - pos)) {
+            graph_file_header h;
+            if (!decode_graph_file_header(in->data + pos, in->size - pos, h, error)) return false;
+            pos += h.header_bytes + 4 * (size_t)(h.payload_words());
+            return true;
+        }
+
+        char const * p = in->data + pos;
+        char const * end = in->data + in->size;
+        int n, e;
+        if (next_uint(p, end, n) != token::value || next_uint(p, end, e) != token::value || e > INT_MAX / 2) {
+            error = "malformed graph header";
+            return false;
+        }
+
+        for (size_t i = 0; i < (size_t)(e) * 2; i++) {
+            while (p < end && is_space(*p)) p++;
+            if (p == end) {
+                error = "expected " + std::to_string(e) + " edges, found " + std::to_string(i / 2);
+                return false;
+            }
+            while (p < end && !is_space(*p)) p++;
+        }
+
+        pos = (size_t)(p - in->data);
+        return true;
+    }
+};
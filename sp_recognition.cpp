@@ -4,931 +4,1014 @@
 #include <stack>
 #include <memory>
 #include <algorithm>
+#include <array>
 #include <cassert>
+#include <string>
+#include <cstring>
+#include <climits>
+#include <cerrno>
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <span>
+#include <sstream>
+#include <iterator>
+#include <type_traits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "certificate_format.h"
+#include "graph_format.h"
+#include "sp_certificate.h"
+#include "sp_graph.h"
+#include "work_stealing_pool.h"
+
+// ==================== ALLOCATION COUNTING ====================
+// Building with -D__COUNT_ALLOCATIONS__ counts every global operator new per thread, so tests
+// can check that the recognizer's steady state does not touch the heap.
+#ifdef __COUNT_ALLOCATIONS__
+#include <cstdlib>
+thread_local long long heap_allocations = 0;
+
+[[gnu::noinline]] void * operator new(std::size_t size) {
+    heap_allocations++;
+    if (void * p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc{};
+}
 
-// ==================== LOGGING ====================
-#ifdef __VERBOSE_LOGGING__
-#define __LOGGING__
-#define V_LOG(a) std::cout << a;
-#else
-#define V_LOG(a)
-#endif
-
-#ifdef __LOGGING__
-#define __LIGHT_LOGGING__
-#define N_LOG(a) std::cout << a;
-#else
-#define N_LOG(a)
-#endif
+[[gnu::noinline]] void operator delete(void * p) noexcept {std::free(p);}
+[[gnu::noinline]] void operator delete(void * p, std::size_t) noexcept {std::free(p);}
 
-#ifdef __LIGHT_LOGGING__
-#define L_LOG(a) std::cout << a;
+#define A_COUNT(a) a
 #else
-#define L_LOG(a)
+#define A_COUNT(a)
 #endif
 
-// ==================== GRAPH ====================
-using edge_t = std::pair<int, int>;
-
-struct graph {
-    int n; // graph order
-    int e; // graph size
-    std::vector<std::vector<int>> adjLists; // graph adjacency lists
-
-    bool adjacent(int e1, int e2) const {
-        for (int v : adjLists[e1]) {
-            if (v == e2) return true;
+// ==================== ARENA ====================
+// Bump allocator for what a recognition run hands back: the certificate, its paths and its SP
+// tree.
+// Nothing in it is freed individually; reset() releases everything at once and keeps the
+// blocks for the next run.
+class sp_arena {
+public:
+    sp_arena() = default;
+    sp_arena(sp_arena const& other) = delete;
+    sp_arena& operator=(sp_arena const& other) = delete;
+
+    void * allocate(size_t size, size_t align) {
+        for (;;) {
+            if (current < blocks.size()) {
+                size_t offset = (used + align - 1) & ~(align - 1);
+                if (offset + size <= sizes[current]) {
+                    used = offset + size;
+                    return blocks[current].get() + offset;
+                }
+                current++;
+                used = 0;
+                continue;
+            }
+            size_t block = std::max(size + align, first_block << std::min(blocks.size(), (size_t)(10)));
+            blocks.emplace_back(new std::byte[block]);
+            sizes.push_back(block);
         }
-        return false;
     }
 
-    void add_edge(int e1, int e2) {
-        adjLists[e1].push_back(e2);
-        adjLists[e2].push_back(e1);
+    // Grows the last allocation, size bytes at p, by more bytes: in place when its block has
+    // room, and otherwise by moving it to the top with as much room again to grow into. Any
+    // other p (null included) is copied to the top.
+    void * extend(void * p, size_t size, size_t more, size_t align) {
+        bool last = (p && current < blocks.size() && (std::byte *)(p) + size == blocks[current].get() + used);
+        if (last && used + more <= sizes[current]) {
+            used += more;
+            return p;
+        }
+        void * q = allocate(2 * (size + more), align);
+        used = (size_t)((std::byte *)(q) - blocks[current].get()) + size + more;
+        if (size) std::memcpy(q, p, size);
+        return q;
     }
 
-    void reserve(graph const& other) {
-        for (int i = 0; i < other.n; i++) {
-            adjLists.emplace_back();
-            adjLists[i].reserve(other.adjLists[i].size());
-        }
+    void reset() {
+        current = 0;
+        used = 0;
     }
 
-    void output_adj_list(int v, std::ostream& os) const {
-        os << "vertex " << v << " adjacencies: ";
-        for (int v2 : adjLists[v]) {
-            os << v2 << " ";
-        }
-        os << "\n";
+    size_t capacity() const {
+        size_t total = 0;
+        for (size_t s : sizes) total += s;
+        return total;
     }
+
+private:
+    static constexpr size_t first_block = 64 * 1024;
+
+    std::vector<std::unique_ptr<std::byte[]>> blocks;
+    std::vector<size_t> sizes;
+    size_t current = 0; // block being filled
+    size_t used = 0; // bytes used in blocks[current]
 };
 
-std::istream& operator>>(std::istream& is, graph& g) {
-    g = graph{};
-    is >> g.n >> g.e;
-    g.adjLists.reserve(g.n);
+// Allocator for std::allocate_shared; every copy (including the one kept in the control block)
+// shares ownership of the arena, so the arena outlives any object still referenced from it.
+template <typename T>
+struct arena_allocator {
+    using value_type = T;
 
-    for (int i = 0; i < g.n; i++) {
-        g.adjLists.emplace_back();
-    }
+    std::shared_ptr<sp_arena> arena;
 
-    for (int i = 0; i < g.e; i++) {
-        int endpoint1, endpoint2;
-        is >> endpoint1 >> endpoint2;
-        g.add_edge(endpoint1, endpoint2);
-    }
+    explicit arena_allocator(std::shared_ptr<sp_arena> arena_) : arena{std::move(arena_)} {}
+    template <typename U>
+    arena_allocator(arena_allocator<U> const& other) : arena{other.arena} {}
 
-    for (std::vector<int>& list : g.adjLists) {
-    list.shrink_to_fit();
-}
+    T * allocate(size_t count) {return static_cast<T *>(arena->allocate(count * sizeof(T), alignof(T)));}
+    void deallocate(T *, size_t) {}
+
+    template <typename U>
+    bool operator==(arena_allocator<U> const& other) const {return arena == other.arena;}
+};
 
-    return is;
+// a shared object (control block included) placed in the arena
+template <typename T>
+std::shared_ptr<T> make_arena_shared(std::shared_ptr<sp_arena> const& arena) {
+    return std::allocate_shared<T>(arena_allocator<T>{arena});
 }
 
-std::ostream& operator<<(std::ostream& os, graph const& g) {
-    os << "Graph with " << g.n << " vertices and " << g.e << " edges:\n";
-    for (int i = 0; i < g.n; i++) {
-        g.output_adj_list(i, os);
+// The arenas of the results a worker holds at once, such as those of the components of a graph
+// until they are merged. acquire() hands them out in turn: the next one, rewound, when no result
+// references it any more, and otherwise a new one. A worker that drops its results between
+// graphs finds the next arena free until one graph needs more than the pool has, so the pool
+// stops growing once it has one arena per result kept at the same time, and one that keeps
+// every result costs O(1) per arena, as a fresh arena per run did.
+struct arena_pool {
+    std::vector<std::shared_ptr<sp_arena>> arenas;
+    size_t next = 0; // the arena to hand out next
+
+    std::shared_ptr<sp_arena> acquire(bool& grew) {
+        if (next == arenas.size()) next = 0;
+        if (next < arenas.size() && arenas[next].use_count() == 1) {
+            arenas[next]->reset();
+            return arenas[next++];
+        }
+        arenas.push_back(std::make_shared<sp_arena>());
+        next = arenas.size();
+        grew = true;
+        return arenas.back();
     }
-    return os;
-}
 
-// ==================== SP TREE ====================
-enum class c_type {
-    edge, series, parallel, antiparallel, dangling
+    size_t capacity() const {
+        size_t total = arenas.capacity();
+        for (std::shared_ptr<sp_arena> const& arena : arenas) total += arena->capacity();
+        return total;
+    }
 };
 
-char c_type_char(c_type comp) {
-    switch (comp) {
-        case c_type::edge:
-            return 'e';
-        case c_type::series:
-            return 'S';
-        case c_type::parallel:
-            return 'P';
-        case c_type::antiparallel:
-            return 'Q';
-        case c_type::dangling:
-            return 'D';
+// ==================== SP TREE ====================
+// Working storage for the SP trees of a recognition run, as parallel arrays indexed by 32-bit
+// node ids. Nodes are only appended, so children always precede their parents; trees dropped
+// during the run simply leave unreachable nodes behind until clear().
+struct sp_node_pool {
+    std::vector<int> source;
+    std::vector<int> sink;
+    std::vector<uint32_t> left;
+    std::vector<uint32_t> right;
+    std::vector<uint8_t> comp_bits;
+
+    uint32_t size() const {return (uint32_t)(source.size());}
+    bool is_edge(uint32_t i) const {return left[i] == sp_no_node;}
+    c_type comp(uint32_t i) const {return is_edge(i) ? c_type::edge : unpack_comp(comp_bits.data(), i);}
+
+    uint32_t edge(int source_, int sink_) {
+        return append(source_, sink_, sp_no_node, sp_no_node, c_type::edge);
     }
-}
 
-struct sp_tree_node {
-    int source;
-    int sink;
-    sp_tree_node * l;
-    sp_tree_node * r;
-    c_type comp;
+    uint32_t join(uint32_t l, uint32_t r, c_type comp_) {
+        if (comp_ == c_type::series) return append(source[l], sink[r], l, r, comp_);
+        return append(source[l], sink[l], l, r, comp_);
+    }
 
-    sp_tree_node(int source_, int sink_) : source{source_}, sink{sink_}, comp{c_type::edge} {}
+    void clear() {
+        source.clear();
+        sink.clear();
+        left.clear();
+        right.clear();
+        comp_bits.clear();
+    }
 
-    sp_tree_node(sp_tree_node * l_, sp_tree_node * r_, c_type comp_) : l{l_}, r{r_}, comp{comp_} {
-        switch (comp) {
-            case c_type::series:
-                source = l->source;
-                sink = r->sink;
-                break;
-            case c_type::dangling:
-            case c_type::parallel:
-            case c_type::antiparallel:
-                source = l->source;
-                sink = l->sink;
-                break;
-            case c_type::edge:
-                break;
-        }
+    size_t capacity() const {
+        return source.capacity() * 2 * sizeof(int) + left.capacity() * 2 * sizeof(uint32_t) + comp_bits.capacity();
+    }
+
+private:
+    uint32_t append(int source_, int sink_, uint32_t l, uint32_t r, c_type comp_) {
+        uint32_t i = size();
+        source.push_back(source_);
+        sink.push_back(sink_);
+        left.push_back(l);
+        right.push_back(r);
+        if ((i & 3) == 0) comp_bits.push_back(0);
+        if (l != sp_no_node) pack_comp(comp_bits.data(), i, comp_);
+        return i;
     }
 };
 
+// A tree in an sp_node_pool, named by its root; moves leave the source empty.
 struct sp_tree {
-    sp_tree_node * root;
+    uint32_t root;
 
-    void compose(sp_tree&& other, c_type comp) {
-        if (!root) {
+    void compose(sp_tree&& other, c_type comp, sp_node_pool& nodes) {
+        if (root == sp_no_node) {
             root = other.root;
-            other.root = nullptr;
+            other.root = sp_no_node;
             return;
-        } else if (!other.root) {
+        } else if (other.root == sp_no_node) {
             return;
         }
-        root = new sp_tree_node{root, other.root, comp};
-        other.root = nullptr;
+        root = nodes.join(root, other.root, comp);
+        other.root = sp_no_node;
     }
 
-    void l_compose(sp_tree&& other, c_type comp) {
-        if (!root) {
+    void l_compose(sp_tree&& other, c_type comp, sp_node_pool& nodes) {
+        if (root == sp_no_node) {
             root = other.root;
-            other.root = nullptr;
+            other.root = sp_no_node;
             return;
-        } else if (!other.root) {
+        } else if (other.root == sp_no_node) {
             return;
         }
-        root = new sp_tree_node{other.root, root, comp};
-        other.root = nullptr;
-    }
-
-    void deantiparallelize() {
-        std::stack<std::pair<sp_tree_node *, int>> hist;
-        bool swap = false;
-        if (!root) return;
-        hist.emplace(root, 0);
-
-        while (!hist.empty()) {
-            sp_tree_node * curr = hist.top().first;
-            if (hist.top().second == 0) {
-                hist.top().second++;
-                if (curr->r) hist.emplace(curr->r, 0);
-                if (curr->comp == c_type::antiparallel) swap = !swap;
-            } else {
-                hist.pop();
-                if (curr->l) hist.emplace(curr->l, 0);
-                if (curr->comp == c_type::antiparallel) {
-                    swap = !swap;
-                    curr->comp = c_type::parallel;
-                }
-                if (swap) {
-                    sp_tree_node * temp = curr->l;
-                    curr->l = curr->r;
-                    curr->r = temp;
-                    int temp_src = curr->source;
-                    curr->source = curr->sink;
-                    curr->sink = temp_src;
-                }
-            }
-        }
-    }
-
-    int source() {return root->source;}
-    int sink() {return root->sink;}
-    int underlying_tree_path_source() {
-        sp_tree_node * leftmost = root;
-        for (; leftmost->comp != c_type::edge; leftmost = leftmost->l);
-        return leftmost->sink;
+        root = nodes.join(other.root, root, comp);
+        other.root = sp_no_node;
     }
 
-    sp_tree() {
-        root = nullptr;
+    bool empty() const {return root == sp_no_node;}
+    int source(sp_node_pool const& nodes) const {return nodes.source[root];}
+    int sink(sp_node_pool const& nodes) const {return nodes.sink[root];}
+    int underlying_tree_path_source(sp_node_pool const& nodes) const {
+        uint32_t leftmost = root;
+        for (; !nodes.is_edge(leftmost); leftmost = nodes.left[leftmost]);
+        return nodes.sink[leftmost];
     }
-    sp_tree(int source_, int sink_) : root{new sp_tree_node{source_, sink_}} {}
 
-    ~sp_tree();
+    sp_tree() : root{sp_no_node} {}
+    sp_tree(int source_, int sink_, sp_node_pool& nodes) : root{nodes.edge(source_, sink_)} {}
 
     sp_tree(sp_tree const& other) = delete;
     sp_tree& operator=(sp_tree const& other) = delete;
 
-    sp_tree(sp_tree&& other) {
+    sp_tree(sp_tree&& other) noexcept {
         root = other.root;
-        other.root = nullptr;
+        other.root = sp_no_node;
     }
 
-    sp_tree& operator=(sp_tree&& other) {
+    sp_tree& operator=(sp_tree&& other) noexcept {
         if (this != &other) {
-            delete root;
             root = other.root;
-            other.root = nullptr;    
+            other.root = sp_no_node;
         }
         return *this;
     }
 };
 
-std::ostream& operator<<(std::ostream& os, sp_tree_node const& t) {
-    #ifdef __VERBOSE_LOGGING__
-    os << "{";
-    if (t.l) os << *(t.l);
-    os << t.source << c_type_char(t.comp) << t.sink;
-    if (t.r) os << *(t.r);
-    os << "}";
-    #else
-    os << "{" << t.source << c_type_char(t.comp) << t.sink << "}";
-    #endif
-    return os;
-}
-
-std::ostream& operator<<(std::ostream& os, sp_tree const& t) {
-    if (t.root) {
-        os << *(t.root);
-    } else {
-        os << "(null tree)";
-    }
-    return os;
-}
+// Stands in for sp_tree when no decomposition is kept. Recognition only asks a tree for its
+// source and, for K4 paths, for the sink of its leftmost edge; both come from the first operand
+// of every composition, so they are carried along without building any nodes.
+struct sp_tree_summary {
+    int first_source = -1; // -1 for the empty tree
+    int first_sink = -1;
 
-sp_tree::~sp_tree() {
-    if (!root) return;
-    std::stack<std::pair<sp_tree_node *, int>> hist;
-    hist.emplace(root, 0);
-    while (!hist.empty()) {
-        sp_tree_node * curr = hist.top().first;
-        if (hist.top().second == 0) {
-            hist.top().second = 1;
-            if (curr->r) hist.emplace(curr->r, 0);
-            if (curr->l) hist.emplace(curr->l, 0);
-        } else {
-            delete curr;
-            hist.pop();
-        }
+    void compose(sp_tree_summary&& other, c_type, sp_node_pool&) {
+        if (empty()) *this = std::move(other);
+        other = sp_tree_summary{};
     }
-}
-
-struct sp_chain_stack_entry {
-    sp_tree SP;
-    int end;
-    sp_tree tail;
-    sp_chain_stack_entry(sp_tree SP_, int end_, sp_tree tail_) : SP{std::move(SP_)}, end{end_}, tail{std::move(tail_)} {}
-    sp_chain_stack_entry() = default;
-};
 
-// ==================== AUXILIARY FUNCTIONS ====================
-void radix_sort(std::vector<int>& v) {
-    if(v.empty()) return;
-    int max_val = *std::max_element(v.begin(), v.end());
-    std::vector<int> output(v.size());
-    std::vector<int> count(10);
-    for(int exp = 1; max_val/exp > 0; exp *= 10) {
-        std::fill(count.begin(), count.end(), 0);
-        for(int i : v) count[(i/exp)%10]++;
-        for(int i = 1; i < 10; i++) count[i] += count[i-1];
-        for(int i = (int)v.size()-1; i >= 0; i--){
-            output[count[(v[i]/exp)%10]-1] = v[i];
-            count[(v[i]/exp)%10]--;
-        }
-        v = output;
+    void l_compose(sp_tree_summary&& other, c_type, sp_node_pool&) {
+        if (!other.empty()) *this = std::move(other);
+        other = sp_tree_summary{};
     }
-}
 
-bool trace_path(int end1, int end2, std::vector<edge_t> const& path, graph const& g, std::vector<bool>& seen) {
-    #ifdef __VERBOSE_LOGGING__
-    for (edge_t edge : path) {
-        V_LOG("(" << edge.first << ", " << edge.second << ") ")
-    }
-    #endif
-    
-    N_LOG("\n")
-    if (path.size() == 0) {
-        L_LOG("====== AUTH FAILED: no edges in path ======\n")
-        return false;
-    }
+    bool empty() const {return first_source == -1;}
+    int source(sp_node_pool const&) const {return first_source;}
+    int underlying_tree_path_source(sp_node_pool const&) const {return first_sink;}
 
-    if (path[0].first == end2) {
-        int tmp = end2;
-        end2 = end1;
-        end1 = tmp;
-    }
+    sp_tree_summary() = default;
+    sp_tree_summary(int source_, int sink_, sp_node_pool&) : first_source{source_}, first_sink{sink_} {}
 
-    if (path[0].first != end1) {
-        L_LOG("====== AUTH FAILED: start of path does not match either endpoint ======\n")
-        return false;
-    }
+    sp_tree_summary(sp_tree_summary const& other) = delete;
+    sp_tree_summary& operator=(sp_tree_summary const& other) = delete;
 
-    if (path.back().second != end2) {
-        L_LOG("====== AUTH FAILED: end of path does not match second endpoint ======\n")
-        return false;
+    sp_tree_summary(sp_tree_summary&& other) noexcept : first_source{other.first_source}, first_sink{other.first_sink} {
+        other.first_source = other.first_sink = -1;
     }
 
-    seen[end1] = true;
-    int prev_v = end1;
-    for (edge_t edge : path) {
-        if (!g.adjacent(edge.first, edge.second)) {
-            L_LOG("====== AUTH FAILED: edge (" << edge.first << ", " << edge.second << ") does not exist in graph ======\n")
-            return false;
-        }
-
-                if (prev_v != edge.first) {
-            L_LOG("====== AUTH FAILED: edge (" << edge.first << ", " << edge.second << ") is not incident on the previous edge ======\n")
-            return false;
-        }
-
-        prev_v = edge.second;
-
-        if (seen[edge.second]) {
-            L_LOG("====== AUTH FAILED: duplicated vertex " << edge.second << " ======\n")
-            return false;
+    sp_tree_summary& operator=(sp_tree_summary&& other) noexcept {
+        if (this != &other) {
+            first_source = other.first_source;
+            first_sink = other.first_sink;
+            other.first_source = other.first_sink = -1;
         }
-
-        seen[edge.second] = true;
+        return *this;
     }
+};
 
-    N_LOG("path good\n")
-    seen[end1] = false;
-    seen[end2] = false;
-    return true;
+inline sp_subtree<sp_node_pool> show(sp_node_pool const& nodes, sp_tree const& t) {
+    return show(nodes, t.root);
 }
 
-int num_comps_after_removal(graph const& g, int v) {
-    int retval = 0;
-    std::vector<bool> seen((size_t)(g.n), false);
-
-    for (int i = 0; i < g.n; i++) {
-        if (seen[i] || i == v) continue;
-        retval++;
-
-        std::stack<int> dfs;
-        dfs.emplace(i);
-
-        while (!dfs.empty()) {
-            int w = dfs.top();
-            dfs.pop();
-            seen[w] = true;
+inline std::string show(sp_node_pool const&, sp_tree_summary const& t) {
+    if (t.empty()) return "(null tree)";
+    return "{" + std::to_string(t.first_source) + "..." + std::to_string(t.first_sink) + "}";
+}
 
-            for (int u : g.adjLists[w]) {
-                if (!seen[u] && u != v) {
-                    dfs.emplace(u);
-                }
-            }
+// Moves a tree built in another pool into nodes, appending its nodes children first as the
+// compositions that built it did. walk and placed are scratch.
+inline sp_tree import_tree(sp_tree&& t, sp_node_pool const& from, sp_node_pool& nodes, std::vector<std::pair<uint32_t, uint32_t>>& walk, std::vector<uint32_t>& placed) {
+    sp_tree out;
+    if (t.empty()) return out;
+
+    // walk holds (node of from, whether its children are placed); placed the new indices of
+    // the finished subtrees, left before right
+    walk.clear();
+    placed.clear();
+    walk.emplace_back(t.root, 0);
+    while (!walk.empty()) {
+        auto [x, expanded] = walk.back();
+        if (from.is_edge(x)) {
+            walk.pop_back();
+            placed.push_back(nodes.edge(from.source[x], from.sink[x]));
+        } else if (!expanded) {
+            walk.back().second = 1;
+            walk.emplace_back(from.right[x], 0);
+            walk.emplace_back(from.left[x], 0);
+        } else {
+            walk.pop_back();
+            uint32_t r = placed.back();
+            placed.pop_back();
+            placed.back() = nodes.join(placed.back(), r, from.comp(x));
         }
     }
-
-    return retval;
+    out.root = placed.back();
+    t = sp_tree{};
+    return out;
 }
 
-bool is_cut_vertex(graph const& g, int v) {
-    if (num_comps_after_removal(g, v) <= 1) {
-        L_LOG("\n====== AUTH FAILED: " << v << " not a cut vertex ======\n\n")
-        return false;
-    }
-    N_LOG("yes\n")
-    return true;
+inline sp_tree_summary import_tree(sp_tree_summary&& t, sp_node_pool const&, sp_node_pool&, std::vector<std::pair<uint32_t, uint32_t>>&, std::vector<uint32_t>&) {
+    return std::move(t);
 }
 
-// ==================== CERTIFICATE DEFINITIONS ====================
-struct certificate {
-    bool verified = false;
-    virtual bool authenticate(graph const& g) = 0;
-    virtual ~certificate() {}
-};
-
-struct negative_cert_K4 : certificate {
-    int a, b, c, d;
-    std::vector<edge_t> ab, ac, ad, bc, bd, cd;
-
-    bool authenticate(graph const& g) override {
-        if (verified) return true;
-
-        L_LOG("====== AUTHENTICATE K4: terminating vertices a: " << a << ", b: " << b << ", c: " << c << ", d: " << d << " ======\n")
-        if (a == b || b == c || c == d || d == a || a == c || b == d) {
-            L_LOG("====== AUTH FAILED: terminating vertices non-distinct ======\n\n")
-            return false;
+// Copies the tree rooted at root out of the pool into arrays allocated by alloc (called as
+// alloc(bytes, align)), renumbering the nodes in postfix order. order is scratch.
+template <typename Alloc>
+sp_decomposition extract_decomposition(sp_node_pool const& nodes, uint32_t root, Alloc&& alloc, std::vector<std::pair<uint32_t, uint32_t>>& order) {
+    sp_decomposition d;
+    if (root == sp_no_node) return d;
+
+    // the pool may hold nodes of dropped trees, so count the reachable ones first
+    order.clear();
+    order.emplace_back(root, 0);
+    while (!order.empty()) {
+        uint32_t x = order.back().first;
+        order.pop_back();
+        d.size++;
+        if (!nodes.is_edge(x)) {
+            order.emplace_back(nodes.left[x], 0);
+            order.emplace_back(nodes.right[x], 0);
         }
-        std::vector<bool> seen((size_t)(g.n), false);
-
-        N_LOG("verify ab: ")
-        if (!trace_path(a, b, ab, g, seen)) return false;
-        N_LOG("verify ac: ")
-        if (!trace_path(a, c, ac, g, seen)) return false;
-        N_LOG("verify ad: ")
-        if (!trace_path(a, d, ad, g, seen)) return false;
-        N_LOG("verify bc: ")
-        if (!trace_path(b, c, bc, g, seen)) return false;
-        N_LOG("verify bd: ")
-        if (!trace_path(b, d, bd, g, seen)) return false;
-        N_LOG("verify cd: ")
-        if (!trace_path(c, d, cd, g, seen)) return false;
-
-        L_LOG("====== AUTH SUCCESS ======\n\n")
-        verified = true;
-        return true;
     }
-};
-
-struct negative_cert_K23 : certificate {
-    int a, b;
-    std::vector<edge_t> one, two, three;
-
-    bool authenticate(graph const& g) override {
-        if (verified) return true;
-
-        L_LOG("====== AUTHENTICATE K23: terminating vertices a: " << a << ", b: " << b << " ======\n")
-
-        if (a == b) {
-            L_LOG("====== AUTH FAILED: terminating vertices non-distinct ======\n\n")
-            return false;
-        }
-
-        std::vector<bool> seen((size_t)(g.n), false);
-
-        N_LOG("verify path one: ")
-        if (!trace_path(a, b, one, g, seen)) return false;
-        if (one.size() < 2) {
-            L_LOG("\n====== AUTH FAILED: path one has no internal vertex ======\n\n")
-            return false;
-        }
-
-        N_LOG("verify path two: ")
-        if (!trace_path(a, b, two, g, seen)) return false;
-        if (two.size() < 2) {
-            L_LOG("\n====== AUTH FAILED: path two has no internal vertex ======\n\n")
-            return false;
-        }
 
-        N_LOG("verify path three: ")
-        if (!trace_path(a, b, three, g, seen)) return false;
-        if (three.size() < 2) {
-            L_LOG("\n====== AUTH FAILED: path three has no internal vertex ======\n\n")
-            return false;
+    uint32_t n = d.size;
+    d.source = {(int *)(alloc(n * sizeof(int), alignof(int))), n};
+    d.sink = {(int *)(alloc(n * sizeof(int), alignof(int))), n};
+    d.left = {(uint32_t *)(alloc(n * sizeof(uint32_t), alignof(uint32_t))), n};
+    d.right = {(uint32_t *)(alloc(n * sizeof(uint32_t), alignof(uint32_t))), n};
+    d.comp_bits = {(uint8_t *)(alloc((n + 3) / 4, 1)), (n + 3) / 4};
+    std::fill(d.comp_bits.begin(), d.comp_bits.end(), 0);
+
+    // a preorder walk that takes right subtrees first, numbered from the back, is a postfix
+    // order; order holds (pool node, new index of its parent), and the parent's right child
+    // is always numbered before its left one
+    uint32_t next = n;
+    order.emplace_back(root, sp_no_node);
+    while (!order.empty()) {
+        auto [x, parent] = order.back();
+        order.pop_back();
+        uint32_t i = --next;
+        if (parent != sp_no_node) (d.right[parent] == sp_no_node ? d.right[parent] : d.left[parent]) = i;
+        d.source[i] = nodes.source[x];
+        d.sink[i] = nodes.sink[x];
+        d.left[i] = d.right[i] = sp_no_node;
+        if (!nodes.is_edge(x)) {
+            pack_comp(d.comp_bits.data(), i, nodes.comp(x));
+            order.emplace_back(nodes.left[x], i);
+            order.emplace_back(nodes.right[x], i);
         }
-
-        L_LOG("====== AUTH SUCCESS ======\n\n")
-        verified = true;
-        return true;
     }
-};
-
-struct negative_cert_T4 : certificate {
-    int c1, c2, a, b;
-    std::vector<edge_t> c1a, c1b, c2a, c2b, ab;
+    return d;
+}
 
-    bool authenticate(graph const& g) override {
-        if (verified) return true;
-        L_LOG("====== AUTHENTICATE T4: terminating vertices a: " << a << ", b: " << b << ", c1: " << c1 << ", c2: " << c2 << " ======\n")
+template <typename Tree>
+struct sp_chain_stack_entry {
+    Tree SP;
+    int end;
+    Tree tail;
+    uint32_t next = 0; // entry below this one, or the next free entry
+    sp_chain_stack_entry(Tree SP_, int end_, Tree tail_) : SP{std::move(SP_)}, end{end_}, tail{std::move(tail_)} {}
+    sp_chain_stack_entry() = default;
+};
 
-        if (a == b || a == c1 || a == c2 || b == c1 || b == c2 || c1 == c2) {
-            L_LOG("====== AUTH FAILED: terminating vertices non-distinct ======\n\n")
-            return false;
+// The ear-chain stacks of all vertices, sharing one pool of entries linked by 32-bit indices;
+// a vertex only holds the index of its top entry. Popped entries go to a free list, so the
+// pool is as large as the most entries ever live at once, not one block per vertex.
+// References returned by top() are invalidated by push().
+template <typename Tree>
+class chain_stack_arena {
+public:
+    static constexpr uint32_t none = UINT32_MAX;
+
+    bool empty(int v) const {return head[v] == none;}
+    sp_chain_stack_entry<Tree>& top(int v) {return entries[head[v]];}
+
+    void push(int v, Tree SP, int end, Tree tail) {
+        uint32_t i = free_head;
+        if (i != none) {
+            free_head = entries[i].next;
+            entries[i].SP = std::move(SP);
+            entries[i].end = end;
+            entries[i].tail = std::move(tail);
+        } else {
+            i = (uint32_t)(entries.size());
+            entries.emplace_back(std::move(SP), end, std::move(tail));
         }
-
-        N_LOG("verify c1 cut vertex: ")
-        if (!is_cut_vertex(g, c1)) return false;
-        N_LOG("verify c2 cut vertex: ")
-        if (!is_cut_vertex(g, c2)) return false;
-
-        std::vector<bool> seen((size_t)(g.n), false);
-        N_LOG("verify path c1a: ")
-        if (!trace_path(c1, a, c1a, g, seen)) return false;
-        N_LOG("verify path c2a: ")
-        if (!trace_path(c2, a, c2a, g, seen)) return false;
-        N_LOG("verify path ab: ")
-        if (!trace_path(a, b, ab, g, seen)) return false;
-        N_LOG("verify path c1b: ")
-        if (!trace_path(c1, b, c1b, g, seen)) return false;
-        N_LOG("verify path c2b: ")
-        if (!trace_path(c2, b, c2b, g, seen)) return false;
-
-        L_LOG("====== AUTH SUCCESS ======\n\n")
-        verified = true;
-        return true;
+        entries[i].next = head[v];
+        head[v] = i;
     }
-};
 
-struct negative_cert_tri_comp_cut : certificate {
-    int v;
+    void pop(int v) {
+        uint32_t i = head[v];
+        head[v] = entries[i].next;
+        entries[i].SP = Tree{};
+        entries[i].tail = Tree{};
+        entries[i].next = free_head;
+        free_head = i;
+    }
 
-    bool authenticate(graph const& g) override {
-        if (verified) return true;
-        L_LOG("====== AUTHENTICATE THREE-COMPONENT CUT VERTEX: " << v << " ======\n")
+    void clear(int v) {
+        while (!empty(v)) pop(v);
+    }
 
-        int comps = num_comps_after_removal(g, v);
+    void resize(size_t n) {head.resize(n, none);}
+    size_t capacity() const {return entries.capacity();}
 
-        if (comps < 3) {
-            L_LOG("====== AUTH FAILED: vertex " << v << " only splits graph into " << comps << " components ======\n\n")
-            return false;
-        }
+private:
+    std::vector<sp_chain_stack_entry<Tree>> entries;
+    std::vector<uint32_t> head;
+    uint32_t free_head = none;
+};
 
-        N_LOG(comps << " comps after removal\n")
-        L_LOG("====== AUTH SUCCESS ======\n\n")
+// ==================== RECOGNIZER CONTEXT ====================
+using dfs_stack = std::stack<std::pair<int, int>, std::vector<std::pair<int, int>>>;
+
+// An ear of recognize_block_by_ears: a nontree edge (u, v) of the BFS tree and the tree edges
+// it labels, the path from top_u down to u, across to v and up to top_v (the first ear runs from
+// u up to the root and down to v instead). Vertices are named by their positions in touched.
+struct ear_record {
+    int u = 0;
+    int v = 0;
+    int lca = 0; // lowest common ancestor of u and v
+    int cu = 0; // the children of lca above u and v
+    int cv = 0;
+    int top_u = 0;
+    int top_v = 0;
+    int len = 0; // edges
+    int host = -1; // the earlier ear it is nested in; -1 for the first ear
+    int lo = 0; // positions of its ends on the host, lo < hi
+    int hi = 0;
+    bool reversed = false; // top_u is at hi
+};
 
-        verified = true;
-        return true;
+// How often the pre-filter of SP_RECOGNITION (--prefilter) ran, and rejected a graph by each
+// of its tests; per run in a context, per input graph in a recognizer_workspace.
+struct prefilter_counts {
+    long long graphs = 0;
+    long long edge_bound = 0; // more than 2n - 3 edges
+    long long core = 0; // within the bound, but with a non-empty 3-core
+
+    prefilter_counts& operator+=(prefilter_counts const& other) {
+        graphs += other.graphs;
+        edge_bound += other.edge_bound;
+        core += other.core;
+        return *this;
     }
 };
 
-struct negative_cert_tri_cut_comp : certificate {
-    int c1, c2, c3;
-
-    bool authenticate(graph const& g) override {
-        if (verified) return true;
-        L_LOG("====== AUTHENTICATE BICOMP WITH THREE CUT VERTICES: cut vertices " << c1 << ", " << c2 << ", " << c3 << " ======\n")
-        N_LOG("verify c1 cut vertex: ")
-        if (!is_cut_vertex(g, c1)) return false;
-        N_LOG("verify c2 cut vertex: ")
-        if (!is_cut_vertex(g, c2)) return false;
-        N_LOG("verify c3 cut vertex: ")
-        if (!is_cut_vertex(g, c3)) return false;
-
-        std::vector<int> dfs_no((size_t)(g.n), 0);
-        std::vector<int> parent((size_t)(g.n)); 
-        std::vector<int> low((size_t)(g.n));
-        int cut_verts[3] = {c1, c2, c3};
-
-        std::stack<edge_t> comp_edges;
-        std::stack<std::pair<int, int>> dfs;
-
-        dfs.emplace(0, 0);
-        dfs_no[0] = 1;
-        low[0] = 1;
-        parent[0] = -1;
-        int curr_dfs = 2;
-
-        while (!dfs.empty()) {
-            std::pair<int, int> p = dfs.top();
-            int w = p.first;
-            int u = g.adjLists[p.first][p.second];
-
-            if (dfs_no[u] == 0) {
-                dfs.push(std::pair{u, 0});
-                comp_edges.emplace(w, u);
-                parent[u] = w;
-                dfs_no[u] = curr_dfs++;
-                low[u] = dfs_no[u];
-                continue;
-            }
-
-            if (parent[u] == w) {
-                if (low[u] >= dfs_no[w]) {
-                    bool seen[3] = {false, false, false};
-                    edge_t e;
-                    do {
-                        e = comp_edges.top();
-                        for (int i = 0; i < 3; i++) {
-                            if (e.first == cut_verts[i] || e.second == cut_verts[i]) seen[i] = true;
-                        }
-                        comp_edges.pop();
-                    } while (e != edge_t{w, u});
-
-                    if (seen[0] && seen[1] && seen[2]) {
-                        N_LOG("vertices belong to one biconnected component...\n")    
-                        L_LOG("====== AUTH SUCCESS ======\n\n")
-                        verified = true;
-                        return true;
-                    }
-                }
-
-                if (low[u] < low[w]) low[w] = low[u];
-            } else if (dfs_no[u] < dfs_no[w] && u != parent[w]) {
-                comp_edges.emplace(w, u);
-                if (dfs_no[u] < low[w]) low[w] = dfs_no[u];
-            }
+// An edge of the multigraph recognize_by_reductions reduces: an edge of the graph, or what a
+// series or parallel reduction left in place of several. Its SP tree runs from u to v.
+struct reduction_edge {
+    int u = 0;
+    int v = 0;
+    uint32_t tree = sp_no_node; // under the full policy, once it is fixed
+    uint32_t weight = 0; // nodes of that tree, counted under every policy; 0 while its direction is free
+    int branches = 0; // with an inner vertex: 0 for an edge of the graph, 1 for a series, the sum for a parallel
+    int pin_a = -1; // the ends of a parallel of two such branches held in series below it, -1 if none
+    int pin_b = -1;
+};
 
-            if ((size_t)(++dfs.top().second) >= g.adjLists[p.first].size()) {
-                dfs.pop();
-            }
-        }
+// Open-addressing map from the edges of a multigraph to their ids, like edge_set. An entry is
+// never removed: an edge only goes away with one of its ends, which is never looked up again.
+class edge_index {
+public:
+    // empties the map, sized for up to edges edges
+    void reset(size_t edges) {
+        int bits = 1;
+        while (((size_t)(1) << bits) < 2 * edges + 2) bits++;
+        shift = 64 - bits;
+        mask = ((size_t)(1) << bits) - 1;
+        keys.assign(mask + 1, empty_key);
+        ids.resize(mask + 1);
+    }
 
-        L_LOG("====== AUTH FAILED: bicomp does not contain the three cut vertices ======\n\n")
-        return false;
+    void insert(int u, int v, int id) {
+        uint64_t k = key(u, v);
+        size_t i = slot(k);
+        for (; keys[i] != empty_key && keys[i] != k; i = (i + 1) & mask);
+        keys[i] = k;
+        ids[i] = id;
     }
-};
 
-struct positive_cert_sp : certificate {
-    sp_tree decomposition;
-    bool is_sp;
-
-    bool authenticate(graph const& g) override {
-        if (verified) return true;
-
-        std::vector<int> n_src((size_t)(g.n), 0);
-        std::vector<int> n_sink((size_t)(g.n), 0);
-        std::vector<bool> no_edge((size_t)(g.n), false);
-        bool swap = false;
-
-        graph g2{};
-        g2.n = g.n;
-        g2.reserve(g);
-        g2.e = 0;
-        
-        std::stack<std::pair<sp_tree_node *, int>> hist;
-        L_LOG("====== AUTHENTICATE SP DECOMPOSITION TREE ======\n")
-        if (!decomposition.root) {
-            L_LOG("====== AUTH FAILED: decomposition tree does not exist ======\n\n")
-            return false;
+    // the id of edge (u, v), -1 if there is none
+    int find(int u, int v) const {
+        uint64_t k = key(u, v);
+        for (size_t i = slot(k);; i = (i + 1) & mask) {
+            if (keys[i] == k) return ids[i];
+            if (keys[i] == empty_key) return -1;
         }
+    }
 
-        hist.emplace(decomposition.root, 0);
-
-        while (!hist.empty()) {
-            sp_tree_node * curr = hist.top().first;
-            V_LOG("traversal: " << *curr << ", phase: " << hist.top().second << "\n")
-            int source = (swap ? curr->sink : curr->source);
-            int sink = (swap ? curr->source : curr->sink);
-
-            if (hist.top().second == 0) {
-                if (!(curr->l) || !(curr->r)) {
-                    if (curr->l || curr->r) {
-                        L_LOG("====== AUTH FAILED: node " << *curr << " malformed (one child) ======\n\n")
-                        return false;
-                    }
-
-                    if (curr->comp != c_type::edge) {
-                        L_LOG("====== AUTH FAILED: node " << *curr << " malformed (leaf, but not an edge) ======\n\n")
-                        return false;
-                    }
-
-                    if (no_edge[source] || no_edge[sink]) {
-                                                L_LOG("====== AUTH FAILED: edge node " << *curr << " is incident on an vertex already merged into a series SP subgraph ======\n\n")
-                        return false;
-                    }
-
-                    g2.add_edge(source, sink);
-                    n_src[source]++;
-                    n_sink[sink]++;
-                    hist.pop();
-                } else {
-                    if (curr->comp == c_type::antiparallel) swap = !swap;
-                    hist.top().second++;
-                    hist.emplace(curr->r, 0);
-                }
-            } else if (hist.top().second == 1) {
-                if (curr->comp == c_type::antiparallel) swap = !swap;
-                hist.top().second++;
-                hist.emplace(curr->l, 0);
-            } else {
-                int lsource = (swap ? curr->r->sink : curr->l->source);
-                int lsink = (swap ? curr->r->source : curr->l->sink);
-                int rsource = (swap ? curr->l->sink : curr->r->source);
-                int rsink = (swap ? curr->l->source : curr->r->sink);
-
-                switch (curr->comp) {
-                    case c_type::edge:
-                        L_LOG("====== AUTH FAILED: node " << *curr << " malformed (edge, but internal) ======\n\n")
-                        return false;
-                    case c_type::series:
-                        if (lsource != source || rsink != sink || lsink != rsource) {
-                            L_LOG("====== AUTH FAILED: node " << *curr << " malformed (series children source/sink mismatch) ======\n\n")
-                            return false;
-                        }
-
-                        if (n_src[lsink] != 1 || n_sink[lsink] != 1) {
-                            L_LOG("====== AUTH FAILED: series node " << *curr << " has incident edges on its middle vertex " << lsink << " which cannot be merged into it ======\n\n")
-                            return false;
-                        }
-
-                        V_LOG("BLOCKING: " << lsink << "\n")
-                        no_edge[lsink] = true;
-                        n_src[lsink]--;
-                        n_sink[lsink]--;
-                        break;
-                    case c_type::parallel:
-                        if (lsource != source || rsource != source || lsink != sink || rsink != sink) {
-                            L_LOG("====== AUTH FAILED: node " << *curr << " malformed (parallel children source/sink mismatch) ======\n\n")
-                            return false;
-                        }
-
-                        n_src[source]--;
-                        n_sink[sink]--;
-                        break;
-                    case c_type::antiparallel:
-                        if (swap) {
-                            if (lsource != sink || rsource != source || lsink != source || rsink != sink) {
-                                L_LOG("====== AUTH FAILED: node " << *curr << " malformed (antiparallel children source/sink mismatch) ======\n\n")
-                                return false;
-                            }
-                        } else {
-                            if (lsource != source || rsource != sink || lsink != sink || rsink != source) {
-                                L_LOG("====== AUTH FAILED: node " << *curr << " malformed (antiparallel children source/sink mismatch) ======\n\n")
-                                return false;
-                            }
-                        }
+    size_t capacity() const {return keys.capacity() * sizeof(uint64_t) + ids.capacity() * sizeof(int);}
 
-                        n_src[source]--;
-                        n_sink[sink]--;
-                        break;
-                    case c_type::dangling:
-                        if (is_sp) {
-                            L_LOG("====== AUTH FAILED: illegal dangling composition in SP decomposition tree ======\n\n")
-                            return false;
-                        }
+private:
+    static constexpr uint64_t empty_key = UINT64_MAX;
+    std::vector<uint64_t> keys;
+    std::vector<int> ids;
+    size_t mask = 0;
+    int shift = 64;
 
-                        if (swap) {
-                            if (rsource != source || rsink != sink || lsink != sink) {
-                                L_LOG("====== AUTH FAILED: node " << *curr << " malformed (dangling children source/sink mismatch) ======\n\n")
-                                return false;
-                            }
-                        } else {
-                            if (lsource != source || lsink != sink || rsource != source) {
-                                L_LOG("====== AUTH FAILED: node " << *curr << " malformed (dangling children source/sink mismatch) ======\n\n")
-                                return false;
-                            }
-                        }
+    static uint64_t key(int u, int v) {
+        if (u > v) std::swap(u, v);
+        return ((uint64_t)(uint32_t)(u) << 32) | (uint32_t)(v);
+    }
 
-                        if (swap) {
-                            n_src[lsource]--;
-                            n_sink[sink]--;
-                        } else {
-                            n_src[source]--;
-                            n_sink[rsink]--;
-                        }
+    size_t slot(uint64_t k) const {return (size_t)((k * 0x9e3779b97f4a7c15ULL) >> shift);}
+};
 
-                        break;
-                }
+// Scratch buffers of get_bicomps and SP_RECOGNITION, kept across runs. The buffers only grow;
+// prepare() restores just the entries of the vertices the previous run visited (the DFS of
+// get_bicomps reaches every vertex either function touches), so recognizing a batch of graphs
+// allocates nothing here once the context has seen the largest graph. SP trees are built in
+// nodes; the result (the certificate and its extracted tree) goes to an arena of the pool, the
+// first one no earlier result still holds, rewound for the run. The "no vertex" sentinel used by
+// ear/earliest_outgoing is the capacity rather than g.n so that it stays valid between graphs
+// of different orders. Tree is sp_tree, or sp_tree_summary for runs that keep no decomposition
+// (and then leave nodes empty).
+template <typename Tree>
+struct basic_recognizer_context {
+    int capacity = 0;
+    int nil = 0; // sentinel vertex, dfs_no[nil] == nil
+    std::vector<int> touched; // vertices visited by the last get_bicomps, in discovery order
+    int used_bicomps = 0; // bicomp-indexed entries used by the last run
+
+    // get_bicomps
+    std::vector<int> bc_dfs_no;
+    std::vector<int> bc_parent;
+    std::vector<int> bc_low;
+    std::vector<edge_t> bicomps;
+    std::vector<edge_t> dfs_bicomps; // bicomps before they were ordered as a chain
+    std::vector<int> prev_cut;
+
+    // get_bicomps_parallel, grown on its first run; by position in touched unless noted
+    bool blocks_labeled = false; // block_of and block_heads are filled already
+    std::vector<int> bc_pos; // by vertex: its position in touched
+    std::vector<int> bc_levels; // position where each BFS level begins, then the end of the last
+    std::vector<int> bc_first_child; // position of the first child; those of t end where those of t + 1 begin
+    std::vector<int> bc_size; // subtree size
+    std::vector<int> bc_reach_low; // lowest dfs_no a nontree edge from the subtree reaches
+    std::vector<int> bc_reach_high; // highest
+    std::vector<int> bc_link; // union-find over the tree edges, each named by the position of its child
+    std::vector<int> bc_block; // at the position where a block starts: the block
+    std::vector<std::vector<int>> bc_chunk_found; // per chunk: vertices or positions it found
+    std::vector<int> bc_chunk_base;
+
+    // recognize_block_by_ears, grown on its first run; by position in touched unless noted
+    std::vector<int> ear_depth;
+    std::vector<int> ear_pre; // dfs_no
+    std::vector<int> ear_up; // position of the parent
+    std::vector<int> ear_group; // first ear whose ends meet at each lowest common ancestor
+    std::vector<int> ear_cursor;
+    std::vector<char> ear_seen; // child reached by the BFS over the children of its parent
+    std::vector<int> ear_first; // first end in a child in that BFS
+    std::vector<uint64_t> ear_key; // lowest key of a nontree edge leaving the subtree
+    std::vector<int> ear_label; // ear of the tree edge to the parent
+    std::vector<ear_record> ear_raw; // by nontree edge
+    std::vector<ear_record> ears;
+    std::vector<int> ear_order; // nontree edges by lowest common ancestor
+    std::vector<int> ear_rank;
+    std::vector<int> ear_host_start; // by ear: where the ears it hosts begin in ear_hosted
+    std::vector<int> ear_hosted;
+    std::vector<int> ear_scan; // exclusive_scan scratch
+    std::vector<uint32_t> ear_tree;
+    std::vector<int> ear_path;
+    std::vector<int> ear_walk; // certificate paths: the ear walked by whole and around
+    std::vector<int> ear_host_walk;
+    std::vector<std::vector<std::pair<int, int>>> ear_chunk_ends; // per chunk: (child, nontree edge)
+
+    // prefilter_reject, grown on its first run; by vertex
+    bool prefilter = false; // run it before the bicomps
+    prefilter_counts prefiltered;
+    std::vector<int> core_degree; // after peeling, at least 3 exactly in the 3-core
+    std::vector<int> core_queue;
+    std::vector<int> core_dfs_no; // 0 between runs
+    std::vector<int> core_low;
+    std::vector<int> core_parent;
+    std::vector<int> core_seen; // the last vertex found next to it by the simplicity check
+    std::vector<int> core_owner; // 0 in the leaf block, -1 between runs
+    std::vector<int> core_visited;
+    std::vector<int> core_stack;
+    std::vector<std::pair<int, int>> core_frames;
+    std::vector<int> core_block;
+
+    // recognize_by_reductions, grown on its first run; by vertex, edge or half-edge (2e and
+    // 2e + 1 are edge e at either end)
+    bool reductions = false; // try them before the bicomps (--engine reduction)
+    std::vector<int> red_degree; // 0 once reduced
+    std::vector<int> red_head; // first half-edge at the vertex, -1 if none
+    std::vector<int> red_next; // by half-edge, -1 at the end of the list
+    std::vector<int> red_prev; // -1 at the head
+    std::vector<int> red_at; // the vertex whose list holds the half-edge
+    std::vector<reduction_edge> red_edges;
+    std::vector<int> red_pending; // vertices that came down to degree 2, last first
+    edge_index red_index;
+    std::vector<std::pair<uint32_t, uint32_t>> red_walk; // tree walks: (node, stage or flip)
+    std::vector<uint32_t> red_done; // reversed subtrees
+    std::vector<std::pair<uint32_t, bool>> red_branches; // (node, flip)
+    std::vector<std::pair<uint32_t, bool>> red_blocks;
+    std::vector<int> red_path;
+    std::vector<int> red_bucket;
+    std::vector<std::pair<int, int>> red_halves;
+
+    // SP_RECOGNITION
+    std::vector<int> cut_verts;
+    std::vector<Tree> cut_vertex_attached_tree;
+    std::vector<int> comp;
+    chain_stack_arena<Tree> vertex_stacks;
+    std::vector<int> dfs_no;
+    std::vector<int> parent;
+    std::vector<edge_t> ear;
+    std::vector<Tree> seq;
+    std::vector<int> earliest_outgoing;
+    std::vector<char> num_children;
+    std::vector<int> alert;
+    std::vector<char> marked; // all false between runs
+    dfs_stack dfs;
+
+    // reroute_virtual_k4, grown on its first run; by vertex, then the pieces of the theta
+    std::vector<int> reroute_from; // -1 between runs
+    std::vector<int> reroute_queue;
+    std::vector<int> reroute_arm[2][2];
+    std::vector<int> reroute_stub[2];
+    std::vector<int> reroute_third;
+    std::vector<int> reroute_detour;
+    std::vector<int> reroute_xz;
+    std::vector<int> reroute_kept;
+
+    // outer_embedding_of
+    std::vector<int> block_of; // block of the tree edge to the parent
+    std::vector<int> block_heads;
+    std::vector<int> block_edge_start;
+    std::vector<edge_t> block_edges;
+    std::vector<int> block_vertices;
+    std::vector<int> block_seen; // last block a vertex was found in, -1 between runs
+    std::vector<int> first_half;
+    std::vector<int> half_to;
+    std::vector<int> half_next;
+    std::vector<char> edge_dead;
+    edge_set joined;
+    std::vector<int> elim_degree;
+    std::vector<int> elim_stack;
+    std::vector<std::array<int, 3>> eliminated;
+    std::vector<int> cycle_next;
+    std::vector<int> cycle_pos;
+    std::vector<int> next_slot;
+    std::vector<int> rotation_start;
+
+    // bicomps of the chain recognized on a pool (block_workers)
+    std::vector<int> chain_pos; // position in the chain of each block of the DFS tree
+    std::vector<uint32_t> imported; // import_tree scratch
+
+    sp_node_pool nodes;
+    std::vector<std::pair<uint32_t, uint32_t>> tree_walk;
+    arena_pool arenas;
+    std::shared_ptr<sp_arena> arena; // of this run's result, from arenas
+
+    // set by a run that grew the context, whose allocations are warm-up (__COUNT_ALLOCATIONS__)
+    bool grown = false;
+
+    void reset_vertex(int v) {
+        bc_dfs_no[v] = 0;
+        bc_parent[v] = 0;
+        bc_low[v] = 0;
+        cut_verts[v] = -1;
+        block_seen[v] = -1;
+        reset_recognition(v);
+    }
 
-                hist.pop();
-            }
-        }
+    void reset_recognition(int v) {
+        comp[v] = -1;
+        vertex_stacks.clear(v);
+        dfs_no[v] = 0;
+        parent[v] = 0;
+        ear[v] = edge_t{nil, nil};
+        seq[v] = Tree{};
+        earliest_outgoing[v] = nil;
+        num_children[v] = 0;
+        alert[v] = -1;
+    }
 
-        N_LOG("decomposition tree well-formed...\n")
-        n_src[decomposition.root->source]--;
-        n_sink[decomposition.root->sink]--;
+    // Undoes everything SP_RECOGNITION did in this run but keeps what get_bicomps found, with
+    // the bicomps back in DFS order, so that they can be recognized again one at a time.
+    void restart_recognition() {
+        for (int v : touched) reset_recognition(v);
+        for (int i = 0; i < used_bicomps; i++) cut_vertex_attached_tree[i] = Tree{};
+        bicomps.assign(dfs_bicomps.begin(), dfs_bicomps.end());
+        for (; !dfs.empty(); dfs.pop());
+        nodes.clear();
+    }
 
-        bool failed = false;
-        for (int i = 0; i < g.n; i++) {
-            if (n_src[i] != 0) {
-                N_LOG("OH NO: disconnected SP subgraph sourced at vertex " << i << "\n")
-                failed = true;
-            }
-            
-            if (n_sink[i] != 0) {
-                N_LOG("OH NO: disconnected SP subgraph sinked at vertex " << i << "\n")
-                failed = true;
-            }
+    // readies the buffers for a graph of order n; returns whether they had to grow. A context
+    // prepared with recognition_only only ever runs recognize_bicomp on bicomps others found,
+    // and leaves the buffers of get_bicomps and outer_embedding_of empty.
+    bool prepare(int n, bool recognition_only = false) {
+        for (int v : touched) reset_vertex(v);
+        touched.clear();
+        for (int i = 0; i < used_bicomps; i++) {
+            cut_vertex_attached_tree[i] = Tree{};
+            prev_cut[i] = -1;
         }
+        used_bicomps = 0;
+        bicomps.clear();
+        blocks_labeled = false;
+        for (; !dfs.empty(); dfs.pop());
+        nodes.clear();
+
+        bool grew = false;
+        arena = nullptr;
+        arena = arenas.acquire(grew);
+
+        if (n <= capacity) return grew;
+
+        size_t cap = (size_t)(n);
+        dfs_no[nil] = 0;
+        capacity = n;
+        nil = n;
+        touched.reserve(cap);
+        comp.resize(cap, -1);
+        vertex_stacks.resize(cap);
+        dfs_no.resize(cap + 1, 0);
+        dfs_no[nil] = nil;
+        parent.resize(cap, 0);
+        ear.assign(cap, edge_t{nil, nil});
+        seq.resize(cap);
+        earliest_outgoing.assign(cap, nil);
+        num_children.resize(cap, 0);
+        alert.resize(cap, -1);
+        marked.resize(cap, false);
+
+        std::vector<std::pair<int, int>> stack_storage;
+        stack_storage.reserve(cap + 1);
+        dfs = dfs_stack{std::move(stack_storage)};
+        if (recognition_only) return true;
+
+        bc_dfs_no.resize(cap, 0);
+        bc_parent.resize(cap, 0);
+        bc_low.resize(cap, 0);
+        bicomps.reserve(cap);
+        dfs_bicomps.reserve(cap);
+        prev_cut.resize(cap, -1);
+        cut_verts.resize(cap, -1);
+        cut_vertex_attached_tree.resize(cap);
+        block_of.resize(cap);
+        block_seen.resize(cap, -1);
+        first_half.resize(cap);
+        elim_degree.resize(cap);
+        cycle_next.resize(cap);
+        cycle_pos.resize(cap);
+        next_slot.resize(cap);
+        rotation_start.resize(cap);
+        chain_pos.resize(cap);
+        return true;
+    }
 
-        if (failed) {
-            L_LOG("====== AUTH FAILED: additional disconnected SP subgraphs are part of the decomposition tree ======\n\n")
-            return false;
-        }
+    // bytes held by the pools that grow on demand during a run
+    size_t pool_capacity() const {
+        return vertex_stacks.capacity() * sizeof(sp_chain_stack_entry<Tree>) + nodes.capacity()
+            + tree_walk.capacity() * sizeof(tree_walk[0]) + arena->capacity()
+            + (block_heads.capacity() + block_edge_start.capacity() + block_vertices.capacity() + half_to.capacity()
+               + half_next.capacity() + elim_stack.capacity()) * sizeof(int)
+            + block_edges.capacity() * sizeof(edge_t) + edge_dead.capacity() + joined.capacity() * sizeof(uint64_t)
+            + eliminated.capacity() * sizeof(eliminated[0]) + imported.capacity() * sizeof(uint32_t)
+            + reroute_capacity() * sizeof(int) + reduction_capacity();
+    }
 
-        N_LOG("decomposition tree connected...\n")
+    // bytes of the recognize_by_reductions scratch that grows with the trees it walks
+    size_t reduction_capacity() const {
+        return (red_walk.capacity() + red_branches.capacity() + red_blocks.capacity()) * sizeof(std::pair<uint32_t, uint32_t>)
+            + (red_pending.capacity() + red_path.capacity() + red_bucket.capacity()) * sizeof(int)
+            + red_done.capacity() * sizeof(uint32_t) + red_halves.capacity() * sizeof(std::pair<int, int>);
+    }
 
-        for (size_t i = 0; i < g2.adjLists.size(); i++) {
-            std::vector<int> l1 = g.adjLists[i];
-            radix_sort(l1);
-            radix_sort(g2.adjLists[i]);
-            if (l1 != g2.adjLists[i]) {
-                L_LOG("====== AUTH FAILED: vertex " << i << " of G does not have the same adjacency list as the one produced by the decomposition tree ======\n\n")
+    size_t reroute_capacity() const {
+        size_t total = reroute_from.capacity() + reroute_queue.capacity() + reroute_third.capacity() + reroute_detour.capacity()
+                     + reroute_xz.capacity() + reroute_kept.capacity();
+        for (int s = 0; s < 2; s++) total += reroute_stub[s].capacity() + reroute_arm[s][0].capacity() + reroute_arm[s][1].capacity();
+        return total;
+    }
 
-                #ifdef __LOGGING__
-                N_LOG("ORIGINAL GRAPH: ")
-                g2.output_adj_list(i, std::cout);
-                N_LOG("PRODUCED GRAPH: ")
-                g2.output_adj_list(i, std::cout);
-                #endif
+    basic_recognizer_context() : dfs_no(1, 0) {}
+};
 
-                L_LOG("======================================================================\n\n")
-                return false;                
-            }
-        }
+using recognizer_context = basic_recognizer_context<sp_tree>;
+
+// ==================== CERTIFICATE POLICIES ====================
+// SP_RECOGNITION is compiled once per policy, and whatever a policy does not keep is compiled
+// out rather than skipped at run time:
+//   full_certificate      the decomposition tree of an SP graph, an obstruction with its paths
+//   terminal_certificate  the obstruction kind and its terminal vertices; an SP graph gets an
+//                         SP certificate without a tree
+//   boolean_certificate   the verdicts alone; no certificate is made and the first K4 ends
+//                         the run
+// The first two report the same certificate kind and terminals for every graph. Deciding
+// whether a K4 passes through the virtual edge of a chained bicomp (and is really a T4) needs
+// its paths, so terminal runs still build them in those bicomps; boolean runs leave that to
+// the blockwise phase.
+template <bool certificate_, bool paths_>
+struct certificate_policy {
+    static constexpr bool certificate = certificate_;
+    static constexpr bool paths = paths_;
+    using tree = std::conditional_t<paths_, sp_tree, sp_tree_summary>;
+};
 
-        N_LOG("decomposition tree produces graph identical to G...\n")
-        L_LOG("====== AUTH SUCCESS ======\n\n")
+using full_certificate = certificate_policy<true, true>;
+using terminal_certificate = certificate_policy<true, false>;
+using boolean_certificate = certificate_policy<false, false>;
 
-        verified = true;
-        return true;
-    }
-};
+enum class cert_policy {full, terminals, boolean};
 
-struct sp_result {
-    bool is_sp;
-    std::shared_ptr<certificate> reason;
+// indexed by cert_policy, as given to --cert-policy
+constexpr char const * cert_policy_names[] = {"full", "terminals", "boolean"};
 
-    bool authenticate(graph const& g) {
-        L_LOG("================== AUTHENTICATING SP RESULT ==================\n") 
-        V_LOG(g)
-        V_LOG("=============================================================\n")
-        L_LOG("\n")
+// ==================== MAIN ALGORITHM FUNCTIONS ====================
+// appends v to a certificate path in the arena, which grows it in place while it is the last
+// thing allocated there
+void push_path(sp_arena& arena, std::span<int>& path, int v) {
+    int * p = (int *)(arena.extend(path.data(), path.size() * sizeof(int), sizeof(int), alignof(int)));
+    path = {p, path.size() + 1};
+    path.back() = v;
+}
 
-        if (!reason) {
-            L_LOG("ERROR: reason not given")
-            return false;
-        }
-        if (!reason->authenticate(g)) return false;
+// appends edge (u, v) to a certificate path kept as its vertex sequence
+void extend_path(sp_arena& arena, std::span<int>& path, int u, int v) {
+    if (path.empty()) push_path(arena, path, u);
+    push_path(arena, path, v);
+}
 
-        L_LOG("this graph is " << (is_sp ? "" : "NOT ") << "SP\n")
-        return true;
-    }
-};
+// a copy of path in the arena, for a path built in scratch storage
+std::span<int> arena_path(sp_arena& arena, std::span<int const> path) {
+    std::span<int> out{(int *)(arena.allocate(path.size() * sizeof(int), alignof(int))), path.size()};
+    std::copy(path.begin(), path.end(), out.begin());
+    return out;
+}
 
-// ==================== MAIN ALGORITHM FUNCTIONS ====================
-int path_contains_edge(std::vector<edge_t> const& path, edge_t test) {
-    for (size_t i = 0; i < path.size(); i++) {
-        edge_t e = path[i];
+// index i of the edge (path[i], path[i + 1]) matching test in either orientation, or -1
+int path_contains_edge(std::span<int const> path, edge_t test) {
+    for (size_t i = 0; i + 1 < path.size(); i++) {
+        edge_t e{path[i], path[i + 1]};
         if (e == test || (e.first == test.second && e.second == test.first)) return (int)(i);
     }
     return -1;
 }
 
-void report_K4_non_stack_pop_case(sp_result& cert_out,
+// paths is false when only the terminals are wanted
+template <typename Tree>
+void report_K4_non_stack_pop_case(std::shared_ptr<certificate>& cert_out,
                                   std::vector<int> const& parent, 
-                                  std::vector<std::stack<sp_chain_stack_entry>>& vertex_stacks, 
+                                  chain_stack_arena<Tree>& vertex_stacks, 
+                                  sp_node_pool const& nodes,
+                                  std::shared_ptr<sp_arena> const& arena,
+                                  bool paths,
                                   int a, 
                                   int b,
                                   int d,
                                   int elose,
                                   int ewin_src,
                                   int ewin_sink) {
-    std::shared_ptr<negative_cert_K4> k4{new negative_cert_K4{}};
+    std::shared_ptr<negative_cert_K4> k4 = make_arena_shared<negative_cert_K4>(arena);
     k4->a = a;
     k4->b = b;
     k4->d = d;
 
-    sp_tree earliest_violating_ear;
+    Tree earliest_violating_ear;
     for (int bw = parent[k4->b]; bw != k4->d; bw = parent[bw]) {
-        for (; !vertex_stacks[bw].empty(); vertex_stacks[bw].pop()) {
-            if (vertex_stacks[bw].top().end == k4->a) {
-                earliest_violating_ear = std::move(vertex_stacks[bw].top().SP);
+        for (; !vertex_stacks.empty(bw); vertex_stacks.pop(bw)) {
+            if (vertex_stacks.top(bw).end == k4->a) {
+                earliest_violating_ear = std::move(vertex_stacks.top(bw).SP);
                 k4->c = bw;
             }
         }
     }
 
-    for (int a = k4->a; a != k4->b; a = parent[a]) k4->ab.emplace_back(a, parent[a]);
-    for (int b = k4->b; b != k4->c; b = parent[b]) k4->bc.emplace_back(b, parent[b]);
-    for (int c = k4->c; c != k4->d; c = parent[c]) k4->cd.emplace_back(c, parent[c]);
+    cert_out = k4;
+    if (!paths) return;
 
-    k4->ad.emplace_back(k4->d, elose);
-    for (int d = elose; d != k4->a; d = parent[d]) k4->ad.emplace_back(d, parent[d]);
+    for (int a = k4->a; a != k4->b; a = parent[a]) extend_path(*arena, k4->ab, a, parent[a]);
+    for (int b = k4->b; b != k4->c; b = parent[b]) extend_path(*arena, k4->bc, b, parent[b]);
+    for (int c = k4->c; c != k4->d; c = parent[c]) extend_path(*arena, k4->cd, c, parent[c]);
+
+    extend_path(*arena, k4->ad, k4->d, elose);
+    for (int d = elose; d != k4->a; d = parent[d]) extend_path(*arena, k4->ad, d, parent[d]);
     for (int e = k4->d; e != ewin_src; e = parent[e]) {
-        k4->bd.emplace_back(e, parent[e]);
+        extend_path(*arena, k4->bd, e, parent[e]);
     }
-    k4->bd.emplace_back(ewin_src, ewin_sink);
-    for (int e = ewin_sink; e != k4->b; e = parent[e]) k4->bd.emplace_back(e, parent[e]);
-    int ear_path = earliest_violating_ear.underlying_tree_path_source();
-    k4->ac.emplace_back(k4->c, ear_path);
-    for (; ear_path != k4->a; ear_path = parent[ear_path]) k4->ac.emplace_back(ear_path, parent[ear_path]);
-
-    cert_out.reason = k4;
+    extend_path(*arena, k4->bd, ewin_src, ewin_sink);
+    for (int e = ewin_sink; e != k4->b; e = parent[e]) extend_path(*arena, k4->bd, e, parent[e]);
+    int ear_path = earliest_violating_ear.underlying_tree_path_source(nodes);
+    extend_path(*arena, k4->ac, k4->c, ear_path);
+    for (; ear_path != k4->a; ear_path = parent[ear_path]) extend_path(*arena, k4->ac, ear_path, parent[ear_path]);
 }
 
-void K23_test(std::shared_ptr<certificate>& cert_ptr, std::vector<int>& alert, std::vector<int> const& parent, edge_t ear_found, edge_t ear_winning, int w) {
+// returns whether a K23 was found; under Policy it is recorded in cert_ptr, with paths if wanted
+template <typename Policy>
+bool K23_test(std::shared_ptr<certificate>& cert_ptr, std::shared_ptr<sp_arena> const& arena, bool paths, std::vector<int>& alert, std::vector<int> const& parent, edge_t ear_found, edge_t ear_winning, int w) {
     V_LOG("testing K23: found ear (" << ear_found.first << ", " << ear_found.second << "), winning ear (" << ear_winning.first << ", " << ear_winning.second << ")\n")
     if (ear_found.second != parent[w]) {
         N_LOG("OOPS, 3.5(a) violation, nonouterplanar\n")
-        std::shared_ptr<negative_cert_K23> k23{new negative_cert_K23{}};
+        if constexpr (!Policy::certificate) return true;
+        std::shared_ptr<negative_cert_K23> k23 = make_arena_shared<negative_cert_K23>(arena);
         k23->a = w;
         k23->b = ear_found.second;
+        cert_ptr = k23;
+        if (!paths) return true;
 
-        k23->one.emplace_back(k23->b, ear_found.first);
-        for (int i = ear_found.first; i != k23->a; i = parent[i]) k23->one.emplace_back(i, parent[i]);
-
-        for (int i = k23->a; i != k23->b; i = parent[i]) k23->two.emplace_back(i, parent[i]);
+        extend_path(*arena, k23->one, k23->b, ear_found.first);
+        for (int i = ear_found.first; i != k23->a; i = parent[i]) extend_path(*arena, k23->one, i, parent[i]);
 
-        for (int i = k23->b; i != ear_winning.second; i = parent[i]) k23->three.emplace_back(i, parent[i]);
-                k23->three.emplace_back(ear_winning.second, ear_winning.first);
-        for (int i = ear_winning.first; i != k23->a; i = parent[i]) k23->three.emplace_back(i, parent[i]);
+        for (int i = k23->a; i != k23->b; i = parent[i]) extend_path(*arena, k23->two, i, parent[i]);
 
-        cert_ptr = k23;
-        return;
+        for (int i = k23->b; i != ear_winning.second; i = parent[i]) extend_path(*arena, k23->three, i, parent[i]);
+                extend_path(*arena, k23->three, ear_winning.second, ear_winning.first);
+        for (int i = ear_winning.first; i != k23->a; i = parent[i]) extend_path(*arena, k23->three, i, parent[i]);
+        return true;
     }
 
     if (alert[w] != -1) {
         N_LOG("OOPS, 3.5(b) violation, nonouterplanar\n")
-        std::shared_ptr<negative_cert_K23> k23{new negative_cert_K23{}};
+        if constexpr (!Policy::certificate) return true;
+        std::shared_ptr<negative_cert_K23> k23 = make_arena_shared<negative_cert_K23>(arena);
         k23->a = w;
         k23->b = ear_found.second;
+        cert_ptr = k23;
+        if (!paths) return true;
 
-        k23->one.emplace_back(k23->b, ear_found.first);
-        for (int i = ear_found.first; i != k23->a; i = parent[i]) k23->one.emplace_back(i, parent[i]);
-
-        k23->two.emplace_back(k23->b, alert[w]);
-        for (int i = alert[w]; i != k23->a; i = parent[i]) k23->two.emplace_back(i, parent[i]);
+        extend_path(*arena, k23->one, k23->b, ear_found.first);
+        for (int i = ear_found.first; i != k23->a; i = parent[i]) extend_path(*arena, k23->one, i, parent[i]);
 
-        for (int i = k23->b; i != ear_winning.second; i = parent[i]) k23->three.emplace_back(i, parent[i]);
-        k23->three.emplace_back(ear_winning.second, ear_winning.first);
-        for (int i = ear_winning.first; i != k23->a; i = parent[i]) k23->three.emplace_back(i, parent[i]);
+        extend_path(*arena, k23->two, k23->b, alert[w]);
+        for (int i = alert[w]; i != k23->a; i = parent[i]) extend_path(*arena, k23->two, i, parent[i]);
 
-        cert_ptr = k23;
-        return;
-    } else {
-        alert[w] = ear_found.first;
+        for (int i = k23->b; i != ear_winning.second; i = parent[i]) extend_path(*arena, k23->three, i, parent[i]);
+        extend_path(*arena, k23->three, ear_winning.second, ear_winning.first);
+        for (int i = ear_winning.first; i != k23->a; i = parent[i]) extend_path(*arena, k23->three, i, parent[i]);
+        return true;
     }
+
+    alert[w] = ear_found.first;
+    return false;
 }
 
-std::vector<edge_t> get_bicomps(graph const& g, std::vector<int>& cut_verts, sp_result& cert_out, int root = 0) {
-    std::vector<int> dfs_no((size_t)(g.n), 0);
-    std::vector<int> parent((size_t)(g.n), 0);
-    std::vector<int> low((size_t)(g.n), 0);
+// rejected is set when the bicomps cannot be chained; the certificate goes to cert_out
+template <typename Policy>
+std::vector<edge_t>& get_bicomps(graph const& g, basic_recognizer_context<typename Policy::tree>& ctx, sp_result& cert_out, bool& rejected, int root = 0) {
+    std::vector<int>& cut_verts = ctx.cut_verts;
+    std::vector<int>& dfs_no = ctx.bc_dfs_no;
+    std::vector<int>& parent = ctx.bc_parent;
+    std::vector<int>& low = ctx.bc_low;
 
-    std::vector<edge_t> retval;
-    std::stack<std::pair<int, int>> dfs;
+    std::vector<edge_t>& retval = ctx.bicomps;
+    dfs_stack& dfs = ctx.dfs;
 
+    ctx.touched.push_back(root);
     dfs.emplace(root, 0);
     dfs_no[root] = 1;
     low[root] = 1;
@@ -942,6 +1025,7 @@ std::vector<edge_t> get_bicomps(graph const& g, std::vector<int>& cut_verts, sp_
         int u = g.adjLists[p.first][p.second];
         if (dfs_no[u] == 0) {
             dfs.push(std::pair{u, 0});
+            ctx.touched.push_back(u);
             parent[u] = w;
             dfs_no[u] = curr_dfs++;
             low[u] = dfs_no[u];
@@ -952,12 +1036,14 @@ std::vector<edge_t> get_bicomps(graph const& g, std::vector<int>& cut_verts, sp_
             if (low[u] >= dfs_no[w]) {
                 if (cut_verts[w] != -1) {
                     if (w != root || root_cut) {
-                        if (!cert_out.reason) {
+                        if (!rejected) {
                             N_LOG("NON-SP, three component cut vertex at " << w << "\n")
-                            std::shared_ptr<negative_cert_tri_comp_cut> cut{new negative_cert_tri_comp_cut{}};
-                            cut->v = w;
-                            cert_out.reason = cut;
-                            cert_out.is_sp = false;
+                            rejected = true;
+                            if constexpr (Policy::certificate) {
+                                std::shared_ptr<negative_cert_tri_comp_cut> cut = make_arena_shared<negative_cert_tri_comp_cut>(ctx.arena);
+                                cut->v = w;
+                                cert_out.reason = cut;
+                            }
                         }
                     } else {
                         root_cut = true;
@@ -979,6 +1065,7 @@ std::vector<edge_t> get_bicomps(graph const& g, std::vector<int>& cut_verts, sp_
     }
 
     int n_bicomps = (int)(retval.size());
+    ctx.used_bicomps = n_bicomps;
     N_LOG(n_bicomps << " bicomp" << (n_bicomps == 1 ? "" : "s") << " found\n")
     for (int i = 0; i < n_bicomps; i++) {
         V_LOG("bicomp " << i << ": root " << retval[i].first << ", edge " << retval[i].second << "\n")
@@ -986,12 +1073,11 @@ std::vector<edge_t> get_bicomps(graph const& g, std::vector<int>& cut_verts, sp_
 
     if (!root_cut) cut_verts[root] = -1;
 
-    retval.shrink_to_fit();
-    if (cert_out.reason) return retval;
+    if (rejected) return retval;
 
     N_LOG("no tri-comp-cut found\n")
 
-    std::vector<int> prev_cut((size_t)(n_bicomps), -1);
+    std::vector<int>& prev_cut = ctx.prev_cut;
     int root_one = -1;
     int root_two = -1;
 
@@ -1010,13 +1096,15 @@ std::vector<edge_t> get_bicomps(graph const& g, std::vector<int>& cut_verts, sp_
                 if (prev_cut[cut_verts[w]] == -1) {
                     prev_cut[cut_verts[w]] = start;
                 } else {
-                    std::shared_ptr<negative_cert_tri_cut_comp> cut{new negative_cert_tri_cut_comp{}};
-                    cut->c1 = w;
-                    cut->c2 = start;
-                    cut->c3 = prev_cut[cut_verts[w]];
-                    N_LOG("NON-SP, bicomp (not at root) with three cut vertices: " << cut->c1 << ", " << cut->c2 << ", " << cut->c3 << "\n")
-                    cert_out.reason = cut;
-                    cert_out.is_sp = false;
+                    N_LOG("NON-SP, bicomp (not at root) with three cut vertices: " << w << ", " << start << ", " << prev_cut[cut_verts[w]] << "\n")
+                    rejected = true;
+                    if constexpr (Policy::certificate) {
+                        std::shared_ptr<negative_cert_tri_cut_comp> cut = make_arena_shared<negative_cert_tri_cut_comp>(ctx.arena);
+                        cut->c1 = w;
+                        cut->c2 = start;
+                        cut->c3 = prev_cut[cut_verts[w]];
+                        cert_out.reason = cut;
+                    }
                     return retval;
                 }
                 break;
@@ -1030,13 +1118,15 @@ std::vector<edge_t> get_bicomps(graph const& g, std::vector<int>& cut_verts, sp_
             } else if (root_two == -1) {
                 root_two = start;
             } else {
-                std::shared_ptr<negative_cert_tri_cut_comp> cut{new negative_cert_tri_cut_comp{}};
-                cut->c1 = root_one;
-                cut->c2 = root_two;
-                cut->c3 = start;
-                N_LOG("NON-SP, bicomp (at root) with three cut vertices: " << cut->c1 << ", " << cut->c2 << ", " << cut->c3 << "\n")
-                cert_out.reason = cut;
-                cert_out.is_sp = false;
+                N_LOG("NON-SP, bicomp (at root) with three cut vertices: " << root_one << ", " << root_two << ", " << start << "\n")
+                rejected = true;
+                if constexpr (Policy::certificate) {
+                    std::shared_ptr<negative_cert_tri_cut_comp> cut = make_arena_shared<negative_cert_tri_cut_comp>(ctx.arena);
+                    cut->c1 = root_one;
+                    cut->c2 = root_two;
+                    cut->c3 = start;
+                    cert_out.reason = cut;
+                }
                 return retval;
             }
         }
@@ -1044,6 +1134,7 @@ std::vector<edge_t> get_bicomps(graph const& g, std::vector<int>& cut_verts, sp_
 
     N_LOG("no tri-cut-comp found\n")
 
+    ctx.dfs_bicomps.assign(retval.begin(), retval.end());
     if (n_bicomps > 1) {
         N_LOG("ordering bicomps as chain: ")
         int second_endpoint = n_bicomps - 1;
@@ -1084,431 +1175,4092 @@ std::vector<edge_t> get_bicomps(graph const& g, std::vector<int>& cut_verts, sp_
     return retval;
 }
 
-sp_result SP_RECOGNITION(graph const& g) {
-    sp_result retval{};
-
-    std::vector<int> cut_verts(g.n, -1);
-    std::vector<edge_t> bicomps = get_bicomps(g, cut_verts, retval);
+// Parallel alternative to get_bicomps after Tarjan and Vishkin, leaving the same results in ctx.
+// The spanning tree is a BFS tree, built one level at a time: every new vertex hangs off the
+// earliest vertex of the level next to it, and the children of a vertex follow each other in
+// touched in the order of its adjacency list. Subtree sizes and preorder numbers (in bc_dfs_no)
+// then come from the levels, bottom up and top down, and so do the lowest and highest preorder
+// numbers the nontree edges of every subtree reach. Two tree edges are in one block if a
+// nontree edge joins the subtrees of their children while neither is an ancestor of the other,
+// or if one is the parent edge of the other and the subtree of the child reaches outside that
+// of the parent; the blocks are the classes of a concurrent union-find over the tree edges.
+// A block starts at the first child of its head in touched, and the bicomps come in reverse
+// order of their starts, so that each comes before the one its head lies in, as they do after a
+// DFS. block_of and block_heads are filled here rather than by label_blocks, whose rule only
+// holds for a DFS tree. Every pass is split into chunks whose results do not depend on how many
+// there are, so the tree, and with it every certificate, is the same for any number of workers.
+template <typename Policy>
+std::vector<edge_t>& get_bicomps_parallel(graph const& g, basic_recognizer_context<typename Policy::tree>& ctx, work_stealing_pool& pool,
+                                          sp_result& cert_out, bool& rejected, int root = 0) {
+    std::vector<int>& cut_verts = ctx.cut_verts;
+    std::vector<int>& dfs_no = ctx.bc_dfs_no;
+    std::vector<int>& parent = ctx.bc_parent;
+    std::vector<int>& claim = ctx.bc_low; // by vertex: 1 + position of the earliest parent seen, 0 once placed
+    std::vector<int>& touched = ctx.touched;
+    std::vector<edge_t>& retval = ctx.bicomps;
+    std::vector<edge_t>& dfs_bicomps = ctx.dfs_bicomps;
+
+    size_t cap = (size_t)(ctx.capacity);
+    if (ctx.bc_pos.size() < cap) {
+        ctx.bc_pos.resize(cap);
+        ctx.bc_first_child.resize(cap + 1);
+        ctx.bc_size.resize(cap);
+        ctx.bc_reach_low.resize(cap);
+        ctx.bc_reach_high.resize(cap);
+        ctx.bc_link.resize(cap);
+        ctx.bc_block.resize(cap);
+    }
+    std::vector<int>& pos = ctx.bc_pos;
+    std::vector<int>& levels = ctx.bc_levels;
+    std::vector<int>& first_child = ctx.bc_first_child;
+    std::vector<int>& size = ctx.bc_size;
+    std::vector<int>& reach_low = ctx.bc_reach_low;
+    std::vector<int>& reach_high = ctx.bc_reach_high;
+    std::vector<int>& link = ctx.bc_link;
+    std::vector<int>& block = ctx.bc_block;
+    std::vector<std::vector<int>>& found = ctx.bc_chunk_found;
+    std::vector<int>& base = ctx.bc_chunk_base;
+
+    const int min_positions_per_chunk = 1 << 12;
+    auto chunks_for = [&](int count) {
+        int chunks = chunk_count(pool, count, min_positions_per_chunk);
+        if ((int)(found.size()) < chunks) {
+            found.resize((size_t)(chunks));
+            base.resize((size_t)(chunks));
+        }
+        return chunks;
+    };
+    // runs f(t) for every position in [begin, end)
+    auto for_positions = [&](int begin, int end, auto const& f) {
+        for_each_chunk(pool, chunks_for(end - begin), end - begin, [&](int, int lo, int hi) {
+            for (int t = begin + lo; t < begin + hi; t++) f(t);
+        });
+    };
+    // lowers x to v if it is 0 or higher
+    auto lower = [](int& x, int v) {
+        std::atomic_ref<int> a{x};
+        int seen = a.load(std::memory_order_relaxed);
+        while ((seen == 0 || v < seen) && !a.compare_exchange_weak(seen, v, std::memory_order_relaxed));
+    };
+    // with path halving; the root of a class is its smallest member
+    auto find = [&](int x) {
+        for (;;) {
+            int up = std::atomic_ref<int>{link[x]}.load(std::memory_order_relaxed);
+            if (up == x) return x;
+            int upup = std::atomic_ref<int>{link[up]}.load(std::memory_order_relaxed);
+            if (up != upup) std::atomic_ref<int>{link[x]}.compare_exchange_weak(up, upup, std::memory_order_relaxed);
+            x = upup;
+        }
+    };
+    auto unite = [&](int a, int b) {
+        for (;;) {
+            a = find(a);
+            b = find(b);
+            if (a == b) return;
+            if (a < b) std::swap(a, b);
+            if (std::atomic_ref<int>{link[a]}.compare_exchange_strong(a, b, std::memory_order_relaxed)) return;
+        }
+    };
+
+    touched.push_back(root);
+    dfs_no[root] = 1;
+    parent[root] = -1;
+    pos[root] = 0;
+    levels.assign(1, 0);
+    while (levels.back() < (int)(touched.size())) {
+        int begin = levels.back();
+        int end = (int)(touched.size());
+        levels.push_back(end);
+        int chunks = chunks_for(end - begin);
+        if (chunks == 1) {
+            for (int t = begin; t < end; t++) {
+                int v = touched[t];
+                first_child[t] = (int)(touched.size());
+                for (int u : g.adjLists[v]) {
+                    if (dfs_no[u] != 0) continue;
+                    dfs_no[u] = 1;
+                    parent[u] = v;
+                    pos[u] = (int)(touched.size());
+                    touched.push_back(u);
+                }
+            }
+            continue;
+        }
+
+        // every vertex of the next level is claimed by the earliest of its neighbours, which
+        // then places it; the chunks of placed vertices are joined in order
+        for_each_chunk(pool, chunks, end - begin, [&](int, int lo, int hi) {
+            for (int t = begin + lo; t < begin + hi; t++) {
+                for (int u : g.adjLists[touched[t]]) {
+                    if (dfs_no[u] == 0) lower(claim[u], t + 1);
+                }
+            }
+        });
+        for_each_chunk(pool, chunks, end - begin, [&](int c, int lo, int hi) {
+            std::vector<int>& placed = found[(size_t)(c)];
+            placed.clear();
+            for (int t = begin + lo; t < begin + hi; t++) {
+                int v = touched[t];
+                first_child[t] = (int)(placed.size());
+                for (int u : g.adjLists[v]) {
+                    std::atomic_ref<int> mine{claim[u]};
+                    if (mine.load(std::memory_order_relaxed) != t + 1) continue;
+                    mine.store(0, std::memory_order_relaxed);
+                    dfs_no[u] = 1;
+                    parent[u] = v;
+                    placed.push_back(u);
+                }
+            }
+        });
+        int next_end = end;
+        for (int c = 0; c < chunks; c++) {
+            base[(size_t)(c)] = next_end;
+            next_end += (int)(found[(size_t)(c)].size());
+        }
+        touched.resize((size_t)(next_end));
+        for_each_chunk(pool, chunks, end - begin, [&](int c, int lo, int hi) {
+            int at = base[(size_t)(c)];
+            for (int t = begin + lo; t < begin + hi; t++) first_child[t] += at;
+            for (int u : found[(size_t)(c)]) {
+                pos[u] = at;
+                touched[(size_t)(at++)] = u;
+            }
+        });
+    }
+    int count = (int)(touched.size());
+    int depth = (int)(levels.size()) - 1;
+    first_child[count] = count;
+    auto for_level = [&](int level, auto const& f) {for_positions(levels[level], levels[level + 1], f);};
+
+    for (int l = depth; l-- > 0;) {
+        for_level(l, [&](int t) {
+            int s = 1;
+            for (int c = first_child[t]; c < first_child[t + 1]; c++) s += size[c];
+            size[t] = s;
+            link[t] = t;
+        });
+    }
+    for (int l = 0; l < depth; l++) {
+        for_level(l, [&](int t) {
+            int next = dfs_no[touched[t]] + 1;
+            for (int c = first_child[t]; c < first_child[t + 1]; c++) {
+                dfs_no[touched[c]] = next;
+                next += size[c];
+            }
+        });
+    }
+
+    // A nontree edge of a BFS tree joins two levels next to each other, so its ends are related
+    // only if one is the parent of the other, through a parallel edge; every edge to the parent
+    // is the tree edge, as in get_bicomps, and the others are all unrelated. Each is united from
+    // its end with the higher number.
+    for_positions(0, count, [&](int t) {
+        int v = touched[t];
+        int lo = dfs_no[v];
+        int hi = dfs_no[v];
+        for (int u : g.adjLists[v]) {
+            if (u == parent[v]) continue;
+            lo = std::min(lo, dfs_no[u]);
+            hi = std::max(hi, dfs_no[u]);
+            if (dfs_no[u] < dfs_no[v]) unite(t, pos[u]);
+        }
+        reach_low[t] = lo;
+        reach_high[t] = hi;
+    });
+    for (int l = depth; l-- > 0;) {
+        for_level(l, [&](int t) {
+            for (int c = first_child[t]; c < first_child[t + 1]; c++) {
+                reach_low[t] = std::min(reach_low[t], reach_low[c]);
+                reach_high[t] = std::max(reach_high[t], reach_high[c]);
+            }
+        });
+    }
+    for_positions(1, count, [&](int t) {
+        int p = dfs_no[touched[t]];
+        for (int c = first_child[t]; c < first_child[t + 1]; c++) {
+            if (reach_low[c] < p || reach_high[c] >= p + size[t]) unite(c, t);
+        }
+    });
+
+    // the tree edges are named by the positions of their children, so every class is rooted at
+    // its first tree edge in touched, where its block starts; the blocks are numbered in that order
+    int chunks = chunks_for(count - 1);
+    for_each_chunk(pool, chunks, count - 1, [&](int c, int lo, int hi) {
+        std::vector<int>& starts = found[(size_t)(c)];
+        starts.clear();
+        for (int t = 1 + lo; t < 1 + hi; t++) {
+            int r = find(t);
+            std::atomic_ref<int>{link[t]}.store(r, std::memory_order_relaxed);
+            if (r == t) starts.push_back(t);
+        }
+    });
+    int n_bicomps = 0;
+    for (int c = 0; c < chunks; c++) {
+        base[(size_t)(c)] = n_bicomps;
+        n_bicomps += (int)(found[(size_t)(c)].size());
+    }
+    std::vector<int>& heads = ctx.block_heads;
+    heads.resize((size_t)(n_bicomps));
+    dfs_bicomps.resize((size_t)(n_bicomps));
+    for_each_chunk(pool, chunks, count - 1, [&](int c, int, int) {
+        int b = base[(size_t)(c)];
+        for (int t : found[(size_t)(c)]) {
+            int v = touched[t];
+            block[t] = b;
+            heads[(size_t)(b)] = parent[v];
+            dfs_bicomps[(size_t)(n_bicomps - 1 - b)] = edge_t{parent[v], v};
+            b++;
+        }
+    });
+    std::vector<int>& block_of = ctx.block_of;
+    for_positions(1, count, [&](int t) {block_of[touched[t]] = block[link[t]];});
+    ctx.blocks_labeled = true;
+
+    retval.assign(dfs_bicomps.begin(), dfs_bicomps.end());
+    ctx.used_bicomps = n_bicomps;
+    N_LOG(n_bicomps << " bicomp" << (n_bicomps == 1 ? "" : "s") << " found\n")
+    for (int i = 0; i < n_bicomps; i++) {
+        V_LOG("bicomp " << i << ": root " << retval[i].first << ", edge " << retval[i].second << "\n")
+    }
+
+    int root_blocks[2] = {-1, -1};
+    int root_heads = 0;
+    for (int i = 0; i < n_bicomps; i++) {
+        int w = retval[i].first;
+        if (w == root) {
+            if (root_heads < 2) root_blocks[root_heads] = i;
+            root_heads++;
+        }
+        if (cut_verts[w] == -1) {
+            cut_verts[w] = i;
+        } else if (!rejected && (w != root || root_heads > 2)) {
+            N_LOG("NON-SP, three component cut vertex at " << w << "\n")
+            rejected = true;
+            if constexpr (Policy::certificate) {
+                std::shared_ptr<negative_cert_tri_comp_cut> cut = make_arena_shared<negative_cert_tri_comp_cut>(ctx.arena);
+                cut->v = w;
+                cert_out.reason = cut;
+            }
+        }
+    }
+
+    bool root_cut = (root_heads > 1);
+    if (!root_cut) cut_verts[root] = -1;
+
+    if (rejected) return retval;
+
+    N_LOG("no tri-comp-cut found\n")
+
+    // every other head is a cut vertex of the bicomp it lies in below its own head
+    std::vector<int>& prev_cut = ctx.prev_cut;
+    int root_one = -1;
+    int root_two = -1;
+    for (int i = 0; i < n_bicomps; i++) {
+        int w = retval[i].first;
+        if (w == root) continue;
+        int j = n_bicomps - 1 - block_of[w];
+        int head = retval[j].first;
+        if (head != root || root_cut) {
+            if (prev_cut[j] == -1) {
+                prev_cut[j] = w;
+                continue;
+            }
+            N_LOG("NON-SP, bicomp with three cut vertices: " << head << ", " << w << ", " << prev_cut[j] << "\n")
+            rejected = true;
+            if constexpr (Policy::certificate) {
+                std::shared_ptr<negative_cert_tri_cut_comp> cut = make_arena_shared<negative_cert_tri_cut_comp>(ctx.arena);
+                cut->c1 = head;
+                cut->c2 = w;
+                cut->c3 = prev_cut[j];
+                cert_out.reason = cut;
+            }
+            return retval;
+        }
+
+        if (root_one == -1) {
+            root_one = w;
+        } else if (root_two == -1) {
+            root_two = w;
+        } else {
+            N_LOG("NON-SP, bicomp (at root) with three cut vertices: " << root_one << ", " << root_two << ", " << w << "\n")
+            rejected = true;
+            if constexpr (Policy::certificate) {
+                std::shared_ptr<negative_cert_tri_cut_comp> cut = make_arena_shared<negative_cert_tri_cut_comp>(ctx.arena);
+                cut->c1 = root_one;
+                cut->c2 = root_two;
+                cut->c3 = w;
+                cert_out.reason = cut;
+            }
+            return retval;
+        }
+    }
+
+    N_LOG("no tri-cut-comp found\n")
+
+    if (n_bicomps > 1) {
+        N_LOG("ordering bicomps as chain\n")
+        // the at most two cut vertices of a bicomp, -1 for those it lacks
+        auto cuts_of = [&](int j, int& a, int& b) {
+            int head = dfs_bicomps[(size_t)(j)].first;
+            if (cut_verts[head] != -1) {
+                a = head;
+                b = prev_cut[j];
+            } else {
+                a = root_one;
+                b = root_two;
+            }
+        };
+        auto other_bicomp = [&](int c, int j) {
+            if (c == root) return root_blocks[0] == j ? root_blocks[1] : root_blocks[0];
+            return cut_verts[c] == j ? n_bicomps - 1 - block_of[c] : cut_verts[c];
+        };
+        auto neighbour_in = [&](int c, int j) {return dfs_bicomps[(size_t)(j)].first == c ? dfs_bicomps[(size_t)(j)].second : parent[c];};
+
+        int j = 0;
+        for (;; j++) {
+            int a, b;
+            cuts_of(j, a, b);
+            if (b == -1) break;
+        }
+        N_LOG("bicomp " << j << " is the end of the chain walked from\n")
+
+        // each bicomp but the last is rooted at the cut vertex it shares with the next one
+        for (int i = 0, from = -1; i < n_bicomps; i++) {
+            int a, b;
+            cuts_of(j, a, b);
+            int to = (a == from ? b : a);
+            if (to != -1) {
+                retval[i] = edge_t{to, neighbour_in(to, j)};
+                j = other_bicomp(to, j);
+            } else {
+                retval[i] = edge_t{neighbour_in(from, j), from};
+            }
+            from = to;
+        }
+
+        #ifdef __VERBOSE_LOGGING__
+            for (int i = 0; i < n_bicomps; i++) {
+                V_LOG("bicomp " << i << " after reordering: root " << retval[i].first << ", edge " << retval[i].second << "\n")
+            }
+        #endif
+    }
+
+    return retval;
+}
+
+// Labels every vertex the DFS of get_bicomps reached, but its root, with the block of the tree
+// edge to its parent (ctx.block_of), records the head of every block (ctx.block_heads) and
+// returns the number of blocks. A vertex starts a new block under its parent when nothing below
+// it reaches higher; touched is in discovery order, so every parent is labeled before its
+// children.
+template <typename Tree>
+int label_blocks(basic_recognizer_context<Tree>& ctx) {
+    std::vector<int>& dfs_no = ctx.bc_dfs_no;
+    std::vector<int>& parent = ctx.bc_parent;
+    std::vector<int>& low = ctx.bc_low;
+    std::vector<int>& block_of = ctx.block_of;
+    std::vector<int>& heads = ctx.block_heads;
+
+    if (ctx.blocks_labeled) return (int)(heads.size());
+    heads.clear();
+    for (size_t i = 1; i < ctx.touched.size(); i++) {
+        int x = ctx.touched[i];
+        int p = parent[x];
+        if (low[x] >= dfs_no[p]) {
+            block_of[x] = (int)(heads.size());
+            heads.push_back(p);
+        } else {
+            block_of[x] = block_of[p];
+        }
+    }
+    return (int)(heads.size());
+}
+
+// ==================== OUTERPLANAR EMBEDDING ====================
+// Outer cycles of the blocks of an outerplanar graph and the rotation system they induce, in
+// O(n + m), from the DFS tree get_bicomps leaves in the context. A block of three or more
+// vertices is reduced to a triangle by removing a degree-2 vertex at a time and joining its two
+// neighbours if they are not adjacent yet. The two are consecutive on the outer cycle of what is
+// left, so putting the vertices back in reverse order, each between its two neighbours, rebuilds
+// the outer cycle of the block. Around a vertex, its neighbours in a block follow the outer
+// cycle on from the vertex, and the blocks at a cut vertex come one after the other. Returns
+// false, leaving out incomplete, if a block does not reduce, i.e. the graph is not outerplanar.
+template <typename Tree>
+bool outer_embedding_of(graph const& g, basic_recognizer_context<Tree>& ctx, sp_arena& arena, outer_embedding& out) {
+    std::vector<int>& dfs_no = ctx.bc_dfs_no;
+    std::vector<int>& block_of = ctx.block_of;
+    std::vector<int>& heads = ctx.block_heads;
+    std::vector<int>& edge_start = ctx.block_edge_start;
+    std::vector<edge_t>& edges = ctx.block_edges;
+    std::vector<int>& next_slot = ctx.next_slot;
+
+    // vertices the DFS did not reach are in no block, which is only right if they are isolated,
+    // i.e. if the reached ones hold every edge
+    if ((int)(ctx.touched.size()) != g.n) {
+        long long reached = 0;
+        for (int v : ctx.touched) reached += g.adjLists.offsets[v + 1] - g.adjLists.offsets[v];
+        if (reached != 2 * (long long)(g.e)) return false;
+    }
+
+    int blocks = label_blocks(ctx);
+
+    // every edge is in the block of its deeper end
+    auto edge_block = [&](int u, int v) {return block_of[dfs_no[u] > dfs_no[v] ? u : v];};
+    edge_start.assign((size_t)(blocks) + 1, 0);
+    for (int u = 0; u < g.n; u++) {
+        for (int v : g.adjLists[u]) {
+            if (u < v) edge_start[edge_block(u, v) + 1]++;
+        }
+    }
+    for (int b = 0; b < blocks; b++) {
+        edge_start[b + 1] += edge_start[b];
+        next_slot[b] = edge_start[b];
+    }
+    edges.resize((size_t)(edge_start[blocks]));
+    for (int u = 0; u < g.n; u++) {
+        for (int v : g.adjLists[u]) {
+            if (u < v) edges[next_slot[edge_block(u, v)]++] = edge_t{u, v};
+        }
+    }
+
+    auto alloc = [&](size_t count) {return std::span<int>{(int *)(arena.allocate(count * sizeof(int), alignof(int))), count};};
+    out.cycle_offsets = alloc((size_t)(blocks) + 1);
+    out.cycles = alloc((size_t)(g.n) + blocks - 1); // every vertex, and the head of each block once more
+    out.rotation = alloc(2 * (size_t)(g.e));
+    for (int v = 0; v < g.n; v++) next_slot[v] = g.adjLists.offsets[v];
+
+    std::vector<int>& verts = ctx.block_vertices;
+    std::vector<int>& seen = ctx.block_seen;
+    std::vector<int>& first_half = ctx.first_half;
+    std::vector<int>& half_to = ctx.half_to;
+    std::vector<int>& half_next = ctx.half_next;
+    std::vector<char>& edge_dead = ctx.edge_dead;
+    std::vector<int>& degree = ctx.elim_degree;
+    std::vector<int>& stack = ctx.elim_stack;
+    std::vector<int>& cycle_next = ctx.cycle_next;
+    std::vector<int>& pos = ctx.cycle_pos;
+    int * rotation = out.rotation.data();
+
+    const long long scan_budget = 4;
+    bool hashed = false;
+    long long scanned = 0;
+
+    // half-edges 2i and 2i + 1 are edge i seen from either end; the block's own edges come
+    // first, then the joins. A parallel edge is added dead: the reduction skips it, but it still
+    // takes its place in the rotation.
+    auto add_edge = [&](int u, int v, bool live = true) {
+        int h = (int)(half_to.size());
+        half_to.push_back(v);
+        half_next.push_back(first_half[u]);
+        first_half[u] = h;
+        half_to.push_back(u);
+        half_next.push_back(first_half[v]);
+        first_half[v] = h + 1;
+        edge_dead.push_back(!live);
+        if (!live) return;
+        degree[u]++;
+        degree[v]++;
+        if (hashed) ctx.joined.insert(u, v);
+    };
+
+    // Like auth_context::adjacent: scans the list of the endpoint of lower degree until the
+    // scans of a block add up to a few times its size, then puts the edges still in the block in
+    // an edge set. Most joined pairs are tested in a few steps, and hashing every edge of a large
+    // block would cost more than the whole reduction.
+    auto adjacent = [&](int u, int v) {
+        if (hashed) return ctx.joined.contains(u, v);
+        if (degree[u] > degree[v]) std::swap(u, v);
+        for (int h = first_half[u]; h != -1; h = half_next[h]) {
+            scanned++;
+            if (!edge_dead[h / 2] && half_to[h] == v) return true;
+        }
+        if (scanned > scan_budget * (long long)(half_to.size())) {
+            ctx.joined.reset(half_to.size());
+            for (size_t h = 0; h < half_to.size(); h += 2) {
+                if (!edge_dead[h / 2]) ctx.joined.insert(half_to[h], half_to[h + 1]);
+            }
+            hashed = true;
+        }
+        return false;
+    };
+
+    int written = 0;
+    for (int b = 0; b < blocks; b++) {
+        int own = edge_start[b + 1] - edge_start[b];
+        int * cycle = out.cycles.data() + written;
+        out.cycle_offsets[b] = written;
+        int k;
+
+        if (own == 1) {
+            auto [u, v] = edges[(size_t)(edge_start[b])];
+            cycle[0] = u;
+            cycle[1] = v;
+            k = 2;
+            rotation[next_slot[u]++] = v;
+            rotation[next_slot[v]++] = u;
+            written += k;
+            continue;
+        }
+
+        verts.clear();
+        half_to.clear();
+        half_next.clear();
+        edge_dead.clear();
+        hashed = false;
+        scanned = 0;
+        for (int i = edge_start[b]; i < edge_start[b + 1]; i++) {
+            auto [u, v] = edges[(size_t)(i)];
+            for (int x : {u, v}) {
+                if (seen[x] == b) continue;
+                seen[x] = b;
+                first_half[x] = -1;
+                degree[x] = 0;
+                verts.push_back(x);
+            }
+            add_edge(u, v, !adjacent(u, v));
+        }
+        k = (int)(verts.size());
+
+        stack.clear();
+        for (int v : verts) {
+            if (degree[v] == 2) stack.push_back(v);
+        }
+        ctx.eliminated.clear();
+        for (int left = k; left > 3; left--) {
+            int v;
+            do {
+                if (stack.empty()) {
+                    N_LOG("block " << b << " has no vertex of degree 2 left, it is not outerplanar\n")
+                    return false;
+                }
+                v = stack.back();
+                stack.pop_back();
+            } while (degree[v] != 2);
+
+            int ends[2];
+            int found = 0;
+            for (int h = first_half[v]; found < 2; h = half_next[h]) {
+                if (edge_dead[h / 2]) continue;
+                edge_dead[h / 2] = true;
+                ends[found++] = half_to[h];
+            }
+            degree[v] = 0;
+            degree[ends[0]]--;
+            degree[ends[1]]--;
+            if (!adjacent(ends[0], ends[1])) add_edge(ends[0], ends[1]);
+            for (int x : ends) {
+                if (degree[x] == 2) stack.push_back(x);
+            }
+            ctx.eliminated.push_back({v, ends[0], ends[1]});
+        }
+
+        if (k == 2) {
+            // a bundle of parallel edges
+            cycle_next[verts[0]] = verts[1];
+            cycle_next[verts[1]] = verts[0];
+        } else {
+            int triangle[3];
+            int t = 0;
+            for (int v : verts) {
+                if (degree[v] == 0) continue;
+                if (t == 3 || degree[v] != 2) return false;
+                triangle[t++] = v;
+            }
+            if (t != 3) return false;
+            for (int i = 0; i < 3; i++) cycle_next[triangle[i]] = triangle[(i + 1) % 3];
+        }
+        for (size_t i = ctx.eliminated.size(); i-- > 0;) {
+            auto [v, x, y] = ctx.eliminated[i];
+            if (cycle_next[y] == x) std::swap(x, y);
+            if (cycle_next[x] != y) return false;
+            cycle_next[x] = v;
+            cycle_next[v] = y;
+        }
+
+        int v = heads[b];
+        for (int i = 0; i < k; i++) {
+            cycle[i] = v;
+            pos[v] = i;
+            ctx.rotation_start[v] = next_slot[v];
+            v = cycle_next[v];
+        }
+
+        // each vertex collects its neighbours in the block in cycle order, then starts them
+        // after itself
+        for (int i = 0; i < k; i++) {
+            for (int h = first_half[cycle[i]]; h != -1; h = half_next[h]) {
+                if (h < 2 * own) rotation[next_slot[half_to[h]]++] = cycle[i];
+            }
+        }
+        for (int i = 0; i < k; i++) {
+            int * first = rotation + ctx.rotation_start[cycle[i]];
+            int * last = rotation + next_slot[cycle[i]];
+            int * after = first;
+            while (after != last && pos[*after] < i) after++;
+            std::rotate(first, after, last);
+        }
+        written += k;
+    }
+    out.cycle_offsets[blocks] = written;
+    out.cycles = out.cycles.first((size_t)(written)); // shorter by the isolated vertices
+    return true;
+}
+
+// What recognizing one bicomp found; the certificates are in the sp_result it was given.
+struct bicomp_outcome {
+    bool found = false; // a K4, with the virtual edge if there is one
+    bool k4_subgraph = false; // ...that is known to be a K4 of the graph
+};
+
+// A K4 found in a chained bicomp whose path between two of its vertices runs through the
+// virtual edge (root, next) leaves those two as its stubs: they are the branch vertices the
+// path ends at, and the T4 needs root and next there instead. The other four vertices form a
+// theta between a and b, with one arc through each stub's branch vertex; a stub is shortened
+// by the path of the bicomp from its highest vertex that leaves it without touching its branch
+// vertex (the bicomp is 2-connected, so there is one). If that path meets the arc of the stub,
+// the arc is rerouted through it; if it meets anything else, the bicomp holds a K4 of its own.
+// Returns that K4, with real_k4 set, or the T4 once both stubs are gone, or null if root and
+// next are not both cut vertices. k4's paths are consumed either way.
+template <typename Tree>
+std::shared_ptr<certificate> reroute_virtual_k4(graph const& g, basic_recognizer_context<Tree>& ctx, std::vector<int> const& cut_verts,
+                                                negative_cert_K4& k4, int pnum, int root, int next, int bicomp,
+                                                std::vector<int> const * owner, bool& real_k4) {
+    static const int k4_t4_translation[6][5] = {{1, 3, 2, 4, 5}, {0, 3, 2, 5, 4}, {0, 4, 1, 5, 3}, {0, 1, 4, 5, 2}, {0, 2, 3, 5, 1}, {1, 2, 3, 4, 0}};
+    static const int k4_t4_endpoint_translation[6][4] = {{0, 1, 2, 3}, {0, 2, 1, 3}, {0, 3, 1, 2}, {1, 2, 0, 3}, {1, 3, 0, 2}, {2, 3, 0, 1}};
+    std::span<int> * k4_paths[6] = {&k4.ab, &k4.ac, &k4.ad, &k4.bc, &k4.bd, &k4.cd};
+    int k4_verts[4] = {k4.a, k4.b, k4.c, k4.d};
+    auto from_end = [](auto& path, int v) {if (path.front() != v) std::reverse(path.begin(), path.end());};
+    auto take = [](std::vector<int>& to, std::span<int const> from) {to.assign(from.begin(), from.end());};
+
+    // stub[s] runs from branch vertex s to root or next, arm[s][0] and arm[s][1] from it to a
+    // and b, and the third arc of the theta from a to b; they are worked on in the context, and
+    // copied to the arena when the certificate is made
+    int a = k4_verts[k4_t4_endpoint_translation[pnum][2]];
+    int b = k4_verts[k4_t4_endpoint_translation[pnum][3]];
+    auto& arm = ctx.reroute_arm;
+    auto& stub = ctx.reroute_stub;
+    std::vector<int>& third = ctx.reroute_third;
+    std::vector<int>& detour = ctx.reroute_detour; // from stub[s][j] to z
+    std::vector<int>& xz = ctx.reroute_xz;
+    std::vector<int>& kept = ctx.reroute_kept;
+    take(third, *(k4_paths[k4_t4_translation[pnum][4]]));
+    from_end(third, a);
+    for (int s = 0; s < 2; s++) {
+        int x = k4_verts[k4_t4_endpoint_translation[pnum][s]];
+        take(arm[s][0], *(k4_paths[k4_t4_translation[pnum][s]]));
+        take(arm[s][1], *(k4_paths[k4_t4_translation[pnum][s + 2]]));
+        from_end(arm[s][0], x);
+        from_end(arm[s][1], x);
+    }
+    std::span<int> through = *(k4_paths[pnum]);
+    from_end(through, k4_verts[k4_t4_endpoint_translation[pnum][0]]);
+    int at = path_contains_edge(through, edge_t{root, next});
+    stub[0].assign(through.begin(), through.begin() + at + 1);
+    stub[1].assign(through.rbegin(), through.rend() - at - 1);
+
+    if ((int)(ctx.reroute_from.size()) < g.n) ctx.reroute_from.resize((size_t)(g.n), -1);
+    std::vector<char>& marked = ctx.marked;
+    std::vector<int>& from = ctx.reroute_from;
+    std::vector<int>& queue = ctx.reroute_queue;
+    // the DFS of the bicomp stopped at the K4, so its comp labels do not bound the bicomp yet;
+    // without owner, the bicomp is the block of the DFS tree holding both root and next
+    int dfs_root = (owner ? -1 : ctx.touched[0]);
+    int block = -1;
+    if (!owner) {
+        label_blocks(ctx);
+        bool at_root = (root != dfs_root && ((next != dfs_root && ctx.block_of[next] == ctx.block_of[root]) || ctx.block_heads[ctx.block_of[root]] == next));
+        block = (at_root ? ctx.block_of[root] : ctx.block_of[next]);
+    }
+    auto in_bicomp = [&](int v) {
+        if (owner) return (*owner)[v] == bicomp || v == root;
+        return (v != dfs_root && ctx.block_of[v] == block) || ctx.block_heads[block] == v;
+    };
+    auto mark = [&](char value) {
+        for (int s = 0; s < 2; s++) {
+            for (int v : stub[s]) marked[v] = value;
+            for (std::vector<int> const& path : arm[s]) for (int v : path) marked[v] = value;
+        }
+        for (int v : third) marked[v] = value;
+    };
+    auto find = [](std::vector<int> const& path, int v) {return (int)(std::find(path.begin(), path.end(), v) - path.begin());};
+    // the K4 on x, y, a and b, given the path from x to y; z → a and z → b are split off arc
+    auto k4_on = [&](int x, std::span<int const> xa, std::span<int const> xb, std::span<int const> xy, int y,
+                     std::span<int const> ya, std::span<int const> yb, std::span<int const> ab) {
+        sp_arena& arena = *ctx.arena;
+        std::shared_ptr<negative_cert_K4> out = make_arena_shared<negative_cert_K4>(ctx.arena);
+        out->a = x;
+        out->b = y;
+        out->c = a;
+        out->d = b;
+        out->ab = arena_path(arena, xy);
+        out->ac = arena_path(arena, xa);
+        out->ad = arena_path(arena, xb);
+        out->bc = arena_path(arena, ya);
+        out->bd = arena_path(arena, yb);
+        out->cd = arena_path(arena, ab);
+        real_k4 = true;
+        return out;
+    };
+
+    while (stub[0].size() > 1 || stub[1].size() > 1) {
+        int s = (stub[0].size() > 1 ? 0 : 1);
+        int x = stub[s][0];
+
+        // from the highest vertex of the stub down, the first that reaches the theta or the
+        // other stub; the vertices reached from higher ones need not be searched again
+        mark(2);
+        for (int v : stub[s]) marked[v] = 1;
+        marked[x] = 2;
+        queue.clear();
+        int j = (int)(stub[s].size()) - 1;
+        int last = -1;
+        int z = -1;
+        for (; j > 0 && z == -1; j--) {
+            size_t head = queue.size();
+            queue.push_back(stub[s][(size_t)(j)]);
+            for (; head < queue.size() && z == -1; head++) {
+                int v = queue[head];
+                for (int u : g.adjLists[v]) {
+                    if (marked[u] == 2 && u != x) {
+                        last = v;
+                        z = u;
+                        break;
+                    }
+                    if (marked[u] == 0 && from[u] == -1 && in_bicomp(u)) {
+                        from[u] = v;
+                        queue.push_back(u);
+                    }
+                }
+            }
+        }
+        j++;
+
+        detour.clear();
+        if (z != -1) {
+            detour.push_back(z);
+            for (int v = last; v != stub[s][(size_t)(j)]; v = from[v]) detour.push_back(v);
+            detour.push_back(stub[s][(size_t)(j)]);
+            std::reverse(detour.begin(), detour.end());
+        }
+        for (int v : queue) from[v] = -1;
+        mark(0);
+        if (z == -1) return nullptr;
+
+        // the path from x through the stub and the detour to z
+        xz.assign(stub[s].begin(), stub[s].begin() + j);
+        xz.insert(xz.end(), detour.begin(), detour.end());
+
+        int k = (z == b ? 1 : z == a ? 0 : -1);
+        for (int side = 0; side < 2 && k == -1; side++) {
+            int i = find(arm[s][side], z);
+            if (i > 0 && i < (int)(arm[s][side].size())) k = side;
+        }
+        if (k != -1) {
+            // the arc of the stub now leaves x's old position through the detour
+            int i = find(arm[s][k], z);
+            kept.assign(stub[s].rend() - j - 1, stub[s].rend());
+            kept.insert(kept.end(), arm[s][1 - k].begin() + 1, arm[s][1 - k].end());
+            detour.insert(detour.end(), arm[s][k].begin() + i + 1, arm[s][k].end());
+            std::swap(arm[s][k], detour);
+            std::swap(arm[s][1 - k], kept);
+            stub[s].erase(stub[s].begin(), stub[s].begin() + j);
+            continue;
+        }
+
+        for (int side = 0; side < 2; side++) {
+            std::vector<int>& arc = arm[1 - s][side];
+            int i = find(arc, z);
+            if (i == (int)(arc.size())) continue;
+            // z splits the other arc into z → a and z → b
+            std::span<int const> to_own{arc.begin() + i, arc.end()};
+            std::vector<int>& to_other = kept;
+            to_other.assign(arc.rend() - i - 1, arc.rend());
+            to_other.insert(to_other.end(), arm[1 - s][1 - side].begin() + 1, arm[1 - s][1 - side].end());
+            std::span<int const> za = (side == 0 ? to_own : std::span<int const>{to_other});
+            std::span<int const> zb = (side == 0 ? std::span<int const>{to_other} : to_own);
+            return k4_on(x, arm[s][0], arm[s][1], xz, z, za, zb, third);
+        }
+        int i = find(third, z);
+        if (i < (int)(third.size())) {
+            std::vector<int>& za = detour;
+            za.assign(third.rend() - i - 1, third.rend());
+            std::span<int const> zb{third.begin() + i, third.end()};
+            std::vector<int>& ab = kept;
+            ab.assign(arm[1 - s][0].rbegin(), arm[1 - s][0].rend());
+            ab.insert(ab.end(), arm[1 - s][1].begin() + 1, arm[1 - s][1].end());
+            return k4_on(x, arm[s][0], arm[s][1], xz, z, za, zb, ab);
+        }
+        // z is on the other stub, which then joins x to its branch vertex without the virtual edge
+        i = find(stub[1 - s], z);
+        xz.insert(xz.end(), stub[1 - s].rend() - i, stub[1 - s].rend());
+        return k4_on(x, arm[s][0], arm[s][1], xz, stub[1 - s][0], arm[1 - s][0], arm[1 - s][1], third);
+    }
+
+    if (cut_verts[stub[0][0]] == -1 || cut_verts[stub[1][0]] == -1) return nullptr;
+    sp_arena& arena = *ctx.arena;
+    std::shared_ptr<negative_cert_T4> t4 = make_arena_shared<negative_cert_T4>(ctx.arena);
+    t4->c1 = stub[0][0];
+    t4->c2 = stub[1][0];
+    t4->a = a;
+    t4->b = b;
+    t4->c1a = arena_path(arena, arm[0][0]);
+    t4->c1b = arena_path(arena, arm[0][1]);
+    t4->c2a = arena_path(arena, arm[1][0]);
+    t4->c2b = arena_path(arena, arm[1][1]);
+    t4->ab = arena_path(arena, third);
+    return t4;
+}
+
+// Recognizes one bicomp of SP_RECOGNITION, from root through next, and leaves its tree in
+// ctx.seq[next] without the tree attached at next if that is a cut vertex, which the caller
+// composes in series. cut_verts and attached are only read at cut vertices inside the bicomp,
+// and a chain has none. Without owner, the bicomp is what the comp labels of the bicomps before
+// it leave reachable. With owner, the comp labels a whole run ends with, it is bounded by owner
+// alone, so the bicomps of a chain can be recognized in any order, each in a context of its
+// own; the vertices visited are then appended to ctx.touched.
+template <typename Policy>
+bicomp_outcome recognize_bicomp(graph const& g, basic_recognizer_context<typename Policy::tree>& ctx, std::vector<int> const& cut_verts,
+                                std::vector<typename Policy::tree>& attached, int bicomp, int root, int next, bool blockwise, bool& nonop,
+                                sp_result& retval, std::vector<int> const * owner = nullptr) {
+    using tree = typename Policy::tree;
+    const int nil = ctx.nil;
+    sp_node_pool& nodes = ctx.nodes;
+    std::vector<int>& comp = ctx.comp;
+    chain_stack_arena<tree>& vertex_stacks = ctx.vertex_stacks;
+    std::vector<int>& dfs_no = ctx.dfs_no;
+    std::vector<int>& parent = ctx.parent;
+    std::vector<edge_t>& ear = ctx.ear;
+    std::vector<tree>& seq = ctx.seq;
+    std::vector<int>& earliest_outgoing = ctx.earliest_outgoing;
+    std::vector<char>& num_children = ctx.num_children;
+    std::vector<int>& alert = ctx.alert;
+    dfs_stack& dfs = ctx.dfs;
+
+    dfs.emplace(root, -1);
+    dfs.emplace(next, 0);
+
+    bool fake_edge = false;
+    if (!blockwise) {
+        fake_edge = true;
+        for (int u1 : g.adjLists[next]) {
+            if (u1 == root) {
+                fake_edge = false;
+                break;
+            }
+        }
+    }
+    // a terminal run builds paths where they decide between K4 and T4
+    bool const paths = Policy::paths || (Policy::certificate && fake_edge);
+    // a K4 found in this bicomp, with the virtual edge if there is one; in the chain it
+    // refutes SP (and may turn out to be a T4), blockwise GSP
+    bool found = false;
+    std::shared_ptr<certificate>& k4_out = (blockwise ? retval.gsp_reason : retval.reason);
+    bool k23_here = false; // the K23 was found in this bicomp
+
+    dfs_no[root] = 1;
+    parent[root] = -1;
+    dfs_no[next] = 2;
+    parent[next] = root;
+    comp[next] = bicomp;
+    int curr_dfs = 3;
+
+    while (!dfs.empty()) {
+        std::pair<int, int> p = dfs.top();
+        int v = parent[p.first];
+        int w = p.first;
+        int u = g.adjLists[p.first][p.second];
+
+        if (owner ? (*owner)[u] == bicomp || u == root : comp[u] == -1 || comp[u] == bicomp) {
+            V_LOG("v: " << v << " w: " << w << " u: " << u << "\n")
+            V_LOG("seq_w: " << show(nodes, seq[w]) << ", seq_u: " << show(nodes, seq[u]) << "\n")
+            if (dfs_no[u] == 0) {
+                dfs.push(std::pair{u, 0});
+                parent[u] = w;
+                dfs_no[u] = curr_dfs++;
+                comp[u] = bicomp;
+                if (owner) ctx.touched.push_back(u);
+                num_children[w]++;
+                continue;
+            }
+
+            bool child_back_edge = (dfs_no[u] < dfs_no[w] && u != v);
+            #ifdef __LOGGING__
+                if (child_back_edge) N_LOG("BACK EDGE (" << w << ", " << u << ")\n")
+            #endif
+
+            if (parent[u] == w) {
+                N_LOG("tree edge (" << w << ", " << u << ")\n")
+                // --- update-seq in the paper begins here ---
+                for (; !vertex_stacks.empty(w); vertex_stacks.pop(w)) {
+                    if (seq[u].source(nodes) != vertex_stacks.top(w).end) {
+                        N_LOG("OOPS, 3.4b due to POPPING STACK child seq " << show(nodes, seq[u]) << " parent seq " << show(nodes, seq[w]) << "\n")
+                        found = true;
+                        if constexpr (!Policy::certificate) break;
+                        std::shared_ptr<negative_cert_K4> k4 = make_arena_shared<negative_cert_K4>(ctx.arena);
+                        k4_out = k4;
+
+                        k4->b = seq[u].source(nodes);
+                        k4->a = vertex_stacks.top(w).end;
+                        k4->c = w;
+                        edge_t holding_ear = ear[u];
+
+                        if (paths) {
+                            for (int a = k4->a; a != k4->b; a = parent[a]) extend_path(*ctx.arena, k4->ab, a, parent[a]);
+                            for (int b = k4->b; b != k4->c; b = parent[b]) extend_path(*ctx.arena, k4->bc, b, parent[b]);
+                        }
+
+                        k4->d = -1;
+                        int c = k4->c;
+                        while (k4->d == -1) {
+                            if (paths) extend_path(*ctx.arena, k4->cd, c, parent[c]);
+                            c = parent[c];
+
+                            for (; !vertex_stacks.empty(c); vertex_stacks.pop(c)) {
+                                if (vertex_stacks.top(c).end == k4->b) {
+                                    k4->d = c;
+                                    break;
+                                }
+                            }
+                        }
+
+                        if (!paths) break;
+
+                        for (int d = k4->d; d != holding_ear.second; d = parent[d]) extend_path(*ctx.arena, k4->ad, d, parent[d]);
+                        extend_path(*ctx.arena, k4->ad, holding_ear.second, holding_ear.first);
+                        for (int d = holding_ear.first; d != k4->a; d = parent[d]) extend_path(*ctx.arena, k4->ad, d, parent[d]);
+
+                        int ear1 = vertex_stacks.top(k4->d).SP.underlying_tree_path_source(nodes);
+                        extend_path(*ctx.arena, k4->bd, k4->d, ear1);
+                        for (; ear1 != k4->b; ear1 = parent[ear1]) extend_path(*ctx.arena, k4->bd, ear1, parent[ear1]);
+                        int ear2 = vertex_stacks.top(k4->c).SP.underlying_tree_path_source(nodes);
+                        extend_path(*ctx.arena, k4->ac, k4->c, ear2);
+                        for (; ear2 != k4->a; ear2 = parent[ear2]) extend_path(*ctx.arena, k4->ac, ear2, parent[ear2]);
+                        break;
+                    }
+
+                    seq[u].compose(std::move(vertex_stacks.top(w).SP), c_type::antiparallel, nodes);
+                    seq[u].l_compose(std::move(vertex_stacks.top(w).tail), c_type::series, nodes);
+                }
+                // ---- update-seq in the paper ends here ----
+
+                if (found) break;
+            }
+
+            if (parent[u] == w || child_back_edge) {
+                // ---- update-ear-of-parent in the paper begins here ----
+                edge_t ear_f = (child_back_edge ? edge_t{w, u} : ear[u]);
+                tree seq_u = (child_back_edge ? tree{u, w, nodes} : std::move(seq[u]));
+
+                if (dfs_no[ear_f.second] < dfs_no[ear[w].second]) {
+                    if (ear[w].first != nil) {
+                        if (!nonop && ear[w].first != w) nonop = k23_here = K23_test<Policy>(retval.op_reason, ctx.arena, paths, alert, parent, ear[w], ear_f, w);
+                        if (seq[w].source(nodes) != ear[w].second) {
+                            N_LOG("OOPS, 3.4a due to CASE B prev winner " << show(nodes, seq[w]) << " prev winner ear (" << ear[w].first << ", " << ear[w].second << ")\n")
+                            found = true;
+                            if constexpr (Policy::certificate) report_K4_non_stack_pop_case(k4_out, parent, vertex_stacks, nodes, ctx.arena, paths, seq[w].source(nodes), w, ear[w].second, ear[w].first, ear_f.second, ear_f.first);
+                            break;
+                        }
+
+                        N_LOG("CASE B (ear exists): placed " << show(nodes, seq[w]) << " onto stk " << ear[w].second << "\n")
+                        vertex_stacks.push(ear[w].second, std::move(seq[w]), w, tree{});
+                        earliest_outgoing[w] = ear[w].second;
+                    }
+                    ear[w] = ear_f;
+                    seq[w] = std::move(seq_u);
+                    N_LOG("CASE B (replace seq): current winning seq " << show(nodes, seq[w]) << "\n")
+                } else {
+                    if (seq_u.source(nodes) != ear_f.second) {
+                        N_LOG("OOPS, 3.4a/b due to CASE A/C child seq " << show(nodes, seq_u) << " child ear (" << ear_f.first << ", " << ear_f.second << ")\n")
+                        found = true;
+                        if constexpr (Policy::certificate) report_K4_non_stack_pop_case(k4_out, parent, vertex_stacks, nodes, ctx.arena, paths, seq_u.source(nodes), w, ear_f.second, ear_f.first, ear[w].second, ear[w].first);
+                        break;
+                    }
+
+                    if (dfs_no[ear_f.second] == dfs_no[ear[w].second]) {
+                        if (!nonop && !child_back_edge && ear[w].first != w) nonop = k23_here = K23_test<Policy>(retval.op_reason, ctx.arena, paths, alert, parent, ear_f, ear[w], w);
+
+                        if (seq[w].source(nodes) != ear[w].second) {
+                            N_LOG("OOPS, 3.4a/b due to CASE C parent seq " << show(nodes, seq[w]) << " parent ear (" << ear[w].first << ", " << ear[w].second << ")\n")
+                            found = true;
+                            if constexpr (Policy::certificate) report_K4_non_stack_pop_case(k4_out, parent, vertex_stacks, nodes, ctx.arena, paths, seq[w].source(nodes), w, ear[w].second, ear[w].first, ear_f.second, ear_f.first);
+                            break;
+                        }
+                        seq[w].compose(std::move(seq_u), c_type::parallel, nodes);
+                        N_LOG("CASE C: current winning seq after merge " << show(nodes, seq[w]) << "\n")
+
+                        if ((ear[w].first == w || dfs_no[ear_f.first] < dfs_no[ear[w].first]) && ear_f.first != w) {
+                            ear[w] = ear_f;
+                        }
+                    } else {
+                        if (!nonop && !child_back_edge) nonop = k23_here = K23_test<Policy>(retval.op_reason, ctx.arena, paths, alert, parent, ear_f, ear[w], w);
+
+                        if (!vertex_stacks.empty(ear_f.second) && vertex_stacks.top(ear_f.second).end == w) {
+                            N_LOG("CASE A (merge onto existing stack entry for stk " << ear_f.second << "): current child seq before merge " << show(nodes, seq_u) << "\n")
+                            vertex_stacks.top(ear_f.second).SP.compose(std::move(seq_u), c_type::parallel, nodes);
+                        } else {
+                            N_LOG("CASE A (new stack entry): placed " << show(nodes, seq_u) << " onto stk " << ear_f.second << " (earliest outgoing " << earliest_outgoing[w] << ")\n")
+                            vertex_stacks.push(ear_f.second, std::move(seq_u), w, tree{});
+                            if (dfs_no[ear_f.second] < dfs_no[earliest_outgoing[w]]) {
+                                earliest_outgoing[w] = ear_f.second;
+                            }
+                        }
+                    }
+                }
+                // ----- update-ear-of-parent in the paper ends here -----
+            }
+        }
+
+        if ((size_t)(++dfs.top().second) >= g.adjLists[p.first].size()) {
+            if (w != root) {
+                if (earliest_outgoing[w] != nil) {
+                    N_LOG("EARLIEST OUTGOING " << earliest_outgoing[w] << ": moved current winning seq " << show(nodes, seq[w]) << " to vertex stack entry tail with SP " << show(nodes, vertex_stacks.top(earliest_outgoing[w]).SP) << "\n")
+                    vertex_stacks.top(earliest_outgoing[w]).tail = std::move(seq[w]);
+                }
+
+                if (v == root) {
+                    seq[w].compose((fake_edge ? tree{} : tree{v, w, nodes}), c_type::parallel, nodes);
+                    break;
+
+                } else {
+                    if (cut_verts[w] != -1) {
+                        attached[cut_verts[w]].l_compose(tree{w, v, nodes}, c_type::dangling, nodes);
+                                                    seq[w].compose(std::move(attached[cut_verts[w]]), c_type::series, nodes);
+                    } else {
+                        seq[w].compose(tree{w, v, nodes}, c_type::series, nodes);
+                    }
+                }
+            }
+
+            dfs.pop();
+        }
+    }
+
+    dfs_no[root] = 0;
+    for (; !dfs.empty(); dfs.pop());
+
+    if (!nonop) {
+        N_LOG("no K23 found\n")
+    }
+
+    // without paths, a K4 through the virtual edge cannot be told from a T4; either way
+    // the graph is not SP, and the blockwise phase decides the rest
+    bool k4_subgraph = found && (Policy::certificate || !fake_edge);
+
+    if (Policy::certificate && fake_edge) {
+        edge_t fake = edge_t{root, next};
+
+        if (found) {
+            std::shared_ptr<negative_cert_K4> k4 = std::dynamic_pointer_cast<negative_cert_K4>(retval.reason);
+            if (k4) {
+                std::span<int> * k4_paths[6] = {&k4->ab, &k4->ac, &k4->ad, &k4->bc, &k4->bd, &k4->cd};
+                int k4_verts[4] = {k4->a, k4->b, k4->c, k4->d};
+                static const int k4_t4_translation[6][5] = {{1, 3, 2, 4, 5}, {0, 3, 2, 5, 4}, {0, 4, 1, 5, 3}, {0, 1, 4, 5, 2}, {0, 2, 3, 5, 1}, {1, 2, 3, 4, 0}};
+                static const int k4_t4_endpoint_translation[6][4] = {{0, 1, 2, 3}, {0, 2, 1, 3}, {0, 3, 1, 2}, {1, 2, 0, 3}, {1, 3, 0, 2}, {2, 3, 0, 1}};
+
+                int pnum = 0;
+                for (; pnum < 6; pnum++) {
+                    if (path_contains_edge(*(k4_paths[pnum]), fake) != -1) break;
+                }
+
+                // the five other paths form a T4 only if the ends of the one through the virtual
+                // edge are cut vertices; where the virtual edge is inside that path they need not
+                // be, and the path is rerouted until they are root and next
+                if (pnum != 6 && (cut_verts[k4_verts[k4_t4_endpoint_translation[pnum][0]]] == -1
+                                  || cut_verts[k4_verts[k4_t4_endpoint_translation[pnum][1]]] == -1)) {
+                    N_LOG("FAKE EDGE IN K4 (pnum " << pnum << ") BETWEEN NON-CUT VERTICES, REROUTE\n")
+                    bool real_k4 = false;
+                    std::shared_ptr<certificate> rerouted = reroute_virtual_k4(g, ctx, cut_verts, *k4, pnum, root, next, bicomp, owner, real_k4);
+                    if (rerouted) retval.reason = rerouted;
+                    k4_subgraph = real_k4;
+                } else if (pnum != 6) {
+                    N_LOG("FAKE EDGE IN K4 (pnum " << pnum << "), GENERATE T4\n")
+                    std::shared_ptr<negative_cert_T4> t4 = make_arena_shared<negative_cert_T4>(ctx.arena);
+
+                    t4->c1a = *(k4_paths[k4_t4_translation[pnum][0]]);
+                    t4->c2a = *(k4_paths[k4_t4_translation[pnum][1]]);
+                    t4->c1b = *(k4_paths[k4_t4_translation[pnum][2]]);
+                    t4->c2b = *(k4_paths[k4_t4_translation[pnum][3]]);
+                    t4->ab = *(k4_paths[k4_t4_translation[pnum][4]]);
+                    t4->c1 = k4_verts[k4_t4_endpoint_translation[pnum][0]];
+                    t4->c2 = k4_verts[k4_t4_endpoint_translation[pnum][1]];
+                    t4->a = k4_verts[k4_t4_endpoint_translation[pnum][2]];
+                    t4->b = k4_verts[k4_t4_endpoint_translation[pnum][3]];
+
+                    retval.reason = t4;
+                    k4_subgraph = false;
+                }
+            }
+        }
+
+        if (k23_here) {
+            std::shared_ptr<negative_cert_K23> k23 = std::dynamic_pointer_cast<negative_cert_K23>(retval.op_reason);
+            if (k23) {
+                std::span<int> * k23_paths[3] = {&k23->one, &k23->two, &k23->three};
+
+                int pnum = 0;
+                int path_ind;
+                for (; pnum < 3; pnum++) {
+                    path_ind = path_contains_edge(*(k23_paths[pnum]), fake);
+                    if (path_ind != -1) break;
+                }
+
+                if (pnum != 3 && k4_subgraph) {
+                    // the DFS stopped at a K4 of the graph, which may have left the path that
+                    // replaces the virtual edge unexplored; the K4 refutes outerplanarity too
+                    N_LOG("FAKE EDGE IN K23 NEXT TO A K4, USE THE K4\n")
+                    retval.op_reason = retval.reason;
+                } else if (pnum != 3) {
+                    std::span<int>& violating_path = *(k23_paths[pnum]);
+                    N_LOG("FAKE EDGE IN K23 (" << violating_path[path_ind] << ", " << violating_path[path_ind + 1] << "), REPLACE WITH PATH\n")
+
+                    // interior of the replacing path, from the root's side to next's side; the
+                    // path with it spliced in is a new one in the arena
+                    sp_arena& arena = *ctx.arena;
+                    std::span<int> splice_path;
+                    std::vector<char>& in_k23 = ctx.marked;
+
+                    for (std::span<int> * path : k23_paths) {
+                        for (int v : *path) {
+                            in_k23[v] = true;
+                            V_LOG(v << " in K23\n")
+                        }
+                    }
+
+                    for (int u2 : g.adjLists[next]) {
+                        if (comp[u2] == bicomp && parent[u2] == next && !in_k23[u2]) {
+                            V_LOG("FOUND TREE CHILD OF NEXT " << next << " NOT IN K23: " << u2 << ", ear (" << ear[u2].first << ", " << ear[u2].second << ")\n")
+                            for (int i = ear[u2].first; i != next; i = parent[i]) push_path(arena, splice_path, i);
+                            break;
+                        }
+                    }
+
+                    for (std::span<int> * path : k23_paths) {
+                        for (int v : *path) in_k23[v] = false;
+                    }
+
+                    if (violating_path[path_ind] != root) std::reverse(splice_path.begin(), splice_path.end());
+                    std::span<int> spliced{(int *)(arena.allocate((violating_path.size() + splice_path.size()) * sizeof(int), alignof(int))),
+                                           violating_path.size() + splice_path.size()};
+                    auto after = std::copy(violating_path.begin(), violating_path.begin() + path_ind + 1, spliced.begin());
+                    after = std::copy(splice_path.begin(), splice_path.end(), after);
+                    std::copy(violating_path.begin() + path_ind + 1, violating_path.end(), after);
+                    violating_path = spliced;
+                }
+            }
+        }
+    }
+
+    return bicomp_outcome{found, k4_subgraph};
+}
+
+// the vertex the DFS of a bicomp starts from after its root
+inline int bicomp_next(std::vector<edge_t> const& bicomps, int bicomp, bool blockwise) {
+    int n_bicomps = (int)(bicomps.size());
+    if (!blockwise && bicomp > 0 && bicomp < n_bicomps - 1) return bicomps[bicomp - 1].first;
+    return bicomps[bicomp].second;
+}
+
+// how SP_RECOGNITION finds the bicomps: get_bicomps, or get_bicomps_parallel on the pool of its
+// block_workers
+enum class bicomp_engine {dfs, parallel};
+
+// indexed by bicomp_engine, as given to --bicomps
+constexpr char const * bicomp_engine_names[] = {"dfs", "parallel"};
+
+// how SP_RECOGNITION recognizes a graph: by the DFS; by recognize_block_by_ears on the pool of
+// its block_workers, with the bicomps found by get_bicomps_parallel, if there is one; or by
+// recognize_by_reductions, before any bicomps are found
+enum class recognition_engine {dfs, ears, reduction};
+
+// indexed by recognition_engine, as given to --engine
+constexpr char const * recognition_engine_names[] = {"dfs", "ears", "reduction"};
+
+// Per-worker contexts for recognizing the bicomps of a chain on a pool (SP_RECOGNITION with
+// workers), and what each bicomp left for the stitching.
+template <typename Tree>
+struct block_workers {
+    struct run {
+        bicomp_outcome outcome;
+        bool nonop = false;
+        sp_result result; // its K4 or T4 in reason, its K23 in op_reason
+        Tree seq; // in the nodes of the worker's context
+        int worker = 0;
+    };
+
+    work_stealing_pool& pool;
+    bicomp_engine engine = bicomp_engine::dfs;
+    recognition_engine block_engine = recognition_engine::dfs;
+    std::vector<basic_recognizer_context<Tree>> ctx;
+    std::vector<char> prepared; // the worker's context is ready for the current graph
+    std::vector<run> runs;
+
+    explicit block_workers(work_stealing_pool& pool_) : pool{pool_}, ctx((size_t)(pool_.size())), prepared((size_t)(pool_.size())) {}
+};
+
+// Recognizes every bicomp of the chain get_bicomps (or get_bicomps_parallel) left in ctx on the pool, one task per
+// bicomp. The bicomps are bounded by the comp labels a sequential run would end with, found
+// beforehand from the blocks of the DFS tree: a vertex gets the chain position of its block,
+// and the cut vertex between two bicomps that of the later one, which reaches it first as next.
+// Every bicomp looks for a K23 as if none had been found before it; the stitching keeps the
+// first, which is the one a sequential run finds.
+template <typename Policy>
+void recognize_chain_on_pool(graph const& g, basic_recognizer_context<typename Policy::tree>& ctx, block_workers<typename Policy::tree>& workers) {
+    using tree = typename Policy::tree;
+    std::vector<edge_t> const& bicomps = ctx.bicomps;
     int n_bicomps = (int)(bicomps.size());
-    std::vector<sp_tree> cut_vertex_attached_tree((size_t)(n_bicomps));
-    std::vector<int> comp(g.n, -1);
+    std::vector<int>& comp = ctx.comp;
+    std::vector<int> const& block_of = ctx.block_of;
+    std::vector<int> const& heads = ctx.block_heads;
+    std::vector<int>& chain_pos = ctx.chain_pos;
+    int dfs_root = ctx.touched[0];
+
+    int blocks = label_blocks(ctx);
+    // a bicomp is the block holding both its root and next, and at most one of them heads it
+    auto in_block = [&](int v, int b) {return (v != dfs_root && block_of[v] == b) || heads[b] == v;};
+    for (int i = 0; i < n_bicomps; i++) {
+        int root = bicomps[i].first;
+        int next = bicomp_next(bicomps, i, false);
+        chain_pos[root != dfs_root && in_block(next, block_of[root]) ? block_of[root] : block_of[next]] = i;
+    }
+    for (size_t k = 1; k < ctx.touched.size(); k++) comp[ctx.touched[k]] = chain_pos[block_of[ctx.touched[k]]];
+    for (int b = 0; b < blocks; b++) {
+        if (heads[b] == dfs_root) comp[dfs_root] = chain_pos[b];
+    }
+    for (int i = 1; i < n_bicomps; i++) comp[bicomp_next(bicomps, i, false)] = i;
+
+    workers.runs.clear();
+    workers.runs.resize((size_t)(n_bicomps));
+    std::fill(workers.prepared.begin(), workers.prepared.end(), 0);
+    for (int i = 0; i < n_bicomps; i++) {
+        workers.pool.submit([&, i](int worker) {
+            // each worker readies its own context, so that growing them is spread over the pool
+            basic_recognizer_context<tree>& wctx = workers.ctx[(size_t)(worker)];
+            if (!workers.prepared[(size_t)(worker)]) {
+                wctx.prepare(g.n, true);
+                workers.prepared[(size_t)(worker)] = 1;
+            }
+            typename block_workers<tree>::run& run = workers.runs[(size_t)(i)];
+            int root = bicomps[i].first;
+            int next = bicomp_next(bicomps, i, false);
+            wctx.touched.push_back(root);
+            wctx.touched.push_back(next);
+            run.worker = worker;
+            run.outcome = recognize_bicomp<Policy>(g, wctx, ctx.cut_verts, ctx.cut_vertex_attached_tree, i, root, next, false, run.nonop, run.result, &comp);
+            run.seq = std::move(wctx.seq[next]);
+            for (int v : wctx.touched) wctx.reset_recognition(v);
+            wctx.touched.clear();
+        });
+    }
+    workers.pool.wait_idle();
+}
+
+// ==================== PARALLEL EAR RECOGNITION ====================
+// A graph of one bicomp can also be recognized from an open ear decomposition, found on the pool
+// from the BFS tree get_bicomps_parallel leaves in the context (after Maon, Schieber and
+// Vishkin). Every nontree edge starts an ear, keyed by the dfs_no of the lowest common ancestor
+// of its ends and then by its rank among the nontree edges that meet there, and every tree edge
+// joins the ear of the lowest key among the nontree edges leaving the subtree below it. The
+// ranks come from a BFS over the children of the ancestor, started from those whose subtrees
+// reach past it, so only one end of any ear but the first climbs all the way to the ancestor:
+// the ears are open.
+//
+// A 2-connected graph with a nested ear decomposition is SP (Eppstein): every ear has both ends
+// on one earlier ear, its host, and the intervals between the ends of the ears a host carries
+// never cross. The SP tree follows the nesting; an ear is the series of its edges, with every
+// interval replaced by the parallel composition of its stretch and the ears on it. Two crossing
+// ears and their host give a K4, and an interval with three branches that each have an inner
+// vertex (its stretch, its ears, or the way round the rest of the graph) a K23. A vertex is
+// inner to one ear, so an ear is nested only in the ear of one of its ends, and then only if
+// its other end is on it too. An ear nested nowhere, a graph that is not outerplanar although no
+// interval shows a K23, and a graph with loops or parallel tree edges are left to the DFS of
+// SP_RECOGNITION; returns whether the ears decided the graph. Only the SP tree, the paths of an
+// obstruction and the outer embedding are built on the calling thread.
+template <typename Policy>
+bool recognize_block_by_ears(graph const& g, basic_recognizer_context<typename Policy::tree>& ctx, work_stealing_pool& pool, sp_result& retval) {
+    std::vector<int> const& touched = ctx.touched;
+    std::vector<int> const& pos = ctx.bc_pos;
+    std::vector<int> const& parent = ctx.bc_parent;
+    std::vector<int> const& dfs_no = ctx.bc_dfs_no;
+    std::vector<int> const& levels = ctx.bc_levels;
+    std::vector<int> const& first_child = ctx.bc_first_child;
+    std::vector<int> const& size = ctx.bc_size;
+    std::vector<int> const& reach_low = ctx.bc_reach_low;
+    std::vector<int> const& reach_high = ctx.bc_reach_high;
+    int count = (int)(touched.size());
+    int depth_count = (int)(levels.size()) - 1;
+    if (count != g.n || count < 3) return false;
+
+    size_t cap = (size_t)(ctx.capacity);
+    if (ctx.ear_depth.size() < cap) {
+        ctx.ear_depth.resize(cap);
+        ctx.ear_pre.resize(cap);
+        ctx.ear_up.resize(cap);
+        ctx.ear_group.resize(cap + 1);
+        ctx.ear_cursor.resize(cap);
+        ctx.ear_seen.resize(cap);
+        ctx.ear_first.resize(cap);
+        ctx.ear_key.resize(cap);
+        ctx.ear_label.resize(cap);
+    }
+    std::vector<int>& depth = ctx.ear_depth;
+    std::vector<int>& pre = ctx.ear_pre;
+    std::vector<int>& up = ctx.ear_up;
+    std::vector<int>& group = ctx.ear_group;
+    std::vector<int>& cursor = ctx.ear_cursor;
+    std::vector<char>& seen = ctx.ear_seen;
+    std::vector<int>& first = ctx.ear_first;
+    std::vector<uint64_t>& key = ctx.ear_key;
+    std::vector<int>& label = ctx.ear_label;
+    std::vector<ear_record>& raw = ctx.ear_raw;
+    std::vector<ear_record>& ears = ctx.ears;
+    std::vector<int>& order = ctx.ear_order;
+    std::vector<int>& rank = ctx.ear_rank;
+    std::vector<int>& host_start = ctx.ear_host_start;
+    std::vector<int>& hosted = ctx.ear_hosted;
+    std::vector<std::vector<int>>& found = ctx.bc_chunk_found;
+    std::vector<std::vector<std::pair<int, int>>>& chunk_ends = ctx.ear_chunk_ends;
+
+    const int min_items_per_chunk = 1 << 12;
+    auto chunks_for = [&](int items) {
+        int chunks = chunk_count(pool, items, min_items_per_chunk);
+        if ((int)(found.size()) < chunks) found.resize((size_t)(chunks));
+        if ((int)(chunk_ends.size()) < chunks) chunk_ends.resize((size_t)(chunks));
+        return chunks;
+    };
+    // runs f(i) for every i in [begin, end)
+    auto for_items = [&](int begin, int end, auto const& f) {
+        for_each_chunk(pool, chunks_for(end - begin), end - begin, [&](int, int lo, int hi) {
+            for (int i = begin + lo; i < begin + hi; i++) f(i);
+        });
+    };
+    std::atomic<bool> undecided{false};
+    auto give_up = [&]() {undecided.store(true, std::memory_order_relaxed);};
+
+    for_each_chunk(pool, chunks_for(count), count, [&](int, int lo, int hi) {
+        int l = (int)(std::upper_bound(levels.begin(), levels.end(), lo) - levels.begin()) - 1;
+        for (int t = lo; t < hi; t++) {
+            for (; levels[(size_t)(l) + 1] <= t; l++);
+            int v = touched[(size_t)(t)];
+            depth[t] = l;
+            pre[t] = dfs_no[v];
+            up[t] = (t == 0 ? -1 : pos[parent[v]]);
+        }
+    });
+
+    // Every nontree edge is listed at its end with the lower dfs_no, in touched order. The
+    // neighbours numbered within the subtree of t are on the next level, its children, and those
+    // numbered below it are listed at their own end.
+    auto nontree = [&](int t, int u) {return dfs_no[u] >= pre[t] + size[t];};
+    for_items(0, count, [&](int t) {
+        int v = touched[(size_t)(t)];
+        int k = 0;
+        int to_parent = 0;
+        for (int u : g.adjLists[v]) {
+            if (u == v) give_up();
+            else if (u == parent[v]) to_parent++;
+            else if (nontree(t, u)) k++;
+        }
+        if (t > 0 && to_parent != 1) give_up();
+        group[t] = k;
+    });
+    if (undecided.load()) return false;
+    int n_ears = exclusive_scan(pool, group.data(), count, ctx.ear_scan);
+    if (n_ears == 0) return false;
+    if (raw.size() < (size_t)(n_ears)) {
+        raw.resize((size_t)(n_ears));
+        ears.resize((size_t)(n_ears));
+        order.resize((size_t)(n_ears));
+        rank.resize((size_t)(n_ears));
+        host_start.resize((size_t)(n_ears) + 1);
+        hosted.resize((size_t)(n_ears));
+        ctx.ear_tree.resize((size_t)(n_ears));
+    }
+
+    // Within a level, the positions follow dfs_no, so the ancestor of t on a level is the last
+    // position there numbered no higher. The lowest common ancestor is the first ancestor of u
+    // whose subtree holds v: most nontree edges close short cycles and find it in a few steps up,
+    // the others by galloping up the levels and then bisecting.
+    auto ancestor_at = [&](int t, int level) {
+        if (depth[t] == level) return t;
+        int const * lo = pre.data() + levels[(size_t)(level)];
+        int const * hi = pre.data() + levels[(size_t)(level) + 1];
+        return (int)(std::upper_bound(lo, hi, pre[t]) - pre.data()) - 1;
+    };
+    auto meet = [&](ear_record& r) {
+        int target = pre[r.v];
+        auto holds = [&](int w) {return pre[w] <= target && target < pre[w] + size[w];};
+        int a = r.u;
+        int below = a;
+        for (int step = 0; step < 8 && !holds(a); step++) {
+            below = a;
+            a = up[a];
+        }
+        if (!holds(a)) {
+            int hi = depth[a];
+            int gap = 8;
+            int lo = std::max(hi - gap, 0);
+            while (!holds(ancestor_at(a, lo))) {
+                hi = lo;
+                gap *= 2;
+                lo = std::max(hi - gap, 0);
+            }
+            while (hi - lo > 1) {
+                int mid = (lo + hi) / 2;
+                if (holds(ancestor_at(a, mid))) lo = mid;
+                else hi = mid;
+            }
+            below = ancestor_at(a, hi);
+            a = ancestor_at(a, lo);
+        }
+        r.lca = a;
+        r.cu = below;
+        r.cv = ancestor_at(r.v, depth[a] + 1);
+    };
+    for_items(0, count, [&](int t) {
+        int v = touched[(size_t)(t)];
+        int id = group[t];
+        for (int u : g.adjLists[v]) {
+            if (!nontree(t, u)) continue;
+            ear_record& r = raw[(size_t)(id++)];
+            r.u = t;
+            r.v = pos[u];
+            meet(r);
+        }
+    });
+
+    // the nontree edges by lowest common ancestor, each group in listing order
+    for_items(0, count, [&](int t) {group[t] = 0;});
+    for_items(0, n_ears, [&](int i) {std::atomic_ref<int>{group[raw[(size_t)(i)].lca]}.fetch_add(1, std::memory_order_relaxed);});
+    exclusive_scan(pool, group.data(), count, ctx.ear_scan);
+    group[count] = n_ears;
+    for_items(0, count, [&](int t) {cursor[t] = group[t];});
+    for_items(0, n_ears, [&](int i) {order[(size_t)(std::atomic_ref<int>{cursor[raw[(size_t)(i)].lca]}.fetch_add(1, std::memory_order_relaxed))] = i;});
+
+    // The nontree edges meeting at w are ranked in the order a BFS over the children of w they
+    // join first scans them. It starts from the children whose subtrees reach past w, or at the
+    // root from the child above the first of them, which makes that one the first ear. A child
+    // is reached through the edge of lowest rank leaving its subtree, the only ear that can
+    // climb to w through it.
+    for_each_chunk(pool, chunks_for(count), count, [&](int c, int lo, int hi) {
+        std::vector<std::pair<int, int>>& ends = chunk_ends[(size_t)(c)];
+        std::vector<int>& queue = found[(size_t)(c)];
+        for (int w = lo; w < hi; w++) {
+            int s = group[w];
+            int e = group[w + 1];
+            if (s == e) continue;
+            std::sort(order.begin() + s, order.begin() + e);
+            ends.clear();
+            for (int i = s; i < e; i++) {
+                int id = order[(size_t)(i)];
+                rank[(size_t)(id)] = -1;
+                ends.emplace_back(raw[(size_t)(id)].cu, id);
+                ends.emplace_back(raw[(size_t)(id)].cv, id);
+            }
+            std::sort(ends.begin(), ends.end());
+            queue.clear();
+            for (size_t i = 0; i < ends.size(); i++) {
+                int child = ends[i].first;
+                if (i > 0 && child == ends[i - 1].first) continue;
+                first[child] = (int)(i);
+                bool escapes = (w != 0 && (reach_low[child] < pre[w] || reach_high[child] >= pre[w] + size[w]));
+                seen[child] = escapes;
+                if (escapes) queue.push_back(child);
+            }
+            if (w == 0) {
+                int child = raw[(size_t)(order[(size_t)(s)])].cu;
+                seen[child] = true;
+                queue.push_back(child);
+            }
+            int ranked = 0;
+            for (size_t q = 0; q < queue.size(); q++) {
+                int child = queue[q];
+                for (size_t i = (size_t)(first[child]); i < ends.size() && ends[i].first == child; i++) {
+                    int id = ends[i].second;
+                    if (rank[(size_t)(id)] != -1) continue;
+                    rank[(size_t)(id)] = ranked++;
+                    ear_record const& r = raw[(size_t)(id)];
+                    int other = (r.cu == child ? r.cv : r.cu);
+                    if (!seen[other]) {
+                        seen[other] = true;
+                        queue.push_back(other);
+                    }
+                }
+            }
+            if (ranked != e - s) {
+                give_up();
+                continue;
+            }
+            for (int i = s; i < e; i++) {
+                int id = order[(size_t)(i)];
+                ear_record& r = ears[(size_t)(s + rank[(size_t)(id)])];
+                r = raw[(size_t)(id)];
+                r.top_u = r.u;
+                r.top_v = r.v;
+                r.host = -1;
+                r.reversed = false;
+            }
+        }
+    });
+    if (undecided.load()) return false;
+
+    // Ears are numbered by lowest common ancestor and rank, and keyed by dfs_no of the ancestor
+    // and number; the first ear is number 0. A tree edge joins the ear of the lowest key leaving
+    // the subtree of its child, which has its ancestor above the child unless the edge is a bridge.
+    const int p0 = 0;
+    for_items(0, count, [&](int t) {key[t] = UINT64_MAX;});
+    for_items(0, n_ears, [&](int s) {
+        ear_record const& r = ears[(size_t)(s)];
+        uint64_t k = ((uint64_t)(pre[r.lca]) << 32) | (uint64_t)(s);
+        for (int t : {r.u, r.v}) {
+            std::atomic_ref<uint64_t> a{key[t]};
+            uint64_t seen_key = a.load(std::memory_order_relaxed);
+            while (k < seen_key && !a.compare_exchange_weak(seen_key, k, std::memory_order_relaxed));
+        }
+    });
+    for (int l = depth_count; l-- > 0;) {
+        for_items(levels[(size_t)(l)], levels[(size_t)(l) + 1], [&](int t) {
+            for (int c = first_child[t]; c < first_child[t + 1]; c++) key[t] = std::min(key[t], key[c]);
+        });
+    }
+    for_items(1, count, [&](int t) {
+        if ((int)(key[t] >> 32) >= pre[t]) give_up();
+        label[t] = (int)(key[t] & 0xffffffffu);
+    });
+    if (undecided.load()) return false;
+
+    // the top of a side of an ear is the parent of its highest tree edge
+    auto in_subtree = [&](int t, int a) {return pre[a] <= pre[t] && pre[t] < pre[a] + size[a];};
+    for_items(1, count, [&](int t) {
+        int s = label[t];
+        int p = up[t];
+        if (s == p0 || (p != 0 && label[p] == s)) return;
+        ear_record& r = ears[(size_t)(s)];
+        if (in_subtree(r.u, t)) r.top_u = p;
+        else r.top_v = p;
+    });
+    for_items(0, n_ears, [&](int s) {
+        ear_record& r = ears[(size_t)(s)];
+        r.len = (s == p0 ? depth[r.u] + depth[r.v] : depth[r.u] - depth[r.top_u] + 1 + depth[r.v] - depth[r.top_v]);
+    });
+
+    // the ear a vertex is inner to, its position there, and the position of an end of ear s
+    auto home = [&](int t) {return t == 0 ? p0 : label[t];};
+    auto position_on = [&](int s, int t) {
+        ear_record const& r = ears[(size_t)(s)];
+        if (s == p0) return in_subtree(r.u, t) ? depth[r.u] - depth[t] : depth[r.u] + depth[t];
+        return in_subtree(r.u, t) ? depth[t] - depth[r.top_u] : r.len - depth[t] + depth[r.top_v];
+    };
+    auto end_on = [&](int s, int t) {
+        if (s == p0) return -1;
+        ear_record const& r = ears[(size_t)(s)];
+        return r.top_u == t ? 0 : r.top_v == t ? r.len : -1;
+    };
+    for_items(1, n_ears, [&](int s) {
+        ear_record& r = ears[(size_t)(s)];
+        int hu = home(r.top_u);
+        int hv = home(r.top_v);
+        int pu = -1;
+        int pv = -1;
+        if (hu == hv) {
+            r.host = hu;
+            pu = position_on(hu, r.top_u);
+            pv = position_on(hu, r.top_v);
+        } else if ((pv = end_on(hu, r.top_v)) != -1) {
+            r.host = hu;
+            pu = position_on(hu, r.top_u);
+        } else if ((pu = end_on(hv, r.top_u)) != -1) {
+            r.host = hv;
+            pv = position_on(hv, r.top_v);
+        } else {
+            give_up();
+            return;
+        }
+        r.lo = std::min(pu, pv);
+        r.hi = std::max(pu, pv);
+        r.reversed = (pu > pv);
+    });
+    bool nested = !undecided.load();
+    auto has_host = [&](int s) {return ears[(size_t)(s)].host != -1;};
+
+    // the nested ears on each host, by interval, outer ones first
+    for_items(0, n_ears, [&](int s) {host_start[(size_t)(s)] = 0;});
+    for_items(1, n_ears, [&](int s) {
+        if (has_host(s)) std::atomic_ref<int>{host_start[(size_t)(ears[(size_t)(s)].host)]}.fetch_add(1, std::memory_order_relaxed);
+    });
+    host_start[(size_t)(n_ears)] = exclusive_scan(pool, host_start.data(), n_ears, ctx.ear_scan);
+    for_items(0, n_ears, [&](int s) {rank[(size_t)(s)] = host_start[(size_t)(s)];});
+    for_items(1, n_ears, [&](int s) {
+        if (has_host(s)) hosted[(size_t)(std::atomic_ref<int>{rank[(size_t)(ears[(size_t)(s)].host)]}.fetch_add(1, std::memory_order_relaxed))] = s;
+    });
+
+    // per chunk of hosts, the first crossing (host, outer ear, inner ear) on a host that is
+    // nested itself, and the first interval with three branches (host, and where its ears begin
+    // and end in hosted)
+    int host_chunks = chunks_for(n_ears);
+    std::vector<std::array<int, 3>> crossings((size_t)(host_chunks), std::array<int, 3>{-1, -1, -1});
+    std::vector<std::array<int, 3>> k23s((size_t)(host_chunks), std::array<int, 3>{-1, -1, -1});
+    for_each_chunk(pool, host_chunks, n_ears, [&](int c, int lo, int hi) {
+        std::vector<int>& stack = found[(size_t)(c)];
+        std::array<int, 3>& crossing = crossings[(size_t)(c)];
+        std::array<int, 3>& k23 = k23s[(size_t)(c)];
+        for (int h = lo; h < hi; h++) {
+            int b = host_start[(size_t)(h)];
+            int e = host_start[(size_t)(h) + 1];
+            std::sort(hosted.begin() + b, hosted.begin() + e, [&](int x, int y) {
+                ear_record const& l = ears[(size_t)(x)];
+                ear_record const& r = ears[(size_t)(y)];
+                if (l.lo != r.lo) return l.lo < r.lo;
+                if (l.hi != r.hi) return l.hi > r.hi;
+                return x < y;
+            });
+            stack.clear();
+            for (int i = b; i < e && crossing[0] == -1 && (h == p0 || has_host(h)); i++) {
+                ear_record const& f = ears[(size_t)(hosted[(size_t)(i)])];
+                while (!stack.empty() && ears[(size_t)(stack.back())].hi <= f.lo) stack.pop_back();
+                if (!stack.empty() && f.hi > ears[(size_t)(stack.back())].hi) crossing = {h, stack.back(), hosted[(size_t)(i)]};
+                stack.push_back(hosted[(size_t)(i)]);
+            }
+            for (int i = b, j = b; i < e && k23[0] == -1; i = j) {
+                ear_record const& f = ears[(size_t)(hosted[(size_t)(i)])];
+                int branches = (f.hi - f.lo >= 2) + (h != p0 || f.lo > 0 || f.hi < ears[(size_t)(h)].len);
+                for (; j < e && ears[(size_t)(hosted[(size_t)(j)])].lo == f.lo && ears[(size_t)(hosted[(size_t)(j)])].hi == f.hi; j++) {
+                    branches += (ears[(size_t)(hosted[(size_t)(j)])].len >= 2);
+                }
+                if (branches >= 3) k23 = {h, i, j};
+            }
+        }
+    });
+    std::array<int, 3> crossing{-1, -1, -1};
+    std::array<int, 3> k23{-1, -1, -1};
+    for (int c = host_chunks; c-- > 0;) {
+        if (crossings[(size_t)(c)][0] != -1) crossing = crossings[(size_t)(c)];
+        if (k23s[(size_t)(c)][0] != -1) k23 = k23s[(size_t)(c)];
+    }
+
+    // An ear that is not nested still gives a K4 when one of its ends, x, is inner to a nested
+    // ear and the other, y, is on the host of that ear, itself nested: x, the ends of its ear and
+    // y. Per chunk,
+    // the first such ear and the end that is x (0 for top_u).
+    std::vector<std::array<int, 2>> misses((size_t)(host_chunks), std::array<int, 2>{-1, -1});
+    if (!nested && crossing[0] == -1) {
+        for_each_chunk(pool, host_chunks, n_ears, [&](int c, int lo, int hi) {
+            for (int s = std::max(lo, 1); s < hi && misses[(size_t)(c)][0] == -1; s++) {
+                ear_record const& r = ears[(size_t)(s)];
+                if (has_host(s)) continue;
+                for (int side = 0; side < 2; side++) {
+                    int x = (side == 0 ? r.top_u : r.top_v);
+                    int y = (side == 0 ? r.top_v : r.top_u);
+                    int a = home(x);
+                    if (a == p0 || !has_host(a)) continue;
+                    int h = ears[(size_t)(a)].host;
+                    if ((h == p0 || has_host(h)) && (home(y) == h || end_on(h, y) != -1)) {
+                        misses[(size_t)(c)] = {s, side};
+                        break;
+                    }
+                }
+            }
+        });
+    }
+    std::array<int, 2> miss{-1, -1};
+    for (int c = host_chunks; c-- > 0;) {
+        if (misses[(size_t)(c)][0] != -1) miss = misses[(size_t)(c)];
+    }
+
+    // the positions of ear s in order, from top_u (from u for the first ear)
+    auto walk_ear = [&](int s, std::vector<int>& out) {
+        ear_record const& r = ears[(size_t)(s)];
+        out.clear();
+        if (s == p0) {
+            for (int t = r.u; t != 0; t = up[t]) out.push_back(t);
+            out.push_back(0);
+            size_t mid = out.size();
+            for (int t = r.v; t != 0; t = up[t]) out.push_back(t);
+            std::reverse(out.begin() + (long)(mid), out.end());
+        } else {
+            for (int t = r.u; t != r.top_u; t = up[t]) out.push_back(t);
+            out.push_back(r.top_u);
+            std::reverse(out.begin(), out.end());
+            for (int t = r.v; t != r.top_v; t = up[t]) out.push_back(t);
+            out.push_back(r.top_v);
+        }
+    };
+    // appends the vertices of an ear from position from to position to to a certificate path
+    auto stretch = [&](std::span<int>& out, std::vector<int> const& walk, int from, int to) {
+        for (int i = from;; i += (from < to ? 1 : -1)) {
+            push_path(*ctx.arena, out, touched[(size_t)(walk[(size_t)(i)])]);
+            if (i == to) break;
+        }
+    };
+    // the vertices from position lo of ear h round the rest of the graph to position hi: back to
+    // its start, along its host (or the edge closing the first ear) and back from its end
+    auto around = [&](std::span<int>& out, int h, int lo, int hi) {
+        ear_record const& r = ears[(size_t)(h)];
+        std::vector<int>& walk = ctx.ear_walk;
+        walk_ear(h, walk);
+        stretch(out, walk, lo, 0);
+        if (h != p0) {
+            std::vector<int>& host_walk = ctx.ear_host_walk;
+            walk_ear(r.host, host_walk);
+            int from = (r.reversed ? r.hi : r.lo);
+            int to = (r.reversed ? r.lo : r.hi);
+            // the ends are those of ear h
+            int step = (from < to ? 1 : -1);
+            for (int i = from + step; from != to && i != to; i += step) push_path(*ctx.arena, out, touched[(size_t)(host_walk[(size_t)(i)])]);
+        }
+        stretch(out, walk, r.len, hi);
+    };
+    auto whole = [&](std::span<int>& out, int s) {
+        std::vector<int>& walk = ctx.ear_walk;
+        walk_ear(s, walk);
+        stretch(out, walk, 0, (int)(walk.size()) - 1);
+    };
+
+    if (crossing[0] != -1) {
+        auto [h, outer, inner] = crossing;
+        N_LOG("NON-SP, ears " << outer << " and " << inner << " cross on ear " << h << "\n")
+        if constexpr (Policy::certificate) {
+            ear_record const& a = ears[(size_t)(outer)];
+            ear_record const& b = ears[(size_t)(inner)];
+            std::vector<int>& walk = ctx.ear_path;
+            walk_ear(h, walk);
+            std::shared_ptr<negative_cert_K4> k4 = make_arena_shared<negative_cert_K4>(ctx.arena);
+            k4->a = touched[(size_t)(walk[(size_t)(a.lo)])];
+            k4->b = touched[(size_t)(walk[(size_t)(b.lo)])];
+            k4->c = touched[(size_t)(walk[(size_t)(a.hi)])];
+            k4->d = touched[(size_t)(walk[(size_t)(b.hi)])];
+            if constexpr (Policy::paths) {
+                stretch(k4->ab, walk, a.lo, b.lo);
+                stretch(k4->bc, walk, b.lo, a.hi);
+                stretch(k4->cd, walk, a.hi, b.hi);
+                whole(k4->ac, outer);
+                whole(k4->bd, inner);
+                around(k4->ad, h, a.lo, b.hi);
+            }
+            retval.reason = k4;
+            retval.gsp_reason = k4;
+            retval.op_reason = k4;
+        }
+        retval.is_sp = false;
+        retval.is_gsp = false;
+        retval.is_op = false;
+        return true;
+    }
+
+    if (miss[0] != -1) {
+        auto [s, side] = miss;
+        ear_record const& r = ears[(size_t)(s)];
+        int x = (side == 0 ? r.top_u : r.top_v);
+        int y = (side == 0 ? r.top_v : r.top_u);
+        int a = home(x);
+        ear_record const& ra = ears[(size_t)(a)];
+        int h = ra.host;
+        N_LOG("NON-SP, ear " << s << " leaves ear " << a << " for its host " << h << "\n")
+        if constexpr (Policy::certificate) {
+            // whole and around walk their ears here too, once ab and ac are read off
+            std::vector<int>& ear_walk = ctx.ear_walk;
+            walk_ear(a, ear_walk);
+            std::vector<int>& walk = ctx.ear_path;
+            walk_ear(h, walk);
+            // the ends of ear a and y, on its host
+            int ps = (ra.reversed ? ra.hi : ra.lo);
+            int pt = (ra.reversed ? ra.lo : ra.hi);
+            int py = (home(y) == h ? position_on(h, y) : end_on(h, y));
+            std::shared_ptr<negative_cert_K4> k4 = make_arena_shared<negative_cert_K4>(ctx.arena);
+            k4->a = touched[(size_t)(x)];
+            k4->b = touched[(size_t)(walk[(size_t)(ps)])];
+            k4->c = touched[(size_t)(walk[(size_t)(pt)])];
+            k4->d = touched[(size_t)(y)];
+            if constexpr (Policy::paths) {
+                int px = position_on(a, x);
+                stretch(k4->ab, ear_walk, px, 0);
+                stretch(k4->ac, ear_walk, px, ra.len);
+                whole(k4->ad, s);
+                // a cycle through both ends and y: two stretches of the host, and the way round
+                if ((ps < py) == (py < pt)) {
+                    stretch(k4->bd, walk, ps, py);
+                    stretch(k4->cd, walk, pt, py);
+                    around(k4->bc, h, std::min(ps, pt), std::max(ps, pt));
+                } else if ((ps < py) == (ps < pt)) {
+                    stretch(k4->cd, walk, pt, py);
+                    stretch(k4->bc, walk, ps, pt);
+                    around(k4->bd, h, std::min(ps, py), std::max(ps, py));
+                } else {
+                    stretch(k4->bd, walk, ps, py);
+                    stretch(k4->bc, walk, ps, pt);
+                    around(k4->cd, h, std::min(pt, py), std::max(pt, py));
+                }
+            }
+            retval.reason = k4;
+            retval.gsp_reason = k4;
+            retval.op_reason = k4;
+        }
+        retval.is_sp = false;
+        retval.is_gsp = false;
+        retval.is_op = false;
+        return true;
+    }
+
+    if (!nested) {
+        N_LOG("an ear is not nested, leaving the graph to the DFS\n")
+        return false;
+    }
+
+    bool nonop = (k23[0] != -1);
+    if constexpr (Policy::certificate) {
+        if (nonop) {
+            auto [h, b, e] = k23;
+            ear_record const& f = ears[(size_t)(hosted[(size_t)(b)])];
+            N_LOG("NON-OP, three branches between positions " << f.lo << " and " << f.hi << " of ear " << h << "\n")
+            std::vector<int>& walk = ctx.ear_path;
+            walk_ear(h, walk);
+            std::shared_ptr<negative_cert_K23> cert = make_arena_shared<negative_cert_K23>(ctx.arena);
+            cert->a = touched[(size_t)(walk[(size_t)(f.lo)])];
+            cert->b = touched[(size_t)(walk[(size_t)(f.hi)])];
+            if constexpr (Policy::paths) {
+                std::span<int> * branch[3] = {&cert->one, &cert->two, &cert->three};
+                int taken = 0;
+                if (f.hi - f.lo >= 2) stretch(*branch[taken++], walk, f.lo, f.hi);
+                for (int i = b; i < e && taken < 3; i++) {
+                    if (ears[(size_t)(hosted[(size_t)(i)])].len >= 2) whole(*branch[taken++], hosted[(size_t)(i)]);
+                }
+                if (taken < 3) around(*branch[taken++], h, f.lo, f.hi);
+            }
+            retval.op_reason = cert;
+        } else {
+            std::shared_ptr<positive_cert_op> op = make_arena_shared<positive_cert_op>(ctx.arena);
+            if constexpr (Policy::paths) {
+                if (!outer_embedding_of(g, ctx, *ctx.arena, op->embedding)) {
+                    N_LOG("no outer cycles found, leaving the graph to the DFS\n")
+                    for (int v : touched) ctx.block_seen[v] = -1;
+                    return false;
+                }
+            }
+            retval.op_reason = op;
+        }
+
+        std::shared_ptr<positive_cert_sp> sp = make_arena_shared<positive_cert_sp>(ctx.arena);
+        if constexpr (Policy::paths) {
+            // every ear after those it hosts: the hosting in BFS order, backwards
+            sp_node_pool& nodes = ctx.nodes;
+            std::vector<uint32_t>& tree = ctx.ear_tree;
+            std::vector<int>& walk = ctx.ear_path;
+            order[0] = p0;
+            for (int i = 0, walked = 1; i < walked; i++) {
+                for (int k = host_start[(size_t)(order[(size_t)(i)])]; k < host_start[(size_t)(order[(size_t)(i)]) + 1]; k++) order[(size_t)(walked++)] = hosted[(size_t)(k)];
+            }
+
+            // An interval is open from its lower end to its upper one, and collects the edges and
+            // closed intervals in between in series; when it closes, the collected tree is
+            // composed in parallel with the ears on it.
+            struct interval {
+                int hi;
+                uint32_t tree;
+                int first; // its ears in hosted
+                int last;
+            };
+            std::vector<interval> open;
+            auto append = [&](interval& in, uint32_t t) {in.tree = (in.tree == sp_no_node ? t : nodes.join(in.tree, t, c_type::series));};
+            for (int i = n_ears; i-- > 0;) {
+                int s = order[(size_t)(i)];
+                ear_record const& r = ears[(size_t)(s)];
+                walk_ear(s, walk);
+                open.assign(1, interval{r.len, sp_no_node, 0, 0});
+                int k = host_start[(size_t)(s)];
+                int k_end = host_start[(size_t)(s) + 1];
+                for (int at = 0; at < r.len; at++) {
+                    while (k < k_end && ears[(size_t)(hosted[(size_t)(k)])].lo == at) {
+                        int hi = ears[(size_t)(hosted[(size_t)(k)])].hi;
+                        int next = k;
+                        for (; next < k_end && ears[(size_t)(hosted[(size_t)(next)])].lo == at && ears[(size_t)(hosted[(size_t)(next)])].hi == hi; next++);
+                        open.push_back(interval{hi, sp_no_node, k, next});
+                        k = next;
+                    }
+                    append(open.back(), nodes.edge(touched[(size_t)(walk[(size_t)(at)])], touched[(size_t)(walk[(size_t)(at) + 1])]));
+                    while (open.size() > 1 && open.back().hi == at + 1) {
+                        interval in = open.back();
+                        open.pop_back();
+                        for (int x = in.first; x < in.last; x++) {
+                            int f = hosted[(size_t)(x)];
+                            in.tree = nodes.join(in.tree, tree[(size_t)(f)], ears[(size_t)(f)].reversed ? c_type::antiparallel : c_type::parallel);
+                        }
+                        append(open.back(), in.tree);
+                    }
+                }
+                tree[(size_t)(s)] = open[0].tree;
+            }
+            ear_record const& r = ears[(size_t)(p0)];
+            uint32_t root = nodes.join(tree[(size_t)(p0)], nodes.edge(touched[(size_t)(r.u)], touched[(size_t)(r.v)]), c_type::parallel);
+            sp->decomposition = extract_decomposition(nodes, root, [&](size_t bytes, size_t align) {return ctx.arena->allocate(bytes, align);}, ctx.tree_walk);
+        }
+        sp->is_sp = true;
+        retval.reason = sp;
+        retval.gsp_reason = sp;
+    }
+    retval.is_sp = true;
+    retval.is_gsp = true;
+    retval.is_op = !nonop;
+    N_LOG("graph is SP" << (nonop ? "" : " and outerplanar") << " (nested ears)\n")
+    return true;
+}
+
+// ==================== SERIES-PARALLEL REDUCTIONS ====================
+// A graph can also be recognized by reducing it as a multigraph instead of walking a DFS
+// (after Duffin, and Valdes, Tarjan and Lawler): a vertex of degree 2 is replaced by an edge
+// between its two neighbours (series), which is merged into the edge already between them if
+// there is one (parallel), so the multigraph stays simple. Vertices wait on a worklist from
+// the moment their degree comes down to 2, and the edge between two neighbours is looked up
+// in the shorter of their lists until the lookups add up to a few times the number of edges,
+// then in an edge_index. A connected graph is SP exactly when it reduces to one edge.
+//
+// Every edge of the multigraph carries the SP tree of what it replaced, from its first end to
+// its second, and the last edge carries the SP tree of the graph. A series needs the trees of
+// its two edges to meet head to tail: an edge of the graph is laid either way the first time
+// it is reduced, and a tree that points the wrong way is rebuilt reversed, the lighter one of
+// the two, so that a node is copied O(log n) times.
+//
+// An SP graph is outerplanar unless it has a K23: two vertices with three branches between
+// them that each have an inner vertex. Every parallel counts its branches with an inner vertex
+// and gives a K23 at three. A parallel of two, held in series by a larger edge, pins that
+// edge: merging it in parallel too gives a K23 on the ends of the pinned parallel, the way
+// round the new cycle being its third branch. Otherwise every block is a parallel of at most
+// two branches with inner vertices, and its outer cycle runs along both, through the branch
+// with inner vertices of every parallel on the way.
+//
+// A multigraph that gets stuck before one edge, like a graph with loops or parallel edges, is
+// left to the DFS of SP_RECOGNITION, which finds the obstruction. Under the boolean policy,
+// what is stuck with every degree at least 3 holds a K4 subdivision (Dirac), and so does the
+// graph, which is rejected at once. Returns whether the reductions decided the graph; all of
+// it runs on the calling thread.
+template <typename Policy>
+bool recognize_by_reductions(graph const& g, basic_recognizer_context<typename Policy::tree>& ctx, sp_result& retval) {
+    sp_node_pool& nodes = ctx.nodes;
+    size_t cap = (size_t)(ctx.capacity);
+    if (ctx.red_degree.size() < cap) {
+        ctx.red_degree.resize(cap);
+        ctx.red_head.resize(cap);
+    }
+    size_t max_edges = (size_t)(g.e) + (size_t)(g.n); // a series adds one edge per vertex
+    if (ctx.red_edges.size() < max_edges) {
+        ctx.red_edges.resize(max_edges);
+        ctx.red_next.resize(2 * max_edges);
+        ctx.red_prev.resize(2 * max_edges);
+        ctx.red_at.resize(2 * max_edges);
+    }
+    std::vector<int>& degree = ctx.red_degree;
+    std::vector<int>& head = ctx.red_head;
+    std::vector<int>& next = ctx.red_next;
+    std::vector<int>& prev = ctx.red_prev;
+    std::vector<int>& at = ctx.red_at;
+    std::vector<reduction_edge>& edges = ctx.red_edges;
+    std::vector<int>& pending = ctx.red_pending;
+    std::vector<std::pair<uint32_t, uint32_t>>& walk = ctx.red_walk;
+
+    int n_edges = 0;
+    auto link = [&](int h, int v) {
+        at[h] = v;
+        prev[h] = -1;
+        next[h] = head[v];
+        if (head[v] != -1) prev[head[v]] = h;
+        head[v] = h;
+    };
+    auto unlink = [&](int h) {
+        if (prev[h] == -1) head[at[h]] = next[h];
+        else next[prev[h]] = next[h];
+        if (next[h] != -1) prev[next[h]] = prev[h];
+        at[h] = -1;
+    };
+    auto add_edge = [&](reduction_edge const& e) {
+        int id = n_edges++;
+        edges[(size_t)(id)] = e;
+        link(2 * id, e.u);
+        link(2 * id + 1, e.v);
+        return id;
+    };
+    auto other = [&](int h) {
+        reduction_edge const& e = edges[(size_t)(h / 2)];
+        return e.u == at[h] ? e.v : e.u;
+    };
+
+    for (int v = 0; v < g.n; v++) {
+        head[v] = -1;
+        degree[v] = g.degree(v);
+    }
+    for (int u = 0; u < g.n; u++) {
+        for (int v : g.adjLists[u]) {
+            if (v == u) return false;
+            if (u < v) add_edge(reduction_edge{u, v});
+        }
+    }
+
+    // Like outer_embedding_of: scans the shorter list until the scans add up to a few times the
+    // number of edges, then indexes the edges left.
+    const long long scan_budget = 4;
+    bool hashed = false;
+    long long scanned = 0;
+    auto find_edge = [&](int u, int v) {
+        if (hashed) return ctx.red_index.find(u, v);
+        if (degree[u] > degree[v]) std::swap(u, v);
+        for (int h = head[u]; h != -1; h = next[h]) {
+            scanned++;
+            if (other(h) == v) return h / 2;
+        }
+        if (scanned > scan_budget * (long long)(n_edges)) {
+            ctx.red_index.reset(max_edges);
+            for (int e = 0; e < n_edges; e++) {
+                if (at[2 * e] != -1) ctx.red_index.insert(edges[(size_t)(e)].u, edges[(size_t)(e)].v, e);
+            }
+            hashed = true;
+        }
+        return -1;
+    };
+
+    // a copy of the tree at root from its sink to its source: a series swaps its halves and
+    // reverses both, a parallel reverses its first branch and becomes antiparallel, and an
+    // antiparallel one only swaps its branches
+    std::vector<uint32_t>& done = ctx.red_done;
+    auto reversed = [&](uint32_t root) {
+        done.clear();
+        walk.assign(1, {root, 0});
+        while (!walk.empty()) {
+            auto [x, stage] = walk.back();
+            uint32_t l = nodes.left[x];
+            uint32_t r = nodes.right[x];
+            c_type comp = nodes.comp(x);
+            if (comp == c_type::edge) {
+                walk.pop_back();
+                done.push_back(nodes.edge(nodes.sink[x], nodes.source[x]));
+            } else if (comp == c_type::antiparallel) {
+                walk.pop_back();
+                done.push_back(nodes.join(r, l, c_type::antiparallel));
+            } else if (stage == 0) {
+                walk.back().second = 1;
+                walk.emplace_back(comp == c_type::series ? r : l, 0);
+            } else if (comp == c_type::parallel) {
+                walk.pop_back();
+                done.back() = nodes.join(done.back(), r, c_type::antiparallel);
+            } else if (stage == 1) {
+                walk.back().second = 2;
+                walk.emplace_back(l, 0);
+            } else {
+                walk.pop_back();
+                uint32_t reversed_l = done.back();
+                done.pop_back();
+                done.back() = nodes.join(done.back(), reversed_l, c_type::series);
+            }
+        }
+        return done.back();
+    };
+    // fixes the direction of an edge of the graph, which gets its tree
+    auto fix = [&](reduction_edge& e) {
+        if (e.weight > 0) return;
+        e.weight = 1;
+        if constexpr (Policy::paths) e.tree = nodes.edge(e.u, e.v);
+    };
+    auto turn = [&](reduction_edge& e) {
+        std::swap(e.u, e.v);
+        if constexpr (Policy::paths) {
+            if (e.tree != sp_no_node) e.tree = reversed(e.tree);
+        }
+    };
+
+    // the first K23: side by side on a parallel (tree), or on a pin (a, b) of the edge tree,
+    // which the edge round closes in a cycle, from its end at v when round_flip
+    int k23 = 0; // 1 side by side, 2 on a pin
+    int k23_a = -1;
+    int k23_b = -1;
+    uint32_t k23_tree = sp_no_node;
+    uint32_t k23_round = sp_no_node;
+    bool k23_round_flip = false;
+
+    int alive = n_edges;
+    int last = 0; // the edge a reduction left last
+    pending.clear();
+    for (int v = 0; v < g.n; v++) {
+        if (degree[v] == 2) pending.push_back(v);
+    }
+    while (alive > 1 && !pending.empty()) {
+        int x = pending.back();
+        pending.pop_back();
+        if (degree[x] != 2) continue;
+
+        int h1 = head[x];
+        int h2 = next[h1];
+        int a = other(h1);
+        int b = other(h2);
+        if (a == b) {
+            N_LOG("parallel edges at " << x << ", leaving the graph to the DFS\n")
+            nodes.clear();
+            return false;
+        }
+        // a -> x -> b, or the other way round if that reverses less
+        auto cost = [&](int h, bool into) {
+            reduction_edge const& e = edges[(size_t)(h / 2)];
+            return ((into ? e.v : e.u) == x ? 0 : e.weight);
+        };
+        if (cost(h1, true) + cost(h2, false) > cost(h2, true) + cost(h1, false)) {
+            std::swap(h1, h2);
+            std::swap(a, b);
+        }
+        reduction_edge& in = edges[(size_t)(h1 / 2)];
+        reduction_edge& out = edges[(size_t)(h2 / 2)];
+        if (in.v != x) turn(in);
+        if (out.u != x) turn(out);
+        fix(in);
+        fix(out);
+
+        reduction_edge s{a, b};
+        s.weight = in.weight + out.weight + 1;
+        s.branches = 1;
+        for (reduction_edge const * e : {&in, &out}) {
+            if (s.pin_a != -1) break;
+            if (e->branches >= 2) {
+                s.pin_a = e->u;
+                s.pin_b = e->v;
+            } else {
+                s.pin_a = e->pin_a;
+                s.pin_b = e->pin_b;
+            }
+        }
+        if constexpr (Policy::paths) s.tree = nodes.join(in.tree, out.tree, c_type::series);
+        for (int h : {h1, h1 ^ 1, h2, h2 ^ 1}) unlink(h);
+        degree[x] = 0;
+        degree[a]--;
+        degree[b]--;
+        alive--;
+
+        int f = find_edge(a, b);
+        if (f == -1) {
+            last = add_edge(s);
+            if (hashed) ctx.red_index.insert(a, b, last);
+            degree[a]++;
+            degree[b]++;
+            continue;
+        }
+
+        reduction_edge& p = edges[(size_t)(f)];
+        if (p.weight == 0 && p.u != a) std::swap(p.u, p.v);
+        fix(p);
+        bool anti = (p.u != a);
+        if (k23 == 0 && p.branches + s.branches >= 3) {
+            k23 = 1;
+            k23_a = p.u;
+            k23_b = p.v;
+        } else if (k23 == 0 && (s.pin_a != -1 || p.pin_a != -1)) {
+            reduction_edge const& pinned = (s.pin_a != -1 ? s : p);
+            reduction_edge const& round = (s.pin_a != -1 ? p : s);
+            k23 = 2;
+            k23_a = pinned.pin_a;
+            k23_b = pinned.pin_b;
+            k23_tree = pinned.tree;
+            k23_round = round.tree;
+            k23_round_flip = (round.u != pinned.v);
+        }
+        if constexpr (Policy::paths) {
+            p.tree = nodes.join(p.tree, s.tree, anti ? c_type::antiparallel : c_type::parallel);
+            if (k23 == 1 && k23_tree == sp_no_node) k23_tree = p.tree;
+        }
+        p.weight += s.weight + 1;
+        p.branches += s.branches;
+        p.pin_a = p.pin_b = -1;
+        alive--;
+        last = f;
+        for (int v : {a, b}) {
+            if (degree[v] == 2) pending.push_back(v);
+        }
+    }
+
+    if (alive > 1) {
+        if constexpr (!Policy::certificate) {
+            bool stuck_dense = true; // no vertex of degree 1; none of degree 2 is left
+            for (int v = 0; v < g.n && stuck_dense; v++) stuck_dense = (degree[v] != 1);
+            if (stuck_dense) {
+                N_LOG("NON-SP, the reductions left " << alive << " edges with every degree at least 3\n")
+                retval.is_sp = false;
+                retval.is_gsp = false;
+                retval.is_op = false;
+                return true;
+            }
+        }
+        N_LOG("the reductions left " << alive << " edges, leaving the graph to the DFS\n")
+        nodes.clear();
+        return false;
+    }
+    reduction_edge& root = edges[(size_t)(last)];
+    fix(root);
+    bool nonop = (k23 != 0);
+
+    if constexpr (Policy::certificate) {
+        // Paths through trees read with a flip from sink to source, as the right child of an
+        // antiparallel node is. walk_path appends the vertices of a path from the source of the
+        // tree at x to its sink, all but the first, through the first branch with an inner
+        // vertex of every parallel; branches_of lists the branches with inner vertices of the
+        // parallel at x, left first, and stops at limit.
+        [[maybe_unused]] auto source_of = [&](uint32_t x, bool flip) {return flip ? nodes.sink[x] : nodes.source[x];};
+        // out is scratch, or a certificate path in the arena
+        [[maybe_unused]] auto walk_path = [&](uint32_t x, bool flip, auto& out) {
+            walk.assign(1, {x, flip});
+            while (!walk.empty()) {
+                auto [y, f] = walk.back();
+                walk.pop_back();
+                c_type comp = nodes.comp(y);
+                uint32_t l = nodes.left[y];
+                uint32_t r = nodes.right[y];
+                if (comp == c_type::edge) {
+                    int v = (f ? nodes.source[y] : nodes.sink[y]);
+                    if constexpr (std::is_same_v<std::remove_cvref_t<decltype(out)>, std::span<int>>) {
+                        push_path(*ctx.arena, out, v);
+                    } else {
+                        out.push_back(v);
+                    }
+                } else if (comp == c_type::series) {
+                    walk.emplace_back(f ? l : r, f);
+                    walk.emplace_back(f ? r : l, f);
+                } else if (!nodes.is_edge(l)) {
+                    walk.emplace_back(l, f);
+                } else {
+                    walk.emplace_back(r, f != (comp == c_type::antiparallel));
+                }
+            }
+        };
+        std::vector<std::pair<uint32_t, bool>>& branches = ctx.red_branches;
+        [[maybe_unused]] auto branches_of = [&](uint32_t x, bool flip, size_t limit) {
+            branches.clear();
+            walk.assign(1, {x, flip});
+            while (!walk.empty() && branches.size() < limit) {
+                auto [y, f] = walk.back();
+                walk.pop_back();
+                c_type comp = nodes.comp(y);
+                if (comp == c_type::series) {
+                    branches.emplace_back(y, f);
+                } else if (comp != c_type::edge) {
+                    walk.emplace_back(nodes.right[y], f != (comp == c_type::antiparallel));
+                    walk.emplace_back(nodes.left[y], f);
+                }
+            }
+        };
+
+        if (nonop) {
+            N_LOG("NON-OP, " << (k23 == 1 ? "three branches" : "a pinned parallel in a cycle") << " between " << k23_a << " and " << k23_b << " (reductions)\n")
+            std::shared_ptr<negative_cert_K23> cert = make_arena_shared<negative_cert_K23>(ctx.arena);
+            cert->a = k23_a;
+            cert->b = k23_b;
+            if constexpr (Policy::paths) {
+                sp_arena& arena = *ctx.arena;
+                std::span<int> * paths[3] = {&cert->one, &cert->two, &cert->three};
+                if (k23 == 1) {
+                    branches_of(k23_tree, false, 3);
+                    for (int i = 0; i < 3; i++) {
+                        push_path(arena, *paths[i], k23_a);
+                        walk_path(branches[(size_t)(i)].first, branches[(size_t)(i)].second, *paths[i]);
+                    }
+                } else {
+                    // the cycle along the pinned edge and back round, and the pinned parallel on it
+                    std::vector<int>& cycle = ctx.red_path;
+                    cycle.assign(1, nodes.source[k23_tree]);
+                    walk_path(k23_tree, false, cycle);
+                    walk_path(k23_round, k23_round_flip, cycle);
+                    cycle.pop_back();
+                    uint32_t pin = sp_no_node;
+                    bool pin_flip = false;
+                    walk.assign(1, {k23_tree, 0});
+                    while (pin == sp_no_node && !walk.empty()) {
+                        auto [y, f] = walk.back();
+                        walk.pop_back();
+                        c_type comp = nodes.comp(y);
+                        if (comp == c_type::series) {
+                            walk.emplace_back(nodes.left[y], f);
+                            walk.emplace_back(nodes.right[y], f);
+                        } else if (comp != c_type::edge && std::minmax(nodes.source[y], nodes.sink[y]) == std::minmax(k23_a, k23_b)) {
+                            pin = y;
+                            pin_flip = f;
+                        }
+                    }
+                    // the cycle passes the pin through its first branch, so the second is the other
+                    branches_of(pin, pin_flip, 2);
+                    push_path(arena, cert->two, source_of(pin, pin_flip));
+                    walk_path(branches[1].first, branches[1].second, cert->two);
+                    if (cert->two[0] != k23_a) std::reverse(cert->two.begin(), cert->two.end());
+                    int k = (int)(cycle.size());
+                    int i = (int)(std::find(cycle.begin(), cycle.end(), k23_a) - cycle.begin());
+                    int j = (int)(std::find(cycle.begin(), cycle.end(), k23_b) - cycle.begin());
+                    int step = (i < j ? 1 : -1);
+                    for (int t = i;; t += step) {
+                        push_path(arena, cert->one, cycle[(size_t)(t)]);
+                        if (t == j) break;
+                    }
+                    for (int t = i;; t = (t - step + k) % k) {
+                        push_path(arena, cert->three, cycle[(size_t)(t)]);
+                        if (t == j) break;
+                    }
+                }
+            }
+            retval.op_reason = cert;
+        } else {
+            std::shared_ptr<positive_cert_op> op = make_arena_shared<positive_cert_op>(ctx.arena);
+            if constexpr (Policy::paths) {
+                // the blocks are what the series at the top of the tree hold
+                std::vector<std::pair<uint32_t, bool>>& blocks = ctx.red_blocks;
+                blocks.clear();
+                walk.assign(1, {root.tree, 0});
+                while (!walk.empty()) {
+                    auto [y, f] = walk.back();
+                    walk.pop_back();
+                    if (nodes.comp(y) == c_type::series) {
+                        walk.emplace_back(nodes.right[y], f);
+                        walk.emplace_back(nodes.left[y], f);
+                    } else {
+                        blocks.emplace_back(y, f);
+                    }
+                }
+
+                outer_embedding& emb = op->embedding;
+                sp_arena& arena = *ctx.arena;
+                auto alloc = [&](size_t count) {return std::span<int>{(int *)(arena.allocate(count * sizeof(int), alignof(int))), count};};
+                int n_blocks = (int)(blocks.size());
+                emb.cycle_offsets = alloc((size_t)(n_blocks) + 1);
+                emb.cycles = alloc((size_t)(g.n) + n_blocks - 1);
+                emb.rotation = alloc(2 * (size_t)(g.e));
+                std::vector<int>& next_slot = ctx.next_slot;
+                std::vector<int>& start = ctx.rotation_start;
+                std::vector<int>& pos = ctx.cycle_pos;
+                std::vector<edge_t>& block_edges = ctx.block_edges;
+                std::vector<int>& bucket = ctx.red_bucket;
+                std::vector<std::pair<int, int>>& halves = ctx.red_halves;
+                std::vector<int>& cycle = ctx.red_path;
+                int * rotation = emb.rotation.data();
+                for (int v = 0; v < g.n; v++) next_slot[v] = g.adjLists.offsets[v];
+
+                int written = 0;
+                for (int b = 0; b < n_blocks; b++) {
+                    auto [x, flip] = blocks[(size_t)(b)];
+                    cycle.assign(1, source_of(x, flip));
+                    if (nodes.is_edge(x)) {
+                        cycle.push_back(flip ? nodes.source[x] : nodes.sink[x]);
+                    } else {
+                        // along the first branch, and back along the second if there is one
+                        branches_of(x, flip, 2);
+                        walk_path(branches[0].first, branches[0].second, cycle);
+                        if (branches.size() > 1) {
+                            size_t mid = cycle.size();
+                            walk_path(branches[1].first, branches[1].second, cycle);
+                            cycle.pop_back();
+                            std::reverse(cycle.begin() + (long)(mid), cycle.end());
+                        }
+                    }
+                    int k = (int)(cycle.size());
+                    emb.cycle_offsets[b] = written;
+                    std::copy(cycle.begin(), cycle.end(), emb.cycles.begin() + written);
+                    written += k;
+                    for (int i = 0; i < k; i++) {
+                        pos[cycle[(size_t)(i)]] = i;
+                        start[cycle[(size_t)(i)]] = next_slot[cycle[(size_t)(i)]];
+                    }
+
+                    // each vertex collects its neighbours in the block in cycle order (a counting
+                    // sort of the half-edges by the position of the neighbour), then starts them
+                    // after itself
+                    block_edges.clear();
+                    walk.assign(1, {x, 0});
+                    while (!walk.empty()) {
+                        uint32_t y = walk.back().first;
+                        walk.pop_back();
+                        if (nodes.is_edge(y)) {
+                            block_edges.emplace_back(nodes.source[y], nodes.sink[y]);
+                        } else {
+                            walk.emplace_back(nodes.left[y], 0);
+                            walk.emplace_back(nodes.right[y], 0);
+                        }
+                    }
+                    bucket.assign((size_t)(k) + 1, 0);
+                    for (auto [u, v] : block_edges) {
+                        bucket[(size_t)(pos[u]) + 1]++;
+                        bucket[(size_t)(pos[v]) + 1]++;
+                    }
+                    for (int i = 0; i < k; i++) bucket[(size_t)(i) + 1] += bucket[(size_t)(i)];
+                    halves.resize(2 * block_edges.size());
+                    for (auto [u, v] : block_edges) {
+                        halves[(size_t)(bucket[(size_t)(pos[v])]++)] = {u, v};
+                        halves[(size_t)(bucket[(size_t)(pos[u])]++)] = {v, u};
+                    }
+                    for (auto [u, v] : halves) rotation[next_slot[u]++] = v;
+                    for (int i = 0; i < k; i++) {
+                        int v = cycle[(size_t)(i)];
+                        int * first = rotation + start[v];
+                        int * end = rotation + next_slot[v];
+                        int * after = first;
+                        while (after != end && pos[*after] < i) after++;
+                        std::rotate(first, after, end);
+                    }
+                }
+                emb.cycle_offsets[n_blocks] = written;
+            }
+            retval.op_reason = op;
+        }
+
+        std::shared_ptr<positive_cert_sp> sp = make_arena_shared<positive_cert_sp>(ctx.arena);
+        if constexpr (Policy::paths) {
+            sp->decomposition = extract_decomposition(nodes, root.tree, [&](size_t bytes, size_t align) {return ctx.arena->allocate(bytes, align);}, ctx.tree_walk);
+        }
+        sp->is_sp = true;
+        retval.reason = sp;
+        retval.gsp_reason = sp;
+    }
+    retval.is_sp = true;
+    retval.is_gsp = true;
+    retval.is_op = !nonop;
+    N_LOG("graph is SP" << (nonop ? "" : " and outerplanar") << " (reductions)\n")
+    return true;
+}
+
+// ==================== PRE-FILTER ====================
+// The first vertex x to finish in a DFS of the 3-core is a leaf, so its core neighbours, at least
+// three, all lie on the tree path to it; let a and b be the two nearest the root. The tree path
+// from a to x, closed by the edge xa, is a cycle with the chord xb, and an edge from a vertex z
+// strictly between b and x to a vertex w above b crosses it: the K4 has the branch vertices b, z,
+// x and w if it lies between a and b, a otherwise. Returns whether some z has such an edge;
+// retval then holds the K4.
+template <typename Policy>
+bool prefilter_leaf_K4(graph const& g, basic_recognizer_context<typename Policy::tree>& ctx, int x, sp_result& retval) {
+    std::vector<int> const& degree = ctx.core_degree;
+    std::vector<int> const& dfs_no = ctx.core_dfs_no;
+    std::vector<int> const& path = ctx.core_visited; // the vertex of DFS number k is path[k - 1]
+    int a = INT_MAX, b = INT_MAX; // DFS numbers
+    for (int u : g.adjLists[x]) {
+        if (degree[u] < 3) continue;
+        if (dfs_no[u] < a) {
+            b = a;
+            a = dfs_no[u];
+        } else if (dfs_no[u] < b) {
+            b = dfs_no[u];
+        }
+    }
+
+    for (int k = b + 1; k < dfs_no[x]; k++) {
+        int z = path[(size_t)(k) - 1];
+        for (int u : g.adjLists[z]) {
+            int w = dfs_no[u];
+            if (w == 0 || w >= b) continue; // off the path, or below b
+
+            int top = std::max(w, a);
+            std::shared_ptr<negative_cert_K4> k4 = make_arena_shared<negative_cert_K4>(ctx.arena);
+            k4->a = path[(size_t)(top) - 1];
+            k4->b = path[(size_t)(b) - 1];
+            k4->c = z;
+            k4->d = x;
+            if constexpr (Policy::paths) {
+                // the tree path from DFS number lo down to hi
+                sp_arena& arena = *ctx.arena;
+                auto down = [&](std::span<int>& out, int lo, int hi) {
+                    for (int i = lo; i <= hi; i++) push_path(arena, out, path[(size_t)(i) - 1]);
+                };
+                down(k4->ab, top, b);
+                push_path(arena, k4->ac, z);
+                down(k4->ac, w, top);
+                push_path(arena, k4->ad, x);
+                down(k4->ad, a, top);
+                down(k4->bc, b, k);
+                extend_path(arena, k4->bd, k4->b, x);
+                down(k4->cd, k, dfs_no[x]);
+            }
+            retval.reason = retval.gsp_reason = retval.op_reason = k4;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Cheap necessary conditions, checked before the bicomps with --prefilter. A simple graph
+// without a K4 subdivision has at most 2n - 3 edges and a vertex of degree at most 2 in every
+// subgraph, so a graph with more edges, or with a non-empty 3-core (what is left after
+// repeatedly removing the vertices of degree below 3), is neither SP, GSP nor outerplanar. Both
+// bounds count parallel edges, so a graph with a loop or a parallel edge, found in one pass over
+// the rows, is left to the run. The core is peeled in O(n + m), and under the boolean policy the
+// edge bound alone rejects. The K4 comes from a leaf block of the core, closed first by a DFS of
+// the core: its vertices but the cut vertex keep their core degree of at least 3 in it, so the
+// 2-connected block is not SP, and recognize_bicomp, bounded by the block, ends with a K4 in the
+// vertices of g. Mostly the K4 is read off the tree path to the first leaf of that DFS by
+// prefilter_leaf_K4 before the block closes, so a dense graph, which peels to the whole graph,
+// costs the filter little more than the path. Returns whether the graph was rejected; retval
+// then holds the verdicts and the K4.
+template <typename Policy>
+bool prefilter_reject(graph const& g, basic_recognizer_context<typename Policy::tree>& ctx, sp_result& retval) {
+    size_t cap = (size_t)(ctx.capacity);
+    if (ctx.core_degree.size() < cap) {
+        ctx.core_degree.resize(cap);
+        ctx.core_queue.resize(cap);
+        ctx.core_dfs_no.resize(cap, 0);
+        ctx.core_low.resize(cap);
+        ctx.core_parent.resize(cap);
+        ctx.core_seen.resize(cap);
+        ctx.core_owner.resize(cap, -1);
+        ctx.core_visited.reserve(cap);
+        ctx.core_stack.reserve(cap);
+        ctx.core_frames.reserve(cap);
+        ctx.core_block.reserve(cap + 1);
+    }
+    std::vector<int>& degree = ctx.core_degree;
+    ctx.prefiltered.graphs++;
+
+    std::vector<int>& seen = ctx.core_seen;
+    std::fill(seen.begin(), seen.begin() + g.n, -1);
+    for (int v = 0; v < g.n; v++) {
+        for (int u : g.adjLists[v]) {
+            if (u == v || seen[u] == v) return false;
+            seen[u] = v;
+        }
+    }
 
-    std::vector<std::stack<sp_chain_stack_entry>> vertex_stacks((size_t)(g.n));
-    std::vector<int> dfs_no((size_t)(g.n + 1), 0);
-    std::vector<int> parent((size_t)(g.n), 0);
+    bool dense = (g.n >= 2 && (long long)(g.e) > 2 * (long long)(g.n) - 3);
+    int root = -1;
+    if (Policy::certificate || !dense) {
+        std::vector<int>& queue = ctx.core_queue;
+        int queued = 0;
+        for (int v = 0; v < g.n; v++) {
+            degree[v] = g.degree(v);
+            if (degree[v] < 3) queue[queued++] = v;
+        }
+        for (int i = 0; i < queued; i++) {
+            for (int u : g.adjLists[queue[i]]) {
+                if (degree[u] >= 3 && --degree[u] == 2) queue[queued++] = u;
+            }
+        }
+        if (queued == g.n) return false;
+        for (root = 0; degree[root] < 3; root++);
+    }
+    if constexpr (Policy::certificate) {
+        // Tarjan's DFS over the core until the first block closes
+        std::vector<int>& dfs_no = ctx.core_dfs_no;
+        std::vector<int>& low = ctx.core_low;
+        std::vector<int>& parent = ctx.core_parent;
+        std::vector<int>& visited = ctx.core_visited;
+        std::vector<int>& stack = ctx.core_stack;
+        std::vector<std::pair<int, int>>& frames = ctx.core_frames;
+        std::vector<int>& block = ctx.core_block;
+        visited.clear();
+        stack.clear();
+        frames.clear();
+        block.clear();
+        dfs_no[root] = low[root] = 1;
+        parent[root] = -1;
+        visited.push_back(root);
+        frames.emplace_back(root, 0);
+        bool found = false; // by prefilter_leaf_K4
+        for (bool leaf = false; block.empty();) {
+            auto& [w, i] = frames.back();
+            if (i < g.degree(w)) {
+                int u = g.adjLists[w][i++];
+                if (degree[u] < 3) continue;
+                if (dfs_no[u] == 0) {
+                    parent[u] = w;
+                    visited.push_back(u);
+                    dfs_no[u] = low[u] = (int)(visited.size());
+                    stack.push_back(u);
+                    frames.emplace_back(u, 0);
+                } else if (u != parent[w]) {
+                    low[w] = std::min(low[w], dfs_no[u]);
+                }
+                continue;
+            }
 
-    std::vector<edge_t> ear((size_t)(g.n), edge_t{g.n, g.n});
-    std::vector<sp_tree> seq((size_t)(g.n));
-    std::vector<int> earliest_outgoing((size_t)(g.n), g.n);
+            if (!leaf) {
+                leaf = true;
+                if ((found = prefilter_leaf_K4<Policy>(g, ctx, w, retval))) break;
+            }
+            int x = w;
+            frames.pop_back();
+            int p = parent[x];
+            low[p] = std::min(low[p], low[x]);
+            if (low[x] < dfs_no[p]) continue;
+            block.push_back(p);
+            do {
+                block.push_back(stack.back());
+                stack.pop_back();
+            } while (block.back() != x);
+        }
+        for (int v : visited) dfs_no[v] = 0;
+
+        // the block is recognized in place from its cut vertex and the child the DFS closed it
+        // at, as bicomp 0 of the labels in owner
+        if (!found) {
+            std::vector<int>& owner = ctx.core_owner;
+            for (int v : block) owner[v] = 0;
+            sp_result inner{};
+            bool nonop = false;
+            ctx.touched.push_back(block.front());
+            ctx.touched.push_back(block.back());
+            recognize_bicomp<Policy>(g, ctx, ctx.cut_verts, ctx.cut_vertex_attached_tree, 0, block.front(), block.back(), true, nonop, inner, &owner);
+            for (int v : ctx.touched) ctx.reset_recognition(v);
+            ctx.touched.clear();
+            for (int v : block) owner[v] = -1;
+            if (!std::dynamic_pointer_cast<negative_cert_K4>(inner.gsp_reason)) return false;
+            retval.reason = retval.gsp_reason = retval.op_reason = inner.gsp_reason;
+        }
+    }
+    (dense ? ctx.prefiltered.edge_bound : ctx.prefiltered.core)++;
+    N_LOG("NON-SP, " << (dense ? "more than 2n - 3 edges" : "the 3-core is not empty") << " (pre-filter)\n")
+    retval.is_sp = retval.is_gsp = retval.is_op = false;
+    return true;
+}
 
-    std::vector<char> num_children((size_t)(g.n), 0);
-    std::vector<int> alert((size_t)(g.n), -1);
+// With workers, the bicomps of the chain are recognized on their pool and then stitched
+// together in chain order, giving the same result, certificates included, as a run without;
+// the blockwise phase of a graph that is not SP always runs here. The bicomps of the parallel
+// engine come from another spanning tree, so the verdicts are those of a run without, but the
+// certificates may differ. So are those of the ear engine, which finds the bicomps in parallel
+// and hands back a graph of one bicomp it cannot decide, and those of the reduction engine,
+// which hands back a graph it cannot reduce before any bicomps are found.
+template <typename Policy = full_certificate>
+sp_result SP_RECOGNITION(graph const& g, basic_recognizer_context<typename Policy::tree>& ctx, block_workers<typename Policy::tree> * workers = nullptr) {
+    using tree = typename Policy::tree;
+    sp_result retval{};
+    bool rejected = false; // not SP
+    bool nonop = false; // a K23 was found
+    bool via_t4 = false; // SP was refuted by a K4 through a virtual edge
+
+    [[maybe_unused]] bool grew = ctx.prepare(g.n);
+    A_COUNT(size_t pool_capacity = ctx.pool_capacity();)
+    A_COUNT(auto count_steady = [&] {
+        if (grew || ctx.pool_capacity() != pool_capacity) ctx.grown = true;
+    };)
+    sp_arena& arena = *ctx.arena;
+    sp_node_pool& nodes = ctx.nodes;
+    if ((ctx.prefilter && prefilter_reject<Policy>(g, ctx, retval))
+        || (ctx.reductions && recognize_by_reductions<Policy>(g, ctx, retval))) {
+        A_COUNT(count_steady();)
+        return retval;
+    }
 
-    std::stack<std::pair<int, int>> dfs;
+    std::vector<int>& cut_verts = ctx.cut_verts;
+    bool by_ears = (workers && workers->block_engine == recognition_engine::ears);
+    bool parallel = (workers && (workers->engine == bicomp_engine::parallel || by_ears));
+    std::vector<edge_t>& bicomps = (parallel ? get_bicomps_parallel<Policy>(g, ctx, workers->pool, retval, rejected)
+                                             : get_bicomps<Policy>(g, ctx, retval, rejected));
+    int n_bicomps = (int)(bicomps.size());
+    std::vector<tree>& cut_vertex_attached_tree = ctx.cut_vertex_attached_tree;
+    std::vector<tree>& seq = ctx.seq;
 
-    dfs_no[g.n] = g.n;
+    if (by_ears && !rejected && n_bicomps == 1 && recognize_block_by_ears<Policy>(g, ctx, workers->pool, retval)) {
+        workers->runs.clear();
+        A_COUNT(count_steady();)
+        return retval;
+    }
 
-    bool do_k23_edge_replacement = true;
+    // Until the graph is known not to be SP, the bicomps are recognized as one chain, closed by
+    // virtual edges where needed. After that, each bicomp is recognized on its own, in DFS
+    // order, and its tree dangles from the cut vertex it hangs off, which decides GSP. K23s
+    // only decide outerplanarity and never stop either phase.
+    bool blockwise = rejected;
+    bool pooled = (workers && !blockwise && n_bicomps > 1);
+    if (pooled) recognize_chain_on_pool<Policy>(g, ctx, *workers);
 
     for (int bicomp = 0; bicomp < n_bicomps; bicomp++) {
-        N_LOG("BICOMP " << bicomp << "\n")
+        N_LOG("BICOMP " << bicomp << (blockwise ? " (blockwise)" : "") << "\n")
 
         int root = bicomps[bicomp].first;
-        int next;
-        if (!retval.reason && bicomp > 0 && bicomp < n_bicomps - 1) {
-            next = bicomps[bicomp - 1].first;
+        int next = bicomp_next(bicomps, bicomp, blockwise);
+        bicomp_outcome outcome;
+        if (pooled) {
+            typename block_workers<tree>::run& run = workers->runs[(size_t)(bicomp)];
+            if (!nonop && run.nonop) {
+                nonop = true;
+                retval.op_reason = std::move(run.result.op_reason);
+            }
+            if (run.outcome.found) retval.reason = std::move(run.result.reason);
+            outcome = run.outcome;
+        } else {
+            outcome = recognize_bicomp<Policy>(g, ctx, cut_verts, cut_vertex_attached_tree, bicomp, root, next, blockwise, nonop, retval);
+        }
+
+        if (outcome.k4_subgraph) {
+            N_LOG("graph is not GSP\n")
+            // a K4 also refutes SP; it replaces the T4, whose translation assumes that the
+            // virtual edge was a whole path of the K4
+            if (!blockwise) retval.gsp_reason = retval.reason;
+            else if (via_t4) retval.reason = retval.gsp_reason;
+            if (!nonop) retval.op_reason = retval.gsp_reason;
+            break;
+        }
+
+        if (outcome.found) {
+            // K23s found next to a K4 may rely on the virtual edge, so outerplanarity is
+            // decided again on the bicomps alone
+            N_LOG("graph is not SP, recognizing the bicomps one at a time\n")
+            rejected = blockwise = via_t4 = true;
+            nonop = false;
+            retval.op_reason = nullptr;
+            ctx.restart_recognition();
+            pooled = false;
+            bicomp = -1;
+            continue;
+        }
+
+        if (pooled) {
+            typename block_workers<tree>::run& run = workers->runs[(size_t)(bicomp)];
+            seq[next] = import_tree(std::move(run.seq), workers->ctx[(size_t)(run.worker)].nodes, nodes, ctx.tree_walk, ctx.imported);
+        }
+        if (cut_verts[next] != -1) {
+            seq[next].compose(std::move(cut_vertex_attached_tree[cut_verts[next]]), c_type::series, nodes);
+        }
+
+        if (cut_verts[root] != -1) {
+            #ifdef __VERBOSE_LOGGING__
+            if (!cut_vertex_attached_tree[cut_verts[root]].empty()) {
+                V_LOG("combine tree " << show(nodes, cut_vertex_attached_tree[cut_verts[root]]) << " with " << show(nodes, seq[next]) << " (bicomp " << bicomp << ")\n");
+            }
+            #endif
+
+            seq[next].compose(std::move(cut_vertex_attached_tree[cut_verts[root]]), c_type::dangling, nodes);
+        }
+
+        if (bicomp < n_bicomps - 1) {
+            V_LOG("ATTACH " << show(nodes, seq[next]) << " to cut vertex " << root << " (bicomp " << bicomp << ")\n");
+            cut_vertex_attached_tree[cut_verts[root]] = std::move(seq[next]);
         } else {
-            next = bicomps[bicomp].second;
+            if constexpr (Policy::certificate) {
+                std::shared_ptr<positive_cert_sp> sp = make_arena_shared<positive_cert_sp>(ctx.arena);
+                if constexpr (Policy::paths) {
+                    sp->decomposition = extract_decomposition(nodes, seq[next].root, [&](size_t bytes, size_t align) {return arena.allocate(bytes, align);}, ctx.tree_walk);
+                }
+                sp->is_sp = !rejected;
+                if (!rejected) retval.reason = sp;
+                retval.gsp_reason = sp;
+                if (!nonop) {
+                    std::shared_ptr<positive_cert_op> op = make_arena_shared<positive_cert_op>(ctx.arena);
+                    if constexpr (Policy::paths) {
+                        // every block of a graph found outerplanar reduces, so an embedding
+                        // that does not come out is a bug; it is never published as a verdict
+                        // without a certificate, and an incomplete one fails authentication
+                        bool embedded = outer_embedding_of(g, ctx, arena, op->embedding);
+                        assert(embedded && "outerplanar graph without an outer embedding");
+                        (void)(embedded);
+                    }
+                    retval.op_reason = op;
+                }
+            }
+            seq[next] = tree{};
+            retval.is_sp = !rejected;
+            retval.is_gsp = true;
+            retval.is_op = !nonop;
+            N_LOG("graph is " << (rejected ? "GSP" : "SP") << (nonop ? "" : " and outerplanar") << "\n")
+        }
+    }
+
+    if (workers) workers->runs.clear();
+
+    A_COUNT(count_steady();)
+
+    #ifdef __VERBOSE_LOGGING__
+        for (int i = 0; i < g.n; i++) {
+            V_LOG("vertex " << i << " ear: (" << ctx.ear[i].first << ", " << ctx.ear[i].second << ")\n")
+            V_LOG("vertex " << i << " parent: " << ctx.parent[i] << "\n")
+            V_LOG("vertex " << i << " dfs_no: " << ctx.dfs_no[i] << "\n")
+        }
+    #endif
+
+    return retval;
+}
+
+// Recognizes g in a context of its own. With prefilter, the pre-filter runs first and its
+// counts are added to *prefilter.
+template <typename Policy = full_certificate>
+sp_result SP_RECOGNITION(graph const& g, work_stealing_pool * pool = nullptr, bicomp_engine engine = bicomp_engine::dfs,
+                         recognition_engine block_engine = recognition_engine::dfs, prefilter_counts * prefilter = nullptr) {
+    basic_recognizer_context<typename Policy::tree> ctx;
+    ctx.prefilter = (prefilter != nullptr);
+    ctx.reductions = (block_engine == recognition_engine::reduction);
+    sp_result result;
+    if (!pool) {
+        result = SP_RECOGNITION<Policy>(g, ctx);
+    } else {
+        block_workers<typename Policy::tree> workers{*pool};
+        workers.engine = engine;
+        workers.block_engine = block_engine;
+        result = SP_RECOGNITION<Policy>(g, ctx, &workers);
+    }
+    if (prefilter) *prefilter += ctx.prefiltered;
+    return result;
+}
+
+// ==================== RESULT CONVERSION ====================
+// What merge_component_results and convert_result keep from one graph to the next: the arenas
+// of the certificates they make and the scratch of the conversions, so that a warm worker
+// merges, renames and lifts results without allocating.
+struct result_buffers {
+    arena_pool arenas;
+    std::vector<std::pair<certificate const *, std::shared_ptr<certificate>>> converted; // empty between calls
+    std::vector<int> count, first, next, edges, path, offsets, cycles; // lift_bundles and lift_certificate scratch
+    std::vector<uint32_t> leaves, placed;
+
+    size_t capacity() const {
+        return arenas.capacity() + converted.capacity() + count.capacity() + first.capacity() + next.capacity()
+             + edges.capacity() + path.capacity() + offsets.capacity() + cycles.capacity() + leaves.capacity()
+             + placed.capacity();
+    }
+};
+
+// ==================== DISCONNECTED GRAPHS ====================
+// A graph that is not connected, or has no edge, is recognized component by component
+// (split_components), each component with an edge as a graph of its own, and their results
+// merged. An SP graph is connected, so only a single vertex is SP among these graphs; the others
+// are refuted by the certificate of a component that is not SP, or by two vertices of different
+// components. A graph is GSP or outerplanar when every component with an edge is; isolated
+// vertices are in both. A class one of them is not in takes the certificate of the first such
+// component, renamed to the vertices of the graph, and a class they are all in takes their SP
+// trees as a GSP forest, or their outer cycles and rotations side by side.
+
+// One certificate of h, a graph whose vertex k is vertex names[k] of g, its row listing the
+// same neighbours, in the vertices of g: every vertex of a path or SP tree is renamed, and the
+// rotation of an outer embedding moves from the row of a vertex in h to its row in g.
+std::shared_ptr<certificate> rename_certificate(std::span<int const> names, graph const& h, graph const& g, certificate const& cert, std::shared_ptr<sp_arena> const& arena) {
+    auto name = [&](int k) {return (k >= 0 && k < (int)(names.size()) ? names[(size_t)(k)] : k);};
+    auto rename_path = [&](std::span<int const> path) {
+        std::span<int> out = arena_path(*arena, path);
+        for (int& v : out) v = name(v);
+        return out;
+    };
+    if (auto k4 = dynamic_cast<negative_cert_K4 const *>(&cert)) {
+        auto out = make_arena_shared<negative_cert_K4>(arena);
+        out->a = name(k4->a);
+        out->b = name(k4->b);
+        out->c = name(k4->c);
+        out->d = name(k4->d);
+        out->ab = rename_path(k4->ab);
+        out->ac = rename_path(k4->ac);
+        out->ad = rename_path(k4->ad);
+        out->bc = rename_path(k4->bc);
+        out->bd = rename_path(k4->bd);
+        out->cd = rename_path(k4->cd);
+        return out;
+    }
+    if (auto k23 = dynamic_cast<negative_cert_K23 const *>(&cert)) {
+        auto out = make_arena_shared<negative_cert_K23>(arena);
+        out->a = name(k23->a);
+        out->b = name(k23->b);
+        out->one = rename_path(k23->one);
+        out->two = rename_path(k23->two);
+        out->three = rename_path(k23->three);
+        return out;
+    }
+    if (auto t4 = dynamic_cast<negative_cert_T4 const *>(&cert)) {
+        auto out = make_arena_shared<negative_cert_T4>(arena);
+        out->c1 = name(t4->c1);
+        out->c2 = name(t4->c2);
+        out->a = name(t4->a);
+        out->b = name(t4->b);
+        out->c1a = rename_path(t4->c1a);
+        out->c1b = rename_path(t4->c1b);
+        out->c2a = rename_path(t4->c2a);
+        out->c2b = rename_path(t4->c2b);
+        out->ab = rename_path(t4->ab);
+        return out;
+    }
+    if (auto tri = dynamic_cast<negative_cert_tri_comp_cut const *>(&cert)) {
+        auto out = make_arena_shared<negative_cert_tri_comp_cut>(arena);
+        out->v = name(tri->v);
+        return out;
+    }
+    if (auto tric = dynamic_cast<negative_cert_tri_cut_comp const *>(&cert)) {
+        auto out = make_arena_shared<negative_cert_tri_cut_comp>(arena);
+        out->c1 = name(tric->c1);
+        out->c2 = name(tric->c2);
+        out->c3 = name(tric->c3);
+        return out;
+    }
+    if (auto disc = dynamic_cast<negative_cert_disconnected const *>(&cert)) {
+        auto out = make_arena_shared<negative_cert_disconnected>(arena);
+        out->u = name(disc->u);
+        out->v = name(disc->v);
+        return out;
+    }
+
+    // the tree keeps its shape, so only the terminals are renamed
+    if (auto sp = dynamic_cast<positive_cert_sp const *>(&cert)) {
+        auto out = make_arena_shared<positive_cert_sp>(arena);
+        out->is_sp = sp->is_sp;
+        sp_decomposition_view const& d = sp->decomposition;
+        if (d.empty()) return out;
+
+        sp_decomposition l;
+        auto copy = [&]<typename T>(std::span<T const> from) {
+            std::span<T> to{(T *)(arena->allocate(from.size() * sizeof(T), alignof(T))), from.size()};
+            std::copy(from.begin(), from.end(), to.begin());
+            return to;
+        };
+        l.size = d.size;
+        l.source = copy(d.source);
+        l.sink = copy(d.sink);
+        l.left = copy(d.left);
+        l.right = copy(d.right);
+        l.comp_bits = copy(d.comp_bits);
+        for (uint32_t i = 0; i < l.size; i++) {
+            l.source[i] = name(l.source[i]);
+            l.sink[i] = name(l.sink[i]);
+        }
+        out->decomposition = l;
+        return out;
+    }
+
+    if (auto op = dynamic_cast<positive_cert_op const *>(&cert)) {
+        auto out = make_arena_shared<positive_cert_op>(arena);
+        outer_embedding const& e = op->embedding;
+        outer_embedding& l = out->embedding;
+        auto alloc = [&](size_t count) {return std::span<int>{(int *)(arena->allocate(count * sizeof(int), alignof(int))), count};};
+        if (e.blocks() > 0) {
+            l.cycle_offsets = alloc(e.cycle_offsets.size());
+            std::copy(e.cycle_offsets.begin(), e.cycle_offsets.end(), l.cycle_offsets.begin());
+            l.cycles = alloc(e.cycles.size());
+            for (size_t i = 0; i < e.cycles.size(); i++) l.cycles[i] = name(e.cycles[i]);
+        }
+        if (!e.rotation.empty()) {
+            l.rotation = alloc(2 * (size_t)(g.e));
+            for (int k = 0; k < h.n; k++) {
+                int at = g.adjLists.offsets[names[(size_t)(k)]];
+                for (int i = h.adjLists.offsets[k]; i < h.adjLists.offsets[k + 1]; i++) l.rotation[(size_t)(at++)] = name(e.rotation[(size_t)(i)]);
+            }
+        }
+        return out;
+    }
+    return nullptr;
+}
+
+// The result of g from the results of its components with an edge, results[i] being that of
+// component parts[i] of split; with_certificates is false under the boolean policy, whose
+// results have none.
+sp_result merge_component_results(graph const& g, graph_components const& split, std::vector<int> const& parts,
+                                  std::vector<sp_result> const& results, bool with_certificates, result_buffers& buffers) {
+    // a single vertex is the one connected graph without an edge
+    bool connected = (g.n <= 1);
+    sp_result out;
+    out.is_sp = out.is_gsp = out.is_op = true;
+    for (sp_result const& r : results) {
+        out.is_sp = out.is_sp && r.is_sp;
+        out.is_gsp = out.is_gsp && r.is_gsp;
+        out.is_op = out.is_op && r.is_op;
+    }
+    bool components_sp = out.is_sp;
+    out.is_sp = out.is_sp && connected;
+    if (!with_certificates) return out;
+
+    bool grew = false;
+    std::shared_ptr<sp_arena> arena = buffers.arenas.acquire(grew);
+    auto alloc = [&](size_t bytes, size_t align) {return arena->allocate(bytes, align);};
+    auto ints = [&](size_t count) {return std::span<int>{(int *)(alloc(count * sizeof(int), alignof(int))), count};};
+
+    // the certificate of the first component not in a class; one that refutes several classes
+    // is renamed once and stays shared
+    std::vector<std::pair<certificate const *, std::shared_ptr<certificate>>>& renamed = buffers.converted;
+    auto refute = [&](bool sp_result::* member, std::shared_ptr<certificate> sp_result::* reason) -> std::shared_ptr<certificate> {
+        size_t i = 0;
+        while (results[i].*member) i++;
+        certificate const * cert = (results[i].*reason).get();
+        if (!cert) return nullptr;
+        for (auto const& [from, to] : renamed) {
+            if (from == cert) return to;
+        }
+        int c = parts[i];
+        renamed.emplace_back(cert, rename_certificate(split.vertices_of(c), split.parts[c], g, *cert, arena));
+        return renamed.back().second;
+    };
+
+    // the trees of the components one after the other, the children of each node moved along
+    // with it
+    auto forest = [&](std::shared_ptr<certificate> sp_result::* reason, bool is_sp) -> std::shared_ptr<certificate> {
+        uint32_t n = 0;
+        for (sp_result const& r : results) {
+            auto sp = dynamic_cast<positive_cert_sp const *>((r.*reason).get());
+            if (!sp) return nullptr;
+            n += sp->decomposition.size;
+        }
+        std::shared_ptr<positive_cert_sp> cert = make_arena_shared<positive_cert_sp>(arena);
+        cert->is_sp = is_sp;
+        sp_decomposition f;
+        f.size = n;
+        f.source = ints(n);
+        f.sink = ints(n);
+        f.left = {(uint32_t *)(alloc(n * sizeof(uint32_t), alignof(uint32_t))), n};
+        f.right = {(uint32_t *)(alloc(n * sizeof(uint32_t), alignof(uint32_t))), n};
+        f.comp_bits = {(uint8_t *)(alloc((n + 3) / 4, 1)), (n + 3) / 4};
+        std::fill(f.comp_bits.begin(), f.comp_bits.end(), 0);
+        uint32_t at = 0;
+        for (size_t i = 0; i < results.size(); i++) {
+            sp_decomposition_view const& d = static_cast<positive_cert_sp const&>(*(results[i].*reason)).decomposition;
+            std::span<int const> names = split.vertices_of(parts[i]);
+            for (uint32_t j = 0; j < d.size; j++, at++) {
+                f.source[at] = names[(size_t)(d.source[j])];
+                f.sink[at] = names[(size_t)(d.sink[j])];
+                f.left[at] = f.right[at] = sp_no_node;
+                if (d.is_edge(j)) continue;
+                f.left[at] = d.left[j] + (at - j);
+                f.right[at] = d.right[j] + (at - j);
+                pack_comp(f.comp_bits.data(), at, d.comp(j));
+            }
+        }
+        cert->decomposition = f;
+        return cert;
+    };
+
+    // the outer cycles of the components one after the other, and the rotation of every vertex
+    // in its row of g; none without the embeddings of every component
+    auto embedding = [&]() -> std::shared_ptr<certificate> {
+        size_t blocks = 0;
+        size_t cycles = 0;
+        bool rotations = true;
+        for (sp_result const& r : results) {
+            auto op = dynamic_cast<positive_cert_op const *>(r.op_reason.get());
+            if (!op) return nullptr;
+            blocks += (size_t)(op->embedding.blocks());
+            cycles += op->embedding.cycles.size();
+            rotations = rotations && !op->embedding.rotation.empty();
+        }
+        std::shared_ptr<positive_cert_op> cert = make_arena_shared<positive_cert_op>(arena);
+        outer_embedding& e = cert->embedding;
+        if (blocks > 0) {
+            e.cycle_offsets = ints(blocks + 1);
+            e.cycles = ints(cycles);
+        }
+        if (rotations) e.rotation = ints(2 * (size_t)(g.e));
+        int b = 0;
+        int written = 0;
+        for (size_t i = 0; i < results.size(); i++) {
+            outer_embedding const& part = static_cast<positive_cert_op const&>(*results[i].op_reason).embedding;
+            graph const& h = split.parts[parts[i]];
+            std::span<int const> names = split.vertices_of(parts[i]);
+            for (int k = 0; k < part.blocks(); k++) {
+                e.cycle_offsets[b++] = written;
+                for (int v : part.cycle(k)) e.cycles[written++] = names[(size_t)(v)];
+            }
+            if (!rotations) continue;
+            for (int k = 0; k < h.n; k++) {
+                int at = g.adjLists.offsets[names[(size_t)(k)]];
+                for (int j = h.adjLists.offsets[k]; j < h.adjLists.offsets[k + 1]; j++) e.rotation[(size_t)(at++)] = names[(size_t)(part.rotation[(size_t)(j)])];
+            }
+        }
+        if (blocks > 0) e.cycle_offsets[b] = written;
+        return cert;
+    };
+
+    // two vertices of different components, when every component is SP
+    auto disconnected = [&]() -> std::shared_ptr<certificate> {
+        std::shared_ptr<negative_cert_disconnected> cert = make_arena_shared<negative_cert_disconnected>(arena);
+        cert->u = (split.parts.size() > 1 ? split.vertices_of(0)[0] : 0);
+        cert->v = (split.parts.size() > 1 ? split.vertices_of(1)[0] : 1);
+        return cert;
+    };
+
+    if (out.is_sp) out.reason = forest(&sp_result::reason, true);
+    else out.reason = (components_sp ? disconnected() : refute(&sp_result::is_sp, &sp_result::reason));
+    if (out.is_gsp) out.gsp_reason = (out.is_sp ? out.reason : forest(&sp_result::gsp_reason, false));
+    else out.gsp_reason = refute(&sp_result::is_gsp, &sp_result::gsp_reason);
+    out.op_reason = (out.is_op ? embedding() : refute(&sp_result::is_op, &sp_result::op_reason));
+    renamed.clear();
+    return out;
+}
+
+// ==================== DEGREE-2 PATH COMPRESSION ====================
+// A maximal path of degree-2 vertices between two other vertices, its ends, can be shortened to
+// one inner vertex (two when both ends are the same vertex, so the kernel stays simple) without
+// changing a verdict: SP and GSP do not see subdivisions, and a degree-2 vertex on the outer
+// face keeps both its edges there, so neither does outerplanarity while the path keeps an inner
+// vertex. With --compress-paths a connected graph is recognized through its kernel and the
+// result is lifted back: the last inner vertex kept on each path stands for the vertices dropped
+// after it, and the kernel edge from it to the end of the path expands into them. A graph that
+// is one cycle shrinks to a triangle. Building the kernel and lifting the result are O(n + m).
+struct path_kernel {
+    graph kernel;
+    std::vector<int> names; // the vertex of g each kernel vertex is
+    std::vector<int> tail_to; // the end of the path a kernel vertex stands for, -1 if none
+    std::vector<int> tail_start; // its dropped vertices, towards tail_to: dropped[tail_start[k] .. tail_start[k + 1])
+    std::vector<int> dropped;
+
+    // build_path_kernel scratch, by vertex of g and path by path, and the arrays of the kernel,
+    // which the next kernel built here reuses once no graph shares them
+    std::vector<char> role;
+    std::vector<int> end_of, tail_first, tail_length, order, run, id, endpoints;
+    csr_buffers csr;
+
+    size_t capacity() const {
+        return names.capacity() + tail_to.capacity() + tail_start.capacity() + dropped.capacity() + role.capacity()
+             + end_of.capacity() + tail_first.capacity() + tail_length.capacity() + order.capacity() + run.capacity()
+             + id.capacity() + endpoints.capacity() + csr.capacity();
+    }
+
+    bool has_tail(int k, int w) const {return tail_to[k] == w && tail_start[k] < tail_start[k + 1];}
+
+    // appends the vertices of g after u, up to and including w, on the kernel edge (u, w)
+    template <typename Out>
+    Out copy_edge(int u, int w, Out out) const {
+        if (has_tail(u, w)) {
+            out = std::copy(dropped.begin() + tail_start[u], dropped.begin() + tail_start[u + 1], out);
+        } else if (has_tail(w, u)) {
+            out = std::copy(dropped.rbegin() + (ptrdiff_t)(dropped.size()) - tail_start[w + 1],
+                            dropped.rbegin() + (ptrdiff_t)(dropped.size()) - tail_start[w], out);
+        }
+        *out++ = names[w];
+        return out;
+    }
+
+    void append_edge(int u, int w, std::vector<int>& out) const {copy_edge(u, w, std::back_inserter(out));}
+
+    // the number of edges of g the kernel edge (u, w) stands for
+    int edge_length(int u, int w) const {
+        if (has_tail(u, w)) return 1 + tail_start[u + 1] - tail_start[u];
+        if (has_tail(w, u)) return 1 + tail_start[w + 1] - tail_start[w];
+        return 1;
+    }
+
+    // the neighbour of u in g on the kernel edge (u, w)
+    int first_on_edge(int u, int w) const {
+        if (has_tail(u, w)) return dropped[(size_t)(tail_start[u])];
+        if (has_tail(w, u)) return dropped[(size_t)(tail_start[w + 1]) - 1];
+        return names[w];
+    }
+
+    // the path of g a kernel path stands for, in the arena
+    std::span<int> lift_path(std::span<int const> path, sp_arena& arena) const {
+        size_t length = (path.empty() ? 0 : 1);
+        for (size_t i = 1; i < path.size(); i++) length += (size_t)(edge_length(path[i - 1], path[i]));
+        std::span<int> out{(int *)(arena.allocate(length * sizeof(int), alignof(int))), length};
+        if (path.empty()) return out;
+        int * at = out.data();
+        *at++ = names[path[0]];
+        for (size_t i = 1; i < path.size(); i++) at = copy_edge(path[i - 1], path[i], at);
+        return out;
+    }
+};
+
+// Builds the kernel of a connected graph g; returns false when no vertex would be dropped.
+inline bool build_path_kernel(graph const& g, path_kernel& out, int threads) {
+    int n = g.n;
+    auto inner = [&](int v) {
+        if (g.degree(v) != 2) return false;
+        int a = g.adjLists[v][0];
+        int b = g.adjLists[v][1];
+        return a != b && a != v && b != v;
+    };
+    // a cycle has no end, so its vertex 0 is taken for one
+    int cycle_end = 0;
+    for (int v = 0; v < n && cycle_end != -1; v++) {
+        if (!inner(v)) cycle_end = -1;
+    }
+    auto is_end = [&](int v) {return v == cycle_end || !inner(v);};
+
+    enum : char {end_vertex, kept, dropped};
+    std::vector<char>& role = out.role;
+    std::vector<int>& tail_to = out.end_of;
+    std::vector<int>& tail_first = out.tail_first; // where the tail of a kept vertex starts in order
+    std::vector<int>& tail_length = out.tail_length;
+    std::vector<int>& order = out.order; // the dropped vertices, path by path
+    std::vector<int>& run = out.run;
+    role.assign((size_t)(n), end_vertex);
+    tail_to.assign((size_t)(n), -1);
+    tail_first.assign((size_t)(n), 0);
+    tail_length.assign((size_t)(n), 0);
+    order.clear();
+    for (int a = 0; a < n; a++) {
+        if (!is_end(a)) continue;
+        for (int u : g.adjLists[a]) {
+            if (is_end(u) || role[u] != end_vertex) continue;
+            run.clear();
+            int prev = a;
+            int cur = u;
+            while (!is_end(cur)) {
+                role[cur] = kept;
+                run.push_back(cur);
+                int next = (g.adjLists[cur][0] == prev ? g.adjLists[cur][1] : g.adjLists[cur][0]);
+                prev = cur;
+                cur = next;
+            }
+
+            size_t keep = (cur == a ? 2 : 1);
+            if (run.size() <= keep) continue;
+            tail_to[run[keep - 1]] = cur;
+            tail_first[run[keep - 1]] = (int)(order.size());
+            tail_length[run[keep - 1]] = (int)(run.size() - keep);
+            for (size_t i = keep; i < run.size(); i++) {
+                role[run[i]] = dropped;
+                order.push_back(run[i]);
+            }
+        }
+    }
+    if (order.empty()) return false;
+
+    std::vector<int>& id = out.id;
+    id.assign((size_t)(n), -1);
+    out.names.clear();
+    for (int v = 0; v < n; v++) {
+        if (role[v] == dropped) continue;
+        id[v] = (int)(out.names.size());
+        out.names.push_back(v);
+    }
+    int nk = (int)(out.names.size());
+    out.tail_to.assign((size_t)(nk), -1);
+    out.tail_start.assign((size_t)(nk) + 1, 0);
+    out.dropped.clear();
+    out.dropped.reserve(order.size());
+    std::vector<int>& endpoints = out.endpoints;
+    endpoints.clear();
+    endpoints.reserve((size_t)(nk) * 4);
+    for (int k = 0; k < nk; k++) {
+        int v = out.names[k];
+        out.tail_start[k] = (int)(out.dropped.size());
+        if (tail_to[v] != -1) {
+            out.tail_to[k] = id[tail_to[v]];
+            out.dropped.insert(out.dropped.end(), order.begin() + tail_first[v], order.begin() + tail_first[v] + tail_length[v]);
+        }
+
+        // every edge once: between kept vertices from the smaller id (a self-loop, which its
+        // row lists twice, once), and from the last kept vertex of a path to its end
+        bool halve = false;
+        for (int u : g.adjLists[v]) {
+            if (id[u] == -1) {
+                if (tail_to[v] != -1 && u == order[(size_t)(tail_first[v])]) {
+                    endpoints.push_back(k);
+                    endpoints.push_back(out.tail_to[k]);
+                }
+            } else if (id[u] > k || (u == v && (halve = !halve))) {
+                endpoints.push_back(k);
+                endpoints.push_back(id[u]);
+            }
+        }
+    }
+    out.tail_start[(size_t)(nk)] = (int)(out.dropped.size());
+
+    // the last kernel lets go of its arrays, which the buffers then reuse
+    out.kernel = graph{};
+    std::string error;
+    return build_graph(nk, (int)(endpoints.size() / 2), endpoints, out.kernel, error, threads, &out.csr);
+}
+
+// One certificate of the kernel in the vertices of g. An SP tree expands every edge leaf into a
+// series chain along its path, and an outer embedding every edge of a cycle into its path; a
+// bridge of the kernel becomes a path of bridges, each a block with a cycle of its own. Its
+// scratch is that of the buffers.
+std::shared_ptr<certificate> lift_certificate(path_kernel const& pk, graph const& g, certificate const& cert, std::shared_ptr<sp_arena> const& arena,
+                                              result_buffers& buffers) {
+    auto name = [&](int k) {return (k >= 0 && k < (int)(pk.names.size()) ? pk.names[(size_t)(k)] : k);};
+    if (auto k4 = dynamic_cast<negative_cert_K4 const *>(&cert)) {
+        auto out = make_arena_shared<negative_cert_K4>(arena);
+        out->a = name(k4->a);
+        out->b = name(k4->b);
+        out->c = name(k4->c);
+        out->d = name(k4->d);
+        out->ab = pk.lift_path(k4->ab, *arena);
+        out->ac = pk.lift_path(k4->ac, *arena);
+        out->ad = pk.lift_path(k4->ad, *arena);
+        out->bc = pk.lift_path(k4->bc, *arena);
+        out->bd = pk.lift_path(k4->bd, *arena);
+        out->cd = pk.lift_path(k4->cd, *arena);
+        return out;
+    }
+    if (auto k23 = dynamic_cast<negative_cert_K23 const *>(&cert)) {
+        auto out = make_arena_shared<negative_cert_K23>(arena);
+        out->a = name(k23->a);
+        out->b = name(k23->b);
+        out->one = pk.lift_path(k23->one, *arena);
+        out->two = pk.lift_path(k23->two, *arena);
+        out->three = pk.lift_path(k23->three, *arena);
+        return out;
+    }
+    if (auto t4 = dynamic_cast<negative_cert_T4 const *>(&cert)) {
+        auto out = make_arena_shared<negative_cert_T4>(arena);
+        out->c1 = name(t4->c1);
+        out->c2 = name(t4->c2);
+        out->a = name(t4->a);
+        out->b = name(t4->b);
+        out->c1a = pk.lift_path(t4->c1a, *arena);
+        out->c1b = pk.lift_path(t4->c1b, *arena);
+        out->c2a = pk.lift_path(t4->c2a, *arena);
+        out->c2b = pk.lift_path(t4->c2b, *arena);
+        out->ab = pk.lift_path(t4->ab, *arena);
+        return out;
+    }
+    if (auto tri = dynamic_cast<negative_cert_tri_comp_cut const *>(&cert)) {
+        auto out = make_arena_shared<negative_cert_tri_comp_cut>(arena);
+        out->v = name(tri->v);
+        return out;
+    }
+    if (auto tric = dynamic_cast<negative_cert_tri_cut_comp const *>(&cert)) {
+        auto out = make_arena_shared<negative_cert_tri_cut_comp>(arena);
+        out->c1 = name(tric->c1);
+        out->c2 = name(tric->c2);
+        out->c3 = name(tric->c3);
+        return out;
+    }
+
+    std::vector<int>& path = buffers.path;
+    if (auto sp = dynamic_cast<positive_cert_sp const *>(&cert)) {
+        auto out = make_arena_shared<positive_cert_sp>(arena);
+        out->is_sp = sp->is_sp;
+        sp_decomposition_view const& d = sp->decomposition;
+        if (d.empty()) return out;
+
+        // a leaf of k edges becomes k leaves and k - 1 series nodes
+        uint32_t n = d.size;
+        for (uint32_t i = 0; i < d.size; i++) {
+            if (d.is_edge(i)) n += 2 * (uint32_t)(pk.edge_length(d.source[i], d.sink[i]) - 1);
+        }
+        sp_decomposition l;
+        auto alloc = [&](size_t bytes, size_t align) {return arena->allocate(bytes, align);};
+        l.size = n;
+        l.source = {(int *)(alloc(n * sizeof(int), alignof(int))), n};
+        l.sink = {(int *)(alloc(n * sizeof(int), alignof(int))), n};
+        l.left = {(uint32_t *)(alloc(n * sizeof(uint32_t), alignof(uint32_t))), n};
+        l.right = {(uint32_t *)(alloc(n * sizeof(uint32_t), alignof(uint32_t))), n};
+        l.comp_bits = {(uint8_t *)(alloc((n + 3) / 4, 1)), (n + 3) / 4};
+        std::fill(l.comp_bits.begin(), l.comp_bits.end(), 0);
+
+        std::vector<uint32_t>& placed = buffers.placed;
+        placed.resize(d.size);
+        uint32_t next = 0;
+        auto emit = [&](int source, int sink, uint32_t left, uint32_t right, c_type comp) {
+            l.source[next] = source;
+            l.sink[next] = sink;
+            l.left[next] = left;
+            l.right[next] = right;
+            if (left != sp_no_node) pack_comp(l.comp_bits.data(), next, comp);
+            return next++;
+        };
+        for (uint32_t i = 0; i < d.size; i++) {
+            if (!d.is_edge(i)) {
+                placed[i] = emit(name(d.source[i]), name(d.sink[i]), placed[d.left[i]], placed[d.right[i]], d.comp(i));
+                continue;
+            }
+            path.clear();
+            path.push_back(name(d.source[i]));
+            pk.append_edge(d.source[i], d.sink[i], path);
+            uint32_t chain = emit(path[0], path[1], sp_no_node, sp_no_node, c_type::edge);
+            for (size_t j = 2; j < path.size(); j++) {
+                uint32_t leaf = emit(path[j - 1], path[j], sp_no_node, sp_no_node, c_type::edge);
+                chain = emit(path[0], path[j], chain, leaf, c_type::series);
+            }
+            placed[i] = chain;
+        }
+        out->decomposition = l;
+        return out;
+    }
+
+    if (auto op = dynamic_cast<positive_cert_op const *>(&cert)) {
+        auto out = make_arena_shared<positive_cert_op>(arena);
+        outer_embedding const& e = op->embedding;
+        outer_embedding& l = out->embedding;
+        auto alloc = [&](size_t count) {return std::span<int>{(int *)(arena->allocate(count * sizeof(int), alignof(int))), count};};
+        if (e.blocks() > 0) {
+            std::vector<int>& offsets = buffers.offsets;
+            std::vector<int>& cycles = buffers.cycles;
+            offsets.assign(1, 0);
+            cycles.clear();
+            for (int b = 0; b < e.blocks(); b++) {
+                std::span<int const> c = e.cycle(b);
+                path.clear();
+                path.push_back(name(c[0]));
+                if (c.size() == 2) {
+                    pk.append_edge(c[0], c[1], path);
+                    for (size_t j = 1; j < path.size(); j++) {
+                        cycles.push_back(path[j - 1]);
+                        cycles.push_back(path[j]);
+                        offsets.push_back((int)(cycles.size()));
+                    }
+                    continue;
+                }
+                for (size_t j = 0; j < c.size(); j++) pk.append_edge(c[j], c[(j + 1) % c.size()], path);
+                path.pop_back();
+                cycles.insert(cycles.end(), path.begin(), path.end());
+                offsets.push_back((int)(cycles.size()));
+            }
+            l.cycle_offsets = alloc(offsets.size());
+            std::copy(offsets.begin(), offsets.end(), l.cycle_offsets.begin());
+            l.cycles = alloc(cycles.size());
+            std::copy(cycles.begin(), cycles.end(), l.cycles.begin());
         }
 
-        dfs.emplace(root, -1);
-        dfs.emplace(next, 0);
-
-        bool fake_edge = false;
-        if (!retval.reason) {
-            fake_edge = true;
-            for (int u1 : g.adjLists[next]) {
-                if (u1 == root) {
-                    fake_edge = false;
-                    break;
+        // a kept vertex lists its neighbours on its kernel edges in the kernel's order, and a
+        // dropped one its two neighbours
+        if (!e.rotation.empty()) {
+            l.rotation = alloc(2 * (size_t)(g.e));
+            csr_view const& kernel = pk.kernel.adjLists;
+            for (int k = 0; k < pk.kernel.n; k++) {
+                int at = g.adjLists.offsets[pk.names[(size_t)(k)]];
+                for (int i = kernel.offsets[k]; i < kernel.offsets[k + 1]; i++) {
+                    l.rotation[(size_t)(at++)] = pk.first_on_edge(k, e.rotation[(size_t)(i)]);
                 }
             }
+            for (int v : pk.dropped) {
+                for (int i = g.adjLists.offsets[v]; i < g.adjLists.offsets[v + 1]; i++) l.rotation[(size_t)(i)] = g.adjLists.targets[i];
+            }
         }
-                dfs_no[root] = 1;
-        parent[root] = -1;
-        dfs_no[next] = 2;
-        parent[next] = root;
-        comp[next] = bicomp;
-        int curr_dfs = 3;
-
-        while (!dfs.empty()) {
-            std::pair<int, int> p = dfs.top();
-            int v = parent[p.first];
-            int w = p.first;
-            int u = g.adjLists[p.first][p.second];
-
-            if (comp[u] == -1 || comp[u] == bicomp) {
-                V_LOG("v: " << v << " w: " << w << " u: " << u << "\n")
-                V_LOG("seq_w: " << seq[w] << ", seq_u: " << seq[u] << "\n")
-                if (dfs_no[u] == 0) {
-                    dfs.push(std::pair{u, 0});
-                    parent[u] = w;
-                    dfs_no[u] = curr_dfs++;
-                    comp[u] = bicomp;
-                    num_children[w]++;
-                    continue;
-                }
-
-                bool child_back_edge = (dfs_no[u] < dfs_no[w] && u != v);
-                #ifdef __LOGGING__
-                    if (child_back_edge) N_LOG("BACK EDGE (" << w << ", " << u << ")\n")
-                #endif
-
-                if (parent[u] == w) {
-                    N_LOG("tree edge (" << w << ", " << u << ")\n")
-                    // --- update-seq in the paper begins here ---
-                    for (; !vertex_stacks[w].empty(); vertex_stacks[w].pop()) {
-                        if (seq[u].source() != vertex_stacks[w].top().end) {
-                            N_LOG("OOPS, 3.4b due to POPPING STACK child seq " << seq[u] << " parent seq " << seq[w] << "\n")
-                            std::shared_ptr<negative_cert_K4> k4{new negative_cert_K4{}};
-
-                            k4->b = seq[u].source();
-                            k4->a = vertex_stacks[w].top().end;
-                            k4->c = w;
-                            edge_t holding_ear = ear[u];
-
-                            for (int a = k4->a; a != k4->b; a = parent[a]) k4->ab.emplace_back(a, parent[a]);
-                            for (int b = k4->b; b != k4->c; b = parent[b]) k4->bc.emplace_back(b, parent[b]);
-
-                            k4->d = -1;
-                            int c = k4->c;
-                            while (k4->d == -1) {
-                                k4->cd.emplace_back(c, parent[c]);
-                                c = parent[c];
-
-                                for (; !vertex_stacks[c].empty(); vertex_stacks[c].pop()) {
-                                    if (vertex_stacks[c].top().end == k4->b) {
-                                        k4->d = c;
-                                        break;
-                                    }
-                                }
-                            }
-
-                            for (int d = k4->d; d != holding_ear.second; d = parent[d]) k4->ad.emplace_back(d, parent[d]);
-                            k4->ad.emplace_back(holding_ear.second, holding_ear.first);
-                            for (int d = holding_ear.first; d != k4->a; d = parent[d]) k4->ad.emplace_back(d, parent[d]);
+        return out;
+    }
+    return nullptr;
+}
 
-                            int ear1 = vertex_stacks[k4->d].top().SP.underlying_tree_path_source();
-                            k4->bd.emplace_back(k4->d, ear1);
-                            for (; ear1 != k4->b; ear1 = parent[ear1]) k4->bd.emplace_back(ear1, parent[ear1]);
-                            int ear2 = vertex_stacks[k4->c].top().SP.underlying_tree_path_source();
-                            k4->ac.emplace_back(k4->c, ear2);
-                            for (; ear2 != k4->a; ear2 = parent[ear2]) k4->ac.emplace_back(ear2, parent[ear2]);
+// r with every certificate replaced by convert(certificate, arena), the arena of the new ones; a
+// certificate shared between the classes stays shared.
+template <typename Convert>
+sp_result convert_result(sp_result const& r, result_buffers& buffers, Convert convert) {
+    bool grew = false;
+    std::shared_ptr<sp_arena> arena = buffers.arenas.acquire(grew);
+    std::vector<std::pair<certificate const *, std::shared_ptr<certificate>>>& converted = buffers.converted;
+    auto map = [&](std::shared_ptr<certificate> const& cert) -> std::shared_ptr<certificate> {
+        if (!cert) return nullptr;
+        for (auto const& [from, to] : converted) {
+            if (from == cert.get()) return to;
+        }
+        converted.emplace_back(cert.get(), convert(*cert, arena));
+        return converted.back().second;
+    };
+
+    sp_result out;
+    out.is_sp = r.is_sp;
+    out.reason = map(r.reason);
+    out.is_gsp = r.is_gsp;
+    out.gsp_reason = map(r.gsp_reason);
+    out.is_op = r.is_op;
+    out.op_reason = map(r.op_reason);
+    converted.clear();
+    return out;
+}
 
-                            retval.reason = k4;
-                            break;
-                        }
+// The result of recognizing the kernel, lifted to g.
+sp_result lift_result(path_kernel const& pk, graph const& g, sp_result const& r, result_buffers& buffers) {
+    return convert_result(r, buffers, [&](certificate const& cert, std::shared_ptr<sp_arena> const& arena) {
+        return lift_certificate(pk, g, cert, arena, buffers);
+    });
+}
 
-                        seq[u].compose(std::move(vertex_stacks[w].top().SP), c_type::antiparallel);
-                        seq[u].l_compose(std::move(vertex_stacks[w].top().tail), c_type::series);
-                    }
-                    // ---- update-seq in the paper ends here ----
+// ==================== VERTEX RELABELING ====================
+// With --relabel, a connected graph is recognized with its vertices renumbered in one of the
+// orders of order_vertices (in sp_graph.h), so that the DFS and the per-vertex arrays of the
+// recognizer walk memory mostly forward, and the result is mapped back: every vertex of a
+// certificate or SP tree is renamed, and the rotation of an outer embedding moves from the row
+// of a vertex in the relabeled graph to its row in g, both listing the same neighbours.
+struct vertex_relabeling {
+    graph relabeled;
+    std::vector<int> names; // the vertex of g each relabeled vertex is
+    std::vector<int> id; // the label of each vertex of g
+    ordering_buffers buffers; // reused by the next relabeling built here
+
+    size_t capacity() const {return names.capacity() + id.capacity() + buffers.capacity();}
+};
 
-                    if (retval.reason) break;
-                }
+inline void build_relabeling(graph const& g, vertex_order order, vertex_relabeling& out, int threads) {
+    order_vertices(g, order, out.names, &out.buffers);
+    // the last relabeled graph lets go of its arrays, which the buffers then reuse
+    out.relabeled = graph{};
+    permute_graph(g, out.names, out.id, out.relabeled, threads, &out.buffers);
+}
 
-                if (parent[u] == w || child_back_edge) {
-                    // ---- update-ear-of-parent in the paper begins here ----
-                    edge_t ear_f = (child_back_edge ? edge_t{w, u} : ear[u]);
-                    sp_tree seq_u = (child_back_edge ? sp_tree{u, w} : std::move(seq[u]));
-
-                    if (dfs_no[ear_f.second] < dfs_no[ear[w].second]) {
-                        if (ear[w].first != g.n) {
-                            if (!retval.reason && ear[w].first != w) K23_test(retval.reason, alert, parent, ear[w], ear_f, w);
-                            if (seq[w].source() != ear[w].second) {
-                                N_LOG("OOPS, 3.4a due to CASE B prev winner " << seq[w] << " prev winner ear (" << ear[w].first << ", " << ear[w].second << ")\n")
-                                report_K4_non_stack_pop_case(retval, parent, vertex_stacks, seq[w].source(), w, ear[w].second, ear[w].first, ear_f.second, ear_f.first);
-                                break;
-                            }
+// the mean of |u - v| over the edges of g, how far apart the rows of neighbours are
+inline double mean_edge_span(graph const& g) {
+    double total = 0;
+    for (int v = 0; v < g.n; v++) {
+        for (int u : g.adjLists[v]) total += std::abs(u - v);
+    }
+    return (g.e > 0 ? total / (2.0 * g.e) : 0.0);
+}
 
-                            N_LOG("CASE B (ear exists): placed " << seq[w] << " onto stk " << ear[w].second << "\n")
-                            vertex_stacks[ear[w].second].emplace(std::move(seq[w]), w, sp_tree{});
-                            earliest_outgoing[w] = ear[w].second;
-                        }
-                        ear[w] = ear_f;
-                        seq[w] = std::move(seq_u);
-                        N_LOG("CASE B (replace seq): current winning seq " << seq[w] << "\n")
-                    } else {
-                        if (seq_u.source() != ear_f.second) {
-                            N_LOG("OOPS, 3.4a/b due to CASE A/C child seq " << seq_u << " child ear (" << ear_f.first << ", " << ear_f.second << ")\n")
-                            report_K4_non_stack_pop_case(retval, parent, vertex_stacks, seq_u.source(), w, ear_f.second, ear_f.first, ear[w].second, ear[w].first);
-                            break;
-                        }
+// One certificate of the relabeled graph in the vertices of g.
+std::shared_ptr<certificate> relabel_certificate(vertex_relabeling const& rl, graph const& g, certificate const& cert, std::shared_ptr<sp_arena> const& arena) {
+    return rename_certificate(rl.names, rl.relabeled, g, cert, arena);
+}
 
-                        if (dfs_no[ear_f.second] == dfs_no[ear[w].second]) {
-                            if (!retval.reason && !child_back_edge && ear[w].first != w) K23_test(retval.reason, alert, parent, ear_f, ear[w], w);
+// The result of recognizing the relabeled graph, in the vertices of g.
+sp_result relabel_result(vertex_relabeling const& rl, graph const& g, sp_result const& r, result_buffers& buffers) {
+    return convert_result(r, buffers, [&](certificate const& cert, std::shared_ptr<sp_arena> const& arena) {
+        return relabel_certificate(rl, g, cert, arena);
+    });
+}
 
-                            if (seq[w].source() != ear[w].second) {
-                                N_LOG("OOPS, 3.4a/b due to CASE C parent seq " << seq[w] << " parent ear (" << ear[w].first << ", " << ear[w].second << ")\n")
-                                report_K4_non_stack_pop_case(retval, parent, vertex_stacks, seq[w].source(), w, ear[w].second, ear[w].first, ear_f.second, ear_f.first);
-                                break;
-                            }
-                            seq[w].compose(std::move(seq_u), c_type::parallel);
-                            N_LOG("CASE C: current winning seq after merge " << seq[w] << "\n")
+// ==================== PARALLEL EDGES ====================
+// A graph with parallel edges is recognized through the simple graph under it, which is in the
+// same classes: a bundle of parallel edges is a parallel composition of single edges, and its
+// edges can be drawn next to each other on the outer face. The result is lifted back. An SP tree
+// replaces the leaf of a bundle of k edges by k leaves under k - 1 parallel nodes, the rotation
+// of an outer embedding lists a neighbour once for each of its edges, and an obstruction, whose
+// paths need one edge of each bundle only, stays as it is. A self-loop has no place in an SP
+// decomposition, so a graph with one is rejected before recognition. Checking for either and
+// lifting are O(n + m), with a last-neighbour stamp and a count per neighbour.
+
+// whether g has a self-loop, which error then names
+inline bool has_self_loop(graph const& g, std::string& error) {
+    for (int v = 0; v < g.n; v++) {
+        for (int u : g.adjLists[v]) {
+            if (u != v) continue;
+            error = "self-loop at vertex " + std::to_string(v) + "; an SP decomposition has none";
+            return true;
+        }
+    }
+    return false;
+}
 
-                            if ((ear[w].first == w || dfs_no[ear_f.first] < dfs_no[ear[w].first]) && ear_f.first != w) {
-                                ear[w] = ear_f;
-                            }
-                        } else {
-                            if (!retval.reason && !child_back_edge) K23_test(retval.reason, alert, parent, ear_f, ear[w], w);
-
-                            if (!vertex_stacks[ear_f.second].empty() && vertex_stacks[ear_f.second].top().end == w) {
-                                N_LOG("CASE A (merge onto existing stack entry for stk " << ear_f.second << "): current child seq before merge " << seq_u << "\n")
-                                vertex_stacks[ear_f.second].top().SP.compose(std::move(seq_u), c_type::parallel);
-                            } else {
-                                N_LOG("CASE A (new stack entry): placed " << seq_u << " onto stk " << ear_f.second << " (earliest outgoing " << earliest_outgoing[w] << ")\n")
-                                vertex_stacks[ear_f.second].emplace(std::move(seq_u), w, sp_tree{});
-                                if (dfs_no[ear_f.second] < dfs_no[earliest_outgoing[w]]) {
-                                    earliest_outgoing[w] = ear_f.second;
-                                }
-                            }
-                        }
-                    }
-                    // ----- update-ear-of-parent in the paper ends here -----
-                }
-            }
+// what build_simple_graph keeps between graphs: the edges of the last simple graph, and its CSR
+// arrays, reused once no graph shares them
+struct simple_graph_buffers {
+    std::vector<int> endpoints;
+    csr_buffers csr;
 
-            if ((size_t)(++dfs.top().second) >= g.adjLists[p.first].size()) {
-                if (w != root) {
-                    if (earliest_outgoing[w] != g.n) {
-                        N_LOG("EARLIEST OUTGOING " << earliest_outgoing[w] << ": moved current winning seq " << seq[w] << " to vertex stack entry tail with SP " << vertex_stacks[earliest_outgoing[w]].top().SP << "\n")
-                        vertex_stacks[earliest_outgoing[w]].top().tail = std::move(seq[w]);
-                    }
+    size_t capacity() const {return endpoints.capacity() + csr.capacity();}
+};
 
-                    if (v == root) {
-                        seq[w].compose((fake_edge ? sp_tree{} : sp_tree{v, w}), c_type::parallel);
+// Builds the simple graph under g, which has no self-loop, into out, which may be g; returns
+// false, leaving out as it was, when g is simple. last is scratch, reused from one graph to the
+// next, and so are the buffers when given.
+inline bool build_simple_graph(graph const& g, graph& out, std::vector<int>& last, int threads, simple_graph_buffers * buffers = nullptr) {
+    last.assign((size_t)(g.n), -1);
+    bool simple = true;
+    for (int v = 0; v < g.n && simple; v++) {
+        for (int u : g.adjLists[v]) {
+            if (last[u] == v) simple = false;
+            last[u] = v;
+        }
+    }
+    if (simple) return false;
+
+    simple_graph_buffers local;
+    simple_graph_buffers& b = (buffers ? *buffers : local);
+    std::vector<int>& endpoints = b.endpoints;
+    last.assign((size_t)(g.n), -1);
+    endpoints.clear();
+    endpoints.reserve((size_t)(g.e) * 2);
+    for (int v = 0; v < g.n; v++) {
+        for (int u : g.adjLists[v]) {
+            if (u < v || last[u] == v) continue;
+            last[u] = v;
+            endpoints.push_back(v);
+            endpoints.push_back(u);
+        }
+    }
 
-                        if (cut_verts[w] != -1) {
-                            seq[w].compose(std::move(cut_vertex_attached_tree[cut_verts[w]]), c_type::series);
-                        }
-                        break;
+    // out lets go of the arrays of the last simple graph, which the buffers then reuse
+    int n = g.n;
+    out = graph{};
+    std::string error;
+    return build_graph(n, (int)(endpoints.size() / 2), endpoints, out, error, threads, &b.csr);
+}
 
-                    } else {
-                        if (cut_verts[w] != -1) {
-                            cut_vertex_attached_tree[cut_verts[w]].l_compose(sp_tree{w, v}, c_type::dangling);
-                                                        seq[w].compose(std::move(cut_vertex_attached_tree[cut_verts[w]]), c_type::series);
-                        } else {
-                            seq[w].compose(sp_tree{w, v}, c_type::series);
-                        }
-                    }
-                }
+// One certificate of simple, the simple graph under g, in g; its scratch is that of the buffers.
+std::shared_ptr<certificate> lift_bundles(graph const& simple, graph const& g, certificate const& cert, std::shared_ptr<sp_arena> const& arena, result_buffers& buffers) {
+    // an obstruction holds for g as it is; only the check is left to do again, on a copy whose
+    // paths are in the new arena
+    if (dynamic_cast<negative_cert_K4 const *>(&cert) || dynamic_cast<negative_cert_K23 const *>(&cert)
+        || dynamic_cast<negative_cert_T4 const *>(&cert) || dynamic_cast<negative_cert_tri_comp_cut const *>(&cert)
+        || dynamic_cast<negative_cert_tri_cut_comp const *>(&cert) || dynamic_cast<negative_cert_disconnected const *>(&cert)) {
+        return rename_certificate({}, simple, g, cert, arena);
+    }
 
-                dfs.pop();
+    // count[u] is how many edges join u to the vertex whose row was counted last
+    std::vector<int>& count = buffers.count;
+    count.assign((size_t)(g.n), 0);
+    auto count_row = [&](int v, int step) {
+        for (int u : g.adjLists[v]) count[u] += step;
+    };
+
+    if (auto sp = dynamic_cast<positive_cert_sp const *>(&cert)) {
+        auto out = make_arena_shared<positive_cert_sp>(arena);
+        out->is_sp = sp->is_sp;
+        sp_decomposition_view const& d = sp->decomposition;
+        if (d.empty()) return out;
+
+        // the edges of every leaf, from the row of its source, with the leaves bucketed by source
+        std::vector<int>& first = buffers.first;
+        first.assign((size_t)(g.n) + 1, 0);
+        for (uint32_t i = 0; i < d.size; i++) {
+            if (d.is_edge(i)) first[(size_t)(d.source[i]) + 1]++;
+        }
+        for (int v = 0; v < g.n; v++) first[v + 1] += first[v];
+        std::vector<uint32_t>& leaves = buffers.leaves;
+        leaves.resize((size_t)(first[g.n]));
+        std::vector<int>& next = buffers.next;
+        next.assign(first.begin(), first.end() - 1);
+        for (uint32_t i = 0; i < d.size; i++) {
+            if (d.is_edge(i)) leaves[(size_t)(next[d.source[i]]++)] = i;
+        }
+        std::vector<int>& edges = buffers.edges;
+        edges.assign(d.size, 1);
+        uint32_t n = d.size;
+        for (int v = 0; v < g.n; v++) {
+            if (first[v] == first[v + 1]) continue;
+            count_row(v, 1);
+            for (int j = first[v]; j < first[v + 1]; j++) {
+                uint32_t i = leaves[(size_t)(j)];
+                edges[i] = std::max(count[d.sink[i]], 1);
+                n += 2 * (uint32_t)(edges[i] - 1);
             }
+            count_row(v, -1);
         }
 
-        dfs_no[root] = 0;
+        // a leaf of k edges becomes k leaves and k - 1 parallel nodes
+        sp_decomposition l;
+        auto alloc = [&](size_t bytes, size_t align) {return arena->allocate(bytes, align);};
+        l.size = n;
+        l.source = {(int *)(alloc(n * sizeof(int), alignof(int))), n};
+        l.sink = {(int *)(alloc(n * sizeof(int), alignof(int))), n};
+        l.left = {(uint32_t *)(alloc(n * sizeof(uint32_t), alignof(uint32_t))), n};
+        l.right = {(uint32_t *)(alloc(n * sizeof(uint32_t), alignof(uint32_t))), n};
+        l.comp_bits = {(uint8_t *)(alloc((n + 3) / 4, 1)), (n + 3) / 4};
+        std::fill(l.comp_bits.begin(), l.comp_bits.end(), 0);
+
+        std::vector<uint32_t>& placed = buffers.placed;
+        placed.resize(d.size);
+        uint32_t at = 0;
+        auto emit = [&](int source, int sink, uint32_t left, uint32_t right, c_type comp) {
+            l.source[at] = source;
+            l.sink[at] = sink;
+            l.left[at] = left;
+            l.right[at] = right;
+            if (left != sp_no_node) pack_comp(l.comp_bits.data(), at, comp);
+            return at++;
+        };
+        for (uint32_t i = 0; i < d.size; i++) {
+            if (!d.is_edge(i)) {
+                placed[i] = emit(d.source[i], d.sink[i], placed[d.left[i]], placed[d.right[i]], d.comp(i));
+                continue;
+            }
+            uint32_t bundle = emit(d.source[i], d.sink[i], sp_no_node, sp_no_node, c_type::edge);
+            for (int k = 1; k < edges[i]; k++) {
+                uint32_t leaf = emit(d.source[i], d.sink[i], sp_no_node, sp_no_node, c_type::edge);
+                bundle = emit(d.source[i], d.sink[i], bundle, leaf, c_type::parallel);
+            }
+            placed[i] = bundle;
+        }
+        out->decomposition = l;
+        return out;
+    }
 
-        if (!retval.reason) {
-            N_LOG("no K23 found\n")
+    if (auto op = dynamic_cast<positive_cert_op const *>(&cert)) {
+        auto out = make_arena_shared<positive_cert_op>(arena);
+        outer_embedding const& e = op->embedding;
+        outer_embedding& l = out->embedding;
+        auto alloc = [&](size_t size) {return std::span<int>{(int *)(arena->allocate(size * sizeof(int), alignof(int))), size};};
+        // the blocks, and so their outer cycles, are those of the simple graph
+        l.cycle_offsets = alloc(e.cycle_offsets.size());
+        std::copy(e.cycle_offsets.begin(), e.cycle_offsets.end(), l.cycle_offsets.begin());
+        l.cycles = alloc(e.cycles.size());
+        std::copy(e.cycles.begin(), e.cycles.end(), l.cycles.begin());
+
+        // the rotation of v in g lists each neighbour of its row in the simple graph once per edge
+        if (!e.rotation.empty()) {
+            l.rotation = alloc(2 * (size_t)(g.e));
+            for (int v = 0; v < g.n; v++) {
+                count_row(v, 1);
+                int at = g.adjLists.offsets[v];
+                for (int i = simple.adjLists.offsets[v]; i < simple.adjLists.offsets[v + 1]; i++) {
+                    int u = e.rotation[(size_t)(i)];
+                    for (int k = 0; k < count[u]; k++) l.rotation[(size_t)(at++)] = u;
+                }
+                count_row(v, -1);
+            }
         }
+        return out;
+    }
+    return nullptr;
+}
 
-        if (fake_edge) {
-            edge_t fake = edge_t{root, next};
+// The result of recognizing simple, the simple graph under g, lifted to g.
+sp_result lift_bundle_result(graph const& simple, graph const& g, sp_result const& r, result_buffers& buffers) {
+    return convert_result(r, buffers, [&](certificate const& cert, std::shared_ptr<sp_arena> const& arena) {
+        return lift_bundles(simple, g, cert, arena, buffers);
+    });
+}
 
-            if (retval.reason) {
-                std::shared_ptr<negative_cert_K4> k4 = std::dynamic_pointer_cast<negative_cert_K4>(retval.reason);
-                if (k4) {
-                    std::vector<edge_t> * k4_paths[6] = {&k4->ab, &k4->ac, &k4->ad, &k4->bc, &k4->bd, &k4->cd};
-                    int k4_verts[4] = {k4->a, k4->b, k4->c, k4->d};
-                    static const int k4_t4_translation[6][5] = {{1, 3, 2, 4, 5}, {0, 3, 2, 5, 4}, {0, 4, 1, 5, 3}, {0, 1, 4, 5, 2}, {0, 2, 3, 5, 1}, {1, 2, 3, 4, 0}};
-                    static const int k4_t4_endpoint_translation[6][4] = {{0, 1, 2, 3}, {0, 2, 1, 3}, {0, 3, 1, 2}, {1, 2, 0, 3}, {1, 3, 0, 2}, {2, 3, 0, 1}};
+// ==================== BATCH MODE ====================
+// Recognizes every graph of a concatenated stream in-process. Each graph produces one record
+// "<index> <n> <m> <SP|NONSP> <kind> <auth> <GSP|NONGSP> <kind> <OP|NONOP> <kind>", where auth
+// is ok/fail (for all three certificates), or "-" when authentication is off, and each kind is
+// that of the certificate of the verdict before it, or "-" under --cert-policy boolean; a graph
+// that cannot be read produces "<index> ERROR <message>".
+// Aggregate throughput is reported on stderr. With --emit-cert, every graph also writes one
+// certificate record, in input order, to the certificate file.
+//
+// The main thread only finds graph boundaries; decoding, recognition and authentication run as
+// one task per graph on a work-stealing pool, each worker reusing its own workspace. Records
+// pass through a reorder buffer so the output is identical to a single-threaded run.
+struct batch_options {
+    bool authenticate = false;
+    int threads = 1;
+    int cert_fd = -1; // certificate output, or -1
+    cert_encoding cert_format = cert_encoding::binary;
+    cert_policy policy = cert_policy::full;
+    bool prefilter = false;
+    bool compress_paths = false; // every connected graph through its degree-2 path kernel
+    bool reductions = false; // series and parallel reductions before the DFS (--engine reduction)
+    bool relabel = false; // every connected graph renumbered in order first
+    vertex_order order = vertex_order::bfs;
+};
 
-                    int pnum = 0;
-                    for (; pnum < 6; pnum++) {
-                        if (path_contains_edge(*(k4_paths[pnum]), fake) != -1) break;
-                    }
+void append_record(std::string& out, long long index, graph const& g, sp_result const& result, char const * auth) {
+    out += std::to_string(index);
+    out += ' ';
+    out += std::to_string(g.n);
+    out += ' ';
+    out += std::to_string(g.e);
+    out += (result.is_sp ? " SP " : " NONSP ");
+    out += (result.reason ? result.reason->kind() : "-");
+    out += ' ';
+    out += auth;
+    out += (result.is_gsp ? " GSP " : " NONGSP ");
+    out += (result.gsp_reason ? result.gsp_reason->kind() : "-");
+    out += (result.is_op ? " OP " : " NONOP ");
+    out += (result.op_reason ? result.op_reason->kind() : "-");
+    out += '\n';
+}
 
-                    if (pnum != 6) {
-                        N_LOG("FAKE EDGE IN K4 (pnum " << pnum << "), GENERATE T4\n")
-                        std::shared_ptr<negative_cert_T4> t4{new negative_cert_T4{}};
-
-                        t4->c1a = std::move(*(k4_paths[k4_t4_translation[pnum][0]]));
-                        t4->c2a = std::move(*(k4_paths[k4_t4_translation[pnum][1]]));
-                        t4->c1b = std::move(*(k4_paths[k4_t4_translation[pnum][2]]));
-                        t4->c2b = std::move(*(k4_paths[k4_t4_translation[pnum][3]]));
-                        t4->ab = std::move(*(k4_paths[k4_t4_translation[pnum][4]]));
-                        t4->c1 = k4_verts[k4_t4_endpoint_translation[pnum][0]];
-                        t4->c2 = k4_verts[k4_t4_endpoint_translation[pnum][1]];
-                        t4->a = k4_verts[k4_t4_endpoint_translation[pnum][2]];
-                        t4->b = k4_verts[k4_t4_endpoint_translation[pnum][3]];
-
-                        retval.reason = t4;
-
-                        for (int i = 0; i < g.n; i++) {
-                            if (comp[i] == bicomp) {
-                                dfs_no[i] = 0;
-                                parent[i] = 0;
-                                ear[i] = edge_t{g.n, g.n};
-                                num_children[i] = 0;
-                                alert[i] = -1;
-                                earliest_outgoing[i] = g.n;
-                                seq[i] = sp_tree{};
-                                vertex_stacks[i] = std::stack<sp_chain_stack_entry>{};
-                            }
-                        }
+// how many graphs the pre-filter rejected, by test (--prefilter); what names the run
+void report_prefilter(char const * what, prefilter_counts const& counts) {
+    std::cerr << what << ": pre-filter rejected " << counts.edge_bound + counts.core << " of " << counts.graphs << " graphs, "
+              << counts.edge_bound << " by the edge bound, " << counts.core << " by the 3-core\n";
+}
 
-                        bicomp--;
-                    }
-                }
-            }
+void report_throughput(long long graphs, long long edges, std::chrono::steady_clock::time_point start) {
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double rate = (secs > 0 ? 1.0 / secs : 0.0);
+    std::cerr << "batch: " << graphs << " graphs, " << edges << " edges in " << secs << " s ("
+              << (double)(graphs) * rate << " graphs/s, " << (double)(edges) * rate << " edges/s)\n";
+}
 
-            if (retval.reason && do_k23_edge_replacement) {
-                std::shared_ptr<negative_cert_K23> k23 = std::dynamic_pointer_cast<negative_cert_K23>(retval.reason);
-                if (k23) {
-                    std::vector<edge_t> * k23_paths[3] = {&k23->one, &k23->two, &k23->three};
+// the recognizer state a worker reuses from one graph to the next
+struct recognizer_workspace {
+    recognizer_context ctx;
+    basic_recognizer_context<sp_tree_summary> summary_ctx; // for the policies without a tree
+    auth_context auth;
+    std::vector<int> component; // by vertex, to tell whether a graph is connected
+    std::vector<int> last_neighbour; // to tell whether a graph is simple
+    graph simple; // the simple graph under the last multigraph
+    simple_graph_buffers simple_buffers;
+    graph_components split; // of the last graph that was not connected
+    std::vector<int> parts; // those of split with an edge
+    std::vector<sp_result> part_results; // of parts, empty between graphs
+    path_kernel kernel; // of the last graph compressed
+    vertex_relabeling relabeling; // of the last graph relabeled
+    result_buffers results; // of the results merged, relabeled or lifted here
+
+    prefilter_counts prefiltered; // by input graph, see count_prefiltered
+
+    // of the buffers kept between graphs outside the contexts, which only grow in a warm-up run
+    size_t capacity() const {
+        return component.capacity() + last_neighbour.capacity() + simple_buffers.capacity() + split.capacity()
+             + parts.capacity() + part_results.capacity() + kernel.capacity() + relabeling.capacity()
+             + results.capacity();
+    }
 
-                    int pnum = 0;
-                    int path_ind;
-                    for (; pnum < 3; pnum++) {
-                        path_ind = path_contains_edge(*(k23_paths[pnum]), fake);
-                        if (path_ind != -1) break;
-                    }
+    // of every run of the pre-filter, whose simple graphs, components and kernels run on their own
+    prefilter_counts prefiltered_runs() const {
+        prefilter_counts counts = ctx.prefiltered;
+        counts += summary_ctx.prefiltered;
+        return counts;
+    }
 
-                    if (pnum != 3) {
-                        std::vector<edge_t>& violating_path = *(k23_paths[pnum]);
-                        N_LOG("FAKE EDGE IN K23 (" << violating_path[path_ind].first << ", " << violating_path[path_ind].second << "), REPLACE WITH PATH\n")
+    // counts an input graph once, rejected by the test that rejected a run of it since before
+    void count_prefiltered(prefilter_counts const& before) {
+        prefilter_counts after = prefiltered_runs();
+        prefiltered.graphs++;
+        if (after.edge_bound > before.edge_bound) prefiltered.edge_bound++;
+        else if (after.core > before.core) prefiltered.core++;
+    }
+};
 
-                        std::vector<edge_t> splice_path;
-                        std::vector<bool> in_k23(g.n, false);
+struct batch_workspace : recognizer_workspace {
+    graph_reader reader;
+    std::string record;
+    buffered_writer cert; // this graph's certificate record, kept in memory
+    long long edges = 0;
+    bool failed = false;
+
+    explicit batch_workspace(std::shared_ptr<input_buffer const> in) : reader{std::move(in)} {}
+
+#ifdef __COUNT_ALLOCATIONS__
+    // allocations of the graphs read, recognized and written by a warm workspace, and how many
+    // of those graphs were counted, and how many of them got an obstruction
+    long long steady_allocations = 0;
+    long long steady_runs = 0;
+    long long steady_obstruction_runs = 0;
+
+    // of the buffers kept between graphs, which only grow in a warm-up run
+    size_t capacity() {
+        return reader.endpoints.capacity() + reader.csr.capacity() + record.capacity() + cert.buffer().capacity()
+             + recognizer_workspace::capacity();
+    }
 
-                        for (std::vector<edge_t> * path : k23_paths) {
-                            for (edge_t e : *path) {
-                                in_k23[e.first] = true;
-                                in_k23[e.second] = true;
-                                V_LOG("(" << e.first << ", " << e.second << ") in K23\n")
-                            }
-                        }
+    // counts a run, unless a context or a buffer grew
+    void count_run(long long allocations, size_t capacity_before, sp_result const& result) {
+        if (ctx.grown || summary_ctx.grown || capacity() != capacity_before) return;
+        steady_allocations += allocations;
+        steady_runs++;
+        if (!result.is_sp || !result.is_op) steady_obstruction_runs++;
+    }
+#endif
+};
 
-                        for (int u2 : g.adjLists[next]) {
-                            if (comp[u2] == bicomp && parent[u2] == next && !in_k23[u2]) {
-                                V_LOG("FOUND TREE CHILD OF NEXT " << next << " NOT IN K23: " << u2 << ", ear (" << ear[u2].first << ", " << ear[u2].second << ")\n")
-                                splice_path.emplace_back(ear[u2].first, root);
-                                for (int i = ear[u2].first; i != next; i = parent[i]) splice_path.emplace_back(parent[i], i);
-                                break;
-                            }
-                        }
+// Recognizes g, which has no self-loop, with the context of the policy, through the simple graph
+// under it, renumbered with relabel and through its kernel with compress_paths; connected says
+// that g is known to be simple, connected and to have an edge, as the parts of split_components
+// of a simple graph with one are.
+sp_result recognize(graph const& g, recognizer_workspace& ws, batch_options const& opts, bool connected = false) {
+    cert_policy policy = opts.policy;
+    if (!connected) {
+        if (build_simple_graph(g, ws.simple, ws.last_neighbour, 1, &ws.simple_buffers)) {
+            return lift_bundle_result(ws.simple, g, recognize(ws.simple, ws, opts), ws.results);
+        }
+    }
 
-                        std::reverse(splice_path.begin(), splice_path.end());
-                        violating_path.erase(violating_path.begin() + path_ind);
-                        violating_path.insert(violating_path.begin() + path_ind, splice_path.begin(), splice_path.end());
-                    }
-                }
-            }
+    int count = 0;
+    if (!connected && (g.e == 0 || (count = connected_components(g, ws.component, 1)) > 1)) {
+        graph_components& split = ws.split;
+        if (g.e > 0) split_components(g, ws.component, count, split, 1);
+        else split.parts.clear();
+        ws.parts.clear();
+        for (int c = 0; c < (int)(split.parts.size()); c++) {
+            if (split.parts[c].e == 0) continue;
+            ws.parts.push_back(c);
+            ws.part_results.push_back(recognize(split.parts[c], ws, opts, true));
         }
+        sp_result merged = merge_component_results(g, split, ws.parts, ws.part_results, policy != cert_policy::boolean, ws.results);
+        // the results of the parts let go of their arenas for the next graph
+        ws.part_results.clear();
+        return merged;
+    }
 
-        if (retval.reason) do_k23_edge_replacement = false;
+    if (opts.relabel) {
+        build_relabeling(g, opts.order, ws.relabeling, 1);
+        batch_options plain = opts;
+        plain.relabel = false;
+        return relabel_result(ws.relabeling, g, recognize(ws.relabeling.relabeled, ws, plain, true), ws.results);
+    }
 
-        if (retval.reason) {
-            retval.is_sp = false;
-            break;
+    if (opts.compress_paths) {
+        if (build_path_kernel(g, ws.kernel, 1)) {
+            batch_options plain = opts;
+            plain.compress_paths = false;
+            return lift_result(ws.kernel, g, recognize(ws.kernel.kernel, ws, plain, true), ws.results);
         }
+    }
 
-        if (cut_verts[root] != -1) {
-            #ifdef __VERBOSE_LOGGING__
-            if (cut_vertex_attached_tree[cut_verts[root]].root) {
-                V_LOG("combine tree " << cut_vertex_attached_tree[cut_verts[root]] << " with " << seq[next] << " (bicomp " << bicomp << ")\n");
-            }
-            #endif
+    ws.ctx.prefilter = ws.summary_ctx.prefilter = opts.prefilter;
+    ws.ctx.reductions = ws.summary_ctx.reductions = opts.reductions;
+    switch (policy) {
+        case cert_policy::terminals:
+            return SP_RECOGNITION<terminal_certificate>(g, ws.summary_ctx);
+        case cert_policy::boolean:
+            return SP_RECOGNITION<boolean_certificate>(g, ws.summary_ctx);
+        default:
+            return SP_RECOGNITION<full_certificate>(g, ws.ctx);
+    }
+}
+
+void recognize_batch_graph(batch_workspace& ws, long long index, size_t pos, batch_options const& opts) {
+    A_COUNT(long long allocations_before = heap_allocations;)
+    A_COUNT(size_t capacity_before = ws.capacity();)
+    A_COUNT(ws.ctx.grown = ws.summary_ctx.grown = false;)
+    graph g;
+    std::string error;
+    ws.record.clear();
+    ws.cert.buffer().clear();
+    ws.reader.pos = pos;
+    if (!ws.reader.next(g, error) || g.n <= 0 || has_self_loop(g, error)) {
+        ws.record += std::to_string(index) + " ERROR " + (error.empty() ? "graph must have at least one vertex" : error) + "\n";
+        if (opts.cert_fd >= 0) write_certificate(ws.cert, opts.cert_format, index, 0, nullptr);
+        ws.failed = true;
+        return;
+    }
 
-            seq[next].compose(std::move(cut_vertex_attached_tree[cut_verts[root]]), c_type::dangling);
+    prefilter_counts before = ws.prefiltered_runs();
+    sp_result result = recognize(g, ws, opts);
+    if (opts.prefilter) ws.count_prefiltered(before);
+    char const * auth = "-";
+    if (opts.authenticate) {
+        bool auth_ok = false;
+        try {
+            auth_ok = result.authenticate(g, ws.auth);
+        } catch(...) {
+            auth_ok = false;
         }
+        auth = (auth_ok ? "ok" : "fail");
+        if (!auth_ok) ws.failed = true;
+    }
 
-        if (bicomp < n_bicomps - 1) {
-            V_LOG("ATTACH " << seq[next] << " to cut vertex " << root << " (bicomp " << bicomp << ")\n");
-            cut_vertex_attached_tree[cut_verts[root]] = std::move(seq[next]);
-        } else {
-            if (!retval.reason) {
-                std::shared_ptr<positive_cert_sp> sp{new positive_cert_sp{}};
+    append_record(ws.record, index, g, result, auth);
+    if (opts.cert_fd >= 0) write_certificate(ws.cert, opts.cert_format, index, g.n, &result);
+    ws.edges += g.e;
+    A_COUNT(ws.count_run(heap_allocations - allocations_before, capacity_before, result);)
+}
 
-                sp->decomposition = std::move(seq[next]);
-                sp->is_sp = true;
-                retval.reason = sp;
-                retval.is_sp = true;
-                N_LOG("graph is SP\n")
-            }
+// Holds finished records, and their certificate records, until every earlier record has been
+// written. At most window records are in flight, which bounds memory however far the workers
+// get ahead of a slow graph.
+struct reorder_buffer {
+    std::mutex mutex;
+    std::condition_variable ready_cv;
+    std::vector<std::string> slots;
+    std::vector<std::string> cert_slots;
+    std::vector<char> ready;
+    long long next = 0; // index of the next record to write
+
+    explicit reorder_buffer(size_t window) : slots(window), cert_slots(window), ready(window, 0) {}
+
+    // swaps the records in, handing the caller back recycled strings
+    void put(long long index, std::string& record, std::string& cert) {
+        std::lock_guard<std::mutex> lock{mutex};
+        size_t slot = (size_t)(index) % slots.size();
+        slots[slot].swap(record);
+        cert_slots[slot].swap(cert);
+        ready[slot] = 1;
+        ready_cv.notify_one();
+    }
+
+    // appends the consecutive finished records to out and cert_out; blocks until at least one
+    // record has been written or next reaches until
+    void drain(buffered_writer& out, buffered_writer& cert_out, long long until) {
+        std::unique_lock<std::mutex> lock{mutex};
+        ready_cv.wait(lock, [&] {return next >= until || ready[(size_t)(next) % slots.size()];});
+        for (size_t slot; next < until && ready[slot = (size_t)(next) % slots.size()]; next++) {
+            out.put(slots[slot]);
+            cert_out.put(cert_slots[slot]);
+            ready[slot] = 0;
         }
     }
+};
 
-    #ifdef __VERBOSE_LOGGING__
-        for (int i = 0; i < g.n; i++) {
-            V_LOG("vertex " << i << " ear: (" << ear[i].first << ", " << ear[i].second << ")\n")
-            V_LOG("vertex " << i << " parent: " << parent[i] << "\n")
-            V_LOG("vertex " << i << " dfs_no: " << dfs_no[i] << "\n")
+int run_batch(std::shared_ptr<input_buffer const> const& in, batch_options const& opts) {
+    auto start = std::chrono::steady_clock::now();
+    int workers = std::max(opts.threads, 1);
+    std::vector<batch_workspace> workspaces;
+    workspaces.reserve((size_t)(workers));
+    for (int i = 0; i < workers; i++) workspaces.emplace_back(in);
+
+    graph_reader scanner{in};
+    buffered_writer out{STDOUT_FILENO, (size_t)(1) << 20};
+    buffered_writer cert_out{opts.cert_fd};
+    std::string error;
+    long long graphs = 0;
+    bool stream_ok = true;
+
+    if (workers == 1) {
+        batch_workspace& ws = workspaces[0];
+        for (; !scanner.at_end(); graphs++) {
+            size_t pos = scanner.pos;
+            if (!scanner.skip(error)) {
+                stream_ok = false;
+                break;
+            }
+            recognize_batch_graph(ws, graphs, pos, opts);
+            out.put(ws.record);
+            cert_out.put(ws.cert.buffer());
         }
-    #endif
+    } else {
+        reorder_buffer reorder{(size_t)(workers) * 64};
+        work_stealing_pool pool{workers};
+        for (; !scanner.at_end(); graphs++) {
+            size_t pos = scanner.pos;
+            if (!scanner.skip(error)) {
+                stream_ok = false;
+                break;
+            }
 
-    return retval;
-}
+            while (graphs - reorder.next >= (long long)(reorder.slots.size())) reorder.drain(out, cert_out, graphs);
 
-// ==================== MAIN FUNCTION ====================
-int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " <graph_input_file>\n";
-        return 1;
-    }
+            pool.submit([&, index = graphs, pos](int worker) {
+                batch_workspace& ws = workspaces[(size_t)(worker)];
+                recognize_batch_graph(ws, index, pos, opts);
+                reorder.put(index, ws.record, ws.cert.buffer());
+            });
+        }
 
-    std::ifstream infile(argv[1]);
-    if (!infile) {
-        std::cerr << "Error: could not open file " << argv[1] << "\n";
-        return 1;
+        while (reorder.next < graphs) reorder.drain(out, cert_out, graphs);
     }
 
-    graph g;
-    infile >> g;
-    if (g.n <= 0) {
-        std::cerr << "Error: Graph must have at least one vertex\n";
-        return 1;
+    int status = 0;
+    long long edges = 0;
+    prefilter_counts prefiltered;
+    A_COUNT(long long steady_allocations = 0;)
+    A_COUNT(long long steady_runs = 0;)
+    A_COUNT(long long obstruction_runs = 0;)
+    for (batch_workspace const& ws : workspaces) {
+        edges += ws.edges;
+        prefiltered += ws.prefiltered;
+        if (ws.failed) status = 1;
+        A_COUNT(steady_allocations += ws.steady_allocations;)
+        A_COUNT(steady_runs += ws.steady_runs;)
+        A_COUNT(obstruction_runs += ws.steady_obstruction_runs;)
+    }
+    if (!stream_ok) {
+        out.put(std::to_string(graphs) + " ERROR " + error + "\n");
+        if (opts.cert_fd >= 0) write_certificate(cert_out, opts.cert_format, graphs, 0, nullptr);
+        status = 1;
     }
 
-    std::cout << "Read graph with " << g.n << " vertices and " << g.e << " edges\n\n";
+    out.flush();
+    if (!cert_out.flush()) {
+        std::cerr << "Error: could not write certificates\n";
+        status = 1;
+    }
+    report_throughput(graphs, edges, start);
+    if (opts.prefilter) report_prefilter("batch", prefiltered);
+    A_COUNT(std::cerr << "batch: " << steady_allocations << " allocations after warm-up in " << steady_runs << " runs, "
+                      << obstruction_runs << " with an obstruction\n";)
+    return status;
+}
 
-    sp_result result = SP_RECOGNITION(g);
+// prints what a negative certificate shows
+void print_reason(std::shared_ptr<certificate> const& reason) {
+    if (auto k4 = std::dynamic_pointer_cast<negative_cert_K4>(reason)) {
+        std::cout << "Reason: K4 subdivision on vertices {"
+                  << k4->a << "," << k4->b << "," << k4->c << "," << k4->d << "}\n";
+    } else if (auto k23 = std::dynamic_pointer_cast<negative_cert_K23>(reason)) {
+        std::cout << "Reason: K23 subdivision between vertices {" 
+                  << k23->a << "," << k23->b << "}\n";
+    } else if (auto t4 = std::dynamic_pointer_cast<negative_cert_T4>(reason)) {
+        std::cout << "Reason: T4 (theta-4) subdivision with cut vertices "
+                  << t4->c1 << "," << t4->c2
+                  << " and others " << t4->a << "," << t4->b << "\n";
+    } else if (auto tri = std::dynamic_pointer_cast<negative_cert_tri_comp_cut>(reason)) {
+        std::cout << "Reason: cut vertex " << tri->v << " splits into >=3 components\n";
+    } else if (auto tric = std::dynamic_pointer_cast<negative_cert_tri_cut_comp>(reason)) {
+        std::cout << "Reason: bicomp with 3 cut vertices {"
+                  << tric->c1 << "," << tric->c2 << "," << tric->c3 << "}\n";
+    } else if (auto disc = std::dynamic_pointer_cast<negative_cert_disconnected>(reason)) {
+        std::cout << "Reason: vertices " << disc->u << " and " << disc->v << " are in different components\n";
+    } else if (!reason) {
+        std::cout << "Reason: not kept (--cert-policy boolean)\n";
+    } else {
+        std::cout << "Reason: unknown (unhandled cert type)\n";
+    }
+}
 
+// Prints the three verdicts of result and what refutes them, as far as the certificate policy
+// keeps it.
+void print_verdicts(sp_result const& result, cert_policy policy) {
     std::cout << "=== Series-Parallel Recognition Results ===\n";
     if (result.is_sp) {
         std::cout << "The graph IS Series-Parallel.\n";
         auto sp = std::dynamic_pointer_cast<positive_cert_sp>(result.reason);
-        if (sp && sp->decomposition.root) {
-            std::cout << "SP decomposition tree root: {"
-                      << sp->decomposition.source() << ","
-                      << sp->decomposition.sink() << "}\n";
+        if (policy != cert_policy::full) {
+            std::cout << "SP decomposition tree not kept (--cert-policy " << cert_policy_names[(int)(policy)] << ").\n";
+        } else if (sp && !sp->decomposition.empty()) {
+            // a tree of k leaves has k - 1 inner nodes, so a forest has as many trees as leaves beyond them
+            long long trees = 0;
+            for (uint32_t i = 0; i < sp->decomposition.size; i++) trees += (sp->decomposition.is_edge(i) ? 1 : -1);
+            if (trees > 1) {
+                std::cout << "SP decomposition forest of " << trees << " trees, one per component with an edge.\n";
+            } else {
+                std::cout << "SP decomposition tree root: {"
+                          << sp->decomposition.source[sp->decomposition.root()] << ","
+                          << sp->decomposition.sink[sp->decomposition.root()] << "}\n";
+            }
         } else {
             std::cout << "Empty SP decomposition (trivial).\n";
         }
     } else {
         std::cout << "The graph is NOT Series-Parallel.\n";
-        if (auto k4 = std::dynamic_pointer_cast<negative_cert_K4>(result.reason)) {
-            std::cout << "Reason: K4 subdivision on vertices {"
-                      << k4->a << "," << k4->b << "," << k4->c << "," << k4->d << "}\n";
-        } else if (auto k23 = std::dynamic_pointer_cast<negative_cert_K23>(result.reason)) {
-            std::cout << "Reason: K23 subdivision between vertices {" 
-                      << k23->a << "," << k23->b << "}\n";
-        } else if (auto t4 = std::dynamic_pointer_cast<negative_cert_T4>(result.reason)) {
-            std::cout << "Reason: T4 (theta-4) subdivision with cut vertices "
-                      << t4->c1 << "," << t4->c2
-                      << " and others " << t4->a << "," << t4->b << "\n";
-        } else if (auto tri = std::dynamic_pointer_cast<negative_cert_tri_comp_cut>(result.reason)) {
-            std::cout << "Reason: cut vertex " << tri->v << " splits into >=3 components\n";
-               } else if (auto tric = std::dynamic_pointer_cast<negative_cert_tri_cut_comp>(result.reason)) {
-            std::cout << "Reason: bicomp with 3 cut vertices {"
-                      << tric->c1 << "," << tric->c2 << "," << tric->c3 << "}\n";
-        } else {
-            std::cout << "Reason: unknown (unhandled cert type)\n";
-        }
+        print_reason(result.reason);
     }
 
-    std::cout << "\n=== Certificate Authentication ===\n";
+    std::cout << "The graph " << (result.is_gsp ? "IS" : "is NOT") << " Generalized Series-Parallel.\n";
+    if (!result.is_gsp) print_reason(result.gsp_reason);
+    std::cout << "The graph " << (result.is_op ? "IS" : "is NOT") << " Outerplanar.\n";
+    if (!result.is_op) print_reason(result.op_reason);
+}
+
+// Authenticates every certificate of result against g and reports it; returns the exit status.
+int report_authentication(graph const& g, sp_result& result) {
     if (!result.reason) {
         std::cerr << "ERROR: No certificate generated\n";
         return 1;
@@ -1529,4 +5281,442 @@ int main(int argc, char* argv[]) {
     std::cout << "Certificate authenticated successfully.\n";
     return 0;
 }
-                       
+
+// prints the outer cycle of every block and the rotation of every vertex (--embedding); with
+// names, vertex v of g is printed as names[v]
+void print_embedding(std::ostream& os, graph const& g, std::shared_ptr<certificate> const& reason, std::span<const int> names = {}) {
+    auto op = std::dynamic_pointer_cast<positive_cert_op>(reason);
+    if (!op || op->embedding.rotation.size() != 2 * (size_t)(g.e)) {
+        os << "No outerplanar embedding found.\n";
+        return;
+    }
+
+    auto name = [&](int v) {return (names.empty() ? v : names[v]);};
+    outer_embedding const& emb = op->embedding;
+    for (int b = 0; b < emb.blocks(); b++) {
+        os << "Outer cycle of block " << b << ":";
+        for (int v : emb.cycle(b)) os << " " << name(v);
+        os << "\n";
+    }
+    for (int v = 0; v < g.n; v++) {
+        os << "Rotation at " << name(v) << ":";
+        for (int i = g.adjLists.offsets[v]; i < g.adjLists.offsets[v + 1]; i++) os << " " << name(emb.rotation[(size_t)(i)]);
+        os << "\n";
+    }
+}
+
+// ==================== CONNECTED COMPONENTS ====================
+// A graph that is not connected is recognized component by component: each component with an
+// edge is a graph of its own, whose vertex i is the i-th smallest vertex of the component, and
+// produces one record in the batch format followed by that smallest vertex,
+// "<index> <n> <m> <SP|NONSP> <kind> <auth> <GSP|NONGSP> <kind> <OP|NONOP> <kind> <first vertex>".
+// Isolated vertices have nothing to recognize and are only counted. --emit-components writes
+// the recognized components, in order, as a text stream. The results are then merged into those
+// of the whole graph, as in a batch, whose verdicts are printed and certificates authenticated
+// like those of a connected graph, and --emit-cert writes its certificate group, an SP forest
+// for a graph in the class, so sp_verify checks it against the input file.
+//
+// Consecutive components are grouped into runs of at least min_edges_per_run edges (a run ends
+// at the first component that reaches it), and the runs are tasks on a work-stealing pool, each
+// worker reusing its own recognizer workspace. Every run keeps its output in memory and the
+// runs are written in order, so the output does not depend on the number of threads.
+struct component_run {
+    int first = 0; // the run recognizes components[first .. last)
+    int last = 0;
+    std::string records;
+    std::string embeddings;
+    std::string graphs; // the components as a text stream, for --emit-components
+    int failed = 0; // components whose certificates failed authentication
+};
+
+// appends g to out in the text input format, every edge once and a self-loop, which its row
+// lists twice, once
+void append_text_graph(std::string& out, graph const& g) {
+    out += std::to_string(g.n) + " " + std::to_string(g.e) + "\n";
+    for (int v = 0; v < g.n; v++) {
+        bool halve = false;
+        for (int u : g.adjLists[v]) {
+            if (u < v || (u == v && (halve = !halve))) continue;
+            out += std::to_string(v) + " " + std::to_string(u) + "\n";
+        }
+    }
+}
+
+// read is the graph as it was read, g the simple graph under it.
+int run_components(graph const& read, graph const& g, std::vector<int> const& component, int count, batch_options const& opts, bool embedding, int components_fd) {
+    const int min_edges_per_run = 1 << 14;
+    graph_components split;
+    split_components(g, component, count, split, opts.threads);
+
+    std::vector<int> components; // the components with an edge
+    for (int c = 0; c < count; c++) {
+        if (split.parts[c].e > 0) components.push_back(c);
+    }
+    int recognized = (int)(components.size());
+
+    std::vector<component_run> runs;
+    for (int i = 0, edges = 0; i < recognized; i++) {
+        if (edges == 0) runs.emplace_back().first = i;
+        edges += split.parts[components[i]].e;
+        if (edges >= min_edges_per_run || i + 1 == recognized) {
+            runs.back().last = i + 1;
+            edges = 0;
+        }
+    }
+
+    bool full = (opts.policy == cert_policy::full);
+    std::vector<sp_result> results((size_t)(recognized));
+    auto recognize_run = [&](component_run& run, recognizer_workspace& ws) {
+        for (int i = run.first; i < run.last; i++) {
+            int c = components[i];
+            graph const& part = split.parts[c];
+            std::span<const int> names = split.vertices_of(c);
+            sp_result& result = results[(size_t)(i)];
+            prefilter_counts before = ws.prefiltered_runs();
+            result = recognize(part, ws, opts, true);
+            if (opts.prefilter) ws.count_prefiltered(before);
+
+            char const * auth = "-";
+            if (full) {
+                bool auth_ok = false;
+                try {
+                    auth_ok = result.authenticate(part, ws.auth);
+                } catch(...) {
+                    auth_ok = false;
+                }
+                auth = (auth_ok ? "ok" : "fail");
+                if (!auth_ok) run.failed++;
+            }
+
+            append_record(run.records, i, part, result, auth);
+            run.records.back() = ' ';
+            run.records += std::to_string(names[0]) + "\n";
+            if (components_fd >= 0) append_text_graph(run.graphs, part);
+            if (embedding) {
+                std::ostringstream os;
+                os << "Component " << i << ":\n";
+                print_embedding(os, part, result.op_reason, names);
+                run.embeddings += os.str();
+            }
+        }
+    };
+
+    int workers = std::max(std::min(opts.threads, (int)(runs.size())), 1);
+    std::vector<recognizer_workspace> workspaces((size_t)(workers));
+    if (workers == 1) {
+        for (component_run& run : runs) recognize_run(run, workspaces[0]);
+    } else {
+        work_stealing_pool pool{workers};
+        for (component_run& run : runs) {
+            pool.submit([&](int worker) {recognize_run(run, workspaces[(size_t)(worker)]);});
+        }
+        pool.wait_idle();
+    }
+    if (opts.prefilter) {
+        prefilter_counts prefiltered;
+        for (recognizer_workspace const& ws : workspaces) prefiltered += ws.prefiltered;
+        report_prefilter("components", prefiltered);
+    }
+
+    std::cout << "Graph has " << count << " connected components (" << count - recognized << " isolated vertices); the "
+              << recognized << " with edges are recognized as graphs of their own, vertex i of each being the i-th smallest vertex of the component.\n\n";
+    std::cout << "=== Per-Component Results ===\n";
+    int status = 0;
+    int failed = 0;
+    buffered_writer components_out{components_fd};
+    for (component_run& run : runs) {
+        std::cout << run.records;
+        components_out.put(run.graphs);
+        failed += run.failed;
+    }
+    if (embedding) {
+        std::cout << "\n=== Outerplanar Embeddings ===\n";
+        for (component_run const& run : runs) std::cout << run.embeddings;
+    }
+    if (!components_out.flush()) {
+        std::cerr << "Error: could not write components\n";
+        status = 1;
+    }
+
+    result_buffers buffers;
+    sp_result merged = merge_component_results(g, split, components, results, opts.policy != cert_policy::boolean, buffers);
+    if (&read != &g) merged = lift_bundle_result(g, read, merged, buffers);
+    std::cout << "\n";
+    print_verdicts(merged, opts.policy);
+    if (opts.cert_fd >= 0) {
+        buffered_writer cert_out{opts.cert_fd};
+        write_certificate(cert_out, opts.cert_format, 0, read.n, &merged);
+        if (!cert_out.flush()) {
+            std::cerr << "Error: could not write certificates\n";
+            status = 1;
+        }
+    }
+
+    std::cout << "\n=== Certificate Authentication ===\n";
+    if (!full) {
+        std::cout << "Skipped: no full certificates under --cert-policy " << cert_policy_names[(int)(opts.policy)] << ".\n";
+        return status;
+    }
+    if (failed > 0) {
+        std::cerr << "ERROR: Certificate authentication failed for " << failed << " components!\n";
+        status = 1;
+    } else {
+        std::cout << "All " << recognized << " component certificates authenticated successfully.\n";
+    }
+    return std::max(status, report_authentication(read, merged));
+}
+
+// ==================== MAIN FUNCTION ====================
+int main(int argc, char* argv[]) {
+    bool batch = false;
+    batch_options opts;
+    opts.threads = hardware_threads();
+    char const * path = nullptr;
+    char const * cert_path = nullptr;
+    char const * components_path = nullptr;
+    bool usage_error = false;
+    bool batch_flag = false; // an option that only applies to batch mode was given
+    bool cert_flag = false; // an option that only applies with --emit-cert was given
+    bool embedding = false;
+    bool threads_flag = false;
+    bool differential = false;
+    bicomp_engine engine = bicomp_engine::dfs;
+    recognition_engine block_engine = recognition_engine::dfs;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--batch") == 0) {
+            batch = true;
+        } else if (std::strcmp(argv[i], "--auth") == 0) {
+            opts.authenticate = batch_flag = true;
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            opts.threads = std::atoi(argv[++i]);
+            usage_error = usage_error || opts.threads < 1;
+            threads_flag = true;
+        } else if (std::strcmp(argv[i], "--bicomps") == 0 && i + 1 < argc) {
+            char const * name = argv[++i];
+            int k = 0;
+            for (; k < 2 && std::strcmp(name, bicomp_engine_names[k]) != 0; k++);
+            engine = (bicomp_engine)(k);
+            usage_error = usage_error || k == 2;
+        } else if (std::strcmp(argv[i], "--engine") == 0 && i + 1 < argc) {
+            char const * name = argv[++i];
+            int k = 0;
+            for (; k < 3 && std::strcmp(name, recognition_engine_names[k]) != 0; k++);
+            block_engine = (recognition_engine)(k);
+            opts.reductions = (block_engine == recognition_engine::reduction);
+            usage_error = usage_error || k == 3;
+        } else if (std::strcmp(argv[i], "--embedding") == 0) {
+            embedding = true;
+        } else if (std::strcmp(argv[i], "--compress-paths") == 0) {
+            opts.compress_paths = true;
+        } else if (std::strcmp(argv[i], "--prefilter") == 0) {
+            opts.prefilter = true;
+        } else if (std::strcmp(argv[i], "--differential") == 0) {
+            differential = true;
+        } else if (std::strcmp(argv[i], "--relabel") == 0 && i + 1 < argc) {
+            char const * name = argv[++i];
+            int k = 0;
+            for (; k < 3 && std::strcmp(name, vertex_order_names[k]) != 0; k++);
+            opts.order = (vertex_order)(k);
+            opts.relabel = true;
+            usage_error = usage_error || k == 3;
+        } else if (std::strcmp(argv[i], "--emit-cert") == 0 && i + 1 < argc) {
+            cert_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--emit-components") == 0 && i + 1 < argc) {
+            components_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--cert-format") == 0 && i + 1 < argc) {
+            char const * format = argv[++i];
+            if (std::strcmp(format, "binary") == 0) opts.cert_format = cert_encoding::binary;
+            else if (std::strcmp(format, "json") == 0) opts.cert_format = cert_encoding::json;
+            else usage_error = true;
+            cert_flag = true;
+        } else if (std::strcmp(argv[i], "--cert-policy") == 0 && i + 1 < argc) {
+            char const * policy = argv[++i];
+            int k = 0;
+            for (; k < 3 && std::strcmp(policy, cert_policy_names[k]) != 0; k++);
+            opts.policy = (cert_policy)(k);
+            usage_error = usage_error || k == 3;
+        } else if (!path) {
+            path = argv[i];
+        } else {
+            usage_error = true;
+        }
+    }
+
+    // only full certificates can be authenticated or exported, or hold an embedding
+    bool partial = (opts.policy != cert_policy::full);
+    if (usage_error || (batch_flag && !batch) || (cert_flag && !cert_path) || ((embedding || components_path || differential || engine != bicomp_engine::dfs || block_engine == recognition_engine::ears) && batch)
+        || (partial && (opts.authenticate || cert_path || embedding))) {
+        std::cerr << "Usage: " << argv[0] << " [--batch [--auth]] [--threads N] [--emit-cert FILE [--cert-format binary|json]]"
+                  << " [--cert-policy full|terminals|boolean] [--embedding] [--bicomps dfs|parallel] [--engine dfs|ears|reduction] [--compress-paths] [--prefilter] [--differential] [--relabel bfs|rcm|dfs] [--emit-components FILE] [graph_input_file]\n"
+                  << "--batch does not combine with --embedding, --bicomps parallel, --engine ears, --differential or --emit-components\n";
+        return 1;
+    }
+
+    bool from_stdin = (!path || std::strcmp(path, "-") == 0);
+    std::shared_ptr<input_buffer> in{new input_buffer{}};
+    if (!(from_stdin ? in->open_fd(STDIN_FILENO) : in->open_path(path))) {
+        std::cerr << "Error: could not open " << (from_stdin ? "standard input" : "file ") << (from_stdin ? "" : path) << "\n";
+        return 1;
+    }
+
+    // the certificate file is only created, or truncated, once there is something to write to it:
+    // a batch streams its records as the graphs are recognized, a single graph is read first
+    auto open_cert = [&] {
+        if (!cert_path) return true;
+        opts.cert_fd = ::open(cert_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (opts.cert_fd < 0) {
+            std::cerr << "Error: could not open certificate file " << cert_path << "\n";
+            return false;
+        }
+        return true;
+    };
+
+    if (batch) {
+        if (!open_cert()) return 1;
+        int status = run_batch(in, opts);
+        if (opts.cert_fd >= 0) ::close(opts.cert_fd);
+        return status;
+    }
+
+    graph g;
+    std::string error;
+    if (!read_graph(in, g, error)) {
+        std::cerr << "Error: " << error << "\n";
+        return 1;
+    }
+    if (g.n <= 0) {
+        std::cerr << "Error: Graph must have at least one vertex\n";
+        return 1;
+    }
+    if (has_self_loop(g, error)) {
+        std::cerr << "Error: " << error << "\n";
+        return 1;
+    }
+
+    // a graph with parallel edges is recognized through the simple graph under it, and one that
+    // is not connected, or has no edge, component by component
+    graph simple;
+    std::vector<int> last_neighbour;
+    bool bundled = build_simple_graph(g, simple, last_neighbour, opts.threads);
+    graph const& input = (bundled ? simple : g);
+    std::vector<int> component;
+    int count = connected_components(input, component, opts.threads);
+    bool split = (count > 1 || input.e == 0);
+    if (split && (differential || engine != bicomp_engine::dfs || block_engine == recognition_engine::ears)) {
+        std::cerr << "Error: --bicomps parallel, --engine ears and --differential only apply to connected graphs with an edge; this one has ";
+        if (input.e == 0) std::cerr << "no edge\n";
+        else std::cerr << count << " components\n";
+        return 1;
+    }
+    if (!open_cert()) return 1;
+
+    std::cout << "Read graph with " << g.n << " vertices and " << g.e << " edges\n\n";
+    if (bundled) std::cout << "Merged parallel edges: simple graph of " << simple.e << " edges\n\n";
+
+    int components_fd = -1;
+    if (components_path) {
+        components_fd = ::open(components_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (components_fd < 0) {
+            std::cerr << "Error: could not open components file " << components_path << "\n";
+            return 1;
+        }
+    }
+
+    if (split) {
+        int status = run_components(g, input, component, count, opts, embedding, components_fd);
+        if (opts.cert_fd >= 0) ::close(opts.cert_fd);
+        if (components_fd >= 0) ::close(components_fd);
+        return status;
+    }
+    if (components_fd >= 0) {
+        std::string text;
+        append_text_graph(text, g);
+        buffered_writer components_out{components_fd};
+        components_out.put(text);
+        bool written = components_out.flush();
+        ::close(components_fd);
+        if (!written) {
+            std::cerr << "Error: could not write components file " << components_path << "\n";
+            return 1;
+        }
+    }
+
+    // a single graph is recognized on one thread unless --threads asks for more; then its
+    // bicomps are spread over a pool. The parallel bicomp engine and the ear engine always run
+    // on a pool, of every hardware thread unless --threads says otherwise. So does the reduction
+    // engine, which reduces on the calling thread but leaves the bicomps of a graph it cannot
+    // reduce to the pool.
+    std::unique_ptr<work_stealing_pool> pool;
+    if (engine == bicomp_engine::parallel || block_engine != recognition_engine::dfs || (threads_flag && opts.threads > 1)) {
+        pool.reset(new work_stealing_pool{opts.threads});
+    }
+
+    // with --relabel, the graph is renumbered first, and with --compress-paths, the kernel is
+    // recognized in place of the graph
+    vertex_relabeling relabeling;
+    if (opts.relabel) {
+        build_relabeling(input, opts.order, relabeling, opts.threads);
+        std::cout << "Relabeled vertices in " << vertex_order_names[(int)(opts.order)] << " order: mean edge span "
+                  << mean_edge_span(input) << " -> " << mean_edge_span(relabeling.relabeled) << "\n\n";
+    }
+    graph const& source = (opts.relabel ? relabeling.relabeled : input);
+    path_kernel kernel;
+    bool compressed = opts.compress_paths && build_path_kernel(source, kernel, opts.threads);
+    graph const& target = (compressed ? kernel.kernel : source);
+    if (compressed) {
+        std::cout << "Compressed degree-2 paths: kernel of " << target.n << " vertices and " << target.e << " edges\n\n";
+    }
+
+    sp_result result;
+    prefilter_counts prefiltered;
+    prefilter_counts * counts = (opts.prefilter ? &prefiltered : nullptr);
+    if (opts.policy == cert_policy::terminals) result = SP_RECOGNITION<terminal_certificate>(target, pool.get(), engine, block_engine, counts);
+    else if (opts.policy == cert_policy::boolean) result = SP_RECOGNITION<boolean_certificate>(target, pool.get(), engine, block_engine, counts);
+    else result = SP_RECOGNITION<full_certificate>(target, pool.get(), engine, block_engine, counts);
+
+    // with --differential, the verdicts are checked against a plain run of the DFS engine
+    if (differential) {
+        sp_result plain = (opts.policy == cert_policy::terminals ? SP_RECOGNITION<terminal_certificate>(target)
+                           : opts.policy == cert_policy::boolean ? SP_RECOGNITION<boolean_certificate>(target)
+                                                                 : SP_RECOGNITION<full_certificate>(target));
+        if (plain.is_sp != result.is_sp || plain.is_gsp != result.is_gsp || plain.is_op != result.is_op) {
+            std::cerr << "Error: the " << recognition_engine_names[(int)(block_engine)] << " engine"
+                      << (engine == bicomp_engine::parallel ? " with parallel bicomps" : "")
+                      << " disagrees with the DFS engine: SP " << result.is_sp << "/" << plain.is_sp
+                      << ", GSP " << result.is_gsp << "/" << plain.is_gsp << ", OP " << result.is_op << "/" << plain.is_op << "\n";
+            return 1;
+        }
+        std::cout << "Differential: the " << recognition_engine_names[(int)(block_engine)] << " engine"
+                  << (engine == bicomp_engine::parallel ? " with parallel bicomps" : "") << " agrees with the DFS engine\n\n";
+    }
+    result_buffers buffers;
+    if (compressed) result = lift_result(kernel, source, result, buffers);
+    if (opts.relabel) result = relabel_result(relabeling, input, result, buffers);
+    if (bundled) result = lift_bundle_result(simple, g, result, buffers);
+    if (opts.prefilter) {
+        std::cout << "Pre-filter: " << (prefiltered.edge_bound > 0 ? "rejected, more than 2n - 3 edges"
+                                        : prefiltered.core > 0 ? "rejected, the 3-core is not empty" : "passed") << "\n\n";
+    }
+
+    print_verdicts(result, opts.policy);
+    if (embedding && result.is_op) print_embedding(std::cout, g, result.op_reason);
+
+    if (opts.cert_fd >= 0) {
+        buffered_writer cert_out{opts.cert_fd};
+        write_certificate(cert_out, opts.cert_format, 0, g.n, &result);
+        bool written = cert_out.flush();
+        ::close(opts.cert_fd);
+        if (!written) {
+            std::cerr << "Error: could not write certificate file " << cert_path << "\n";
+            return 1;
+        }
+        std::cout << "Certificate written to " << cert_path << "\n";
+    }
+
+    std::cout << "\n=== Certificate Authentication ===\n";
+    if (partial) {
+        std::cout << "Skipped: no full certificate under --cert-policy " << cert_policy_names[(int)(opts.policy)] << ".\n";
+        return 0;
+    }
+    return report_authentication(g, result);
+}
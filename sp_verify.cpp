@@ -0,0 +1,150 @@
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+#include <unistd.h>
+
+#include "certificate_format.h"
+#include "graph_format.h"
+#include "sp_certificate.h"
+#include "sp_graph.h"
+
+// ==================== VERIFICATION ====================
+// Checks the certificates written by sp_recognition --emit-cert against their graphs, without
+// recognizing anything. Both files are mapped; the graph file is a single graph or a batch
+// stream, and record group i of the (binary) certificate file belongs to graph i. Every checked
+// graph produces a record in the batch format of sp_recognition, "<index> <n> <m> <SP|NONSP>
+// <certificate kind> <ok|fail>", followed by "<GSP|NONGSP> <kind> <OP|NONOP> <kind>" when the
+// group holds those verdicts, as a version 2 group does after its SP record (a version 1 group
+// is the SP record alone), or "<index> ERROR <message>".
+// With --sample K only every K-th graph is checked; the others are skipped without decoding.
+struct verify_options {
+    long long sample = 1;
+    int threads = hardware_threads();
+};
+
+int run_verify(std::shared_ptr<input_buffer const> const& graphs, std::shared_ptr<input_buffer const> const& certs, verify_options const& opts) {
+    auto start = std::chrono::steady_clock::now();
+    graph_reader reader{graphs};
+    buffered_writer out{STDOUT_FILENO, (size_t)(1) << 20};
+    size_t cert_pos = 0;
+    long long index = 0;
+    long long checked = 0;
+    long long failed = 0;
+    int status = 0;
+    std::string error;
+    auth_context auth;
+
+    auto report_error = [&](std::string const& message) {
+        out.put(std::to_string(index) + " ERROR " + message + "\n");
+        failed++;
+        status = 1;
+    };
+
+    for (; !reader.at_end(); index++) {
+        if (cert_pos == certs->size) {
+            report_error("no certificate for this graph");
+            break;
+        }
+
+        sp_result result;
+        uint32_t cert_n;
+        if (!read_certificate(certs->data, certs->size, cert_pos, result, cert_n, error)) {
+            report_error(error);
+            break;
+        }
+
+        if (index % opts.sample != 0) {
+            if (!reader.skip(error)) {
+                report_error(error);
+                break;
+            }
+            continue;
+        }
+
+        graph g;
+        if (!reader.next(g, error, opts.threads)) {
+            report_error(error);
+            break;
+        }
+
+        checked++;
+        if (!result.reason) {
+            report_error("certificate records an unreadable graph");
+            continue;
+        }
+        if (cert_n != (uint32_t)(g.n)) {
+            report_error("certificate is for a graph of order " + std::to_string(cert_n));
+            continue;
+        }
+
+        bool auth_ok = false;
+        try {
+            auth_ok = result.authenticate(g, auth);
+        } catch(...) {
+            auth_ok = false;
+        }
+        if (!auth_ok) {
+            failed++;
+            status = 1;
+        }
+
+        out.put(std::to_string(index) + " " + std::to_string(g.n) + " " + std::to_string(g.e)
+                + (result.is_sp ? " SP " : " NONSP ") + result.reason->kind() + (auth_ok ? " ok" : " fail"));
+        if (result.gsp_reason) out.put(std::string{result.is_gsp ? " GSP " : " NONGSP "} + result.gsp_reason->kind());
+        if (result.op_reason) out.put(std::string{result.is_op ? " OP " : " NONOP "} + result.op_reason->kind());
+        out.put('\n');
+    }
+
+    if (status == 0 && cert_pos != certs->size) {
+        out.put(std::to_string(index) + " ERROR certificates left over after the last graph\n");
+        status = 1;
+    }
+
+    out.flush();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "verify: " << checked << " of " << index << " certificates checked, " << failed << " failed in " << secs << " s\n";
+    return status;
+}
+
+// ==================== MAIN FUNCTION ====================
+int main(int argc, char* argv[]) {
+    verify_options opts;
+    char const * paths[2] = {nullptr, nullptr};
+    int num_paths = 0;
+    bool usage_error = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--sample") == 0 && i + 1 < argc) {
+            opts.sample = std::atoll(argv[++i]);
+            usage_error = usage_error || opts.sample < 1;
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            opts.threads = std::atoi(argv[++i]);
+            usage_error = usage_error || opts.threads < 1;
+        } else if (num_paths < 2) {
+            paths[num_paths++] = argv[i];
+        } else {
+            usage_error = true;
+        }
+    }
+
+    if (usage_error || num_paths != 2) {
+        std::cerr << "Usage: " << argv[0] << " [--sample K] [--threads N] graph_input_file certificate_file\n";
+        return 1;
+    }
+
+    std::shared_ptr<input_buffer> graphs{new input_buffer{}};
+    std::shared_ptr<input_buffer> certs{new input_buffer{}};
+    for (int i = 0; i < 2; i++) {
+        bool from_stdin = (std::strcmp(paths[i], "-") == 0);
+        input_buffer& in = (i == 0 ? *graphs : *certs);
+        if (!(from_stdin ? in.open_fd(STDIN_FILENO) : in.open_path(paths[i]))) {
+            std::cerr << "Error: could not open " << (from_stdin ? "standard input" : "file ") << (from_stdin ? "" : paths[i]) << "\n";
+            return 1;
+        }
+    }
+
+    return run_verify(graphs, certs, opts);
+}
@@ -5,9 +5,14 @@
 #include <string>
 #include <chrono>
 #include <iomanip>
+#include <iterator>
+#include <algorithm>
 #include <cstdlib>
 #include <cassert>
 
+#include "certificate_format.h"
+#include "graph_format.h"
+
 struct TestResult {
     bool generator_success;
     bool recognizer_success;
@@ -120,6 +125,1014 @@ public:
         return result;
     }
     
+    // The fixture of the tests below: runs command (none when empty) and then check on its exit
+    // code, timing both, and records the result. check fills in the counts of the result and
+    // returns the summary printed after PASSED, or sets result.error_message when the test fails.
+    template <typename Check>
+    void run_command_test(const std::string& name, const std::string& command, Check check) {
+        tests_run++;
+        std::cout << "Test " << tests_run << ": " << name << " ... " << std::flush;
+
+        TestResult result = {};
+        result.generator_success = true;
+
+        auto start_time = std::chrono::high_resolution_clock::now();
+        int exit_code = (command.empty() ? 0 : system(command.c_str()));
+        std::string summary = check(exit_code, result);
+        auto end_time = std::chrono::high_resolution_clock::now();
+        result.recognition_time = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+
+        result.recognizer_success = (result.generator_success && result.error_message.empty());
+        results.push_back(result);
+        if (result.recognizer_success) {
+            tests_passed++;
+            std::cout << "PASSED [" << summary << "]";
+            std::cout << " Rec:" << std::fixed << std::setprecision(1) << result.recognition_time << "ms" << std::endl;
+        } else {
+            std::cout << "FAILED - " << result.error_message << std::endl;
+        }
+    }
+
+    // whether two outputs of the recognizer print the same verdicts and authentication lines
+    static bool same_verdicts(const std::string& a, const std::string& b) {
+        std::string run = "grep -E '^The graph|authenticated' " + a + " > verdicts_dfs.txt"
+                          " && grep -E '^The graph|authenticated' " + b + " > verdicts_parallel.txt"
+                          " && cmp -s verdicts_dfs.txt verdicts_parallel.txt";
+        return system(run.c_str()) == 0;
+    }
+
+    // Concatenates several generated graphs (alternating text and binary output) into one file,
+    // runs the recognizer once in batch mode and checks every record, in order, against a
+    // single-graph run.
+    void run_batch_test(const std::string& name, int count, long three_edges, long seed, int threads) {
+        std::vector<bool> expected_sp;
+        bool generated = true;
+
+        system("rm -f batch_graphs.bin");
+        auto start_time = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < count; i++) {
+            std::string params = std::to_string(1 + i % 3) + " " + std::to_string(3 + i % 4) + " " +
+                                 std::to_string(i % 2) + " " + std::to_string(3 + i % 3) + " " +
+                                 std::to_string(three_edges) + " " + std::to_string(seed + i);
+            std::string format = (i % 3 == 0 ? "" : (i % 3 == 1 ? "--binary " : "--csr "));
+            std::string gen_cmd = "./graph_generator " + format + params + " > test_graph.txt 2>/dev/null"
+                                  " && cat test_graph.txt >> batch_graphs.bin";
+            if (system(gen_cmd.c_str()) != 0) {
+                generated = false;
+                break;
+            }
+
+            system("./sp_recognizer test_graph.txt > sp_result.txt 2>&1");
+            std::ifstream single("sp_result.txt");
+            std::string line;
+            bool is_sp = false;
+            while (std::getline(single, line)) {
+                if (line.find("IS Series-Parallel") != std::string::npos) is_sp = true;
+            }
+            expected_sp.push_back(is_sp);
+        }
+        auto end_time = std::chrono::high_resolution_clock::now();
+        double generation_time = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+
+        std::string rec_cmd = "./sp_recognizer --batch --auth --threads " + std::to_string(threads) + " batch_graphs.bin > sp_result.txt 2>/dev/null";
+        run_command_test(name, generated ? rec_cmd : "", [&](int rec_exit_code, TestResult& result) {
+            result.generation_time = generation_time;
+            if (!generated) {
+                result.generator_success = false;
+                result.error_message = "Graph generator failed";
+                return std::string();
+            }
+            if (rec_exit_code != 0) {
+                result.error_message = "SP recognizer failed in batch mode";
+                return std::string();
+            }
+
+            std::ifstream result_file("sp_result.txt");
+            std::string line;
+            int records = 0;
+            while (std::getline(result_file, line)) {
+                std::istringstream record(line);
+                long index;
+                int n, m;
+                std::string verdict, reason, auth;
+                record >> index >> n >> m >> verdict >> reason >> auth;
+                if (index != records || records >= count || auth != "ok" || (verdict == "SP") != expected_sp[records]) {
+                    result.error_message = "Batch record " + std::to_string(records) + " disagrees with single-graph run: " + line;
+                    return std::string();
+                }
+                result.vertices += n;
+                result.edges += m;
+                records++;
+            }
+
+            if (records != count) {
+                result.error_message = "Expected " + std::to_string(count) + " batch records, got " + std::to_string(records);
+            }
+            return std::to_string(count) + " graphs, " + std::to_string(result.vertices) + "v," + std::to_string(result.edges) + "e";
+        });
+    }
+
+    // writes a binary graph file with the given CSR payload (n + 1 offsets, then 2m neighbours)
+    static bool write_csr_file(const std::string& path, uint32_t n, uint32_t m, std::vector<uint32_t> payload) {
+        graph_file_header h;
+        h.flags = graph_file_csr;
+        h.n = n;
+        h.m = m;
+        h.checksum = graph_file_checksum(payload.data(), payload.size());
+        for (uint32_t& w : payload) w = to_little_endian(w);
+        unsigned char header[graph_file_header_bytes];
+        encode_graph_file_header(h, header);
+        std::FILE * out = std::fopen(path.c_str(), "wb");
+        if (!out) return false;
+        bool ok = std::fwrite(header, 1, sizeof(header), out) == sizeof(header)
+                  && std::fwrite(payload.data(), sizeof(uint32_t), payload.size(), out) == payload.size();
+        return std::fclose(out) == 0 && ok;
+    }
+
+    // Loads binary CSR files whose rows are not symmetric, one with a row that lists a neighbour
+    // that does not list it back and one with every degree right but the arcs all one way round a
+    // triangle, and checks that both are rejected, alone and in a batch, while the triangle itself
+    // is accepted.
+    void run_csr_validation_test(const std::string& name) {
+        bool written = write_csr_file("csr_triangle.bin", 3, 3, {0, 2, 4, 6, 1, 2, 2, 0, 0, 1})
+                       && write_csr_file("csr_one_way.bin", 3, 2, {0, 2, 3, 4, 1, 2, 0, 1})
+                       && write_csr_file("csr_rotated.bin", 3, 3, {0, 2, 4, 6, 1, 1, 2, 2, 0, 0});
+
+        std::string rec_cmd = "./sp_recognizer csr_triangle.bin > sp_result.txt 2>&1 && grep -q 'authenticated successfully' sp_result.txt";
+        run_command_test(name, written ? rec_cmd : "", [&](int rec_exit_code, TestResult& result) {
+            if (!written) {
+                result.generator_success = false;
+                result.error_message = "could not write the CSR files";
+                return std::string();
+            }
+            if (rec_exit_code != 0) {
+                result.error_message = "a symmetric CSR triangle was not accepted";
+                return std::string();
+            }
+            for (const char * file : {"csr_one_way.bin", "csr_rotated.bin"}) {
+                std::string single = std::string("./sp_recognizer ") + file + " > sp_result.txt 2>&1; test $? -ne 0 && grep -q 'not symmetric' sp_result.txt";
+                std::string batch = std::string("cat csr_triangle.bin ") + file + " csr_triangle.bin > batch_csr.bin"
+                                    " && ./sp_recognizer --batch --auth batch_csr.bin > sp_result.txt 2>/dev/null;"
+                                    " grep -q '^1 ERROR .*not symmetric' sp_result.txt && grep -q '^0 3 3 SP' sp_result.txt";
+                if (system(single.c_str()) != 0 || system(batch.c_str()) != 0) {
+                    result.error_message = std::string("asymmetric CSR rows were accepted: ") + file;
+                    return std::string();
+                }
+            }
+            return std::string("3 files");
+        });
+    }
+
+    // Runs the allocation-counting build (-D__COUNT_ALLOCATIONS__) over the last batch file and
+    // graphs that take the other paths of a batch worker (disconnected, edgeless, with parallel
+    // edges, trees), all twice in a row, under every certificate policy and with each of
+    // --relabel, --compress-paths, --prefilter and --engine reduction, on one worker. Every graph
+    // the worker reads, recognizes and records without growing its workspace is counted, and none
+    // may perform a heap allocation: the CSR arrays, decomposition, certificate with its paths and
+    // record included. Some of the graphs counted must have an obstruction.
+    void run_allocation_test(const std::string& name) {
+        static const char * graphs[] = {
+            "6 6 0 1 1 2 2 0 3 4 4 5 5 3", // two triangles
+            "9 10 0 1 0 2 0 3 1 2 1 3 2 3 4 5 5 6 6 7 7 4", // a K4 and a cycle, a vertex apart
+            "8 9 0 2 0 3 0 4 1 2 1 3 1 4 5 6 6 7 7 5", // a K2,3 and a triangle
+            "1 0",
+            "5 0",
+            "4 6 0 1 0 1 1 2 1 2 2 3 3 0", // a cycle with doubled edges
+            "5 8 0 1 0 2 0 3 1 2 1 3 2 3 2 3 3 4", // a K4 with a doubled edge and a pendant
+            "7 6 0 1 0 2 1 3 1 4 2 5 2 6", // a binary tree
+            "6 5 0 1 1 2 2 3 3 4 4 5", // a path
+            "7 6 0 1 0 2 0 3 0 4 0 5 0 6", // a star
+        };
+        std::ofstream extra("allocation_graphs.txt");
+        for (const char * edges : graphs) extra << edges << "\n";
+        extra.close();
+
+        std::string cat_cmd = "cat batch_graphs.bin allocation_graphs.txt batch_graphs.bin allocation_graphs.txt > batch_twice.bin";
+        run_command_test(name, cat_cmd, [&](int cat_exit_code, TestResult& result) {
+            if (cat_exit_code != 0) {
+                result.error_message = "could not write the doubled batch file";
+                return std::string();
+            }
+            long long runs = 0;
+            long long obstruction_runs = 0;
+            for (const char * options : {"", " --relabel bfs", " --compress-paths", " --prefilter", " --engine reduction"}) {
+                for (const char * policy : {"full", "terminals", "boolean"}) {
+                    std::string rec_cmd = std::string("./sp_recognizer_alloc --batch --threads 1 --cert-policy ") + policy + options
+                                        + " batch_twice.bin > /dev/null 2> sp_result.txt";
+                    int rec_exit_code = system(rec_cmd.c_str());
+                    std::string run = std::string(policy) + options;
+
+                    // batch: <allocations> allocations after warm-up in <runs> runs, <obstruction runs> with an obstruction
+                    std::ifstream result_file("sp_result.txt");
+                    std::string line;
+                    long long allocations = -1;
+                    long long policy_runs = 0;
+                    long long policy_obstruction_runs = 0;
+                    while (std::getline(result_file, line)) {
+                        if (line.find("allocations after warm-up") == std::string::npos) continue;
+                        std::istringstream report(line.substr(line.find(':') + 1));
+                        std::string words;
+                        report >> allocations >> words >> words >> words >> words >> policy_runs >> words >> policy_obstruction_runs;
+                    }
+
+                    if (rec_exit_code != 0 || allocations < 0) {
+                        result.error_message = "allocation-counting recognizer failed (" + run + ")";
+                    } else if (allocations != 0) {
+                        result.error_message = std::to_string(allocations) + " allocations after warm-up (" + run + ")";
+                    } else if (policy_obstruction_runs == 0) {
+                        result.error_message = "no warm run with an obstruction was counted (" + run + ")";
+                    }
+                    if (!result.error_message.empty()) return std::string();
+                    runs += policy_runs;
+                    obstruction_runs += policy_obstruction_runs;
+                }
+            }
+            return "0 allocations in " + std::to_string(runs) + " warm runs, " + std::to_string(obstruction_runs) + " with an obstruction";
+        });
+    }
+
+    // Exports the certificates of the last batch file in both encodings and checks that there
+    // is one record per graph, of the kind the batch records report, and that a parallel run
+    // writes a byte-identical binary file.
+    void run_cert_export_test(const std::string& name, int threads) {
+        std::string rec_cmd = "./sp_recognizer --batch --emit-cert batch_certs.bin batch_graphs.bin > sp_result.txt 2>/dev/null"
+                              " && ./sp_recognizer --batch --emit-cert batch_certs.json --cert-format json batch_graphs.bin > /dev/null 2>&1"
+                              " && ./sp_recognizer --batch --threads " + std::to_string(threads) +
+                              " --emit-cert batch_certs_par.bin batch_graphs.bin > /dev/null 2>&1";
+        run_command_test(name, rec_cmd, [&](int rec_exit_code, TestResult& result) {
+            std::vector<std::string> expected;
+            std::vector<std::string> expected_classes; // the GSP and OP kinds
+            std::ifstream records("sp_result.txt");
+            std::string line;
+            while (std::getline(records, line)) {
+                std::istringstream record(line);
+                std::string index, n, m, verdict, reason, auth, gsp, gsp_reason, op, op_reason;
+                record >> index >> n >> m >> verdict >> reason >> auth >> gsp >> gsp_reason >> op >> op_reason;
+                expected.push_back(reason);
+                expected_classes.push_back(gsp_reason);
+                expected_classes.push_back(op_reason);
+            }
+
+            std::ifstream binary("batch_certs.bin", std::ios::binary);
+            std::string bytes((std::istreambuf_iterator<char>(binary)), std::istreambuf_iterator<char>());
+            auto load = [&](size_t pos, int width) {
+                unsigned long long x = 0;
+                for (int k = width - 1; k >= 0; k--) x = (x << 8) | (unsigned char)(bytes[pos + k]);
+                return x;
+            };
+            std::vector<std::string> binary_kinds;
+            std::vector<std::string> binary_classes;
+            for (size_t pos = 0; pos + 32 <= bytes.size() && bytes.compare(pos, 4, "GSPC") == 0;) {
+                unsigned long long kind = load(pos + 6, 2);
+                bool first = ((load(pos + 8, 4) >> cert_file_class_shift) & 3) == cert_class_sp;
+                (first ? binary_kinds : binary_classes).push_back(kind < cert_kinds ? cert_kind_names[kind] : "?");
+                pos += 32 + 4 * load(pos + 16, 8);
+            }
+
+            std::ifstream json("batch_certs.json");
+            std::vector<std::string> json_kinds;
+            while (std::getline(json, line)) {
+                size_t at = line.find("\"kind\":\"");
+                json_kinds.push_back(at == std::string::npos ? "?" : line.substr(at + 8, line.find('"', at + 8) - (at + 8)));
+            }
+
+            if (rec_exit_code != 0 || expected.empty()) {
+                result.error_message = "SP recognizer failed to export certificates";
+            } else if (binary_kinds != expected || binary_classes != expected_classes) {
+                result.error_message = "binary certificates disagree with the batch records";
+            } else if (json_kinds != expected) {
+                result.error_message = "JSON certificates disagree with the batch records";
+            } else if (system("cmp -s batch_certs.bin batch_certs_par.bin") != 0) {
+                result.error_message = "parallel export differs from the single-threaded one";
+            } else if (system("printf '3 5 0 1\\n' > cert_bad_graph.txt && ! ./sp_recognizer --emit-cert batch_certs_par.bin cert_bad_graph.txt > /dev/null 2>&1"
+                              " && cmp -s batch_certs.bin batch_certs_par.bin") != 0) {
+                result.error_message = "a graph that fails to parse truncated the certificate file";
+            }
+            return std::to_string(expected.size()) + " certificates";
+        });
+    }
+
+    // Recognizes the last batch file under each --cert-policy and checks that a terminals run
+    // writes the same records as a full one, and a boolean run the same records with the
+    // certificate kinds left out.
+    void run_cert_policy_test(const std::string& name) {
+        std::string rec_cmd = "./sp_recognizer --batch --cert-policy full batch_graphs.bin > sp_result.txt 2>/dev/null"
+                              " && ./sp_recognizer --batch --cert-policy terminals batch_graphs.bin > sp_result_terminals.txt 2>/dev/null"
+                              " && ./sp_recognizer --batch --cert-policy boolean batch_graphs.bin > sp_result_boolean.txt 2>/dev/null";
+        run_command_test(name, rec_cmd, [&](int rec_exit_code, TestResult& result) {
+            auto read_lines = [](const char * path) {
+                std::ifstream in(path);
+                std::vector<std::string> lines;
+                for (std::string line; std::getline(in, line);) lines.push_back(line);
+                return lines;
+            };
+            std::vector<std::string> full = read_lines("sp_result.txt");
+            std::vector<std::string> terminals = read_lines("sp_result_terminals.txt");
+            std::vector<std::string> boolean = read_lines("sp_result_boolean.txt");
+
+            bool same = (boolean.size() == full.size());
+            for (size_t i = 0; same && i < full.size(); i++) {
+                std::istringstream record(full[i]);
+                std::string index, n, m, verdict, reason, auth, gsp, gsp_reason, op;
+                record >> index >> n >> m >> verdict >> reason >> auth >> gsp >> gsp_reason >> op;
+                same = (boolean[i] == index + " " + n + " " + m + " " + verdict + " - - " + gsp + " - " + op + " -");
+            }
+
+            if (rec_exit_code != 0 || full.empty()) {
+                result.error_message = "SP recognizer failed under a certificate policy";
+            } else if (terminals != full) {
+                result.error_message = "terminals policy disagrees with full certificates";
+            } else if (!same) {
+                result.error_message = "boolean policy disagrees with full certificates";
+            }
+            return std::to_string(full.size()) + " graphs, 3 policies";
+        });
+    }
+
+    // Recognizes a stream of small graphs whose SP, GSP and outerplanar memberships are known,
+    // with authentication, and checks the three verdicts of every record.
+    void run_class_test(const std::string& name) {
+        struct known_graph {
+            const char * edges;
+            const char * verdicts;
+        };
+        static const known_graph graphs[] = {
+            {"4 6 0 1 0 2 0 3 1 2 1 3 2 3", "NONSP NONGSP NONOP"}, // K4
+            {"5 6 0 2 2 1 0 3 3 1 0 4 4 1", "SP GSP NONOP"}, // K23
+            {"4 5 0 1 1 2 2 3 3 0 0 2", "SP GSP OP"}, // square with a chord
+            {"7 9 0 1 1 2 2 0 0 3 3 4 4 0 0 5 5 6 6 0", "NONSP GSP OP"}, // three triangles at one vertex
+            {"6 7 0 2 0 3 1 2 1 3 2 3 0 4 1 5", "NONSP GSP OP"}, // K4 minus an edge, with pendants at its ends
+            {"9 14 0 1 0 2 0 3 1 2 1 3 2 3 3 4 4 6 4 7 6 5 7 5 4 8 8 5 5 0", "NONSP NONGSP NONOP"}, // K4 and K23
+            // chained bicomps whose K4 runs through the virtual edge inside one of its paths
+            {"10 13 3 1 2 7 1 0 2 3 7 0 4 6 2 1 7 8 9 8 3 5 2 4 0 4 2 6", "NONSP GSP NONOP"},
+            {"9 12 3 0 3 4 3 5 2 1 5 1 4 6 4 0 3 6 3 2 2 7 4 8 5 6", "NONSP GSP OP"},
+            {"14 19 5 11 3 8 5 3 4 12 10 11 6 2 0 8 3 0 5 1 12 9 2 5 4 9 4 6 12 13 4 1 2 11 7 12 4 7 6 10", "NONSP NONGSP NONOP"},
+            // a K4 of a chained bicomp next to a K23 through its virtual edge
+            {"13 21 5 12 8 12 7 4 3 9 10 11 1 8 8 9 5 3 7 5 0 7 10 5 0 6 8 2 8 6 10 1 6 12 0 10 5 1 0 2 7 6 5 9", "NONSP NONGSP NONOP"},
+            // outer cycles around an isolated vertex and a doubled edge
+            {"4 3 0 1 1 2 2 0", "NONSP GSP OP"},
+            {"3 4 0 1 1 2 2 0 0 1", "SP GSP OP"},
+            // graphs that are not connected are not SP, and GSP or outerplanar when all their
+            // components are
+            {"7 9 0 1 1 2 2 0 3 4 3 5 3 6 4 5 4 6 5 6", "NONSP NONGSP NONOP"}, // a triangle and a K4
+            {"12 10 9 10 10 11 11 9 0 2 0 3 1 2 1 3 2 3 0 4 1 5", "NONSP GSP OP"}, // a triangle and a T4
+            {"8 7 0 2 2 4 4 0 1 3 3 5 5 7 7 1", "NONSP GSP OP"}, // a triangle and a square
+            {"1 0", "SP GSP OP"},
+            {"3 0", "NONSP GSP OP"},
+        };
+
+        std::ofstream out("class_graphs.txt");
+        for (const known_graph& graph : graphs) out << graph.edges << "\n";
+        out.close();
+
+        run_command_test(name, "./sp_recognizer --batch --auth class_graphs.txt > sp_result.txt 2>/dev/null", [&](int rec_exit_code, TestResult& result) {
+            if (rec_exit_code != 0) {
+                result.error_message = "SP recognizer failed on the classification graphs";
+                return std::string();
+            }
+
+            std::ifstream records("sp_result.txt");
+            std::string line;
+            size_t count = 0;
+            while (std::getline(records, line)) {
+                std::istringstream record(line);
+                std::string index, n, m, verdict, reason, auth, gsp, gsp_reason, op, op_reason;
+                record >> index >> n >> m >> verdict >> reason >> auth >> gsp >> gsp_reason >> op >> op_reason;
+                if (count >= std::size(graphs) || auth != "ok" || verdict + " " + gsp + " " + op != graphs[count].verdicts
+                    || (op == "OP") != (op_reason == "OP")) {
+                    result.error_message = "unexpected classification: " + line;
+                    return std::string();
+                }
+                count++;
+            }
+
+            if (count != std::size(graphs)) {
+                result.error_message = "Expected " + std::to_string(std::size(graphs)) + " records, got " + std::to_string(count);
+            }
+            return std::to_string(count) + " graphs, 3 classes";
+        });
+    }
+
+    // Recognizes graphs with parallel edges, one at a time and as a batch, and requires their
+    // certificates, lifted from the simple graph under them, to authenticate; graphs with a
+    // self-loop must be rejected with an error, alone and as one record of a batch.
+    void run_multigraph_test(const std::string& name) {
+        static const char * multigraphs[] = {
+            "4 5 1 3 0 3 0 2 3 1 2 1",
+            "4 5 0 3 1 0 2 3 2 3 0 2",
+            "5 6 2 3 3 1 4 1 2 1 1 3 2 0",
+            "4 4 1 0 2 3 0 2 3 2",
+            "6 9 4 5 5 3 1 5 2 4 1 3 2 5 5 0 5 0 4 1",
+            "5 8 0 1 0 2 0 3 1 2 1 3 2 3 2 3 3 4", // a K4 with a doubled edge and a pendant
+            "6 5 0 1 0 1 2 3 4 5 4 5", // doubled edges in three components
+        };
+        static const char * looped[] = {"1 1 0 0", "3 4 0 1 1 2 2 0 1 1"};
+
+        std::ofstream batch("multigraph_batch.txt");
+        for (const char * edges : multigraphs) batch << edges << "\n";
+        for (const char * edges : looped) batch << edges << "\n";
+        batch.close();
+
+        run_command_test(name, "./sp_recognizer --batch --auth multigraph_batch.txt > sp_result.txt 2>/dev/null", [&](int, TestResult& result) {
+            std::ifstream records("sp_result.txt");
+            std::string line;
+            size_t count = 0;
+            while (std::getline(records, line)) {
+                std::istringstream record(line);
+                std::string index, n, m, verdict, reason, auth;
+                record >> index >> n >> m >> verdict >> reason >> auth;
+                bool loop = (count >= std::size(multigraphs));
+                if (loop ? n != "ERROR" : auth != "ok") {
+                    result.error_message = "unexpected batch record: " + line;
+                    return std::string();
+                }
+                count++;
+            }
+            if (count != std::size(multigraphs) + std::size(looped)) {
+                result.error_message = "Expected " + std::to_string(std::size(multigraphs) + std::size(looped)) + " records, got " + std::to_string(count);
+                return std::string();
+            }
+
+            for (const char * edges : multigraphs) {
+                std::ofstream("multigraph.txt") << edges << "\n";
+                if (system("./sp_recognizer --threads 2 multigraph.txt > sp_result.txt 2>&1 && grep -q 'authenticated successfully' sp_result.txt") != 0) {
+                    result.error_message = std::string("multigraph not authenticated: ") + edges;
+                    return std::string();
+                }
+            }
+            for (const char * edges : looped) {
+                std::ofstream("multigraph.txt") << edges << "\n";
+                if (system("./sp_recognizer multigraph.txt > sp_result.txt 2>&1; test $? -ne 0 && grep -q 'self-loop' sp_result.txt") != 0) {
+                    result.error_message = std::string("self-loop not rejected: ") + edges;
+                    return std::string();
+                }
+            }
+            return std::to_string(std::size(multigraphs)) + " multigraphs, " + std::to_string(std::size(looped)) + " with loops";
+        });
+    }
+
+    // graphs of several bicomps, as shell commands that print them
+    static std::vector<std::string> block_test_commands() {
+        std::vector<std::string> commands = {
+            "echo 7 9 0 1 1 2 2 0 2 3 3 4 4 2 4 5 5 6 6 4", // three triangles in a chain
+            "echo 9 12 0 1 1 2 2 0 2 3 3 5 2 4 4 5 2 6 6 5 5 7 7 8 8 5", // a K23 between two triangles
+            "echo 6 7 0 2 0 3 1 2 1 3 2 3 0 4 1 5", // a T4 through the virtual edge
+            "echo 10 16 0 1 0 2 0 3 1 2 1 3 2 3 3 4 4 5 5 3 5 6 6 7 7 8 8 5 6 9 9 7 6 8", // K4s at both ends
+            "echo 10 13 3 1 2 7 1 0 2 3 7 0 4 6 2 1 7 8 9 8 3 5 2 4 0 4 2 6", // a K4 path through the virtual edge
+        };
+        for (int seed = 0; seed < 4; seed++) {
+            commands.push_back("./graph_generator " + std::to_string(8 + seed) + " 5 " + std::to_string(seed % 3) + " 4 0 " + std::to_string(12500 + seed));
+        }
+        return commands;
+    }
+
+    // Recognizes graphs of several bicomps (small chains that are SP, hold a K23, a T4 or K4s,
+    // and generated graphs) with --threads 1 and with their bicomps on a pool of 4 threads, and checks
+    // that the output, certificate file included, is the same byte for byte.
+    void run_block_pool_test(const std::string& name) {
+        std::vector<std::string> commands = block_test_commands();
+        run_command_test(name, "", [&](int, TestResult& result) {
+            for (const std::string& command : commands) {
+                std::string run = command + " > block_graph.txt"
+                                  " && ./sp_recognizer --threads 1 --emit-cert block_graph.cert block_graph.txt > sp_result.txt 2>&1"
+                                  " && mv block_graph.cert block_graph_seq.cert"
+                                  " && ./sp_recognizer --threads 4 --emit-cert block_graph.cert block_graph.txt > sp_result_pool.txt 2>&1";
+                if (system(run.c_str()) != 0) {
+                    result.error_message = "SP recognizer failed on: " + command;
+                    return std::string();
+                }
+                if (system("cmp -s sp_result.txt sp_result_pool.txt && cmp -s block_graph_seq.cert block_graph.cert") != 0) {
+                    result.error_message = "pooled bicomps differ from the sequential run on: " + command;
+                    return std::string();
+                }
+            }
+            return std::to_string(commands.size()) + " graphs";
+        });
+    }
+
+    // Finds the bicomps of the same graphs with the parallel engine (--bicomps parallel) on 1 and
+    // 4 threads. Its spanning tree differs from the DFS tree, so only the verdicts must match the
+    // DFS engine, but its own output and certificate must not depend on the number of threads.
+    void run_parallel_bicomps_test(const std::string& name) {
+        std::vector<std::string> commands = block_test_commands();
+        run_command_test(name, "", [&](int, TestResult& result) {
+            for (const std::string& command : commands) {
+                std::string run = command + " > block_graph.txt"
+                                  " && ./sp_recognizer block_graph.txt > sp_result.txt 2>&1"
+                                  " && ./sp_recognizer --bicomps parallel --threads 1 --emit-cert block_graph.cert block_graph.txt > sp_result_pool.txt 2>&1"
+                                  " && mv block_graph.cert block_graph_seq.cert"
+                                  " && ./sp_recognizer --bicomps parallel --threads 4 --emit-cert block_graph.cert block_graph.txt > sp_result_parallel.txt 2>&1";
+                if (system(run.c_str()) != 0) {
+                    result.error_message = "SP recognizer failed on: " + command;
+                } else if (system("cmp -s sp_result_pool.txt sp_result_parallel.txt && cmp -s block_graph_seq.cert block_graph.cert") != 0) {
+                    result.error_message = "parallel bicomps depend on the number of threads on: " + command;
+                } else if (system("grep '^The graph' sp_result.txt > verdicts_dfs.txt && grep '^The graph' sp_result_pool.txt > verdicts_parallel.txt"
+                                  " && cmp -s verdicts_dfs.txt verdicts_parallel.txt") != 0) {
+                    result.error_message = "parallel bicomps change the verdict on: " + command;
+                } else if (system("grep -q 'authenticated successfully' sp_result.txt && grep -q 'authenticated successfully' sp_result_pool.txt") != 0) {
+                    result.error_message = "certificate of the parallel bicomps fails authentication on: " + command;
+                }
+                if (!result.error_message.empty()) return std::string();
+            }
+            return std::to_string(commands.size()) + " graphs";
+        });
+    }
+
+    // Recognizes single bicomps with the parallel ear engine (--engine ears) on 1 and 4 threads:
+    // SP and outerplanar blocks, K4s found by crossing ears and by an ear leaving its host, a
+    // graph whose ears are not nested and go back to the DFS, and generated blocks. The verdicts
+    // must match the DFS engine, and the output and certificate must not depend on the number of
+    // threads.
+    void run_ear_engine_test(const std::string& name) {
+        std::vector<std::string> commands = {
+            "echo 4 6 0 1 0 2 0 3 1 2 1 3 2 3", // K4
+            "echo 5 6 0 2 0 3 0 4 1 2 1 3 1 4", // K23
+            "echo 6 9 0 1 1 2 2 3 3 4 4 5 5 0 0 2 0 3 0 4", // a fan
+            "echo 6 9 0 1 1 2 2 3 3 4 4 5 5 0 0 3 1 4 2 5", // K33, crossing chords
+            "echo 8 11 0 1 1 2 2 3 3 4 4 5 5 6 6 7 7 0 0 4 1 3 5 7", // nested chords
+            "echo 7 12 2 5 2 4 1 6 2 1 1 3 2 0 4 0 3 6 2 6 4 1 6 4 5 1", // ears not nested
+            "./graph_generator 1 30 0 3 0 7",
+            "./graph_generator 1 40 1 3 0 8",
+            "./graph_generator 1 3 1 10 0 12360",
+        };
+
+        run_command_test(name, "", [&](int, TestResult& result) {
+            for (const std::string& command : commands) {
+                std::string run = command + " > block_graph.txt"
+                                  " && ./sp_recognizer block_graph.txt > sp_result.txt 2>&1"
+                                  " && ./sp_recognizer --engine ears --threads 1 --emit-cert block_graph.cert block_graph.txt > sp_result_pool.txt 2>&1"
+                                  " && mv block_graph.cert block_graph_seq.cert"
+                                  " && ./sp_recognizer --engine ears --threads 4 --emit-cert block_graph.cert block_graph.txt > sp_result_parallel.txt 2>&1";
+                if (system(run.c_str()) != 0) {
+                    result.error_message = "SP recognizer failed on: " + command;
+                } else if (system("cmp -s sp_result_pool.txt sp_result_parallel.txt && cmp -s block_graph_seq.cert block_graph.cert") != 0) {
+                    result.error_message = "the ear engine depends on the number of threads on: " + command;
+                } else if (!same_verdicts("sp_result.txt", "sp_result_pool.txt")) {
+                    result.error_message = "the ear engine changes the verdict on: " + command;
+                }
+                if (!result.error_message.empty()) return std::string();
+            }
+            return std::to_string(commands.size()) + " graphs";
+        });
+    }
+
+    // Recognizes the stream block_batch.txt as a batch with --auth, as it is and with flags, and
+    // checks that every record authenticates and keeps its verdicts.
+    static bool batch_keeps_verdicts(const std::string& flags) {
+        std::string run = "./sp_recognizer --batch --auth block_batch.txt > sp_result.txt 2>/dev/null"
+                          " && ./sp_recognizer --batch --auth " + flags + " block_batch.txt > sp_result_pool.txt 2>/dev/null"
+                          " && awk '{print $1, $2, $3, $4, $6, $7, $9}' sp_result.txt > verdicts_dfs.txt"
+                          " && awk '{print $1, $2, $3, $4, $6, $7, $9}' sp_result_pool.txt > verdicts_parallel.txt"
+                          " && test -s verdicts_dfs.txt && cmp -s verdicts_dfs.txt verdicts_parallel.txt";
+        return system(run.c_str()) == 0;
+    }
+
+    // Recognizes graphs with long degree-2 paths through their kernel (--compress-paths): one
+    // cycle, a path, a spider, a K23 with long sides, a cycle with chords, two cycles apart, and
+    // the graphs of several bicomps. The verdicts must match the graph recognized as it is, and
+    // the lifted certificates, outer embedding included, must authenticate against the graph,
+    // one graph at a time and all of them as a batch.
+    void run_compress_test(const std::string& name) {
+        std::vector<std::string> commands = {
+            "echo 6 6 0 1 1 2 2 3 3 4 4 5 5 0", // a cycle
+            "echo 5 4 0 1 1 2 2 3 3 4", // a path
+            "echo 8 7 0 1 1 2 2 3 0 4 4 5 0 6 6 7", // a spider
+            "echo 12 15 0 2 2 3 3 1 0 4 4 5 5 1 0 6 6 7 7 1 0 8 8 9 9 1 1 10 10 11 11 1", // a K23 with long sides
+            "echo 12 14 0 1 1 2 2 3 3 4 4 5 5 6 6 7 7 8 8 9 9 10 10 11 11 0 0 6 1 5", // nested chords of a long cycle
+            "echo 10 10 0 1 1 2 2 3 3 0 4 5 5 6 6 7 7 8 8 9 9 4", // two cycles apart
+            "./graph_generator 3 12 1 4 0 12600",
+        };
+        for (const std::string& command : block_test_commands()) commands.push_back(command);
+
+        run_command_test(name, "rm -f block_batch.txt", [&](int, TestResult& result) {
+            for (const std::string& command : commands) {
+                std::string run = command + " > block_graph.txt && cat block_graph.txt >> block_batch.txt"
+                                  " && ./sp_recognizer block_graph.txt > sp_result.txt 2>&1"
+                                  " && ./sp_recognizer --compress-paths --embedding block_graph.txt > sp_result_pool.txt 2>&1";
+                if (system(run.c_str()) != 0) {
+                    result.error_message = "SP recognizer failed on: " + command;
+                } else if (!same_verdicts("sp_result.txt", "sp_result_pool.txt")) {
+                    result.error_message = "the kernel changes the verdict on: " + command;
+                }
+                if (!result.error_message.empty()) return std::string();
+            }
+            if (!batch_keeps_verdicts("--compress-paths")) {
+                result.error_message = "the kernel changes a verdict of the batch";
+            } else if (system("echo 6 6 0 1 1 2 2 3 3 4 4 5 5 0 | ./sp_recognizer --compress-paths"
+                              " | grep -q 'kernel of 3 vertices and 3 edges'") != 0) {
+                result.error_message = "a cycle was not compressed to a triangle";
+            }
+            return std::to_string(commands.size()) + " graphs";
+        });
+    }
+
+    // Runs the pre-filter (--prefilter) ahead of recognition: a K5 over the edge bound, a K5 with
+    // a tail and two K5s joined by a path, a wheel, which like the K5 is its own 3-core, a graph
+    // whose K4 is not on the tree path to the first leaf of the core and so comes from its leaf
+    // block, a chorded square with a doubled chord, over the edge bound only by its parallel edge,
+    // and the graphs of several bicomps. The verdicts must match the run without, under every
+    // policy, the certificates must authenticate, and the filter must say which test rejected.
+    // A batch must count each graph once, however many components and kernels it is run as.
+    void run_prefilter_test(const std::string& name) {
+        std::vector<std::string> commands = {
+            "echo 5 10 0 1 0 2 0 3 0 4 1 2 1 3 1 4 2 3 2 4 3 4", // K5
+            "echo 8 13 0 1 0 2 0 3 0 4 1 2 1 3 1 4 2 3 2 4 3 4 4 5 5 6 6 7", // K5 with a tail
+            "echo 12 23 0 1 0 2 0 3 0 4 1 2 1 3 1 4 2 3 2 4 3 4 4 10 10 11 11 5 5 6 5 7 5 8 5 9 6 7 6 8 6 9 7 8 7 9 8 9", // two K5s and a path
+            "echo 7 12 0 1 0 2 0 3 0 4 0 5 0 6 1 2 2 3 3 4 4 5 5 6 6 1", // a wheel
+            "echo 6 10 0 1 2 4 1 2 0 4 0 3 1 4 2 3 0 5 2 5 1 3", // a K4 off the path to the first leaf
+            "echo 4 6 0 1 1 2 2 3 3 0 0 2 0 2", // a doubled chord
+            "./graph_generator 0 3 4 5 0 12700",
+        };
+        for (const std::string& command : block_test_commands()) commands.push_back(command);
+
+        run_command_test(name, "", [&](int, TestResult& result) {
+            for (const std::string& command : commands) {
+                for (const char * policy : {"full", "terminals", "boolean"}) {
+                    std::string run = command + " > block_graph.txt"
+                                      " && ./sp_recognizer --cert-policy " + policy + " block_graph.txt > sp_result.txt 2>&1"
+                                      " && ./sp_recognizer --prefilter --cert-policy " + policy + " block_graph.txt > sp_result_pool.txt 2>&1";
+                    if (system(run.c_str()) != 0) {
+                        result.error_message = "SP recognizer failed on: " + command;
+                    } else if (!same_verdicts("sp_result.txt", "sp_result_pool.txt")) {
+                        result.error_message = "the pre-filter changes the verdict on: " + command + " (" + policy + ")";
+                    }
+                    if (!result.error_message.empty()) return std::string();
+                }
+            }
+            if (system("echo 5 10 0 1 0 2 0 3 0 4 1 2 1 3 1 4 2 3 2 4 3 4 | ./sp_recognizer --prefilter | grep -q 'more than 2n - 3 edges'") != 0
+                || system("echo 8 13 0 1 0 2 0 3 0 4 1 2 1 3 1 4 2 3 2 4 3 4 4 5 5 6 6 7 | ./sp_recognizer --prefilter | grep -q '3-core is not empty'") != 0
+                || system("echo 6 6 0 1 1 2 2 3 3 4 4 5 5 0 | ./sp_recognizer --prefilter | grep -q 'Pre-filter: passed'") != 0
+                || system("echo 4 6 0 1 1 2 2 3 3 0 0 2 0 2 | ./sp_recognizer --prefilter --cert-policy boolean | grep -q 'Pre-filter: passed'") != 0) {
+                result.error_message = "the pre-filter did not report the test that rejected";
+            } else if (system("printf '5 10 0 1 0 2 0 3 0 4 1 2 1 3 1 4 2 3 2 4 3 4\\n"
+                              "10 20 0 1 0 2 0 3 0 4 1 2 1 3 1 4 2 3 2 4 3 4 5 6 5 7 5 8 5 9 6 7 6 8 6 9 7 8 7 9 8 9\\n"
+                              "6 6 0 1 1 2 2 3 3 4 4 5 5 0\\n' > block_batch.txt"
+                              " && ./sp_recognizer --batch --prefilter --compress-paths block_batch.txt 2>&1 >/dev/null"
+                              " | grep -q 'rejected 2 of 3 graphs, 2 by the edge bound, 0 by the 3-core'") != 0) {
+                result.error_message = "the pre-filter did not count each graph of a batch once";
+            }
+            return std::to_string(commands.size()) + " graphs";
+        });
+    }
+
+    // Recognizes graphs by series and parallel reductions (--engine reduction): a cycle, a path, a
+    // chorded square with a pendant, K23 and a K23 of long sides, a pinned parallel closing a K23
+    // through a cycle, K4 and a K4 subdivision left to the DFS, and the graphs of several bicomps.
+    // The verdicts must match the DFS engine under the full and the boolean policy, the
+    // certificates, outer embedding included, must authenticate, and --differential must agree;
+    // all of them as a batch must keep the verdicts of the DFS engine.
+    void run_reduction_engine_test(const std::string& name) {
+        std::vector<std::string> commands = {
+            "echo 6 6 0 1 1 2 2 3 3 4 4 5 5 0", // a cycle
+            "echo 5 4 0 1 1 2 2 3 3 4", // a path
+            "echo 5 6 0 1 1 2 2 3 3 0 0 2 2 4", // a chorded square with a pendant
+            "echo 5 6 0 2 0 3 0 4 1 2 1 3 1 4", // K23
+            "echo 12 15 0 2 2 3 3 1 0 4 4 5 5 1 0 6 6 7 7 1 0 8 8 9 9 1 1 10 10 11 11 1", // a K23 with long sides
+            "echo 6 7 0 2 2 1 0 3 3 1 1 4 0 5 5 4", // a K23 through a pinned parallel
+            "echo 4 6 0 1 0 2 0 3 1 2 1 3 2 3", // K4
+            "echo 5 7 0 1 1 2 2 3 3 0 0 4 4 2 1 3", // a K4 subdivision
+            "./graph_generator 1 40 0 3 0 12800",
+            "./graph_generator 2 9 0 3 1 12801",
+        };
+        for (const std::string& command : block_test_commands()) commands.push_back(command);
+
+        run_command_test(name, "rm -f block_batch.txt", [&](int, TestResult& result) {
+            for (const std::string& command : commands) {
+                for (const char * policy : {"full", "boolean"}) {
+                    bool full = (std::string(policy) == "full");
+                    std::string run = command + " > block_graph.txt" + (full ? " && cat block_graph.txt >> block_batch.txt" : "") +
+                                      " && ./sp_recognizer --cert-policy " + policy + " block_graph.txt > sp_result.txt 2>&1"
+                                      " && ./sp_recognizer --engine reduction --differential --cert-policy " + policy + (full ? " --embedding" : "") +
+                                      " block_graph.txt > sp_result_pool.txt 2>&1";
+                    if (system(run.c_str()) != 0) {
+                        result.error_message = "SP recognizer failed on: " + command + " (" + policy + ")";
+                    } else if (!same_verdicts("sp_result.txt", "sp_result_pool.txt")
+                               || system("grep -q 'agrees with the DFS engine' sp_result_pool.txt") != 0) {
+                        result.error_message = "the reduction engine changes the verdict on: " + command + " (" + policy + ")";
+                    }
+                    if (!result.error_message.empty()) return std::string();
+                }
+            }
+            if (!batch_keeps_verdicts("--engine reduction")) {
+                result.error_message = "the reduction engine changes a verdict of the batch";
+            }
+            return std::to_string(commands.size()) + " graphs";
+        });
+    }
+
+    // Recognizes graphs relabeled in BFS, reverse Cuthill-McKee and DFS preorder (--relabel): K4,
+    // K23, a wheel, a cycle with nested chords, generated graphs and the graphs of several bicomps,
+    // also through their kernel with --compress-paths. The verdicts must match the graph
+    // recognized as it is, and the certificates, mapped back to its labels with the outer
+    // embedding, must authenticate against it, one graph at a time and all of them as a batch.
+    void run_relabel_test(const std::string& name) {
+        std::vector<std::string> commands = {
+            "echo 4 6 0 1 0 2 0 3 1 2 1 3 2 3", // K4
+            "echo 5 6 0 2 0 3 0 4 1 2 1 3 1 4", // K23
+            "echo 7 12 0 1 0 2 0 3 0 4 0 5 0 6 1 2 2 3 3 4 4 5 5 6 6 1", // a wheel
+            "echo 6 10 0 1 2 4 1 2 0 4 0 3 1 4 2 3 0 5 2 5 1 3", // a K4 off the path to the first leaf
+            "echo 8 11 0 1 1 2 2 3 3 4 4 5 5 6 6 7 7 0 0 4 1 3 5 7", // nested chords
+            "./graph_generator 1 40 0 3 0 12900",
+            "./graph_generator 6 7 1 4 0 12901",
+        };
+        for (const std::string& command : block_test_commands()) commands.push_back(command);
+
+        run_command_test(name, "rm -f block_batch.txt", [&](int, TestResult& result) {
+            for (const std::string& command : commands) {
+                if (system((command + " >> block_batch.txt").c_str()) != 0) {
+                    result.error_message = "SP recognizer failed on: " + command;
+                    return std::string();
+                }
+                for (const char * order : {"bfs", "rcm", "dfs"}) {
+                    std::string run = command + " > block_graph.txt"
+                                      " && ./sp_recognizer block_graph.txt > sp_result.txt 2>&1"
+                                      " && ./sp_recognizer --relabel " + order + " --embedding block_graph.txt > sp_result_pool.txt 2>&1"
+                                      " && ./sp_recognizer --relabel " + order + " --compress-paths --embedding block_graph.txt > sp_result_parallel.txt 2>&1";
+                    if (system(run.c_str()) != 0) {
+                        result.error_message = "SP recognizer failed on: " + command + " (" + order + ")";
+                    } else if (!same_verdicts("sp_result.txt", "sp_result_pool.txt") || !same_verdicts("sp_result.txt", "sp_result_parallel.txt")
+                               || system("grep -q 'Relabeled vertices in' sp_result_pool.txt") != 0) {
+                        result.error_message = "relabeling changes the verdict on: " + command + " (" + order + ")";
+                    }
+                    if (!result.error_message.empty()) return std::string();
+                }
+            }
+            for (const char * order : {"bfs", "rcm", "dfs"}) {
+                if (!batch_keeps_verdicts(std::string("--relabel ") + order + " --compress-paths")) {
+                    result.error_message = std::string("relabeling changes a verdict of the batch (") + order + ")";
+                    return std::string();
+                }
+            }
+            return std::to_string(commands.size()) + " graphs, 3 orders";
+        });
+    }
+
+    // Packs the same graphs into one vertex space, an isolated vertex after each, and checks
+    // that the disconnected graph is recognized component by component: one record per graph,
+    // with the verdicts of the graph on its own and its first vertex, the same output and
+    // certificate on 1 and 4 threads, and a certificate of the whole graph that the verifier
+    // accepts against the input file, as it must the DISC refutation of a graph of SP components.
+    void run_components_test(const std::string& name) {
+        std::vector<std::string> commands = block_test_commands();
+        std::vector<std::string> verdicts; // "<SP|NONSP> <GSP|NONGSP> <OP|NONOP>" of every graph
+        std::vector<int> first_vertex;
+        std::vector<std::pair<int, int>> edges;
+        int vertices = 0;
+        std::string failed_command;
+        // the verdicts a single-graph run printed to sp_result.txt
+        auto read_verdicts = [] {
+            std::ifstream lines("sp_result.txt");
+            std::string line, verdict;
+            while (std::getline(lines, line)) {
+                if (line.rfind("The graph IS Series", 0) == 0) verdict += "SP";
+                else if (line.rfind("The graph is NOT Series", 0) == 0) verdict += "NONSP";
+                else if (line.rfind("The graph IS Generalized", 0) == 0) verdict += " GSP";
+                else if (line.rfind("The graph is NOT Generalized", 0) == 0) verdict += " NONGSP";
+                else if (line.rfind("The graph IS Outerplanar", 0) == 0) verdict += " OP";
+                else if (line.rfind("The graph is NOT Outerplanar", 0) == 0) verdict += " NONOP";
+            }
+            return verdict;
+        };
+        // the graph is not SP, and GSP or outerplanar when every component is
+        bool whole[3] = {false, true, true};
+        for (const std::string& command : commands) {
+            std::string run = command + " > block_graph.txt && ./sp_recognizer block_graph.txt > sp_result.txt 2>&1";
+            if (system(run.c_str()) != 0) {
+                failed_command = command;
+                break;
+            }
+            std::ifstream graph_file("block_graph.txt");
+            int n = 0, m = 0, u, v;
+            graph_file >> n >> m;
+            for (int i = 0; i < m && graph_file >> u >> v; i++) edges.emplace_back(vertices + u, vertices + v);
+            first_vertex.push_back(vertices);
+            vertices += n + 1;
+
+            verdicts.push_back(read_verdicts());
+            std::istringstream classes(verdicts.back());
+            std::string verdict;
+            for (int k = 0; k < 3 && classes >> verdict; k++) whole[k] = whole[k] && verdict.rfind("NON", 0) != 0;
+        }
+        std::string whole_verdict = std::string(whole[0] ? "SP" : "NONSP") + (whole[1] ? " GSP" : " NONGSP") + (whole[2] ? " OP" : " NONOP");
+
+        std::ofstream out("components_graph.txt");
+        out << vertices << " " << edges.size() << "\n";
+        for (auto [u, v] : edges) out << u << " " << v << "\n";
+        out.close();
+
+        std::string rec_cmd = "./sp_recognizer --threads 1 --emit-cert components.cert --emit-components components.txt components_graph.txt > sp_result.txt 2>&1"
+                              " && mv components.cert components_seq.cert"
+                              " && ./sp_recognizer --threads 4 --emit-cert components.cert components_graph.txt > sp_result_pool.txt 2>&1";
+        run_command_test(name, failed_command.empty() ? rec_cmd : "", [&](int rec_exit_code, TestResult& result) {
+            result.vertices = vertices;
+            result.edges = (int)(edges.size());
+            if (!failed_command.empty()) {
+                result.error_message = "SP recognizer failed on: " + failed_command;
+                return std::string();
+            }
+
+            int records = 0;
+            std::ifstream lines("sp_result.txt");
+            std::string line;
+            bool in_records = false;
+            while (std::getline(lines, line)) {
+                if (line == "=== Per-Component Results ===") {
+                    in_records = true;
+                    continue;
+                }
+                if (line.empty()) in_records = false;
+                if (!in_records) continue;
+
+                std::istringstream record(line);
+                std::string index, n, m, sp, sp_kind, auth, gsp, gsp_kind, op, op_kind;
+                int first = -1;
+                record >> index >> n >> m >> sp >> sp_kind >> auth >> gsp >> gsp_kind >> op >> op_kind >> first;
+                if (records >= (int)(verdicts.size()) || index != std::to_string(records) || auth != "ok"
+                    || sp + " " + gsp + " " + op != verdicts[records] || first != first_vertex[records]) {
+                    result.error_message = "unexpected component record: " + line;
+                    return std::string();
+                }
+                records++;
+            }
+
+            if (rec_exit_code != 0) {
+                result.error_message = "SP recognizer failed on the disconnected graph";
+            } else if (read_verdicts() != whole_verdict || system("grep -q '^Certificate authenticated successfully' sp_result.txt") != 0) {
+                result.error_message = "the verdicts of the whole graph are not " + whole_verdict + ", authenticated";
+            } else if (records != (int)(commands.size())) {
+                result.error_message = "Expected " + std::to_string(commands.size()) + " component records, got " + std::to_string(records);
+            } else if (system("cmp -s sp_result.txt sp_result_pool.txt && cmp -s components_seq.cert components.cert") != 0) {
+                result.error_message = "components on 4 threads differ from the sequential run";
+            } else if (system("test -f ./sp_verify") == 0
+                       && (system("./sp_verify components_graph.txt components.cert > /dev/null 2>&1") != 0
+                           || system("echo 8 5 0 1 1 2 2 0 4 5 5 6 > block_graph.txt && ./sp_recognizer --emit-cert components.cert block_graph.txt > /dev/null 2>&1"
+                                     " && ./sp_verify block_graph.txt components.cert 2>/dev/null | grep -q '^0 8 5 NONSP DISC ok GSP GSP'") != 0)) {
+                result.error_message = "verifier rejected the certificate of a disconnected graph";
+            }
+            for (const char * flag : {"--differential", "--engine ears", "--bicomps parallel"}) {
+                if (!result.error_message.empty()) break;
+                std::string command = std::string("./sp_recognizer ") + flag + " components_graph.txt > /dev/null 2>&1";
+                if (system(command.c_str()) == 0) result.error_message = std::string(flag) + " was not rejected for a disconnected graph";
+            }
+            return std::to_string(records) + " components, " + std::to_string(result.vertices) + "v," + std::to_string(result.edges) + "e";
+        });
+    }
+
+    // Reads the outerplanar embedding of a graph with a chorded hexagon, a triangle and a bridge
+    // (--embedding) and traces the faces of its rotation system: an outerplanar embedding of a
+    // connected graph has m - n + 2 faces, one of which passes through every vertex.
+    void run_embedding_test(const std::string& name) {
+        std::ofstream out("embedding_graph.txt");
+        out << "9 13 0 1 1 2 2 3 3 4 4 5 5 0 0 2 0 3 3 5 3 6 6 7 7 3 7 8\n";
+        out.close();
+
+        run_command_test(name, "./sp_recognizer --embedding embedding_graph.txt > sp_result.txt 2>/dev/null", [&](int rec_exit_code, TestResult& result) {
+            result.vertices = 9;
+            result.edges = 13;
+            if (rec_exit_code != 0) {
+                result.error_message = "SP recognizer failed on the embedding graph";
+                return std::string();
+            }
+
+            std::vector<std::vector<int>> rotation(result.vertices);
+            int cycles = 0;
+            std::ifstream lines("sp_result.txt");
+            std::string line;
+            while (std::getline(lines, line)) {
+                if (line.rfind("Outer cycle of block", 0) == 0) cycles++;
+                if (line.rfind("Rotation at ", 0) != 0) continue;
+                std::istringstream fields(line.substr(12));
+                int v, u;
+                char colon;
+                fields >> v >> colon;
+                while (v >= 0 && v < result.vertices && fields >> u) rotation[v].push_back(u);
+            }
+
+            // the face after dart (u, v) continues from v to the neighbour after u around v
+            std::vector<std::vector<char>> done(result.vertices);
+            int darts = 0;
+            for (int v = 0; v < result.vertices; v++) {
+                done[v].assign(rotation[v].size(), 0);
+                darts += (int)(rotation[v].size());
+            }
+            int faces = 0;
+            bool outer = false;
+            bool valid = (darts == 2 * result.edges);
+            for (int v = 0; valid && v < result.vertices; v++) {
+                for (size_t i = 0; valid && i < rotation[v].size(); i++) {
+                    if (done[v][i]) continue;
+                    faces++;
+                    std::vector<char> on_face(result.vertices, 0);
+                    int seen = 0;
+                    for (int x = v, j = (int)(i); valid && !done[x][j];) {
+                        done[x][j] = 1;
+                        if (!on_face[x]) seen++;
+                        on_face[x] = 1;
+                        int y = rotation[x][j];
+                        auto back = std::find(rotation[y].begin(), rotation[y].end(), x);
+                        valid = (back != rotation[y].end());
+                        if (valid) j = (int)((back - rotation[y].begin() + 1) % rotation[y].size());
+                        x = y;
+                    }
+                    outer = outer || seen == result.vertices;
+                }
+            }
+
+            if (!valid || cycles != 3 || faces != result.edges - result.vertices + 2 || !outer) {
+                result.error_message = std::to_string(cycles) + " outer cycles, " + std::to_string(faces) + " faces"
+                    + (outer ? "" : ", none through every vertex") + (valid ? "" : ", rotation is not a permutation");
+            }
+            return std::to_string(cycles) + " blocks, " + std::to_string(faces) + " faces";
+        });
+    }
+
+    // writes a binary certificate file of one record, of kind and for a graph of order n, that
+    // claims the graph is not SP
+    static bool write_cert_file(const std::string& path, cert_kind kind, uint32_t n, std::vector<uint32_t> payload, uint32_t flags = 0, bool append = false) {
+        cert_file_header h;
+        h.kind = kind;
+        h.flags = flags;
+        h.n = n;
+        h.payload_words = payload.size();
+        uint64_t checksum = to_little_endian(graph_file_checksum(payload.data(), payload.size()));
+        for (uint32_t& w : payload) w = to_little_endian(w);
+        unsigned char header[cert_file_header_bytes];
+        encode_cert_file_header(h, header);
+        std::FILE * out = std::fopen(path.c_str(), append ? "ab" : "wb");
+        if (!out) return false;
+        bool ok = std::fwrite(header, 1, sizeof(header), out) == sizeof(header)
+                  && std::fwrite(payload.data(), sizeof(uint32_t), payload.size(), out) == payload.size()
+                  && std::fwrite(&checksum, sizeof(checksum), 1, out) == 1;
+        return std::fclose(out) == 0 && ok;
+    }
+
+    // Checks the exported binary certificates of the last batch with the standalone verifier,
+    // that the verifier rejects them against a different graph stream, and that it rejects
+    // forged obstructions in SP graphs: a K4 of K4 minus an edge whose path cd runs through the
+    // terminal a, a T4 whose path c2b runs through the terminal a, and bicomps of a path that
+    // name one cut vertex more than once; and a forged outer cycle of a K4, whose chords cross.
+    void run_verify_test(const std::string& name) {
+        struct forged_cert {
+            const char * graph;
+            cert_kind kind;
+            uint32_t n;
+            std::vector<uint32_t> payload;
+        };
+        static const forged_cert forged[] = {
+            {"4 5 0 1 0 2 0 3 1 2 1 3", cert_k4, 4, {0, 1, 2, 3, 2, 0, 1, 2, 0, 2, 2, 0, 3, 2, 1, 2, 2, 1, 3, 3, 2, 0, 3}},
+            {"6 6 0 2 0 3 1 2 2 3 0 4 1 5", cert_t4, 6, {0, 1, 2, 3, 2, 0, 2, 2, 0, 3, 2, 1, 2, 3, 1, 2, 3, 2, 2, 3}},
+            {"3 2 0 1 1 2", cert_bicomp3, 3, {1, 1, 1}},
+            {"5 4 0 1 1 2 2 3 3 4", cert_bicomp3, 5, {1, 2, 2}},
+        };
+
+        run_command_test(name, "./sp_verify batch_graphs.bin batch_certs.bin > sp_result.txt 2>/dev/null", [&](int verify_exit_code, TestResult& result) {
+            std::ifstream result_file("sp_result.txt");
+            std::string line;
+            int records = 0;
+            bool all_ok = true;
+            while (std::getline(result_file, line)) {
+                std::istringstream record(line);
+                std::string index, n, m, verdict, reason, auth;
+                record >> index >> n >> m >> verdict >> reason >> auth;
+                if (index != std::to_string(records) || auth != "ok") all_ok = false;
+                result.vertices += std::atoi(n.c_str());
+                result.edges += std::atoi(m.c_str());
+                records++;
+            }
+
+            if (verify_exit_code != 0 || !all_ok || records == 0) {
+                result.error_message = "verifier rejected the exported certificates";
+            } else if (system("./sp_verify test_graph.txt batch_certs.bin > /dev/null 2>&1") == 0) {
+                result.error_message = "verifier accepted certificates for a different graph stream";
+            }
+            for (const forged_cert& cert : forged) {
+                if (!result.error_message.empty()) break;
+                std::ofstream graph("forged_graph.txt");
+                graph << cert.graph << "\n";
+                graph.close();
+                if (!write_cert_file("forged.cert", cert.kind, cert.n, cert.payload)) {
+                    result.error_message = "could not write a forged certificate";
+                } else if (system("./sp_verify forged_graph.txt forged.cert > /dev/null 2>&1") == 0) {
+                    result.error_message = std::string("verifier accepted a forged ") + cert_kind_names[cert.kind] + " of an SP graph";
+                }
+            }
+            if (result.error_message.empty()) {
+                std::ofstream graph("forged_graph.txt");
+                graph << "4 6 0 1 0 2 0 3 1 2 1 3 2 3\n";
+                graph.close();
+                std::vector<uint32_t> k4 = {0, 1, 2, 3, 2, 0, 1, 2, 0, 2, 2, 0, 3, 2, 1, 2, 2, 1, 3, 2, 2, 3};
+                if (!write_cert_file("forged.cert", cert_k4, 4, k4) || system("./sp_verify forged_graph.txt forged.cert > /dev/null 2>&1") != 0) {
+                    result.error_message = "verifier rejected the K4 of a K4";
+                } else if (!write_cert_file("forged.cert", cert_op, 4, {1, 4, 0, 1, 2, 3, 0}, cert_file_sp | cert_class_op << cert_file_class_shift, true)) {
+                    result.error_message = "could not write a forged certificate";
+                } else if (system("./sp_verify forged_graph.txt forged.cert > /dev/null 2>&1") == 0) {
+                    result.error_message = "verifier accepted a forged outer cycle of a K4";
+                }
+            }
+            return std::to_string(records) + " certificates, " + std::to_string(result.vertices) + "v," + std::to_string(result.edges) + "e";
+        });
+    }
+
     void print_summary() {
         std::cout << "\n" << std::string(70, '=') << std::endl;
         std::cout << "Test Summary:" << std::endl;
@@ -179,7 +1192,7 @@ int main() {
     
     if (system("test -f ./sp_recognizer") != 0) {
         std::cerr << "Error: sp_recognizer executable not found!" << std::endl;
-        std::cerr << "Please compile it first with: clang++ -std=c++20 -Wall -Wextra sp_recognizer.cpp -o sp_recognizer" << std::endl;
+        std::cerr << "Please compile it first with: clang++ -std=c++20 -O2 -Wall -Wextra -pthread sp_recognition.cpp -o sp_recognizer" << std::endl;
         return 1;
     }
     
@@ -222,10 +1235,92 @@ int main() {
         suite.run_test("Random test " + std::to_string(i+1), 2, 6, 2, 5, 0);
     }
     
+    // Batch mode tests
+    std::cout << "\n--- Batch Mode Tests ---" << std::endl;
+    suite.run_batch_test("Mixed text/binary batch", 30, 0, 12361, 1);
+    suite.run_batch_test("Mixed text/binary batch with 3-edges", 30, 1, 12391, 1);
+    suite.run_batch_test("Parallel batch, 4 threads", 60, 0, 12421, 4);
+    
+    // Binary graph tests
+    std::cout << "\n--- Binary Graph Tests ---" << std::endl;
+    suite.run_csr_validation_test("Asymmetric CSR rows are rejected");
+    
+    // Certificate export tests
+    std::cout << "\n--- Certificate Export Tests ---" << std::endl;
+    suite.run_cert_export_test("Certificate export, binary and JSON", 4);
+    
+    // Certificate policy tests
+    std::cout << "\n--- Certificate Policy Tests ---" << std::endl;
+    suite.run_cert_policy_test("Terminal and boolean certificate policies");
+    
+    // Classification tests
+    std::cout << "\n--- Classification Tests ---" << std::endl;
+    suite.run_class_test("SP, GSP and outerplanar classification");
+    
+    // Parallel edge tests
+    std::cout << "\n--- Parallel Edge Tests ---" << std::endl;
+    suite.run_multigraph_test("Parallel edges are lifted, self-loops rejected");
+    
+    // Outerplanar embedding tests
+    std::cout << "\n--- Outerplanar Embedding Tests ---" << std::endl;
+    suite.run_embedding_test("Outerplanar embedding");
+    
+    // Bicomp pool tests
+    std::cout << "\n--- Bicomp Pool Tests ---" << std::endl;
+    suite.run_block_pool_test("Bicomps on a pool match the sequential run");
+    
+    // Parallel bicomp engine tests
+    std::cout << "\n--- Parallel Bicomp Engine Tests ---" << std::endl;
+    suite.run_parallel_bicomps_test("Parallel bicomp engine agrees with the DFS engine");
+    
+    // Ear engine tests
+    std::cout << "\n--- Ear Engine Tests ---" << std::endl;
+    suite.run_ear_engine_test("Parallel ear engine agrees with the DFS engine");
+    
+    // Path compression tests
+    std::cout << "\n--- Path Compression Tests ---" << std::endl;
+    suite.run_compress_test("Degree-2 path compression keeps the verdicts");
+    
+    // Pre-filter tests
+    std::cout << "\n--- Pre-filter Tests ---" << std::endl;
+    suite.run_prefilter_test("Pre-filter keeps the verdicts and certifies its rejections");
+    
+    // Reduction engine tests
+    std::cout << "\n--- Reduction Engine Tests ---" << std::endl;
+    suite.run_reduction_engine_test("Reduction engine agrees with the DFS engine");
+    
+    // Relabeling tests
+    std::cout << "\n--- Relabeling Tests ---" << std::endl;
+    suite.run_relabel_test("Vertex relabeling keeps the verdicts and maps certificates back");
+    
+    // Disconnected graph tests
+    std::cout << "\n--- Disconnected Graph Tests ---" << std::endl;
+    suite.run_components_test("Disconnected graph, component by component");
+    
+    // Verifier tests
+    std::cout << "\n--- Verifier Tests ---" << std::endl;
+    if (system("test -f ./sp_verify") == 0) {
+        suite.run_verify_test("Standalone certificate verifier");
+    } else {
+        std::cout << "(skipping verifier test: build sp_verify from sp_verify.cpp)" << std::endl;
+    }
+    
+    // Allocation tests
+    std::cout << "\n--- Allocation Tests ---" << std::endl;
+    if (system("test -f ./sp_recognizer_alloc") == 0) {
+        suite.run_allocation_test("Warm batch worker allocates nothing");
+    } else {
+        std::cout << "(skipping allocation test: build sp_recognizer_alloc with -D__COUNT_ALLOCATIONS__)" << std::endl;
+    }
+    
     suite.print_summary();
     
     // Cleanup
-    system("rm -f test_graph.txt sp_result.txt");
+    system("rm -f test_graph.txt sp_result.txt batch_graphs.bin batch_twice.bin allocation_graphs.txt batch_certs.bin batch_certs_par.bin batch_certs.json cert_bad_graph.txt"
+           " sp_result_terminals.txt sp_result_boolean.txt class_graphs.txt multigraph.txt multigraph_batch.txt embedding_graph.txt"
+           " sp_result_pool.txt sp_result_parallel.txt block_graph.txt block_batch.txt block_graph.cert block_graph_seq.cert verdicts_dfs.txt verdicts_parallel.txt"
+           " components_graph.txt components.txt components.cert components_seq.cert"
+           " csr_triangle.bin csr_one_way.bin csr_rotated.bin batch_csr.bin forged_graph.txt forged.cert");
     
     return 0;
 }
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ==================== WORK-STEALING POOL ====================
+// Every worker owns a deque of tasks submitted from inside its tasks and an inbox of tasks
+// submitted from outside the pool, which are dealt round-robin. A worker pops the newest task of
+// its own deque, so nested work runs depth first, and otherwise the oldest task of its inbox;
+// when both are empty it steals the oldest task of another worker, deque before inbox, so a few
+// very large tasks cannot strand the small ones queued behind them. Outside tasks thus start in
+// the order they were submitted on every worker, which keeps the head of a bounded window of
+// work (such as the batch's reorder buffer) from being left until last. Each task receives the
+// index of the worker running it, for indexing per-worker state.
+class work_stealing_pool {
+public:
+    using task = std::function<void(int)>;
+
+    explicit work_stealing_pool(int workers) {
+        if (workers < 1) workers = 1;
+        for (int i = 0; i < workers; i++) queues.emplace_back(new worker_queue{});
+        for (int i = 0; i < workers; i++) threads.emplace_back([this, i] {run(i);});
+    }
+
+    ~work_stealing_pool() {
+        wait_idle();
+        {
+            std::lock_guard<std::mutex> lock{sleep_mutex};
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& t : threads) t.join();
+    }
+
+    work_stealing_pool(work_stealing_pool const& other) = delete;
+    work_stealing_pool& operator=(work_stealing_pool const& other) = delete;
+
+    int size() const {return (int)(queues.size());}
+
+    void submit(task t) {
+        bool inside = (current_pool == this);
+        size_t q = (inside ? (size_t)(current_worker) : next_queue++ % queues.size());
+        pending++;
+        {
+            std::lock_guard<std::mutex> lock{queues[q]->mutex};
+            (inside ? queues[q]->tasks : queues[q]->inbox).push_back(std::move(t));
+        }
+        {
+            std::lock_guard<std::mutex> lock{sleep_mutex};
+            queued++;
+        }
+        wake.notify_one();
+    }
+
+    // blocks until every submitted task has finished; must not be called from a task
+    void wait_idle() {
+        std::unique_lock<std::mutex> lock{sleep_mutex};
+        idle.wait(lock, [this] {return pending == 0;});
+    }
+
+private:
+    struct worker_queue {
+        std::mutex mutex;
+        std::deque<task> tasks; // submitted from inside the pool
+        std::deque<task> inbox; // submitted from outside
+    };
+
+    std::vector<std::unique_ptr<worker_queue>> queues;
+    std::vector<std::thread> threads;
+    std::mutex sleep_mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::atomic<long long> pending{0}; // submitted and not yet finished
+    long long queued = 0; // submitted and not yet taken; guarded by sleep_mutex
+    std::atomic<size_t> next_queue{0};
+    bool stopping = false;
+
+    static inline thread_local work_stealing_pool * current_pool = nullptr;
+    static inline thread_local int current_worker = -1;
+
+    bool take(int id, task& t) {
+        size_t n = queues.size();
+        for (size_t k = 0; k < n; k++) {
+            worker_queue& q = *queues[(id + k) % n];
+            std::lock_guard<std::mutex> lock{q.mutex};
+            if (k == 0 && !q.tasks.empty()) {
+                t = std::move(q.tasks.back());
+                q.tasks.pop_back();
+            } else if (!q.tasks.empty() || !q.inbox.empty()) {
+                std::deque<task>& from = (q.tasks.empty() ? q.inbox : q.tasks);
+                t = std::move(from.front());
+                from.pop_front();
+            } else {
+                continue;
+            }
+            return true;
+        }
+        return false;
+    }
+
+    void run(int id) {
+        current_pool = this;
+        current_worker = id;
+
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock{sleep_mutex};
+                wake.wait(lock, [this] {return stopping || queued > 0;});
+                if (queued == 0) return;
+                queued--;
+            }
+
+            // a task is reserved for this worker, so one is in some deque until taken
+            task t;
+            while (!take(id, t)) std::this_thread::yield();
+            t(id);
+
+            if (--pending == 0) {
+                std::lock_guard<std::mutex> lock{sleep_mutex};
+                idle.notify_all();
+            }
+        }
+    }
+};
+
+// number of chunks to split count items into: at least grain items each, a few per worker so
+// that stealing can even out uneven chunks, and one when the items are too few to share or
+// there is no other worker to share them with
+inline int chunk_count(work_stealing_pool const& pool, long long count, long long grain) {
+    if (pool.size() == 1) return 1;
+    return (int)(std::clamp<long long>(count / grain, 1, 4 * (long long)(pool.size())));
+}
+
+// Runs f(chunk, lo, hi) for the chunks of [0, count), chunk c covering [count * c / chunks,
+// count * (c + 1) / chunks), on the pool, and returns when all have finished. A single chunk
+// runs on the caller. Must not be called from a task.
+template <typename F>
+void for_each_chunk(work_stealing_pool& pool, int chunks, int count, F const& f) {
+    auto bound = [&](int c) {return (int)((long long)(count) * c / chunks);};
+    if (chunks == 1) {
+        f(0, 0, count);
+        return;
+    }
+    for (int c = 0; c < chunks; c++) {
+        pool.submit([&f, c, lo = bound(c), hi = bound(c + 1)](int) {f(c, lo, hi);});
+    }
+    pool.wait_idle();
+}
+
+// Replaces a[0 .. count) by its exclusive prefix sums and returns their total: every chunk is
+// summed on the pool, the chunk sums are scanned on the caller, and then every chunk is scanned
+// from its offset on the pool. sums is scratch. Must not be called from a task.
+inline int exclusive_scan(work_stealing_pool& pool, int * a, int count, std::vector<int>& sums) {
+    const int min_items_per_chunk = 1 << 14;
+    int chunks = chunk_count(pool, count, min_items_per_chunk);
+    sums.assign((size_t)(chunks) + 1, 0);
+    for_each_chunk(pool, chunks, count, [&](int c, int lo, int hi) {
+        int s = 0;
+        for (int i = lo; i < hi; i++) s += a[i];
+        sums[(size_t)(c) + 1] = s;
+    });
+    for (int c = 0; c < chunks; c++) sums[(size_t)(c) + 1] += sums[(size_t)(c)];
+    for_each_chunk(pool, chunks, count, [&](int c, int lo, int hi) {
+        int s = sums[(size_t)(c)];
+        for (int i = lo; i < hi; i++) {
+            int x = a[i];
+            a[i] = s;
+            s += x;
+        }
+    });
+    return sums[(size_t)(chunks)];
+}